@@ -0,0 +1,115 @@
+#include "AddressResolutionCache.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "OrbitModule.h"
+#include "Pdb.h"
+
+void AddressResolutionCache::Resolve(
+    const std::map<uint64_t, std::shared_ptr<Module>>& modules,
+    std::vector<uint64_t>* addresses_to_resolve) {
+  std::vector<uint64_t>& addresses = *addresses_to_resolve;
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()),
+                  addresses.end());
+
+  // Drop the addresses that are already cached.
+  size_t num_new_addresses = 0;
+  auto cached_it = entries_.begin();
+  for (uint64_t address : addresses) {
+    while (cached_it != entries_.end() && cached_it->address < address) {
+      ++cached_it;
+    }
+    if ((cached_it == entries_.end() || cached_it->address != address) &&
+        !single_entries_.contains(address)) {
+      addresses[num_new_addresses++] = address;
+    }
+  }
+  addresses.resize(num_new_addresses);
+  if (addresses.empty()) {
+    return;
+  }
+
+  // An address belongs to the last module starting at or before it, if it is
+  // below the end of that module. As both addresses and modules are sorted,
+  // the addresses of each module form a contiguous range.
+  std::vector<Function*> functions(addresses.size(), nullptr);
+  auto module_it = modules.end();
+  auto next_module_it = modules.begin();
+  size_t begin = 0;
+  while (begin < addresses.size()) {
+    while (next_module_it != modules.end() &&
+           next_module_it->first <= addresses[begin]) {
+      module_it = next_module_it++;
+    }
+    const Module* module =
+        module_it != modules.end() ? module_it->second.get() : nullptr;
+    if (module == nullptr || addresses[begin] >= module->m_AddressEnd) {
+      // Skip to the next module.
+      if (next_module_it == modules.end()) {
+        break;
+      }
+      begin = std::lower_bound(addresses.begin() + begin, addresses.end(),
+                               next_module_it->first) -
+              addresses.begin();
+      continue;
+    }
+
+    uint64_t range_end = module->m_AddressEnd;
+    if (next_module_it != modules.end()) {
+      range_end = std::min(range_end, next_module_it->first);
+    }
+    size_t end = std::lower_bound(addresses.begin() + begin, addresses.end(),
+                                  range_end) -
+                 addresses.begin();
+    if (module->m_Pdb != nullptr) {
+      module->m_Pdb->GetFunctionsFromProgramCounters(
+          addresses.data() + begin, end - begin, functions.data() + begin);
+    }
+    begin = end;
+  }
+
+  size_t num_cached = entries_.size();
+  entries_.reserve(num_cached + addresses.size());
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    entries_.push_back({addresses[i], functions[i]});
+  }
+  std::inplace_merge(entries_.begin(), entries_.begin() + num_cached,
+                     entries_.end(), [](const Entry& a, const Entry& b) {
+                       return a.address < b.address;
+                     });
+}
+
+Function* AddressResolutionCache::ResolveOne(
+    const std::map<uint64_t, std::shared_ptr<Module>>& modules,
+    uint64_t address) {
+  Function* function = nullptr;
+  auto module_it = modules.upper_bound(address);
+  if (module_it != modules.begin()) {
+    const Module* module = std::prev(module_it)->second.get();
+    if (module != nullptr && address < module->m_AddressEnd &&
+        module->m_Pdb != nullptr) {
+      module->m_Pdb->GetFunctionsFromProgramCounters(&address, 1, &function);
+    }
+  }
+  single_entries_[address] = function;
+  return function;
+}
+
+bool AddressResolutionCache::Find(uint64_t address,
+                                  Function** function) const {
+  auto it = std::lower_bound(
+      entries_.begin(), entries_.end(), address,
+      [](const Entry& entry, uint64_t value) { return entry.address < value; });
+  if (it != entries_.end() && it->address == address) {
+    *function = it->function;
+    return true;
+  }
+  auto single_it = single_entries_.find(address);
+  if (single_it != single_entries_.end()) {
+    *function = single_it->second;
+    return true;
+  }
+  return false;
+}
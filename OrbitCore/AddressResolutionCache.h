@@ -0,0 +1,61 @@
+#ifndef ORBIT_CORE_ADDRESS_RESOLUTION_CACHE_H_
+#define ORBIT_CORE_ADDRESS_RESOLUTION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+class Function;
+struct Module;
+
+// Caches the function containing each resolved address in an array sorted by
+// address. Addresses are resolved in batches: a batch is sorted once, then
+// matched against the modules and the functions of each module in a single
+// merge pass, instead of looking up a module and then a function for every
+// address.
+//
+// Resolution follows Process::GetFunctionFromAddress with a_IsExact set to
+// false. The cache refers to the functions of the modules' Pdbs, so it must be
+// cleared when modules or their functions change. It is not thread-safe.
+class AddressResolutionCache {
+ public:
+  // Resolves and caches the addresses that are not cached yet. addresses is
+  // sorted and deduplicated in place, then only keeps the addresses that were
+  // not cached.
+  void Resolve(const std::map<uint64_t, std::shared_ptr<Module>>& modules,
+               std::vector<uint64_t>* addresses);
+
+  // Resolves and caches a single address that is not cached yet, and returns
+  // the function containing it. Unlike Resolve, this doesn't merge into the
+  // sorted array, so that isolated misses don't cost a pass over the cache.
+  Function* ResolveOne(
+      const std::map<uint64_t, std::shared_ptr<Module>>& modules,
+      uint64_t address);
+
+  // Returns false if the address is not cached. Otherwise sets *function to
+  // the function containing the address, which is nullptr if there is none.
+  bool Find(uint64_t address, Function** function) const;
+
+  size_t Size() const { return entries_.size() + single_entries_.size(); }
+  void Clear() {
+    entries_.clear();
+    single_entries_.clear();
+  }
+
+ private:
+  struct Entry {
+    uint64_t address;
+    Function* function;
+  };
+
+  // Addresses resolved in batches, sorted by address.
+  std::vector<Entry> entries_;
+  // Addresses resolved by ResolveOne.
+  absl::flat_hash_map<uint64_t, Function*> single_entries_;
+};
+
+#endif  // ORBIT_CORE_ADDRESS_RESOLUTION_CACHE_H_
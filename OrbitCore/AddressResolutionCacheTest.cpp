@@ -0,0 +1,189 @@
+#include "AddressResolutionCache.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "OrbitModule.h"
+#include "OrbitProcess.h"
+#include "Pdb.h"
+
+namespace {
+std::shared_ptr<Module> AddModule(Process* process, uint64_t start,
+                                  uint64_t end,
+                                  const std::vector<uint64_t>& functions) {
+  auto module = std::make_shared<Module>();
+  module->m_AddressStart = start;
+  module->m_AddressEnd = end;
+  module->m_Pdb->SetMainModule(start);
+  for (uint64_t address : functions) {
+    Function function("", "", "", address, 0, 0, module->m_Pdb.get());
+    module->m_Pdb->AddFunction(function);
+  }
+  module->m_Pdb->PopulateFunctionMap();
+  process->AddModule(module);
+  return module;
+}
+}  // namespace
+
+TEST(AddressResolutionCache, MatchesGetFunctionFromAddress) {
+  Process process;
+  AddModule(&process, 0x1000, 0x2000, {0x100, 0x200});
+  std::shared_ptr<Module> no_functions =
+      AddModule(&process, 0x5000, 0x6000, {});
+  no_functions->m_Pdb = nullptr;
+  AddModule(&process, 0x8000, 0x9000, {0x0, 0x800});
+
+  const std::vector<uint64_t> addresses = {
+      0x10,   0x1150, 0x1100, 0x1050, 0x1250, 0x1fff, 0x2500,
+      0x5100, 0x8000, 0x8fff, 0x9000, 0x1150, 0xffffffffffffffff};
+  std::vector<uint64_t> addresses_to_resolve = addresses;
+  process.ResolveAddresses(&addresses_to_resolve);
+  // Sorted and deduplicated.
+  EXPECT_EQ(addresses_to_resolve.size(), addresses.size() - 1);
+  EXPECT_TRUE(std::is_sorted(addresses_to_resolve.begin(),
+                             addresses_to_resolve.end()));
+
+  for (uint64_t address : addresses) {
+    EXPECT_EQ(process.GetCachedFunctionFromAddress(address, false),
+              process.GetFunctionFromAddress(address, false))
+        << std::hex << address;
+    EXPECT_EQ(process.GetCachedFunctionFromAddress(address, true),
+              process.GetFunctionFromAddress(address, true))
+        << std::hex << address;
+  }
+  EXPECT_NE(process.GetCachedFunctionFromAddress(0x1250, false), nullptr);
+  EXPECT_EQ(process.GetCachedFunctionFromAddress(0x1250, true), nullptr);
+  EXPECT_NE(process.GetCachedFunctionFromAddress(0x1200, true), nullptr);
+
+  // Only addresses that are not cached yet are resolved.
+  addresses_to_resolve = {0x1100, 0x1180, 0x8000};
+  process.ResolveAddresses(&addresses_to_resolve);
+  EXPECT_EQ(addresses_to_resolve, std::vector<uint64_t>{0x1180});
+}
+
+TEST(AddressResolutionCache, Find) {
+  AddressResolutionCache cache;
+  std::map<uint64_t, std::shared_ptr<Module>> modules;
+  std::vector<uint64_t> addresses = {3, 1, 2};
+  cache.Resolve(modules, &addresses);
+  EXPECT_EQ(cache.Size(), 3);
+
+  Function* function = reinterpret_cast<Function*>(1);
+  EXPECT_TRUE(cache.Find(2, &function));
+  EXPECT_EQ(function, nullptr);
+  EXPECT_FALSE(cache.Find(4, &function));
+
+  cache.Clear();
+  EXPECT_FALSE(cache.Find(2, &function));
+}
+
+TEST(AddressResolutionCache, ResolveOneMatchesResolve) {
+  constexpr int num_functions = 1'000;
+  constexpr int num_addresses = 10'000;
+  constexpr uint64_t module_start = 0x400000;
+  constexpr uint64_t function_size = 64;
+  constexpr uint64_t module_size = num_functions * function_size;
+
+  std::vector<uint64_t> functions;
+  for (uint64_t i = 0; i < num_functions; ++i) {
+    functions.push_back(i * function_size);
+  }
+  Process process;
+  std::shared_ptr<Module> module =
+      AddModule(&process, module_start, module_start + module_size, functions);
+  std::map<uint64_t, std::shared_ptr<Module>> modules = {
+      {module_start, module}};
+
+  std::mt19937_64 random_engine(0);
+  std::uniform_int_distribution<uint64_t> address_distribution(
+      module_start - function_size, module_start + module_size);
+  std::vector<uint64_t> addresses(num_addresses);
+  for (uint64_t& address : addresses) {
+    address = address_distribution(random_engine);
+  }
+
+  AddressResolutionCache batch_cache;
+  std::vector<uint64_t> addresses_to_resolve = addresses;
+  batch_cache.Resolve(modules, &addresses_to_resolve);
+
+  // Half of the addresses are resolved one by one, then the rest in a batch
+  // that must skip them.
+  AddressResolutionCache mixed_cache;
+  for (size_t i = 0; i < addresses.size() / 2; ++i) {
+    Function* function = nullptr;
+    if (!mixed_cache.Find(addresses[i], &function)) {
+      function = mixed_cache.ResolveOne(modules, addresses[i]);
+    }
+    EXPECT_EQ(function, process.GetFunctionFromAddress(addresses[i], false));
+  }
+  size_t num_resolved_one_by_one = mixed_cache.Size();
+  addresses_to_resolve = addresses;
+  mixed_cache.Resolve(modules, &addresses_to_resolve);
+  EXPECT_EQ(mixed_cache.Size(), batch_cache.Size());
+  EXPECT_EQ(addresses_to_resolve.size(),
+            batch_cache.Size() - num_resolved_one_by_one);
+
+  for (uint64_t address : addresses) {
+    Function* expected = nullptr;
+    Function* function = nullptr;
+    ASSERT_TRUE(batch_cache.Find(address, &expected));
+    ASSERT_TRUE(mixed_cache.Find(address, &function));
+    EXPECT_EQ(function, expected);
+    EXPECT_EQ(function, process.GetFunctionFromAddress(address, false));
+  }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the resolution
+// rate of 1M addresses in a module of 500k functions, one address at a time
+// and in a batch.
+TEST(AddressResolutionCache, DISABLED_Throughput) {
+  constexpr int num_functions = 500'000;
+  constexpr int num_addresses = 1'000'000;
+  constexpr uint64_t module_start = 0x400000;
+  constexpr uint64_t function_size = 64;
+  constexpr uint64_t module_size = num_functions * function_size;
+
+  std::vector<uint64_t> functions;
+  functions.reserve(num_functions);
+  for (uint64_t i = 0; i < num_functions; ++i) {
+    functions.push_back(i * function_size);
+  }
+  Process process;
+  AddModule(&process, module_start, module_start + module_size, functions);
+
+  std::mt19937_64 random_engine(0);
+  std::uniform_int_distribution<uint64_t> address_distribution(
+      module_start, module_start + module_size - 1);
+  std::vector<uint64_t> addresses(num_addresses);
+  for (uint64_t& address : addresses) {
+    address = address_distribution(random_engine);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Function*> expected_functions;
+  expected_functions.reserve(num_addresses);
+  for (uint64_t address : addresses) {
+    expected_functions.push_back(
+        process.GetFunctionFromAddress(address, false));
+  }
+  auto resolved_one_by_one = std::chrono::steady_clock::now();
+  std::vector<uint64_t> addresses_to_resolve = addresses;
+  process.ResolveAddresses(&addresses_to_resolve);
+  auto resolved_in_batch = std::chrono::steady_clock::now();
+
+  auto one_by_one_seconds =
+      std::chrono::duration<double>(resolved_one_by_one - start).count();
+  auto batch_seconds = std::chrono::duration<double>(resolved_in_batch -
+                                                     resolved_one_by_one)
+                           .count();
+  printf("GetFunctionFromAddress: %.1f M addresses/s\n",
+         num_addresses / one_by_one_seconds / 1e6);
+  printf("ResolveAddresses: %.1f M addresses/s\n",
+         num_addresses / batch_seconds / 1e6);
+}
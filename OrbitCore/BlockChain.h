@@ -97,8 +97,25 @@ struct BlockChain {
 
   void push_back(const T& a_Item) { m_Current->Add(a_Item); }
 
+  // Copies as many items as fit in the current block at once.
   void push_back(const T* a_Array, uint32_t a_Num) {
-    for (uint32_t i = 0; i < a_Num; ++i) m_Current->Add(a_Array[i]);
+    while (a_Num > 0) {
+      uint32_t size = m_Current->m_Size;
+      if (size == BlockSize) {
+        // Moves to the next block.
+        m_Current->Add(*a_Array);
+        ++a_Array;
+        --a_Num;
+        continue;
+      }
+
+      uint32_t num = std::min(a_Num, BlockSize - size);
+      std::copy(a_Array, a_Array + num, m_Current->m_Data + size);
+      m_Current->m_Size = size + num;
+      m_NumItems += num;
+      a_Array += num;
+      a_Num -= num;
+    }
   }
 
   void push_back_n(const T& a_Item, uint32_t a_Num) {
@@ -21,6 +21,12 @@ CallStack::CallStack(CallStackPOD a_CS) : CallStack() {
   memcpy(m_Data.data(), a_CS.Data(), m_Depth * sizeof(m_Data[0]));
 }
 
+//-----------------------------------------------------------------------------
+CallStack::CallStack(const CallstackView& a_View)
+    : m_Hash(a_View.Hash()),
+      m_Depth(a_View.Depth()),
+      m_Data(a_View.begin(), a_View.end()) {}
+
 //-----------------------------------------------------------------------------
 void CallStack::Print() {
   PRINT_VAR(m_Hash);
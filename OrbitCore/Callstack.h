@@ -3,6 +3,7 @@
 //-----------------------------------
 #pragma once
 
+#include "CallstackInternTable.h"
 #include "CallstackTypes.h"
 #include "OrbitDbgHelp.h"
 #include "PrintVar.h"
@@ -18,7 +19,7 @@ class CallStackPOD {
   }
 
   void CalculateHash() {
-    hash_ = XXH64(&data_[0], depth_ * sizeof(data_[0]), 0xca1157ac);
+    hash_ = ComputeCallstackHash(&data_[0], depth_);
   }
 
   CallstackID Hash() const { return hash_; }
@@ -39,9 +40,10 @@ class CallStackPOD {
 struct CallStack {
   CallStack() {}
   CallStack(CallStackPOD a_CS);
+  explicit CallStack(const CallstackView& a_View);
   inline CallstackID Hash() {
     if (m_Hash != 0) return m_Hash;
-    m_Hash = XXH64(m_Data.data(), m_Depth * sizeof(uint64_t), 0xca1157ac);
+    m_Hash = ComputeCallstackHash(m_Data.data(), m_Depth);
     return m_Hash;
   }
   void Print();
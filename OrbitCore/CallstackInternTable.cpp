@@ -0,0 +1,66 @@
+#include "CallstackInternTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xxhash.h"
+
+namespace {
+// Number of frames of an arena block, unless a callstack is deeper.
+constexpr size_t ARENA_BLOCK_SIZE = 1024 * 1024;
+
+// Frames of empty callstacks, so that their views are valid.
+constexpr uint64_t NO_FRAMES[1] = {0};
+}  // namespace
+
+CallstackID ComputeCallstackHash(const uint64_t* frames, size_t depth) {
+  return XXH64(frames, depth * sizeof(frames[0]), 0xca1157ac);
+}
+
+uint32_t CallstackInternTable::Intern(CallstackID hash, const uint64_t* frames,
+                                      uint32_t depth) {
+  auto [it, inserted] = index_of_hash_.try_emplace(hash, Size());
+  if (inserted) {
+    entries_.push_back({hash, AllocateFrames(frames, depth), depth});
+  }
+  return it->second;
+}
+
+uint32_t CallstackInternTable::GetIndex(CallstackID hash) const {
+  auto it = index_of_hash_.find(hash);
+  return it != index_of_hash_.end() ? it->second : INVALID_INDEX;
+}
+
+CallstackView CallstackInternTable::Find(CallstackID hash) const {
+  uint32_t index = GetIndex(hash);
+  return index != INVALID_INDEX ? Get(index) : CallstackView();
+}
+
+void CallstackInternTable::Clear() {
+  entries_.clear();
+  index_of_hash_.clear();
+  arena_blocks_.clear();
+  arena_position_ = nullptr;
+  arena_remaining_ = 0;
+  num_frames_ = 0;
+}
+
+const uint64_t* CallstackInternTable::AllocateFrames(const uint64_t* frames,
+                                                     uint32_t depth) {
+  if (depth == 0) {
+    return NO_FRAMES;
+  }
+  if (depth > arena_remaining_) {
+    // The unused end of the current block is abandoned.
+    size_t block_size = std::max(ARENA_BLOCK_SIZE, static_cast<size_t>(depth));
+    arena_blocks_.emplace_back(new uint64_t[block_size]);
+    arena_position_ = arena_blocks_.back().get();
+    arena_remaining_ = block_size;
+  }
+  uint64_t* destination = arena_position_;
+  memcpy(destination, frames, depth * sizeof(frames[0]));
+  arena_position_ += depth;
+  arena_remaining_ -= depth;
+  num_frames_ += depth;
+  return destination;
+}
@@ -0,0 +1,90 @@
+#ifndef ORBIT_CORE_CALLSTACK_INTERN_TABLE_H_
+#define ORBIT_CORE_CALLSTACK_INTERN_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CallstackTypes.h"
+#include "absl/container/flat_hash_map.h"
+
+// Hash identifying the callstack made of the depth addresses at frames.
+CallstackID ComputeCallstackHash(const uint64_t* frames, size_t depth);
+
+// Read-only view of the frames of a callstack stored in a
+// CallstackInternTable. A default-constructed view refers to no callstack.
+class CallstackView {
+ public:
+  CallstackView() = default;
+  CallstackView(CallstackID hash, const uint64_t* frames, uint32_t depth)
+      : hash_(hash), frames_(frames), depth_(depth) {}
+
+  explicit operator bool() const { return frames_ != nullptr; }
+
+  CallstackID Hash() const { return hash_; }
+  uint32_t Depth() const { return depth_; }
+  const uint64_t* Data() const { return frames_; }
+  uint64_t operator[](size_t index) const { return frames_[index]; }
+  const uint64_t* begin() const { return frames_; }
+  const uint64_t* end() const { return frames_ + depth_; }
+
+ private:
+  CallstackID hash_ = 0;
+  const uint64_t* frames_ = nullptr;
+  uint32_t depth_ = 0;
+};
+
+// Stores each distinct callstack once and assigns it a dense index, in order
+// of insertion, so that per-callstack data can be kept in plain vectors
+// indexed by callstack instead of in maps keyed by CallstackID.
+//
+// The frames of all callstacks are appended to large arena blocks, which are
+// never reallocated: views returned by Get and Find stay valid until Clear is
+// called, even while more callstacks are added. The table is not thread-safe.
+class CallstackInternTable {
+ public:
+  static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+  CallstackInternTable() = default;
+  CallstackInternTable(const CallstackInternTable&) = delete;
+  CallstackInternTable& operator=(const CallstackInternTable&) = delete;
+
+  // Returns the index of the callstack identified by hash, first copying
+  // frames into the table if the callstack is not present yet.
+  uint32_t Intern(CallstackID hash, const uint64_t* frames, uint32_t depth);
+  // Returns INVALID_INDEX if the callstack is not present.
+  uint32_t GetIndex(CallstackID hash) const;
+  bool Contains(CallstackID hash) const {
+    return GetIndex(hash) != INVALID_INDEX;
+  }
+
+  CallstackView Get(uint32_t index) const {
+    const Entry& entry = entries_[index];
+    return CallstackView(entry.hash, entry.frames, entry.depth);
+  }
+  // Returns an empty view if the callstack is not present.
+  CallstackView Find(CallstackID hash) const;
+
+  uint32_t Size() const { return static_cast<uint32_t>(entries_.size()); }
+  uint64_t GetNumFrames() const { return num_frames_; }
+  void Clear();
+
+ private:
+  struct Entry {
+    CallstackID hash;
+    const uint64_t* frames;
+    uint32_t depth;
+  };
+
+  const uint64_t* AllocateFrames(const uint64_t* frames, uint32_t depth);
+
+  std::vector<Entry> entries_;
+  absl::flat_hash_map<CallstackID, uint32_t> index_of_hash_;
+  std::vector<std::unique_ptr<uint64_t[]>> arena_blocks_;
+  uint64_t* arena_position_ = nullptr;
+  size_t arena_remaining_ = 0;
+  uint64_t num_frames_ = 0;
+};
+
+#endif  // ORBIT_CORE_CALLSTACK_INTERN_TABLE_H_
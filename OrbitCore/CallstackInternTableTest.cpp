@@ -0,0 +1,80 @@
+#include "CallstackInternTable.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+TEST(CallstackInternTable, Intern) {
+  std::vector<uint64_t> frames_0 = {0x10, 0x20, 0x30};
+  std::vector<uint64_t> frames_1 = {0x40};
+  CallstackID id_0 = ComputeCallstackHash(frames_0.data(), frames_0.size());
+  CallstackID id_1 = ComputeCallstackHash(frames_1.data(), frames_1.size());
+  ASSERT_NE(id_0, id_1);
+
+  CallstackInternTable table;
+  EXPECT_FALSE(table.Contains(id_0));
+  EXPECT_FALSE(table.Find(id_0));
+  EXPECT_EQ(table.GetIndex(id_0), CallstackInternTable::INVALID_INDEX);
+
+  EXPECT_EQ(table.Intern(id_0, frames_0.data(), frames_0.size()), 0);
+  EXPECT_EQ(table.Intern(id_1, frames_1.data(), frames_1.size()), 1);
+  EXPECT_EQ(table.Intern(id_0, frames_0.data(), frames_0.size()), 0);
+  EXPECT_EQ(table.Size(), 2);
+  EXPECT_EQ(table.GetNumFrames(), 4);
+  EXPECT_TRUE(table.Contains(id_1));
+  EXPECT_EQ(table.GetIndex(id_1), 1);
+
+  CallstackView callstack = table.Find(id_0);
+  ASSERT_TRUE(callstack);
+  EXPECT_EQ(callstack.Hash(), id_0);
+  EXPECT_EQ(callstack.Depth(), 3);
+  EXPECT_EQ(std::vector<uint64_t>(callstack.begin(), callstack.end()),
+            frames_0);
+  // The frames were copied.
+  EXPECT_NE(callstack.Data(), frames_0.data());
+
+  table.Clear();
+  EXPECT_EQ(table.Size(), 0);
+  EXPECT_FALSE(table.Contains(id_0));
+}
+
+TEST(CallstackInternTable, EmptyCallstack) {
+  CallstackInternTable table;
+  CallstackID id = ComputeCallstackHash(nullptr, 0);
+  EXPECT_EQ(table.Intern(id, nullptr, 0), 0);
+
+  CallstackView callstack = table.Get(0);
+  EXPECT_TRUE(callstack);
+  EXPECT_EQ(callstack.Depth(), 0);
+  EXPECT_EQ(callstack.begin(), callstack.end());
+}
+
+TEST(CallstackInternTable, ViewsStayValid) {
+  CallstackInternTable table;
+  std::vector<uint64_t> first_frames = {1, 2, 3, 4};
+  table.Intern(ComputeCallstackHash(first_frames.data(), first_frames.size()),
+               first_frames.data(), first_frames.size());
+  CallstackView first_callstack = table.Get(0);
+
+  // Enough frames to need several arena blocks, including a callstack
+  // larger than a block.
+  std::vector<uint64_t> frames(3 * 1024 * 1024);
+  for (uint64_t i = 0; i < 1024; ++i) {
+    frames[0] = i;
+    uint32_t depth = 4 * 1024;
+    table.Intern(ComputeCallstackHash(frames.data(), depth), frames.data(),
+                 depth);
+  }
+  frames[0] = 1024;
+  table.Intern(ComputeCallstackHash(frames.data(), frames.size()),
+               frames.data(), frames.size());
+
+  EXPECT_EQ(table.Size(), 1026);
+  EXPECT_EQ(first_callstack.Data(), table.Get(0).Data());
+  EXPECT_EQ(std::vector<uint64_t>(first_callstack.begin(),
+                                  first_callstack.end()),
+            first_frames);
+  EXPECT_EQ(table.Get(1000)[0], 999);
+  EXPECT_EQ(table.Get(1025).Depth(), frames.size());
+  EXPECT_EQ(table.Get(1025)[0], 1024);
+}
@@ -0,0 +1,188 @@
+#include "CallstackWireFormat.h"
+
+#include <cstring>
+
+namespace {
+// Increment when changing the layout.
+constexpr uint32_t WIRE_FORMAT_VERSION = 1;
+
+struct Header {
+  uint32_t version;
+  uint32_t num_events;
+  uint64_t num_frames;
+};
+static_assert(sizeof(Header) == 16);
+
+constexpr size_t GetEncodedSize(size_t num_events, size_t num_frames,
+                                bool has_frames) {
+  return sizeof(Header) + num_events * 2 * sizeof(uint64_t) +
+         num_frames * sizeof(uint64_t) + num_events * sizeof(uint32_t) +
+         (has_frames ? num_events * sizeof(uint32_t) : 0);
+}
+
+class ColumnWriter {
+ public:
+  explicit ColumnWriter(char* buffer) : buffer_(buffer) {}
+
+  template <typename T>
+  void Write(T value) {
+    memcpy(buffer_, &value, sizeof(T));
+    buffer_ += sizeof(T);
+  }
+
+  void WriteArray(const uint64_t* values, size_t count) {
+    memcpy(buffer_, values, count * sizeof(uint64_t));
+    buffer_ += count * sizeof(uint64_t);
+  }
+
+ private:
+  char* buffer_;
+};
+
+template <typename T>
+T ReadAt(const char* column, size_t index) {
+  T value;
+  memcpy(&value, column + index * sizeof(T), sizeof(T));
+  return value;
+}
+
+// Reads the header of data and checks that the size of data matches it.
+bool ReadHeader(const char* data, size_t size, bool has_frames,
+                Header* header) {
+  if (size < sizeof(Header)) {
+    return false;
+  }
+  memcpy(header, data, sizeof(Header));
+  if (header->version != WIRE_FORMAT_VERSION) {
+    return false;
+  }
+  if (!has_frames && header->num_frames != 0) {
+    return false;
+  }
+  // Check the number of frames on its own first, as a corrupted value could
+  // overflow the computation of the size.
+  if (header->num_frames > size / sizeof(uint64_t)) {
+    return false;
+  }
+  return size ==
+         GetEncodedSize(header->num_events, header->num_frames, has_frames);
+}
+}  // namespace
+
+size_t GetEncodedCallstacksSize(
+    const std::vector<LinuxCallstackEvent>& events) {
+  size_t num_frames = 0;
+  for (const LinuxCallstackEvent& event : events) {
+    num_frames += event.m_CS.m_Data.size();
+  }
+  return GetEncodedSize(events.size(), num_frames, true);
+}
+
+void EncodeCallstacks(const std::vector<LinuxCallstackEvent>& events,
+                      char* buffer) {
+  size_t num_frames = 0;
+  for (const LinuxCallstackEvent& event : events) {
+    num_frames += event.m_CS.m_Data.size();
+  }
+
+  ColumnWriter writer(buffer);
+  writer.Write(Header{WIRE_FORMAT_VERSION,
+                      static_cast<uint32_t>(events.size()), num_frames});
+  for (const LinuxCallstackEvent& event : events) {
+    writer.Write<uint64_t>(event.m_time);
+  }
+  for (const LinuxCallstackEvent& event : events) {
+    writer.Write<uint64_t>(event.m_CS.m_Hash);
+  }
+  for (const LinuxCallstackEvent& event : events) {
+    writer.WriteArray(event.m_CS.m_Data.data(), event.m_CS.m_Data.size());
+  }
+  for (const LinuxCallstackEvent& event : events) {
+    writer.Write<uint32_t>(event.m_CS.m_ThreadId);
+  }
+  for (const LinuxCallstackEvent& event : events) {
+    writer.Write<uint32_t>(event.m_CS.m_Data.size());
+  }
+}
+
+bool DecodeCallstacks(
+    const char* data, size_t size,
+    const std::function<void(LinuxCallstackEvent&)>& callback) {
+  Header header;
+  if (!ReadHeader(data, size, true, &header)) {
+    return false;
+  }
+  const size_t num_events = header.num_events;
+  const char* times = data + sizeof(Header);
+  const char* ids = times + num_events * sizeof(uint64_t);
+  const char* frames = ids + num_events * sizeof(uint64_t);
+  const char* tids = frames + header.num_frames * sizeof(uint64_t);
+  const char* depths = tids + num_events * sizeof(uint32_t);
+
+  // The depths need to add up to the number of frames before any event is
+  // passed on.
+  uint64_t total_depth = 0;
+  for (size_t i = 0; i < num_events; ++i) {
+    total_depth += ReadAt<uint32_t>(depths, i);
+  }
+  if (total_depth != header.num_frames) {
+    return false;
+  }
+
+  LinuxCallstackEvent event;
+  size_t frame_index = 0;
+  for (size_t i = 0; i < num_events; ++i) {
+    const uint32_t depth = ReadAt<uint32_t>(depths, i);
+    event.m_time = ReadAt<uint64_t>(times, i);
+    event.m_CS.m_Hash = ReadAt<uint64_t>(ids, i);
+    event.m_CS.m_ThreadId = ReadAt<uint32_t>(tids, i);
+    event.m_CS.m_Depth = depth;
+    event.m_CS.m_Data.resize(depth);
+    memcpy(event.m_CS.m_Data.data(),
+           frames + frame_index * sizeof(uint64_t), depth * sizeof(uint64_t));
+    frame_index += depth;
+    callback(event);
+  }
+  return true;
+}
+
+size_t GetEncodedHashedCallstacksSize(
+    const std::vector<CallstackEvent>& events) {
+  return GetEncodedSize(events.size(), 0, false);
+}
+
+void EncodeHashedCallstacks(const std::vector<CallstackEvent>& events,
+                            char* buffer) {
+  ColumnWriter writer(buffer);
+  writer.Write(
+      Header{WIRE_FORMAT_VERSION, static_cast<uint32_t>(events.size()), 0});
+  for (const CallstackEvent& event : events) {
+    writer.Write<uint64_t>(event.m_Time);
+  }
+  for (const CallstackEvent& event : events) {
+    writer.Write<uint64_t>(event.m_Id);
+  }
+  for (const CallstackEvent& event : events) {
+    writer.Write<uint32_t>(event.m_TID);
+  }
+}
+
+bool DecodeHashedCallstacks(
+    const char* data, size_t size,
+    const std::function<void(CallstackEvent&)>& callback) {
+  Header header;
+  if (!ReadHeader(data, size, false, &header)) {
+    return false;
+  }
+  const size_t num_events = header.num_events;
+  const char* times = data + sizeof(Header);
+  const char* ids = times + num_events * sizeof(uint64_t);
+  const char* tids = ids + num_events * sizeof(uint64_t);
+
+  for (size_t i = 0; i < num_events; ++i) {
+    CallstackEvent event(ReadAt<uint64_t>(times, i), ReadAt<uint64_t>(ids, i),
+                         ReadAt<uint32_t>(tids, i));
+    callback(event);
+  }
+  return true;
+}
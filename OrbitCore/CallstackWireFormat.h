@@ -0,0 +1,55 @@
+#ifndef ORBIT_CORE_CALLSTACK_WIRE_FORMAT_H_
+#define ORBIT_CORE_CALLSTACK_WIRE_FORMAT_H_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "EventBuffer.h"
+#include "LinuxCallstackEvent.h"
+
+// Binary encoding of the sampled callstacks sent from the service to the
+// client in Msg_SamplingCallstacks and Msg_SamplingHashedCallstacks messages.
+//
+// The events are stored column by column behind a fixed-size header, so that
+// the service can write them directly into the payload of the outgoing packet
+// and the client can read them directly from the payload of the received
+// message, without going through intermediate streams or per-event
+// allocations. All values are in the byte order of the host, as both ends of
+// the connection are x86_64. The 64-bit columns come first so that they are
+// aligned when the payload is.
+//
+// Layout of a message with n events and f frames in total:
+//   uint32_t version
+//   uint32_t n
+//   uint64_t f
+//   uint64_t time[n]
+//   uint64_t callstack_id[n]
+//   uint64_t frames[f]      (Msg_SamplingCallstacks only)
+//   uint32_t tid[n]
+//   uint32_t depth[n]       (Msg_SamplingCallstacks only)
+//
+// Only the fields of LinuxCallstackEvent used by the client are transferred:
+// m_header and m_numCallstacks are not.
+
+size_t GetEncodedCallstacksSize(const std::vector<LinuxCallstackEvent>& events);
+// buffer must hold GetEncodedCallstacksSize(events) bytes.
+void EncodeCallstacks(const std::vector<LinuxCallstackEvent>& events,
+                      char* buffer);
+// Calls callback for each event encoded in data, reusing the same
+// LinuxCallstackEvent. Returns false, without calling callback, if data is not
+// a valid encoding.
+bool DecodeCallstacks(
+    const char* data, size_t size,
+    const std::function<void(LinuxCallstackEvent&)>& callback);
+
+size_t GetEncodedHashedCallstacksSize(
+    const std::vector<CallstackEvent>& events);
+// buffer must hold GetEncodedHashedCallstacksSize(events) bytes.
+void EncodeHashedCallstacks(const std::vector<CallstackEvent>& events,
+                            char* buffer);
+bool DecodeHashedCallstacks(
+    const char* data, size_t size,
+    const std::function<void(CallstackEvent&)>& callback);
+
+#endif  // ORBIT_CORE_CALLSTACK_WIRE_FORMAT_H_
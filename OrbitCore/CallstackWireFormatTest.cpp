@@ -0,0 +1,101 @@
+#include "CallstackWireFormat.h"
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace {
+LinuxCallstackEvent MakeCallstackEvent(uint64_t time, ThreadID tid,
+                                       std::vector<uint64_t> frames) {
+  LinuxCallstackEvent event;
+  event.m_time = time;
+  event.m_CS.m_Data = std::move(frames);
+  event.m_CS.m_Depth = event.m_CS.m_Data.size();
+  event.m_CS.m_ThreadId = tid;
+  event.m_CS.Hash();
+  return event;
+}
+}  // namespace
+
+TEST(CallstackWireFormat, Callstacks) {
+  std::vector<LinuxCallstackEvent> events;
+  events.push_back(MakeCallstackEvent(11, 1, {0x10, 0x20, 0x30}));
+  events.push_back(MakeCallstackEvent(12, 2, {}));
+  events.push_back(MakeCallstackEvent(13, 1, {0x40}));
+
+  std::vector<char> buffer(GetEncodedCallstacksSize(events));
+  EncodeCallstacks(events, buffer.data());
+
+  std::vector<LinuxCallstackEvent> decoded_events;
+  EXPECT_TRUE(DecodeCallstacks(
+      buffer.data(), buffer.size(),
+      [&](LinuxCallstackEvent& event) { decoded_events.push_back(event); }));
+
+  ASSERT_EQ(decoded_events.size(), events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(decoded_events[i].m_time, events[i].m_time);
+    EXPECT_EQ(decoded_events[i].m_CS.m_Hash, events[i].m_CS.m_Hash);
+    EXPECT_EQ(decoded_events[i].m_CS.m_ThreadId, events[i].m_CS.m_ThreadId);
+    EXPECT_EQ(decoded_events[i].m_CS.m_Depth, events[i].m_CS.m_Depth);
+    EXPECT_EQ(decoded_events[i].m_CS.m_Data, events[i].m_CS.m_Data);
+  }
+}
+
+TEST(CallstackWireFormat, HashedCallstacks) {
+  std::vector<CallstackEvent> events;
+  events.emplace_back(21, 0x1234, 1);
+  events.emplace_back(22, 0x5678, 2);
+
+  std::vector<char> buffer(GetEncodedHashedCallstacksSize(events));
+  EncodeHashedCallstacks(events, buffer.data());
+
+  std::vector<CallstackEvent> decoded_events;
+  EXPECT_TRUE(DecodeHashedCallstacks(
+      buffer.data(), buffer.size(),
+      [&](CallstackEvent& event) { decoded_events.push_back(event); }));
+
+  ASSERT_EQ(decoded_events.size(), 2);
+  EXPECT_EQ(decoded_events[0].m_Time, 21);
+  EXPECT_EQ(decoded_events[0].m_Id, 0x1234);
+  EXPECT_EQ(decoded_events[0].m_TID, 1);
+  EXPECT_EQ(decoded_events[1].m_Time, 22);
+  EXPECT_EQ(decoded_events[1].m_Id, 0x5678);
+  EXPECT_EQ(decoded_events[1].m_TID, 2);
+}
+
+TEST(CallstackWireFormat, RejectsInvalidData) {
+  std::vector<LinuxCallstackEvent> events;
+  events.push_back(MakeCallstackEvent(11, 1, {0x10, 0x20}));
+  std::vector<char> buffer(GetEncodedCallstacksSize(events));
+  EncodeCallstacks(events, buffer.data());
+
+  int num_decoded_events = 0;
+  auto count_events = [&](LinuxCallstackEvent&) { ++num_decoded_events; };
+
+  // Truncated.
+  EXPECT_FALSE(
+      DecodeCallstacks(buffer.data(), buffer.size() - 1, count_events));
+  EXPECT_FALSE(DecodeCallstacks(buffer.data(), 4, count_events));
+
+  // Depths not adding up to the number of frames.
+  std::vector<char> wrong_depth = buffer;
+  uint32_t depth = 3;
+  memcpy(wrong_depth.data() + wrong_depth.size() - sizeof(depth), &depth,
+         sizeof(depth));
+  EXPECT_FALSE(
+      DecodeCallstacks(wrong_depth.data(), wrong_depth.size(), count_events));
+
+  // Unknown version.
+  std::vector<char> wrong_version = buffer;
+  uint32_t version = 0;
+  memcpy(wrong_version.data(), &version, sizeof(version));
+  EXPECT_FALSE(DecodeCallstacks(wrong_version.data(), wrong_version.size(),
+                                count_events));
+
+  // Full callstacks decoded as hashed callstacks.
+  EXPECT_FALSE(DecodeHashedCallstacks(buffer.data(), buffer.size(),
+                                      [](CallstackEvent&) {}));
+
+  EXPECT_EQ(num_decoded_events, 0);
+}
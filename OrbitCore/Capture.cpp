@@ -74,6 +74,11 @@ std::shared_ptr<Session> Capture::GSessionPresets = nullptr;
 
 void (*Capture::GClearCaptureDataFunc)();
 std::vector<std::shared_ptr<SamplingProfiler> > GOldSamplingProfilers;
+Timer GLiveSamplingReportTimer;
+// Report version last seen and number of threads of the last report created
+// while sampling.
+uint32_t GLiveSamplingReportVersion = 0;
+size_t GLiveSamplingReportNumThreads = 0;
 bool Capture::GUnrealSupported = false;
 
 // The user_data pointer is provided by caller when registering capture
@@ -141,6 +146,8 @@ void Capture::SetTargetProcess(const std::shared_ptr<Process>& a_Process) {
 
     GTargetProcess = a_Process;
     GSamplingProfiler = std::make_shared<SamplingProfiler>(a_Process);
+    GLiveSamplingReportVersion = 0;
+    GLiveSamplingReportNumThreads = 0;
     GSelectedFunctionsMap.clear();
     GSessionPresets = nullptr;
     GOrbitUnreal.Clear();
@@ -323,6 +330,7 @@ void Capture::SendFunctionHooks() {
                      (void*)selectedFunctionsData.data(),
                      selectedFunctionsData.size());
 
+    GTcpClient->Send(Msg_RequestCompressedEvents);
     Message msg(Msg_StartCapture);
     msg.m_Header.m_GenericHeader.m_Address = GTargetProcess->GetID();
     GTcpClient->Send(msg);
@@ -432,6 +440,30 @@ void Capture::Update() {
     }
 #endif
 
+    if (GSamplingProfiler->GetState() == SamplingProfiler::Sampling &&
+        GParams.m_LiveSamplingReportPeriodMs > 0 &&
+        GLiveSamplingReportTimer.QueryMillis() >
+            GParams.m_LiveSamplingReportPeriodMs) {
+      GLiveSamplingReportTimer.Start();
+      GSamplingProfiler->UpdateReportAsync();
+    }
+
+    // The data views of a report refresh themselves when the profiler's
+    // report version changes, a new report is only needed for the tabs of new
+    // threads. The number of threads is only read after an update, as reading
+    // it waits for the update to finish.
+    if (GSamplingProfiler->GetState() == SamplingProfiler::Sampling &&
+        GSamplingProfiler->GetReportVersion() != GLiveSamplingReportVersion) {
+      GLiveSamplingReportVersion = GSamplingProfiler->GetReportVersion();
+      size_t numThreads = GSamplingProfiler->GetNumThreadSampleData();
+      if (numThreads != GLiveSamplingReportNumThreads &&
+          sampling_done_callback_ != nullptr) {
+        GLiveSamplingReportNumThreads = numThreads;
+        sampling_done_callback_(GSamplingProfiler,
+                                sampling_done_callback_user_data_);
+      }
+    }
+
     if (GSamplingProfiler->GetState() == SamplingProfiler::DoneProcessing) {
       if (sampling_done_callback_ != nullptr) {
         sampling_done_callback_(GSamplingProfiler,
@@ -543,6 +575,10 @@ void Capture::NewSamplingProfiler() {
 
   Capture::GSamplingProfiler =
       std::make_shared<SamplingProfiler>(Capture::GTargetProcess, true);
+  Capture::GSamplingProfiler->SetSlidingWindow(
+      GParams.m_SamplingReportWindowSeconds);
+  GLiveSamplingReportVersion = 0;
+  GLiveSamplingReportNumThreads = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -4,14 +4,16 @@
 
 #include "ConnectionManager.h"
 
+#include "CallstackWireFormat.h"
 #include "Capture.h"
 #include "ContextSwitch.h"
 #include "CoreApp.h"
+#include "DeltaEncoding.h"
 #include "EventBuffer.h"
 #include "Introspection.h"
 #include "KeyAndString.h"
 #include "LinuxCallstackEvent.h"
-#include "LinuxSymbol.h"
+#include "LinuxSymbolBatch.h"
 #include "OrbitBase/Tracing.h"
 #include "OrbitFunction.h"
 #include "OrbitModule.h"
@@ -23,6 +25,7 @@
 #include "TcpServer.h"
 #include "TestRemoteMessages.h"
 #include "TimerManager.h"
+#include "absl/strings/str_format.h"
 
 #if __linux__
 #include "LinuxUtils.h"
@@ -116,37 +119,101 @@ void ConnectionManager::SetSelectedFunctionsOnRemote(const Message& a_Msg) {
 }
 
 void ConnectionManager::ServerCaptureThreadWorker() {
+  // Reused across batches to avoid reallocating it.
+  std::string encoding_buffer;
+  const absl::Duration max_latency =
+      absl::Milliseconds(GParams.m_EventBatchMaxLatencyMs);
   while (Capture::IsCapturing()) {
-    OrbitSleepMs(20);
+    tracing_session_.WaitForBatch(max_latency);
+    SendBufferedEvents(&encoding_buffer);
+  }
+  // Tracing has stopped, send what was recorded since the last batch.
+  SendBufferedEvents(&encoding_buffer);
+}
 
-    std::vector<Timer> timers;
-    if (tracing_session_.ReadAllTimers(&timers)) {
+void ConnectionManager::SendBufferedEvents(std::string* encoding_buffer) {
+  std::vector<Timer> timers;
+  if (tracing_session_.ReadAllTimers(&timers)) {
+    if (send_compressed_events_) {
+      SendCompressedEvents(Msg_RemoteTimersCompressed, &timers, &EncodeTimers,
+                           encoding_buffer);
+    } else {
       Message Msg(Msg_RemoteTimers);
       GTcpServer->Send(Msg, timers);
+      GTcpServer->AddEncodingStats(timers.size(),
+                                   timers.size() * sizeof(Timer),
+                                   timers.size() * sizeof(Timer), 0);
     }
+  }
 
-    std::vector<LinuxCallstackEvent> callstacks;
-    if (tracing_session_.ReadAllCallstacks(&callstacks)) {
-      std::string message_data = SerializeObjectBinary(callstacks);
-      GTcpServer->Send(Msg_SamplingCallstacks, message_data.c_str(),
-                       message_data.size());
-    }
+  // The symbols of a callstack are recorded before the callstack, so reading
+  // the symbols after the callstacks gets those of every callstack read.
+  std::vector<LinuxCallstackEvent> callstacks;
+  bool has_callstacks = tracing_session_.ReadAllCallstacks(&callstacks);
+  std::vector<CallstackEvent> hashed_callstacks;
+  bool has_hashed_callstacks =
+      tracing_session_.ReadAllHashedCallstacks(&hashed_callstacks);
+  LinuxSymbolBatch symbols;
+
+  // Symbols are sent first, so that the client knows them when it receives
+  // the callstacks they were found in.
+  if (tracing_session_.ReadAllSymbols(&symbols)) {
+    Message msg(Msg_RemoteSymbols,
+                static_cast<uint32_t>(symbols.GetEncodedSize()));
+    TcpPacket packet(msg, nullptr);
+    symbols.Encode(packet.GetPayload());
+    GTcpServer->SendPacket(std::move(packet));
+  }
 
-    std::vector<CallstackEvent> hashed_callstacks;
-    if (tracing_session_.ReadAllHashedCallstacks(&hashed_callstacks)) {
-      std::string message_data = SerializeObjectBinary(hashed_callstacks);
-      GTcpServer->Send(Msg_SamplingHashedCallstacks, message_data.c_str(),
-                       message_data.size());
-    }
+  if (has_callstacks) {
+    Message msg(Msg_SamplingCallstacks,
+                static_cast<uint32_t>(GetEncodedCallstacksSize(callstacks)));
+    TcpPacket packet(msg, nullptr);
+    EncodeCallstacks(callstacks, packet.GetPayload());
+    GTcpServer->SendPacket(std::move(packet));
+  }
+
+  if (has_hashed_callstacks) {
+    Message msg(Msg_SamplingHashedCallstacks,
+                static_cast<uint32_t>(
+                    GetEncodedHashedCallstacksSize(hashed_callstacks)));
+    TcpPacket packet(msg, nullptr);
+    EncodeHashedCallstacks(hashed_callstacks, packet.GetPayload());
+    GTcpServer->SendPacket(std::move(packet));
+  }
 
-    std::vector<ContextSwitch> context_switches;
-    if (tracing_session_.ReadAllContextSwitches(&context_switches)) {
+  std::vector<ContextSwitch> context_switches;
+  if (tracing_session_.ReadAllContextSwitches(&context_switches)) {
+    if (send_compressed_events_) {
+      SendCompressedEvents(Msg_RemoteContextSwitchesCompressed,
+                           &context_switches, &EncodeContextSwitches,
+                           encoding_buffer);
+    } else {
       Message Msg(Msg_RemoteContextSwitches);
       GTcpServer->Send(Msg, context_switches);
+      GTcpServer->AddEncodingStats(
+          context_switches.size(),
+          context_switches.size() * sizeof(ContextSwitch),
+          context_switches.size() * sizeof(ContextSwitch), 0);
     }
   }
 }
 
+template <typename T>
+void ConnectionManager::SendCompressedEvents(
+    MessageType type, std::vector<T>* events,
+    void (*encode)(std::vector<T>*, std::string*), std::string* buffer) {
+  double encoding_millis = 0;
+  buffer->clear();
+  {
+    LocalScopeTimer timer(&encoding_millis);
+    encode(events, buffer);
+  }
+  GTcpServer->Send(type, buffer->data(), buffer->size());
+  GTcpServer->AddEncodingStats(events->size(), events->size() * sizeof(T),
+                               buffer->size(), encoding_millis);
+}
+
 void ConnectionManager::SetupIntrospection() {
 #if __linux__ && ORBIT_TRACING_ENABLED
   // Setup introspection handler.
@@ -165,6 +232,8 @@ void ConnectionManager::StartCaptureAsRemote(uint32_t pid) {
   }
   Capture::SetTargetProcess(process);
   tracing_session_.Reset();
+  tracing_session_.SetBatchLimits(GParams.m_EventBatchMaxNumEvents,
+                                  GParams.m_EventBatchMaxNumBytes);
   Capture::StartCapture(&tracing_session_);
   server_capture_thread_ = std::make_unique<std::thread>(
       &ConnectionManager::ServerCaptureThreadWorker, this);
@@ -178,6 +247,9 @@ void ConnectionManager::StopCaptureAsRemote() {
   Capture::StopCapture();
   server_capture_thread_->join();
   server_capture_thread_ = nullptr;
+  // The next capture could be started by another client, which might not
+  // understand compressed events.
+  send_compressed_events_ = false;
 }
 
 void ConnectionManager::Stop() { exit_requested_ = true; }
@@ -197,6 +269,12 @@ void ConnectionManager::SetupServerCallbacks() {
   GTcpServer->AddMainThreadCallback(
       Msg_StopCapture, [this](const Message&) { StopCaptureAsRemote(); });
 
+  // Clients that don't send this before Msg_StartCapture receive timers and
+  // context switches as they are.
+  GTcpServer->AddMainThreadCallback(
+      Msg_RequestCompressedEvents,
+      [this](const Message&) { send_compressed_events_ = true; });
+
   GTcpServer->AddMainThreadCallback(
       Msg_RemoteProcessRequest, [this](const Message& msg) {
         uint32_t pid =
@@ -273,6 +351,18 @@ void ConnectionManager::SetupClientCallbacks() {
     }
   });
 
+  GTcpClient->AddCallback(
+      Msg_RemoteTimersCompressed, [=](const Message& a_Msg) {
+        std::vector<Timer> timers;
+        if (!DecodeTimers(a_Msg.GetData(), a_Msg.m_Size, &timers)) {
+          PRINT("Received invalid Msg_RemoteTimersCompressed message\n");
+          return;
+        }
+        for (const Timer& timer : timers) {
+          GTimerManager->Add(timer);
+        }
+      });
+
   GTcpClient->AddCallback(Msg_KeyAndString, [=](const Message& a_Msg) {
     KeyAndString key_and_string;
     std::istringstream buffer(std::string(a_Msg.m_Data, a_Msg.m_Size));
@@ -290,13 +380,17 @@ void ConnectionManager::SetupClientCallbacks() {
     GCoreApp->ProcessCallStack(stack);
   });
 
-  GTcpClient->AddCallback(Msg_RemoteSymbol, [=](const Message& a_Msg) {
-    LinuxSymbol symbol;
-    std::istringstream buffer(std::string(a_Msg.m_Data, a_Msg.m_Size));
-    cereal::BinaryInputArchive inputAr(buffer);
-    inputAr(symbol);
-
-    GCoreApp->AddSymbol(symbol.m_Address, symbol.m_Module, symbol.m_Name);
+  GTcpClient->AddCallback(Msg_RemoteSymbols, [=](const Message& a_Msg) {
+    if (!LinuxSymbolBatch::Decode(
+            a_Msg.GetData(), a_Msg.m_Size,
+            [](uint64_t address, std::string_view module,
+               std::string_view function_name, uint64_t offset) {
+              GCoreApp->AddSymbol(
+                  address, std::string(module),
+                  absl::StrFormat("%s+%#x", function_name, offset));
+            })) {
+      PRINT("Received invalid Msg_RemoteSymbols message\n");
+    }
   });
 
   GTcpClient->AddCallback(Msg_RemoteContextSwitches, [=](const Message& a_Msg) {
@@ -308,30 +402,38 @@ void ConnectionManager::SetupClientCallbacks() {
     }
   });
 
-  GTcpClient->AddCallback(Msg_SamplingCallstacks, [=](const Message& a_Msg) {
-    const char* a_Data = a_Msg.GetData();
-    size_t a_Size = a_Msg.m_Size;
-    std::istringstream buffer(std::string(a_Data, a_Size));
-    cereal::BinaryInputArchive inputAr(buffer);
-    std::vector<LinuxCallstackEvent> call_stacks;
-    inputAr(call_stacks);
+  GTcpClient->AddCallback(
+      Msg_RemoteContextSwitchesCompressed, [=](const Message& a_Msg) {
+        std::vector<ContextSwitch> context_switches;
+        if (!DecodeContextSwitches(a_Msg.GetData(), a_Msg.m_Size,
+                                   &context_switches)) {
+          PRINT(
+              "Received invalid Msg_RemoteContextSwitchesCompressed "
+              "message\n");
+          return;
+        }
+        for (const ContextSwitch& context_switch : context_switches) {
+          GCoreApp->ProcessContextSwitch(context_switch);
+        }
+      });
 
-    for (auto& cs : call_stacks) {
-      GCoreApp->ProcessSamplingCallStack(cs);
+  GTcpClient->AddCallback(Msg_SamplingCallstacks, [=](const Message& a_Msg) {
+    if (!DecodeCallstacks(a_Msg.GetData(), a_Msg.m_Size,
+                          [](LinuxCallstackEvent& cs) {
+                            GCoreApp->ProcessSamplingCallStack(cs);
+                          })) {
+      PRINT("Received invalid Msg_SamplingCallstacks message\n");
     }
   });
 
   GTcpClient->AddCallback(
       Msg_SamplingHashedCallstacks, [=](const Message& a_Msg) {
-        const char* a_Data = a_Msg.GetData();
-        size_t a_Size = a_Msg.m_Size;
-        std::istringstream buffer(std::string(a_Data, a_Size));
-        cereal::BinaryInputArchive inputAr(buffer);
-        std::vector<CallstackEvent> call_stacks;
-        inputAr(call_stacks);
-
-        for (auto& cs : call_stacks) {
-          GCoreApp->ProcessHashedSamplingCallStack(cs);
+        if (!DecodeHashedCallstacks(a_Msg.GetData(), a_Msg.m_Size,
+                                    [](CallstackEvent& cs) {
+                                      GCoreApp->ProcessHashedSamplingCallStack(
+                                          cs);
+                                    })) {
+          PRINT("Received invalid Msg_SamplingHashedCallstacks message\n");
         }
       });
 }
@@ -35,6 +35,12 @@ class ConnectionManager {
   void ConnectionThreadWorker();
   void RemoteThreadWorker();
   void ServerCaptureThreadWorker();
+  // Reads all events buffered by the tracing session and sends them.
+  void SendBufferedEvents(std::string* encoding_buffer);
+  template <typename T>
+  void SendCompressedEvents(MessageType type, std::vector<T>* events,
+                            void (*encode)(std::vector<T>*, std::string*),
+                            std::string* buffer);
 
   void StopThread();
   void SetupClientCallbacks();
@@ -52,4 +58,6 @@ class ConnectionManager {
   std::string remote_address_;
   std::atomic<bool> exit_requested_;
   bool is_service_;
+  // Requested by the client before each capture, reset when it stops.
+  std::atomic<bool> send_compressed_events_{false};
 };
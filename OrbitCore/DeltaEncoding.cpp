@@ -0,0 +1,286 @@
+#include "DeltaEncoding.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Increment when changing the encoding.
+constexpr uint64_t ENCODING_VERSION = 1;
+
+// Bits of the flags of an encoded timer, telling which of the usually zero
+// fields follow.
+constexpr uint8_t HAS_CALLSTACK_HASH = 1 << 0;
+constexpr uint8_t HAS_USER_DATA_0 = 1 << 1;
+constexpr uint8_t HAS_USER_DATA_1 = 1 << 2;
+
+// Maps small negative and positive differences to small unsigned values.
+uint64_t EncodeDelta(uint64_t value, uint64_t previous_value) {
+  auto delta = static_cast<int64_t>(value - previous_value);
+  return (static_cast<uint64_t>(delta) << 1) ^
+         static_cast<uint64_t>(delta >> 63);
+}
+
+uint64_t DecodeDelta(uint64_t encoded_delta, uint64_t previous_value) {
+  uint64_t delta = (encoded_delta >> 1) ^ (~(encoded_delta & 1) + 1);
+  return previous_value + delta;
+}
+
+void WriteVarint(uint64_t value, std::string* buffer) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+void WriteByte(uint8_t value, std::string* buffer) {
+  buffer->push_back(static_cast<char>(value));
+}
+
+void WriteFixed64(uint64_t value, std::string* buffer) {
+  char bytes[sizeof(value)];
+  memcpy(bytes, &value, sizeof(value));
+  buffer->append(bytes, sizeof(bytes));
+}
+
+class Reader {
+ public:
+  Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  bool ReadVarint(uint64_t* value) {
+    uint64_t result = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+      if (position_ == size_) {
+        return false;
+      }
+      auto byte = static_cast<uint8_t>(data_[position_++]);
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadByte(uint8_t* value) {
+    if (position_ == size_) {
+      return false;
+    }
+    *value = static_cast<uint8_t>(data_[position_++]);
+    return true;
+  }
+
+  bool ReadFixed64(uint64_t* value) {
+    if (size_ - position_ < sizeof(*value)) {
+      return false;
+    }
+    memcpy(value, data_ + position_, sizeof(*value));
+    position_ += sizeof(*value);
+    return true;
+  }
+
+  size_t GetRemainingSize() const { return size_ - position_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+// Groups events by the value of get_key, keeping the relative order of the
+// events of each group, and calls encode_group for the range of each group.
+template <typename T, typename GetKey, typename EncodeGroup>
+void EncodeGroups(std::vector<T>* events, GetKey get_key,
+                  EncodeGroup encode_group, std::string* buffer) {
+  std::stable_sort(events->begin(), events->end(),
+                   [&get_key](const T& lhs, const T& rhs) {
+                     return get_key(lhs) < get_key(rhs);
+                   });
+
+  uint64_t num_groups = 0;
+  for (size_t i = 0; i < events->size(); ++i) {
+    if (i == 0 || get_key((*events)[i]) != get_key((*events)[i - 1])) {
+      ++num_groups;
+    }
+  }
+
+  WriteVarint(ENCODING_VERSION, buffer);
+  WriteVarint(num_groups, buffer);
+  auto group_begin = events->begin();
+  while (group_begin != events->end()) {
+    auto group_end = std::find_if(
+        group_begin, events->end(), [&](const T& event) {
+          return get_key(event) != get_key(*group_begin);
+        });
+    WriteVarint(get_key(*group_begin), buffer);
+    WriteVarint(static_cast<uint64_t>(group_end - group_begin), buffer);
+    encode_group(group_begin, group_end);
+    group_begin = group_end;
+  }
+}
+
+// Reads the header and the groups, calling decode_group with the key and the
+// number of events of each group.
+template <typename DecodeGroup>
+bool DecodeGroups(Reader* reader, DecodeGroup decode_group) {
+  uint64_t version;
+  uint64_t num_groups;
+  if (!reader->ReadVarint(&version) || version != ENCODING_VERSION ||
+      !reader->ReadVarint(&num_groups)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < num_groups; ++i) {
+    uint64_t key;
+    uint64_t num_events;
+    // Every event takes at least one byte, which also prevents a corrupted
+    // number of events from leading to a huge allocation.
+    if (!reader->ReadVarint(&key) || !reader->ReadVarint(&num_events) ||
+        num_events > reader->GetRemainingSize() ||
+        !decode_group(key, num_events)) {
+      return false;
+    }
+  }
+  return reader->GetRemainingSize() == 0;
+}
+}  // namespace
+
+void EncodeTimers(std::vector<Timer>* timers, std::string* buffer) {
+  auto encode_group = [buffer](std::vector<Timer>::const_iterator begin,
+                               std::vector<Timer>::const_iterator end) {
+    uint64_t previous_start = 0;
+    uint64_t previous_function_address = 0;
+    for (auto it = begin; it != end; ++it) {
+      const Timer& timer = *it;
+      uint8_t flags = 0;
+      if (timer.m_CallstackHash != 0) flags |= HAS_CALLSTACK_HASH;
+      if (timer.m_UserData[0] != 0) flags |= HAS_USER_DATA_0;
+      if (timer.m_UserData[1] != 0) flags |= HAS_USER_DATA_1;
+      WriteByte(flags, buffer);
+      WriteByte(timer.m_Depth, buffer);
+      WriteByte(timer.m_SessionID, buffer);
+      WriteByte(timer.m_Type, buffer);
+      WriteByte(timer.m_Processor, buffer);
+      // Hashes don't compress, unlike the other fields.
+      if (flags & HAS_CALLSTACK_HASH) {
+        WriteFixed64(timer.m_CallstackHash, buffer);
+      }
+      if (flags & HAS_USER_DATA_0) WriteVarint(timer.m_UserData[0], buffer);
+      if (flags & HAS_USER_DATA_1) WriteVarint(timer.m_UserData[1], buffer);
+      WriteVarint(
+          EncodeDelta(timer.m_FunctionAddress, previous_function_address),
+          buffer);
+      WriteVarint(EncodeDelta(timer.m_Start, previous_start), buffer);
+      WriteVarint(EncodeDelta(timer.m_End, timer.m_Start), buffer);
+      previous_function_address = timer.m_FunctionAddress;
+      previous_start = timer.m_Start;
+    }
+  };
+  EncodeGroups(
+      timers, [](const Timer& timer) { return timer.m_TID; }, encode_group,
+      buffer);
+}
+
+bool DecodeTimers(const char* data, size_t size, std::vector<Timer>* timers) {
+  Reader reader(data, size);
+  auto decode_group = [&reader, timers](uint64_t tid, uint64_t num_timers) {
+    uint64_t previous_start = 0;
+    uint64_t previous_function_address = 0;
+    for (uint64_t i = 0; i < num_timers; ++i) {
+      // Timer is packed, so its fields are not read into directly.
+      uint8_t flags;
+      uint8_t depth;
+      uint8_t session_id;
+      uint8_t type;
+      uint8_t processor;
+      uint64_t callstack_hash = 0;
+      uint64_t user_data_0 = 0;
+      uint64_t user_data_1 = 0;
+      uint64_t function_address_delta;
+      uint64_t start_delta;
+      uint64_t duration;
+      if (!reader.ReadByte(&flags) || !reader.ReadByte(&depth) ||
+          !reader.ReadByte(&session_id) || !reader.ReadByte(&type) ||
+          !reader.ReadByte(&processor) ||
+          ((flags & HAS_CALLSTACK_HASH) &&
+           !reader.ReadFixed64(&callstack_hash)) ||
+          ((flags & HAS_USER_DATA_0) && !reader.ReadVarint(&user_data_0)) ||
+          ((flags & HAS_USER_DATA_1) && !reader.ReadVarint(&user_data_1)) ||
+          !reader.ReadVarint(&function_address_delta) ||
+          !reader.ReadVarint(&start_delta) || !reader.ReadVarint(&duration)) {
+        return false;
+      }
+      Timer& timer = timers->emplace_back();
+      timer.m_TID = static_cast<uint32_t>(tid);
+      timer.m_Depth = depth;
+      timer.m_SessionID = session_id;
+      timer.m_Type = static_cast<Timer::Type>(type);
+      timer.m_Processor = processor;
+      timer.m_CallstackHash = callstack_hash;
+      timer.m_UserData[0] = user_data_0;
+      timer.m_UserData[1] = user_data_1;
+      timer.m_FunctionAddress =
+          DecodeDelta(function_address_delta, previous_function_address);
+      timer.m_Start = DecodeDelta(start_delta, previous_start);
+      timer.m_End = DecodeDelta(duration, timer.m_Start);
+      previous_function_address = timer.m_FunctionAddress;
+      previous_start = timer.m_Start;
+    }
+    return true;
+  };
+  return DecodeGroups(&reader, decode_group);
+}
+
+void EncodeContextSwitches(std::vector<ContextSwitch>* context_switches,
+                           std::string* buffer) {
+  auto encode_group =
+      [buffer](std::vector<ContextSwitch>::const_iterator begin,
+               std::vector<ContextSwitch>::const_iterator end) {
+        uint64_t previous_time = 0;
+        for (auto it = begin; it != end; ++it) {
+          const ContextSwitch& context_switch = *it;
+          WriteVarint(context_switch.m_ThreadId, buffer);
+          WriteByte(static_cast<uint8_t>(context_switch.m_Type), buffer);
+          WriteByte(context_switch.m_ProcessorNumber, buffer);
+          WriteVarint(EncodeDelta(context_switch.m_Time, previous_time),
+                      buffer);
+          previous_time = context_switch.m_Time;
+        }
+      };
+  EncodeGroups(
+      context_switches,
+      [](const ContextSwitch& context_switch) {
+        return context_switch.m_ProcessorIndex;
+      },
+      encode_group, buffer);
+}
+
+bool DecodeContextSwitches(const char* data, size_t size,
+                           std::vector<ContextSwitch>* context_switches) {
+  Reader reader(data, size);
+  auto decode_group = [&reader, context_switches](
+                          uint64_t processor_index,
+                          uint64_t num_context_switches) {
+    uint64_t previous_time = 0;
+    for (uint64_t i = 0; i < num_context_switches; ++i) {
+      uint64_t thread_id;
+      uint8_t type;
+      uint8_t processor_number;
+      uint64_t time_delta;
+      if (!reader.ReadVarint(&thread_id) || !reader.ReadByte(&type) ||
+          !reader.ReadByte(&processor_number) ||
+          !reader.ReadVarint(&time_delta)) {
+        return false;
+      }
+      ContextSwitch& context_switch = context_switches->emplace_back(
+          static_cast<ContextSwitch::SwitchType>(type));
+      context_switch.m_ThreadId = static_cast<uint32_t>(thread_id);
+      context_switch.m_Time = DecodeDelta(time_delta, previous_time);
+      context_switch.m_ProcessorIndex = static_cast<uint16_t>(processor_index);
+      context_switch.m_ProcessorNumber = processor_number;
+      previous_time = context_switch.m_Time;
+    }
+    return true;
+  };
+  return DecodeGroups(&reader, decode_group);
+}
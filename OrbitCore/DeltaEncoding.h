@@ -0,0 +1,36 @@
+#ifndef ORBIT_CORE_DELTA_ENCODING_H_
+#define ORBIT_CORE_DELTA_ENCODING_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ContextSwitch.h"
+#include "ScopeTimer.h"
+
+// Compact encoding of the timers and context switches sent from the service to
+// the client in Msg_RemoteTimersCompressed and
+// Msg_RemoteContextSwitchesCompressed messages, as an alternative to sending
+// the packed structs as they are (Msg_RemoteTimers, Msg_RemoteContextSwitches).
+//
+// Timers are grouped by thread and context switches by processor, keeping the
+// relative order of the events of a group. Timestamps (and function addresses)
+// are then stored as the difference to the previous event of the same group,
+// zigzag-encoded so that events out of time order are still supported, and
+// all integers are written as little-endian base-128 varints. Fields that are
+// usually zero are only written when they are not.
+
+// Appends the encoding of timers to buffer. This groups timers by thread.
+void EncodeTimers(std::vector<Timer>* timers, std::string* buffer);
+// Appends the decoded timers to timers. Returns false if data is not a valid
+// encoding, in which case the content of timers is unspecified.
+bool DecodeTimers(const char* data, size_t size, std::vector<Timer>* timers);
+
+// Appends the encoding of context_switches to buffer. This groups
+// context_switches by processor.
+void EncodeContextSwitches(std::vector<ContextSwitch>* context_switches,
+                           std::string* buffer);
+bool DecodeContextSwitches(const char* data, size_t size,
+                           std::vector<ContextSwitch>* context_switches);
+
+#endif  // ORBIT_CORE_DELTA_ENCODING_H_
@@ -0,0 +1,109 @@
+#include "DeltaEncoding.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace {
+Timer MakeTimer(uint32_t tid, uint64_t start, uint64_t end,
+                uint64_t function_address) {
+  Timer timer;
+  timer.m_TID = tid;
+  timer.m_Start = start;
+  timer.m_End = end;
+  timer.m_FunctionAddress = function_address;
+  return timer;
+}
+
+ContextSwitch MakeContextSwitch(ContextSwitch::SwitchType type, uint32_t tid,
+                                uint64_t time, uint16_t processor) {
+  ContextSwitch context_switch(type);
+  context_switch.m_ThreadId = tid;
+  context_switch.m_Time = time;
+  context_switch.m_ProcessorIndex = processor;
+  context_switch.m_ProcessorNumber = static_cast<uint8_t>(processor);
+  return context_switch;
+}
+}  // namespace
+
+TEST(DeltaEncoding, Timers) {
+  std::vector<Timer> timers;
+  timers.push_back(MakeTimer(2, 1000000, 1000100, 0x7f0000001000));
+  timers.push_back(MakeTimer(1, 1000050, 1000300, 0x401000));
+  // Out of order with respect to the previous timer of the same thread.
+  timers.push_back(MakeTimer(2, 999000, 1000200, 0x7f0000000100));
+  timers.push_back(MakeTimer(1, 1000400, 1000400, 0));
+  timers[1].m_Depth = 3;
+  timers[1].m_Type = Timer::INTROSPECTION;
+  timers[1].m_Processor = 7;
+  timers[1].m_CallstackHash = 0xfedcba9876543210;
+  timers[2].m_UserData[0] = 42;
+  timers[3].m_UserData[1] = ~0ull;
+  std::vector<Timer> expected_timers = {timers[1], timers[3], timers[0],
+                                        timers[2]};
+
+  std::string buffer;
+  EncodeTimers(&timers, &buffer);
+  EXPECT_LT(buffer.size(), timers.size() * sizeof(Timer) / 2);
+
+  std::vector<Timer> decoded_timers;
+  ASSERT_TRUE(DecodeTimers(buffer.data(), buffer.size(), &decoded_timers));
+  ASSERT_EQ(decoded_timers.size(), expected_timers.size());
+  for (size_t i = 0; i < expected_timers.size(); ++i) {
+    // Timer is packed and has no padding.
+    EXPECT_EQ(memcmp(&decoded_timers[i], &expected_timers[i], sizeof(Timer)),
+              0)
+        << "timer " << i;
+  }
+}
+
+TEST(DeltaEncoding, ContextSwitches) {
+  std::vector<ContextSwitch> context_switches;
+  context_switches.push_back(
+      MakeContextSwitch(ContextSwitch::In, 10, 5000, 1));
+  context_switches.push_back(
+      MakeContextSwitch(ContextSwitch::In, 11, 5010, 0));
+  context_switches.push_back(
+      MakeContextSwitch(ContextSwitch::Out, 10, 6000, 1));
+  context_switches.push_back(
+      MakeContextSwitch(ContextSwitch::Out, 11, 4000, 0));
+
+  std::string buffer;
+  EncodeContextSwitches(&context_switches, &buffer);
+
+  std::vector<ContextSwitch> decoded_context_switches;
+  ASSERT_TRUE(DecodeContextSwitches(buffer.data(), buffer.size(),
+                                    &decoded_context_switches));
+  ASSERT_EQ(decoded_context_switches.size(), 4);
+  // Grouped by processor.
+  EXPECT_EQ(decoded_context_switches[0].m_ThreadId, 11);
+  EXPECT_EQ(decoded_context_switches[0].m_Type, ContextSwitch::In);
+  EXPECT_EQ(decoded_context_switches[0].m_Time, 5010);
+  EXPECT_EQ(decoded_context_switches[0].m_ProcessorIndex, 0);
+  EXPECT_EQ(decoded_context_switches[1].m_ThreadId, 11);
+  EXPECT_EQ(decoded_context_switches[1].m_Type, ContextSwitch::Out);
+  EXPECT_EQ(decoded_context_switches[1].m_Time, 4000);
+  EXPECT_EQ(decoded_context_switches[2].m_ThreadId, 10);
+  EXPECT_EQ(decoded_context_switches[2].m_Time, 5000);
+  EXPECT_EQ(decoded_context_switches[2].m_ProcessorIndex, 1);
+  EXPECT_EQ(decoded_context_switches[2].m_ProcessorNumber, 1);
+  EXPECT_EQ(decoded_context_switches[3].m_Type, ContextSwitch::Out);
+  EXPECT_EQ(decoded_context_switches[3].m_Time, 6000);
+}
+
+TEST(DeltaEncoding, RejectsInvalidData) {
+  std::vector<Timer> timers = {MakeTimer(1, 100, 200, 0x1000)};
+  std::string buffer;
+  EncodeTimers(&timers, &buffer);
+
+  std::vector<Timer> decoded_timers;
+  EXPECT_FALSE(DecodeTimers(buffer.data(), buffer.size() - 1, &decoded_timers));
+  EXPECT_FALSE(DecodeTimers(buffer.data(), 0, &decoded_timers));
+  std::string trailing_data = buffer + '\0';
+  EXPECT_FALSE(DecodeTimers(trailing_data.data(), trailing_data.size(),
+                            &decoded_timers));
+  std::string wrong_version = buffer;
+  wrong_version[0] = 0;
+  EXPECT_FALSE(DecodeTimers(wrong_version.data(), wrong_version.size(),
+                            &decoded_timers));
+}
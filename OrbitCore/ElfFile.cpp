@@ -1,19 +1,24 @@
 #include "ElfFile.h"
 
+#include <algorithm>
+#include <iterator>
 #include <string_view>
 #include <vector>
 
 #include "OrbitFunction.h"
 #include "Path.h"
 #include "PrintVar.h"
+#include "Threading.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
-#include "llvm/Demangle/Demangle.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/ObjectFile.h"
 
 namespace {
 
+// Number of symbols read by each task when loading functions.
+constexpr size_t SYMBOLS_PER_CHUNK = 64 * 1024;
+
 template <typename ElfT>
 class ElfFileImpl : public ElfFile {
  public:
@@ -35,6 +40,7 @@ class ElfFileImpl : public ElfFile {
   llvm::object::OwningBinary<llvm::object::ObjectFile> owning_binary_;
   llvm::object::ELFObjectFile<ElfT>* object_file_;
   std::unique_ptr<typename ElfT::Shdr> text_section_;
+  std::unique_ptr<typename ElfT::Shdr> symtab_section_;
   std::string build_id_;
   bool has_symtab_section_;
 };
@@ -76,6 +82,7 @@ void ElfFileImpl<ElfT>::InitSections() {
     }
 
     if (name.str() == ".symtab") {
+      symtab_section_ = std::make_unique<typename ElfT::Shdr>(section);
       has_symtab_section_ = true;
     }
 
@@ -118,7 +125,6 @@ bool ElfFileImpl<ElfT>::GetFunctions(Pdb* pdb,
   if (!has_symtab_section_) {
     return false;
   }
-  bool function_added = false;
 
   std::optional<uint64_t> load_bias_optional = GetLoadBias();
   if (!load_bias_optional) {
@@ -127,37 +133,65 @@ bool ElfFileImpl<ElfT>::GetFunctions(Pdb* pdb,
 
   uint64_t load_bias = load_bias_optional.value();
 
-  for (const llvm::object::ELFSymbolRef& symbol_ref : object_file_->symbols()) {
-    if ((symbol_ref.getFlags() & llvm::object::BasicSymbolRef::SF_Undefined) !=
-        0) {
-      continue;
-    }
-
-    std::string name = symbol_ref.getName() ? symbol_ref.getName().get() : "";
-    std::string pretty_name = llvm::demangle(name);
+  // The file is memory-mapped by llvm, so symbols are read in place from the
+  // .symtab section rather than through llvm::object::SymbolRef, and in
+  // chunks on several threads, as debug files can have millions of them.
+  const llvm::object::ELFFile<ElfT>* elf_file = object_file_->getELFFile();
+  llvm::Expected<typename ElfT::SymRange> symbols_or_error =
+      elf_file->symbols(symtab_section_.get());
+  if (!symbols_or_error) {
+    PRINT(absl::StrFormat("Unable to load symbols from \"%s\"", file_path_));
+    return false;
+  }
+  llvm::Expected<llvm::StringRef> string_table_or_error =
+      elf_file->getStringTableForSymtab(*symtab_section_);
+  if (!string_table_or_error) {
+    PRINT(absl::StrFormat("Unable to load symbol names from \"%s\"",
+                          file_path_));
+    return false;
+  }
 
-    // Unknown type - skip and generate a warning
-    if (!symbol_ref.getType()) {
-      PRINT(
-          absl::StrFormat("WARNING: Type is not set for symbol \"%s\" in "
-                          "\"%s\", skipping.",
-                          name, file_path_));
-      continue;
-    }
+  typename ElfT::SymRange symbols = symbols_or_error.get();
+  llvm::StringRef string_table = string_table_or_error.get();
+  std::string module_name = Path::GetFileName(file_path_);
+
+  size_t num_chunks =
+      (symbols.size() + SYMBOLS_PER_CHUNK - 1) / SYMBOLS_PER_CHUNK;
+  std::vector<std::vector<Function>> chunk_functions(num_chunks);
+  ParallelFor(num_chunks, [&](size_t chunk) {
+    size_t begin = chunk * SYMBOLS_PER_CHUNK;
+    size_t end = std::min(begin + SYMBOLS_PER_CHUNK, symbols.size());
+    for (const typename ElfT::Sym& symbol : symbols.slice(begin, end - begin)) {
+      // Limit list of symbols to functions. Ignore sections and variables.
+      if (symbol.isUndefined() || symbol.getType() != llvm::ELF::STT_FUNC) {
+        continue;
+      }
 
-    // Limit list of symbols to functions. Ignore sections and variables.
-    if (symbol_ref.getType().get() != llvm::object::SymbolRef::ST_Function) {
-      continue;
+      llvm::Expected<llvm::StringRef> name_or_error =
+          symbol.getName(string_table);
+      std::string name;
+      if (name_or_error) {
+        name = name_or_error.get().str();
+      } else {
+        llvm::consumeError(name_or_error.takeError());
+      }
+      // The pretty name is demangled on first use.
+      chunk_functions[chunk].emplace_back(name, "", module_name,
+                                          symbol.st_value, symbol.st_size,
+                                          load_bias, pdb);
     }
+  });
 
-    functions->emplace_back(name, pretty_name, Path::GetFileName(file_path_),
-                            symbol_ref.getValue(), symbol_ref.getSize(),
-                            load_bias, pdb);
-
-    function_added = true;
+  size_t num_functions = 0;
+  for (const std::vector<Function>& chunk : chunk_functions) {
+    num_functions += chunk.size();
+  }
+  functions->reserve(functions->size() + num_functions);
+  for (std::vector<Function>& chunk : chunk_functions) {
+    std::move(chunk.begin(), chunk.end(), std::back_inserter(*functions));
   }
 
-  return function_added;
+  return num_functions > 0;
 }
 
 template <typename ElfT>
@@ -1,10 +1,103 @@
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "ElfFile.h"
 #include "Path.h"
+#include "llvm/BinaryFormat/ELF.h"
+
+namespace {
+// Writes a 64-bit elf file with a single PT_LOAD segment at 0x400000 and a
+// .symtab of num_symbols symbols after the null symbol. Symbol i is named
+// "symbol_<i>" and has address 0x401000 + 16 * i. Every third symbol is a
+// variable, the others are functions.
+void WriteElfWithSymbols(const std::string& file_path, size_t num_symbols) {
+  using namespace llvm::ELF;
+
+  std::string string_table(1, '\0');
+  std::vector<Elf64_Sym> symbols(num_symbols + 1, Elf64_Sym{});
+  for (size_t i = 1; i <= num_symbols; ++i) {
+    Elf64_Sym& symbol = symbols[i];
+    symbol.st_name = string_table.size();
+    string_table += "symbol_" + std::to_string(i - 1) + '\0';
+    symbol.setBindingAndType(STB_GLOBAL,
+                             (i - 1) % 3 == 2 ? STT_OBJECT : STT_FUNC);
+    symbol.st_shndx = 1;
+    symbol.st_value = 0x401000 + 16 * (i - 1);
+    symbol.st_size = 16;
+  }
+  const std::string section_names("\0.text\0.symtab\0.strtab\0.shstrtab\0",
+                                  33);
+
+  const size_t symbols_offset = sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr);
+  const size_t symbols_size = symbols.size() * sizeof(Elf64_Sym);
+  const size_t string_table_offset = symbols_offset + symbols_size;
+  const size_t section_names_offset = string_table_offset + string_table.size();
+  const size_t section_headers_offset =
+      section_names_offset + section_names.size();
+
+  Elf64_Ehdr header{};
+  std::copy(ElfMagic, ElfMagic + 4, header.e_ident);
+  header.e_ident[EI_CLASS] = ELFCLASS64;
+  header.e_ident[EI_DATA] = ELFDATA2LSB;
+  header.e_ident[EI_VERSION] = EV_CURRENT;
+  header.e_type = ET_EXEC;
+  header.e_machine = EM_X86_64;
+  header.e_version = EV_CURRENT;
+  header.e_phoff = sizeof(Elf64_Ehdr);
+  header.e_shoff = section_headers_offset;
+  header.e_ehsize = sizeof(Elf64_Ehdr);
+  header.e_phentsize = sizeof(Elf64_Phdr);
+  header.e_phnum = 1;
+  header.e_shentsize = sizeof(Elf64_Shdr);
+  header.e_shnum = 5;
+  header.e_shstrndx = 4;
+
+  Elf64_Phdr load_segment{};
+  load_segment.p_type = PT_LOAD;
+  load_segment.p_flags = PF_R | PF_X;
+  load_segment.p_vaddr = 0x400000;
+  load_segment.p_paddr = 0x400000;
+  load_segment.p_align = 0x1000;
+
+  std::vector<Elf64_Shdr> sections(5, Elf64_Shdr{});
+  sections[1].sh_name = 1;
+  sections[1].sh_type = SHT_NOBITS;
+  sections[1].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+  sections[1].sh_addr = 0x401000;
+  sections[1].sh_size = 16 * num_symbols;
+  sections[2].sh_name = 7;
+  sections[2].sh_type = SHT_SYMTAB;
+  sections[2].sh_offset = symbols_offset;
+  sections[2].sh_size = symbols_size;
+  sections[2].sh_link = 3;
+  sections[2].sh_info = 1;
+  sections[2].sh_entsize = sizeof(Elf64_Sym);
+  sections[3].sh_name = 15;
+  sections[3].sh_type = SHT_STRTAB;
+  sections[3].sh_offset = string_table_offset;
+  sections[3].sh_size = string_table.size();
+  sections[4].sh_name = 23;
+  sections[4].sh_type = SHT_STRTAB;
+  sections[4].sh_offset = section_names_offset;
+  sections[4].sh_size = section_names.size();
+
+  std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(&load_segment),
+             sizeof(load_segment));
+  file.write(reinterpret_cast<const char*>(symbols.data()), symbols_size);
+  file.write(string_table.data(), string_table.size());
+  file.write(section_names.data(), section_names.size());
+  file.write(reinterpret_cast<const char*>(sections.data()),
+             sections.size() * sizeof(Elf64_Shdr));
+}
+}  // namespace
 
 TEST(ElfFile, GetFunctions) {
   std::string executable_path = Path::GetExecutablePath();
@@ -33,6 +126,36 @@ TEST(ElfFile, GetFunctions) {
   EXPECT_EQ(function->GetPdb(), &pdb);
 }
 
+TEST(ElfFile, GetFunctionsOfManySymbols) {
+  // More than two chunks of symbols are parsed in parallel.
+  constexpr size_t num_symbols = 150'000;
+  std::string elf_file_path = ::testing::TempDir() + "many_symbols_elf";
+  WriteElfWithSymbols(elf_file_path, num_symbols);
+
+  auto elf_file = ElfFile::Create(elf_file_path);
+  ASSERT_NE(elf_file, nullptr);
+  EXPECT_EQ(elf_file->GetLoadBias(), 0x400000);
+
+  Pdb pdb;
+  std::vector<Function> functions;
+  ASSERT_TRUE(elf_file->GetFunctions(&pdb, &functions));
+  remove(elf_file_path.c_str());
+
+  // Only functions are kept, in symbol order.
+  ASSERT_EQ(functions.size(), num_symbols - num_symbols / 3);
+  size_t function_index = 0;
+  for (size_t symbol = 0; symbol < num_symbols; ++symbol) {
+    if (symbol % 3 == 2) {
+      continue;
+    }
+    const Function& function = functions[function_index++];
+    ASSERT_EQ(function.Name(), "symbol_" + std::to_string(symbol));
+    ASSERT_EQ(function.Address(), 0x401000 + 16 * symbol);
+    ASSERT_EQ(function.Size(), 16);
+    ASSERT_EQ(function.GetPdb(), &pdb);
+  }
+}
+
 TEST(ElfFile, IsAddressInTextSection) {
   std::string executable_path = Path::GetExecutablePath();
   std::string test_elf_file = executable_path + "/testdata/hello_world_elf";
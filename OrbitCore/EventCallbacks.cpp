@@ -235,7 +235,8 @@ void EventTracing::CallbackStackWalk(PEVENT_RECORD a_EventRecord,
       CS.m_Data.resize(stackDepth);
       memcpy(CS.m_Data.data(), &event->Stack1, numBytes);
 
-      Capture::GSamplingProfiler->AddCallStack(CS);
+      Capture::GSamplingProfiler->AddCallStack(
+          CS, a_EventRecord->EventHeader.TimeStamp.QuadPart);
       GEventTracer.GetEventBuffer().AddCallstackEvent(
           a_EventRecord->EventHeader.TimeStamp.QuadPart, CS.Hash(),
           CS.m_ThreadId);
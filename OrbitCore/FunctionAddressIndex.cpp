@@ -0,0 +1,160 @@
+#include "FunctionAddressIndex.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "Threading.h"
+
+namespace {
+// Number of addresses per block: two cache lines.
+constexpr size_t BLOCK_SIZE = 16;
+
+// Indices with fewer functions are built on a single thread.
+constexpr size_t MIN_PARALLEL_BUILD_SIZE = 64 * 1024;
+
+// Number of addresses of the block that are less than or equal to address.
+inline size_t CountLessOrEqual(const uint64_t* block, uint64_t address) {
+  size_t count = 0;
+  for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+    count += block[i] <= address ? 1 : 0;
+  }
+  return count;
+}
+
+size_t NumBlocks(size_t size) { return (size + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+}  // namespace
+
+void FunctionAddressIndex::Build(
+    std::vector<std::pair<uint64_t, Function*>> functions) {
+  Clear();
+  if (functions.empty()) {
+    return;
+  }
+
+  // Sort chunks on several threads, then merge pairs of sorted chunks until
+  // one remains. Sorts and merges are stable so that the first function of an
+  // address can be kept.
+  auto compare = [](const std::pair<uint64_t, Function*>& a,
+                    const std::pair<uint64_t, Function*>& b) {
+    return a.first < b.first;
+  };
+  size_t num_chunks = 1;
+  if (functions.size() >= MIN_PARALLEL_BUILD_SIZE) {
+    num_chunks = std::max(1u, std::thread::hardware_concurrency());
+  }
+  size_t chunk_size = (functions.size() + num_chunks - 1) / num_chunks;
+  auto chunk_begin = [&](size_t chunk) {
+    return functions.begin() +
+           std::min(chunk * chunk_size, functions.size());
+  };
+  ParallelFor(num_chunks, [&](size_t chunk) {
+    std::stable_sort(chunk_begin(chunk), chunk_begin(chunk + 1), compare);
+  });
+  for (size_t width = 1; width < num_chunks; width *= 2) {
+    size_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+    ParallelFor(num_merges, [&](size_t merge) {
+      size_t first = merge * 2 * width;
+      std::inplace_merge(chunk_begin(first), chunk_begin(first + width),
+                         chunk_begin(first + 2 * width), compare);
+    });
+  }
+
+  std::vector<uint64_t> addresses;
+  addresses.reserve(NumBlocks(functions.size()) * BLOCK_SIZE);
+  functions_.reserve(functions.size());
+  for (const auto& [address, function] : functions) {
+    if (addresses.empty() || addresses.back() != address) {
+      addresses.push_back(address);
+      functions_.push_back(function);
+    }
+  }
+  size_ = addresses.size();
+  functions_.shrink_to_fit();
+
+  levels_.push_back(std::move(addresses));
+  level_sizes_.push_back(size_);
+  while (true) {
+    std::vector<uint64_t>& level = levels_.back();
+    size_t level_size = level_sizes_.back();
+    level.resize(NumBlocks(level_size) * BLOCK_SIZE, UINT64_MAX);
+    if (level_size <= BLOCK_SIZE) {
+      break;
+    }
+
+    std::vector<uint64_t> upper_level;
+    upper_level.reserve(NumBlocks(NumBlocks(level_size)) * BLOCK_SIZE);
+    for (size_t i = 0; i < level_size; i += BLOCK_SIZE) {
+      upper_level.push_back(level[i]);
+    }
+    level_sizes_.push_back(upper_level.size());
+    levels_.push_back(std::move(upper_level));
+  }
+}
+
+void FunctionAddressIndex::Clear() {
+  levels_.clear();
+  level_sizes_.clear();
+  functions_.clear();
+  size_ = 0;
+}
+
+size_t FunctionAddressIndex::GetMemoryUsage() const {
+  size_t bytes = functions_.capacity() * sizeof(functions_[0]);
+  for (const std::vector<uint64_t>& level : levels_) {
+    bytes += level.capacity() * sizeof(level[0]);
+  }
+  return bytes;
+}
+
+size_t FunctionAddressIndex::FindFloorIndex(uint64_t address) const {
+  if (size_ == 0) {
+    return NOT_FOUND;
+  }
+
+  // The entry found in a level is the first address of the block to scan in
+  // the level below.
+  size_t index = 0;
+  for (size_t level = levels_.size(); level-- > 0;) {
+    size_t block_begin = index * BLOCK_SIZE;
+    size_t count =
+        CountLessOrEqual(levels_[level].data() + block_begin, address);
+    if (count == 0) {
+      return NOT_FOUND;
+    }
+    // Padding is counted if address is UINT64_MAX.
+    index = std::min(block_begin + count - 1, level_sizes_[level] - 1);
+  }
+  return index;
+}
+
+Function* FunctionAddressIndex::FindFloor(uint64_t address) const {
+  size_t index = FindFloorIndex(address);
+  return index != NOT_FOUND ? functions_[index] : nullptr;
+}
+
+Function* FunctionAddressIndex::FindExact(uint64_t address) const {
+  size_t index = FindFloorIndex(address);
+  return index != NOT_FOUND && levels_[0][index] == address ? functions_[index]
+                                                             : nullptr;
+}
+
+void FunctionAddressIndex::FindFloors(const uint64_t* addresses,
+                                      size_t num_addresses,
+                                      Function** functions) const {
+  // Walking through all functions only pays off if there are enough
+  // addresses.
+  if (num_addresses * BLOCK_SIZE < size_) {
+    for (size_t i = 0; i < num_addresses; ++i) {
+      functions[i] = FindFloor(addresses[i]);
+    }
+    return;
+  }
+
+  size_t next_index = 0;
+  for (size_t i = 0; i < num_addresses; ++i) {
+    while (next_index < size_ && levels_[0][next_index] <= addresses[i]) {
+      ++next_index;
+    }
+    functions[i] = next_index > 0 ? functions_[next_index - 1] : nullptr;
+  }
+}
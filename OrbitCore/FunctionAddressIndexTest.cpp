@@ -0,0 +1,171 @@
+#include "FunctionAddressIndex.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+// The index never dereferences functions, so any distinct pointers will do.
+Function* FakeFunction(size_t id) {
+  return reinterpret_cast<Function*>((id + 1) * 8);
+}
+
+Function* FindFloor(const std::map<uint64_t, Function*>& map,
+                    uint64_t address) {
+  auto it = map.upper_bound(address);
+  return it != map.begin() ? std::prev(it)->second : nullptr;
+}
+
+Function* FindExact(const std::map<uint64_t, Function*>& map,
+                    uint64_t address) {
+  auto it = map.find(address);
+  return it != map.end() ? it->second : nullptr;
+}
+}  // namespace
+
+TEST(FunctionAddressIndex, Empty) {
+  FunctionAddressIndex index;
+  EXPECT_TRUE(index.Empty());
+  EXPECT_EQ(index.FindFloor(0), nullptr);
+  EXPECT_EQ(index.FindFloor(UINT64_MAX), nullptr);
+  EXPECT_EQ(index.FindExact(0), nullptr);
+
+  index.Build({});
+  EXPECT_TRUE(index.Empty());
+  EXPECT_EQ(index.FindFloor(0x100), nullptr);
+}
+
+TEST(FunctionAddressIndex, Edges) {
+  FunctionAddressIndex index;
+  index.Build({{0x200, FakeFunction(1)},
+               {0x100, FakeFunction(0)},
+               {UINT64_MAX, FakeFunction(2)},
+               {0x100, FakeFunction(3)}});
+  EXPECT_EQ(index.Size(), 3);
+
+  EXPECT_EQ(index.FindFloor(0xff), nullptr);
+  EXPECT_EQ(index.FindFloor(0x100), FakeFunction(0));
+  EXPECT_EQ(index.FindFloor(0x1ff), FakeFunction(0));
+  EXPECT_EQ(index.FindFloor(0x200), FakeFunction(1));
+  EXPECT_EQ(index.FindFloor(UINT64_MAX - 1), FakeFunction(1));
+  EXPECT_EQ(index.FindFloor(UINT64_MAX), FakeFunction(2));
+
+  EXPECT_EQ(index.FindExact(0x100), FakeFunction(0));
+  EXPECT_EQ(index.FindExact(0x180), nullptr);
+  EXPECT_EQ(index.FindExact(UINT64_MAX), FakeFunction(2));
+
+  index.Clear();
+  EXPECT_TRUE(index.Empty());
+  EXPECT_EQ(index.FindFloor(0x200), nullptr);
+}
+
+// Compares lookups with a std::map for sizes around block and level
+// boundaries, and for an index large enough to be built on several threads.
+TEST(FunctionAddressIndex, MatchesMap) {
+  std::mt19937_64 random_engine(0);
+  for (size_t num_functions :
+       {1, 15, 16, 17, 255, 256, 257, 4097, 200'000}) {
+    // Few distinct addresses, so that some are duplicated.
+    std::uniform_int_distribution<uint64_t> address_distribution(
+        0x1000, 0x1000 + num_functions * 32);
+    std::vector<std::pair<uint64_t, Function*>> functions;
+    std::map<uint64_t, Function*> map;
+    for (size_t i = 0; i < num_functions; ++i) {
+      uint64_t address = address_distribution(random_engine) & ~7ULL;
+      functions.emplace_back(address, FakeFunction(i));
+      map.insert(functions.back());
+    }
+    FunctionAddressIndex index;
+    index.Build(functions);
+    ASSERT_EQ(index.Size(), map.size());
+
+    std::vector<uint64_t> addresses = {0, 0xfff, UINT64_MAX};
+    for (const auto& entry : map) {
+      addresses.push_back(entry.first);
+      addresses.push_back(entry.first + 1);
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+      addresses.push_back(address_distribution(random_engine));
+    }
+    for (uint64_t address : addresses) {
+      ASSERT_EQ(index.FindFloor(address), FindFloor(map, address))
+          << num_functions << " " << address;
+      ASSERT_EQ(index.FindExact(address), FindExact(map, address))
+          << num_functions << " " << address;
+    }
+
+    // Both the walk through all functions and the individual lookups of
+    // FindFloors.
+    std::sort(addresses.begin(), addresses.end());
+    for (size_t num_addresses : {addresses.size(), size_t{3}}) {
+      std::vector<Function*> found(num_addresses);
+      index.FindFloors(addresses.data(), num_addresses, found.data());
+      for (size_t i = 0; i < num_addresses; ++i) {
+        ASSERT_EQ(found[i], FindFloor(map, addresses[i]))
+            << num_functions << " " << addresses[i];
+      }
+    }
+  }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the build time,
+// memory usage and lookup rate of 500k functions, compared to a std::map.
+TEST(FunctionAddressIndex, DISABLED_Throughput) {
+  constexpr size_t num_functions = 500'000;
+  constexpr size_t num_lookups = 2'000'000;
+  // Three pointers, a color and the key, allocated separately.
+  constexpr size_t map_node_size = 48;
+
+  std::mt19937_64 random_engine(0);
+  std::uniform_int_distribution<uint64_t> address_distribution(
+      0, num_functions * 64);
+  std::vector<std::pair<uint64_t, Function*>> functions;
+  functions.reserve(num_functions);
+  for (size_t i = 0; i < num_functions; ++i) {
+    functions.emplace_back(address_distribution(random_engine),
+                           FakeFunction(i));
+  }
+  std::vector<uint64_t> addresses(num_lookups);
+  for (uint64_t& address : addresses) {
+    address = address_distribution(random_engine);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::map<uint64_t, Function*> map;
+  for (const auto& entry : functions) {
+    map.insert(entry);
+  }
+  auto map_built = std::chrono::steady_clock::now();
+  FunctionAddressIndex index;
+  index.Build(functions);
+  auto index_built = std::chrono::steady_clock::now();
+
+  // Sum the pointers so that the lookups are not optimized away.
+  uintptr_t map_sum = 0;
+  for (uint64_t address : addresses) {
+    map_sum += reinterpret_cast<uintptr_t>(FindFloor(map, address));
+  }
+  auto map_looked_up = std::chrono::steady_clock::now();
+  uintptr_t index_sum = 0;
+  for (uint64_t address : addresses) {
+    index_sum += reinterpret_cast<uintptr_t>(index.FindFloor(address));
+  }
+  auto index_looked_up = std::chrono::steady_clock::now();
+  EXPECT_EQ(index_sum, map_sum);
+
+  auto milliseconds = [](auto begin, auto end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+  };
+  printf("Build: std::map %.1f ms, FunctionAddressIndex %.1f ms\n",
+         milliseconds(start, map_built), milliseconds(map_built, index_built));
+  printf("Memory: std::map %.1f MB, FunctionAddressIndex %.1f MB\n",
+         map.size() * map_node_size / 1e6, index.GetMemoryUsage() / 1e6);
+  printf("Lookups: std::map %.1f M/s, FunctionAddressIndex %.1f M/s\n",
+         num_lookups / milliseconds(index_built, map_looked_up) / 1e3,
+         num_lookups / milliseconds(map_looked_up, index_looked_up) / 1e3);
+}
@@ -0,0 +1,168 @@
+#include "LinuxSymbolBatch.h"
+
+#include <cstring>
+
+namespace {
+// Increment when changing the layout.
+constexpr uint32_t WIRE_FORMAT_VERSION = 1;
+
+struct Header {
+  uint32_t version;
+  uint32_t num_addresses;
+  uint32_t num_functions;
+  uint32_t num_strings;
+};
+static_assert(sizeof(Header) == 16);
+
+// Size of everything but the characters of the strings.
+size_t GetFixedSize(const Header& header) {
+  return sizeof(Header) +
+         size_t{header.num_addresses} *
+             (2 * sizeof(uint64_t) + sizeof(uint32_t)) +
+         size_t{header.num_functions} * 2 * sizeof(uint32_t) +
+         size_t{header.num_strings} * sizeof(uint32_t);
+}
+
+template <typename T>
+void Write(char** buffer, T value) {
+  memcpy(*buffer, &value, sizeof(T));
+  *buffer += sizeof(T);
+}
+
+template <typename T>
+T ReadAt(const char* column, size_t index) {
+  T value;
+  memcpy(&value, column + index * sizeof(T), sizeof(T));
+  return value;
+}
+}  // namespace
+
+void LinuxSymbolBatch::Add(uint64_t address, const std::string& module,
+                           const std::string& function_name,
+                           uint64_t offset) {
+  std::pair<uint32_t, uint32_t> strings(GetStringIndex(module),
+                                        GetStringIndex(function_name));
+  auto [it, inserted] =
+      function_indices_.try_emplace(strings, function_strings_.size());
+  if (inserted) {
+    function_strings_.push_back(strings);
+  }
+  addresses_.push_back({address, offset, it->second});
+}
+
+uint32_t LinuxSymbolBatch::GetStringIndex(const std::string& str) {
+  auto [it, inserted] = string_indices_.try_emplace(str, strings_.size());
+  if (inserted) {
+    strings_.push_back(str);
+    num_string_bytes_ += str.size();
+  }
+  return it->second;
+}
+
+void LinuxSymbolBatch::Clear() {
+  addresses_.clear();
+  function_strings_.clear();
+  function_indices_.clear();
+  strings_.clear();
+  string_indices_.clear();
+  num_string_bytes_ = 0;
+}
+
+size_t LinuxSymbolBatch::GetEncodedSize() const {
+  Header header{WIRE_FORMAT_VERSION, static_cast<uint32_t>(addresses_.size()),
+                static_cast<uint32_t>(function_strings_.size()),
+                static_cast<uint32_t>(strings_.size())};
+  return GetFixedSize(header) + num_string_bytes_;
+}
+
+void LinuxSymbolBatch::Encode(char* buffer) const {
+  Write(&buffer, Header{WIRE_FORMAT_VERSION,
+                        static_cast<uint32_t>(addresses_.size()),
+                        static_cast<uint32_t>(function_strings_.size()),
+                        static_cast<uint32_t>(strings_.size())});
+  for (const Address& address : addresses_) {
+    Write<uint64_t>(&buffer, address.address);
+  }
+  for (const Address& address : addresses_) {
+    Write<uint64_t>(&buffer, address.offset);
+  }
+  for (const Address& address : addresses_) {
+    Write<uint32_t>(&buffer, address.function_index);
+  }
+  for (const auto& [module, name] : function_strings_) {
+    Write<uint32_t>(&buffer, module);
+  }
+  for (const auto& [module, name] : function_strings_) {
+    Write<uint32_t>(&buffer, name);
+  }
+  for (const std::string& str : strings_) {
+    Write<uint32_t>(&buffer, str.size());
+  }
+  for (const std::string& str : strings_) {
+    memcpy(buffer, str.data(), str.size());
+    buffer += str.size();
+  }
+}
+
+bool LinuxSymbolBatch::Decode(
+    const char* data, size_t size,
+    const std::function<void(uint64_t address, std::string_view module,
+                             std::string_view function_name,
+                             uint64_t offset)>& callback) {
+  Header header;
+  if (size < sizeof(Header)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(Header));
+  if (header.version != WIRE_FORMAT_VERSION || GetFixedSize(header) > size) {
+    return false;
+  }
+
+  const size_t num_addresses = header.num_addresses;
+  const size_t num_functions = header.num_functions;
+  const size_t num_strings = header.num_strings;
+  const char* addresses = data + sizeof(Header);
+  const char* offsets = addresses + num_addresses * sizeof(uint64_t);
+  const char* function_indices = offsets + num_addresses * sizeof(uint64_t);
+  const char* modules = function_indices + num_addresses * sizeof(uint32_t);
+  const char* names = modules + num_functions * sizeof(uint32_t);
+  const char* string_sizes = names + num_functions * sizeof(uint32_t);
+  const char* string_data = string_sizes + num_strings * sizeof(uint32_t);
+
+  // Check all sizes and indices before any address is passed on.
+  std::vector<std::string_view> strings;
+  strings.reserve(num_strings);
+  size_t remaining_size = size - GetFixedSize(header);
+  for (size_t i = 0; i < num_strings; ++i) {
+    uint32_t string_size = ReadAt<uint32_t>(string_sizes, i);
+    if (string_size > remaining_size) {
+      return false;
+    }
+    strings.emplace_back(string_data, string_size);
+    string_data += string_size;
+    remaining_size -= string_size;
+  }
+  if (remaining_size != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < num_functions; ++i) {
+    if (ReadAt<uint32_t>(modules, i) >= num_strings ||
+        ReadAt<uint32_t>(names, i) >= num_strings) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < num_addresses; ++i) {
+    if (ReadAt<uint32_t>(function_indices, i) >= num_functions) {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < num_addresses; ++i) {
+    uint32_t function = ReadAt<uint32_t>(function_indices, i);
+    callback(ReadAt<uint64_t>(addresses, i),
+             strings[ReadAt<uint32_t>(modules, function)],
+             strings[ReadAt<uint32_t>(names, function)],
+             ReadAt<uint64_t>(offsets, i));
+  }
+  return true;
+}
@@ -0,0 +1,73 @@
+#ifndef ORBIT_CORE_LINUX_SYMBOL_BATCH_H_
+#define ORBIT_CORE_LINUX_SYMBOL_BATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+// Symbols of sampled addresses, sent from the service to the client in one
+// Msg_RemoteSymbols message per batch instead of one message per address.
+//
+// All the addresses in one function share a single entry holding the module
+// and the function name, and only add their offset in the function. Module
+// and function names are stored once per batch.
+//
+// Layout of a message with a addresses, f functions and s strings, in the
+// byte order of the host like the other binary wire formats:
+//   uint32_t version
+//   uint32_t a
+//   uint32_t f
+//   uint32_t s
+//   uint64_t address[a]
+//   uint64_t offset[a]
+//   uint32_t function_index[a]
+//   uint32_t function_module_string_index[f]
+//   uint32_t function_name_string_index[f]
+//   uint32_t string_size[s]
+//   char     strings[sum of string_size]
+class LinuxSymbolBatch {
+ public:
+  void Add(uint64_t address, const std::string& module,
+           const std::string& function_name, uint64_t offset);
+  void Clear();
+
+  bool Empty() const { return addresses_.empty(); }
+  size_t NumAddresses() const { return addresses_.size(); }
+  size_t NumFunctions() const { return function_strings_.size(); }
+
+  size_t GetEncodedSize() const;
+  // buffer must hold GetEncodedSize() bytes.
+  void Encode(char* buffer) const;
+  // Calls callback for each address encoded in data. Returns false, without
+  // calling callback, if data is not a valid encoding.
+  static bool Decode(
+      const char* data, size_t size,
+      const std::function<void(uint64_t address, std::string_view module,
+                               std::string_view function_name,
+                               uint64_t offset)>& callback);
+
+ private:
+  uint32_t GetStringIndex(const std::string& str);
+
+  struct Address {
+    uint64_t address;
+    uint64_t offset;
+    uint32_t function_index;
+  };
+  std::vector<Address> addresses_;
+  // Indices in strings_ of the module and the name of each function.
+  std::vector<std::pair<uint32_t, uint32_t>> function_strings_;
+  absl::flat_hash_map<std::pair<uint32_t, uint32_t>, uint32_t>
+      function_indices_;
+  std::vector<std::string> strings_;
+  absl::flat_hash_map<std::string, uint32_t> string_indices_;
+  size_t num_string_bytes_ = 0;
+};
+
+#endif  // ORBIT_CORE_LINUX_SYMBOL_BATCH_H_
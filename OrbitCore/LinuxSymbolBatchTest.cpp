@@ -0,0 +1,164 @@
+#include "LinuxSymbolBatch.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Message.h"
+#include "absl/strings/str_format.h"
+
+namespace {
+struct DecodedSymbol {
+  uint64_t address;
+  std::string module;
+  std::string function_name;
+  uint64_t offset;
+};
+
+std::vector<char> Encode(const LinuxSymbolBatch& batch) {
+  std::vector<char> data(batch.GetEncodedSize());
+  batch.Encode(data.data());
+  return data;
+}
+
+// Size of a symbol serialized with cereal's binary archive, as it was sent in
+// Msg_RemoteSymbol: the class version, the three strings prefixed with their
+// 64-bit sizes, the line and the address.
+size_t GetSerializedSymbolSize(const std::string& module,
+                               const std::string& name) {
+  return sizeof(uint32_t) + 3 * sizeof(uint64_t) + module.size() +
+         name.size() + sizeof(uint32_t) + sizeof(uint64_t);
+}
+
+bool Decode(const std::vector<char>& data,
+            std::vector<DecodedSymbol>* symbols) {
+  return LinuxSymbolBatch::Decode(
+      data.data(), data.size(),
+      [symbols](uint64_t address, std::string_view module,
+                std::string_view function_name, uint64_t offset) {
+        symbols->push_back({address, std::string(module),
+                            std::string(function_name), offset});
+      });
+}
+}  // namespace
+
+TEST(LinuxSymbolBatch, RoundTrip) {
+  LinuxSymbolBatch batch;
+  EXPECT_TRUE(batch.Empty());
+  batch.Add(0x1010, "/usr/lib/libc.so.6", "malloc", 0x10);
+  batch.Add(0x1024, "/usr/lib/libc.so.6", "malloc", 0x24);
+  batch.Add(0x2000, "/usr/lib/libc.so.6", "free", 0);
+  batch.Add(0x3008, "/usr/bin/game", "malloc", 0x8);
+  batch.Add(0x4000, "", "", 0);
+  EXPECT_EQ(batch.NumAddresses(), 5);
+  EXPECT_EQ(batch.NumFunctions(), 4);
+
+  std::vector<DecodedSymbol> symbols;
+  ASSERT_TRUE(Decode(Encode(batch), &symbols));
+  ASSERT_EQ(symbols.size(), 5);
+  EXPECT_EQ(symbols[0].address, 0x1010);
+  EXPECT_EQ(symbols[0].module, "/usr/lib/libc.so.6");
+  EXPECT_EQ(symbols[0].function_name, "malloc");
+  EXPECT_EQ(symbols[0].offset, 0x10);
+  EXPECT_EQ(symbols[1].address, 0x1024);
+  EXPECT_EQ(symbols[1].offset, 0x24);
+  EXPECT_EQ(symbols[2].function_name, "free");
+  EXPECT_EQ(symbols[3].module, "/usr/bin/game");
+  EXPECT_EQ(symbols[3].function_name, "malloc");
+  EXPECT_EQ(symbols[4].module, "");
+  EXPECT_EQ(symbols[4].function_name, "");
+
+  batch.Clear();
+  EXPECT_TRUE(batch.Empty());
+  EXPECT_EQ(batch.NumFunctions(), 0);
+  symbols.clear();
+  ASSERT_TRUE(Decode(Encode(batch), &symbols));
+  EXPECT_TRUE(symbols.empty());
+}
+
+TEST(LinuxSymbolBatch, InvalidData) {
+  LinuxSymbolBatch batch;
+  batch.Add(0x1010, "module", "function", 0x10);
+  batch.Add(0x2020, "module", "other_function", 0x20);
+  const std::vector<char> data = Encode(batch);
+  std::vector<DecodedSymbol> symbols;
+
+  std::vector<char> bad_version = data;
+  bad_version[0] ^= 0x7f;
+  EXPECT_FALSE(Decode(bad_version, &symbols));
+
+  for (size_t size = 0; size < data.size(); ++size) {
+    EXPECT_FALSE(Decode(std::vector<char>(data.begin(), data.begin() + size),
+                        &symbols));
+  }
+  std::vector<char> too_long = data;
+  too_long.push_back(0);
+  EXPECT_FALSE(Decode(too_long, &symbols));
+
+  // The function index of the first address follows the header, the two
+  // addresses and the two offsets.
+  std::vector<char> bad_function_index = data;
+  bad_function_index[16 + 4 * sizeof(uint64_t)] = 2;
+  EXPECT_FALSE(Decode(bad_function_index, &symbols));
+
+  // Then come the two function indices and the module of the first function.
+  std::vector<char> bad_string_index = data;
+  bad_string_index[16 + 4 * sizeof(uint64_t) + 2 * sizeof(uint32_t)] = 3;
+  EXPECT_FALSE(Decode(bad_string_index, &symbols));
+
+  EXPECT_TRUE(symbols.empty());
+}
+
+namespace {
+// Size of the symbols of a cold capture, where every sampled address is new,
+// sent as one Msg_RemoteSymbol per address (first) or as one batch per capture
+// tick (second).
+std::pair<size_t, size_t> GetColdCaptureTraffic(
+    size_t num_ticks, size_t num_functions_per_tick,
+    size_t num_addresses_per_function) {
+  const std::string module = "/mnt/developer/game/bin/game_binary";
+  size_t num_bytes = 0;
+  size_t num_batched_bytes = 0;
+  LinuxSymbolBatch batch;
+  for (size_t tick = 0; tick < num_ticks; ++tick) {
+    for (size_t i = 0; i < num_functions_per_tick; ++i) {
+      size_t function = tick * num_functions_per_tick + i;
+      std::string function_name = absl::StrFormat(
+          "engine::render::Renderer%u::DrawPrimitives(int, float)", function);
+      for (size_t j = 0; j < num_addresses_per_function; ++j) {
+        uint64_t offset = j * 0x14;
+        uint64_t address = 0x400000 + function * 0x1000 + offset;
+        std::string symbol_name =
+            absl::StrFormat("%s+%#x", function_name, offset);
+        num_bytes +=
+            sizeof(Message) + GetSerializedSymbolSize(module, symbol_name);
+        batch.Add(address, module, function_name, offset);
+      }
+    }
+    num_batched_bytes += sizeof(Message) + batch.GetEncodedSize();
+    batch.Clear();
+  }
+  return {num_bytes, num_batched_bytes};
+}
+}  // namespace
+
+TEST(LinuxSymbolBatch, ColdCaptureTraffic) {
+  auto [num_bytes, num_batched_bytes] = GetColdCaptureTraffic(2, 10, 8);
+  EXPECT_LT(num_batched_bytes, num_bytes / 2);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the traffic of
+// the symbols of a large cold capture.
+TEST(LinuxSymbolBatch, DISABLED_ColdCaptureTraffic) {
+  constexpr size_t num_ticks = 10;
+  constexpr size_t num_functions_per_tick = 2'000;
+  constexpr size_t num_addresses_per_function = 8;
+  auto [num_bytes, num_batched_bytes] = GetColdCaptureTraffic(
+      num_ticks, num_functions_per_tick, num_addresses_per_function);
+  printf("Symbols of %zu addresses: %.2f MB one per message, %.2f MB in %zu "
+         "batches\n",
+         num_ticks * num_functions_per_tick * num_addresses_per_function,
+         num_bytes / 1e6, num_batched_bytes / 1e6, num_ticks);
+}
@@ -9,8 +9,8 @@
 #include "Params.h"
 #include "Path.h"
 #include "Pdb.h"
+#include "SymbolNamePool.h"
 #include "TcpServer.h"
-#include "llvm/Demangle/Demangle.h"
 
 void LinuxTracingHandler::Start() {
   pid_t pid = target_process_->GetID();
@@ -34,6 +34,19 @@ void LinuxTracingHandler::Start() {
   tracer_->SetTraceCallstacks(true);
   tracer_->SetTraceInstrumentedFunctions(true);
 
+  tracer_->SetUseEventDrivenWakeup(GParams.m_UseEventDrivenWakeup);
+  LinuxTracing::WakeupWatermarks wakeup_watermarks;
+  wakeup_watermarks.sampling_bytes = GParams.m_SamplingWakeupWatermarkBytes;
+  wakeup_watermarks.uprobes_bytes = GParams.m_UprobesWakeupWatermarkBytes;
+  tracer_->SetWakeupWatermarks(wakeup_watermarks);
+  tracer_->SetNumReaderThreads(GParams.m_NumTracingReaderThreads);
+  LinuxTracing::StackDumpOptions stack_dump_options;
+  stack_dump_options.sampling_bytes = GParams.m_SamplingStackDumpBytes;
+  stack_dump_options.uprobes_bytes = GParams.m_UprobesStackDumpBytes;
+  stack_dump_options.trim_uprobes_stacks = GParams.m_TrimUprobesStacks;
+  tracer_->SetStackDumpOptions(stack_dump_options);
+  tracer_->SetUseFramePointerUnwinding(GParams.m_UseFramePointerUnwinding);
+
   tracer_->Start();
 }
 
@@ -52,11 +65,12 @@ void LinuxTracingHandler::OnTid(pid_t tid) {
 
 void LinuxTracingHandler::ProcessCallstackEvent(LinuxCallstackEvent&& event) {
   CallStack cs = event.m_CS;
+  uint64_t time = event.m_time;
   if (sampling_profiler_->HasCallStack(cs.Hash())) {
     CallstackEvent hashed_callstack;
     hashed_callstack.m_Id = cs.m_Hash;
     hashed_callstack.m_TID = cs.m_ThreadId;
-    hashed_callstack.m_Time = event.m_time;
+    hashed_callstack.m_Time = time;
 
     session_->RecordHashedCallstack(std::move(hashed_callstack));
   } else {
@@ -64,7 +78,7 @@ void LinuxTracingHandler::ProcessCallstackEvent(LinuxCallstackEvent&& event) {
   }
 
   // TODO: Is this needed for the case when the call stack already cached?
-  sampling_profiler_->AddCallStack(cs);
+  sampling_profiler_->AddCallStack(cs, time);
 }
 
 void LinuxTracingHandler::OnContextSwitchIn(
@@ -103,18 +117,18 @@ void LinuxTracingHandler::OnCallstack(
 
     if (!frame.GetFunctionName().empty() &&
         !target_process_->HasSymbol(address)) {
-      std::string symbol_name =
-          absl::StrFormat("%s+%#x", llvm::demangle(frame.GetFunctionName()),
-                          frame.GetFunctionOffset());
+      const std::string& function_name =
+          GSymbolNamePool.Demangle(frame.GetFunctionName());
       std::shared_ptr<LinuxSymbol> symbol = std::make_shared<LinuxSymbol>();
       symbol->m_Module = frame.GetMapName();
-      symbol->m_Name = symbol_name;
+      symbol->m_Name = absl::StrFormat("%s+%#x", function_name,
+                                       frame.GetFunctionOffset());
       symbol->m_Address = address;
 
-      // TODO: Move this out of here...
-      std::string message_data = SerializeObjectBinary(*symbol);
-      GTcpServer->Send(Msg_RemoteSymbol, message_data.c_str(),
-                       message_data.size());
+      // Sent to the client in batches, with the other symbols of the
+      // function.
+      session_->RecordSymbol(address, frame.GetMapName(), function_name,
+                             frame.GetFunctionOffset());
 
       target_process_->AddSymbol(address, symbol);
     }
@@ -1,32 +1,115 @@
 #include "LinuxTracingSession.h"
 
+#include <iterator>
 #include <utility>
 
 #include "KeyAndString.h"
 #include "TcpServer.h"
 
+namespace {
+// Moves all the events in queue to buffer. Returns false, leaving buffer
+// untouched, if there are none.
+template <typename T>
+bool DequeueAll(moodycamel::ConcurrentQueue<T>* queue, std::vector<T>* buffer) {
+  // Events recorded concurrently might not be counted and will be dequeued by
+  // the next call.
+  size_t num_events = queue->size_approx();
+  if (num_events == 0) {
+    return false;
+  }
+
+  std::vector<T> events;
+  events.reserve(num_events);
+  if (queue->try_dequeue_bulk(std::back_inserter(events), num_events) == 0) {
+    return false;
+  }
+  *buffer = std::move(events);
+  return true;
+}
+
+uint64_t GetEventSize(const ContextSwitch&) { return sizeof(ContextSwitch); }
+uint64_t GetEventSize(const Timer&) { return sizeof(Timer); }
+uint64_t GetEventSize(const CallstackEvent&) { return sizeof(CallstackEvent); }
+uint64_t GetEventSize(const LinuxCallstackEvent& event) {
+  return sizeof(LinuxCallstackEvent) +
+         event.m_CS.m_Data.size() * sizeof(event.m_CS.m_Data[0]);
+}
+
+template <typename T>
+void Clear(moodycamel::ConcurrentQueue<T>* queue) {
+  T event;
+  while (queue->try_dequeue(event)) {
+  }
+}
+}  // namespace
+
 LinuxTracingSession::LinuxTracingSession(TcpServer* tcp_server)
     : tcp_server_(tcp_server) {}
 
 void LinuxTracingSession::RecordContextSwitch(ContextSwitch&& context_switch) {
-  absl::MutexLock lock(&context_switch_buffer_mutex_);
-  context_switch_buffer_.push_back(std::move(context_switch));
+  AddBufferedEvent(GetEventSize(context_switch));
+  context_switch_buffer_.enqueue(std::move(context_switch));
 }
 
 void LinuxTracingSession::RecordTimer(Timer&& timer) {
-  absl::MutexLock lock(&timer_buffer_mutex_);
-  timer_buffer_.push_back(std::move(timer));
+  AddBufferedEvent(GetEventSize(timer));
+  timer_buffer_.enqueue(std::move(timer));
 }
 
 void LinuxTracingSession::RecordCallstack(LinuxCallstackEvent&& event) {
-  absl::MutexLock lock(&callstack_buffer_mutex_);
-  callstack_buffer_.push_back(std::move(event));
+  AddBufferedEvent(GetEventSize(event));
+  callstack_buffer_.enqueue(std::move(event));
 }
 
 void LinuxTracingSession::RecordHashedCallstack(
     CallstackEvent&& hashed_call_stack) {
-  absl::MutexLock lock(&hashed_callstack_buffer_mutex_);
-  hashed_callstack_buffer_.push_back(std::move(hashed_call_stack));
+  AddBufferedEvent(GetEventSize(hashed_call_stack));
+  hashed_callstack_buffer_.enqueue(std::move(hashed_call_stack));
+}
+
+void LinuxTracingSession::RecordSymbol(uint64_t address,
+                                       const std::string& module,
+                                       const std::string& function_name,
+                                       uint64_t offset) {
+  absl::MutexLock lock(&symbol_mutex_);
+  symbol_buffer_.Add(address, module, function_name, offset);
+}
+
+void LinuxTracingSession::AddBufferedEvent(uint64_t num_bytes) {
+  uint64_t num_events = num_buffered_events_.fetch_add(1) + 1;
+  uint64_t previous_num_bytes = num_buffered_bytes_.fetch_add(num_bytes);
+  // Only the recording thread that crosses a limit signals the reader.
+  uint64_t max_num_bytes = max_batch_num_bytes_;
+  if (num_events == max_batch_num_events_ ||
+      (previous_num_bytes < max_num_bytes &&
+       previous_num_bytes + num_bytes >= max_num_bytes)) {
+    absl::MutexLock lock(&batch_mutex_);
+    batch_ready_ = true;
+  }
+}
+
+template <typename T>
+void LinuxTracingSession::RemoveBufferedEvents(const std::vector<T>& events) {
+  uint64_t num_bytes = 0;
+  for (const T& event : events) {
+    num_bytes += GetEventSize(event);
+  }
+  num_buffered_events_ -= events.size();
+  num_buffered_bytes_ -= num_bytes;
+}
+
+void LinuxTracingSession::SetBatchLimits(uint64_t max_num_events,
+                                         uint64_t max_num_bytes) {
+  max_batch_num_events_ = max_num_events;
+  max_batch_num_bytes_ = max_num_bytes;
+}
+
+bool LinuxTracingSession::WaitForBatch(absl::Duration timeout) {
+  absl::MutexLock lock(&batch_mutex_);
+  bool batch_ready =
+      batch_mutex_.AwaitWithTimeout(absl::Condition(&batch_ready_), timeout);
+  batch_ready_ = false;
+  return batch_ready;
 }
 
 void LinuxTracingSession::SetStringManager(
@@ -52,69 +135,60 @@ void LinuxTracingSession::SendKeyAndString(
 
 bool LinuxTracingSession::ReadAllContextSwitches(
     std::vector<ContextSwitch>* buffer) {
-  absl::MutexLock lock(&context_switch_buffer_mutex_);
-  if (context_switch_buffer_.empty()) {
+  if (!DequeueAll(&context_switch_buffer_, buffer)) {
     return false;
   }
-
-  *buffer = std::move(context_switch_buffer_);
-  context_switch_buffer_.clear();
+  RemoveBufferedEvents(*buffer);
   return true;
 }
 
 bool LinuxTracingSession::ReadAllTimers(std::vector<Timer>* buffer) {
-  absl::MutexLock lock(&timer_buffer_mutex_);
-  if (timer_buffer_.empty()) {
+  if (!DequeueAll(&timer_buffer_, buffer)) {
     return false;
   }
-
-  *buffer = std::move(timer_buffer_);
-  timer_buffer_.clear();
+  RemoveBufferedEvents(*buffer);
   return true;
 }
 
 bool LinuxTracingSession::ReadAllCallstacks(
     std::vector<LinuxCallstackEvent>* buffer) {
-  absl::MutexLock lock(&callstack_buffer_mutex_);
-  if (callstack_buffer_.empty()) {
+  if (!DequeueAll(&callstack_buffer_, buffer)) {
     return false;
   }
-
-  *buffer = std::move(callstack_buffer_);
-  callstack_buffer_.clear();
+  RemoveBufferedEvents(*buffer);
   return true;
 }
 
 bool LinuxTracingSession::ReadAllHashedCallstacks(
     std::vector<CallstackEvent>* buffer) {
-  absl::MutexLock lock(&hashed_callstack_buffer_mutex_);
-  if (hashed_callstack_buffer_.empty()) {
+  if (!DequeueAll(&hashed_callstack_buffer_, buffer)) {
     return false;
   }
-
-  *buffer = std::move(hashed_callstack_buffer_);
-  hashed_callstack_buffer_.clear();
+  RemoveBufferedEvents(*buffer);
   return true;
 }
 
-void LinuxTracingSession::Reset() {
-  {
-    absl::MutexLock lock(&context_switch_buffer_mutex_);
-    context_switch_buffer_.clear();
-  }
-
-  {
-    absl::MutexLock lock(&timer_buffer_mutex_);
-    timer_buffer_.clear();
-  }
-
-  {
-    absl::MutexLock lock(&callstack_buffer_mutex_);
-    callstack_buffer_.clear();
+bool LinuxTracingSession::ReadAllSymbols(LinuxSymbolBatch* symbols) {
+  absl::MutexLock lock(&symbol_mutex_);
+  if (symbol_buffer_.Empty()) {
+    return false;
   }
+  *symbols = std::move(symbol_buffer_);
+  symbol_buffer_.Clear();
+  return true;
+}
 
+void LinuxTracingSession::Reset() {
+  Clear(&context_switch_buffer_);
+  Clear(&timer_buffer_);
+  Clear(&callstack_buffer_);
+  Clear(&hashed_callstack_buffer_);
   {
-    absl::MutexLock lock(&hashed_callstack_buffer_mutex_);
-    hashed_callstack_buffer_.clear();
+    absl::MutexLock lock(&symbol_mutex_);
+    symbol_buffer_.Clear();
   }
+  num_buffered_events_ = 0;
+  num_buffered_bytes_ = 0;
+  absl::MutexLock lock(&batch_mutex_);
+  batch_ready_ = false;
 }
@@ -4,14 +4,24 @@
 #include "ContextSwitch.h"
 #include "EventBuffer.h"
 #include "LinuxCallstackEvent.h"
+#include "LinuxSymbolBatch.h"
 #include "ScopeTimer.h"
 #include "StringManager.h"
 #include "TcpServer.h"
 
+#include <concurrentqueue.h>
+
+#include <atomic>
+#include <limits>
+
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 
 // This class stores information about tracing session
 // and provides thread-safe access and record functions.
+// Recording never blocks: the events are buffered in lock-free queues, in
+// which each recording thread appends to blocks of its own, and reading
+// harvests the content of all of them at once.
 class LinuxTracingSession {
  public:
   explicit LinuxTracingSession(TcpServer* tcp_server);
@@ -22,6 +32,10 @@ class LinuxTracingSession {
   void RecordTimer(Timer&& timer);
   void RecordCallstack(LinuxCallstackEvent&& event);
   void RecordHashedCallstack(CallstackEvent&& event);
+  // Symbols are not counted in the batch limits: they are sent along with the
+  // callstacks they were found in.
+  void RecordSymbol(uint64_t address, const std::string& module,
+                    const std::string& function_name, uint64_t offset);
 
   void SetStringManager(std::shared_ptr<StringManager> string_manager);
   void SendKeyAndString(uint64_t hash, const std::string& name);
@@ -33,22 +47,43 @@ class LinuxTracingSession {
   bool ReadAllTimers(std::vector<Timer>* buffer);
   bool ReadAllCallstacks(std::vector<LinuxCallstackEvent>* buffer);
   bool ReadAllHashedCallstacks(std::vector<CallstackEvent>* buffer);
+  bool ReadAllSymbols(LinuxSymbolBatch* symbols);
+
+  // Once the events buffered across all buffers reach max_num_events or
+  // max_num_bytes, WaitForBatch returns. By default there is no limit.
+  void SetBatchLimits(uint64_t max_num_events, uint64_t max_num_bytes);
+  // Blocks until one of the batch limits has been reached since the previous
+  // call, or until timeout has passed. Returns whether a limit was reached.
+  bool WaitForBatch(absl::Duration timeout);
 
   void Reset();
 
  private:
   // Buffering data to send large messages instead of small ones.
-  absl::Mutex context_switch_buffer_mutex_;
-  std::vector<ContextSwitch> context_switch_buffer_;
-
-  absl::Mutex timer_buffer_mutex_;
-  std::vector<Timer> timer_buffer_;
+  moodycamel::ConcurrentQueue<ContextSwitch> context_switch_buffer_;
+  moodycamel::ConcurrentQueue<Timer> timer_buffer_;
+  moodycamel::ConcurrentQueue<LinuxCallstackEvent> callstack_buffer_;
+  moodycamel::ConcurrentQueue<CallstackEvent> hashed_callstack_buffer_;
+  // Symbols are only recorded for addresses seen for the first time, so
+  // locking is rare.
+  absl::Mutex symbol_mutex_;
+  LinuxSymbolBatch symbol_buffer_;
 
-  absl::Mutex callstack_buffer_mutex_;
-  std::vector<LinuxCallstackEvent> callstack_buffer_;
+  void AddBufferedEvent(uint64_t num_bytes);
+  template <typename T>
+  void RemoveBufferedEvents(const std::vector<T>& events);
 
-  absl::Mutex hashed_callstack_buffer_mutex_;
-  std::vector<CallstackEvent> hashed_callstack_buffer_;
+  // Approximate amount of events in all the buffers. Events are counted
+  // before being enqueued, so that the counts never go below zero.
+  std::atomic<uint64_t> num_buffered_events_ = 0;
+  std::atomic<uint64_t> num_buffered_bytes_ = 0;
+  std::atomic<uint64_t> max_batch_num_events_ =
+      std::numeric_limits<uint64_t>::max();
+  std::atomic<uint64_t> max_batch_num_bytes_ =
+      std::numeric_limits<uint64_t>::max();
+  // Only locked when a limit is reached, not for every event.
+  absl::Mutex batch_mutex_;
+  bool batch_ready_ = false;
 
   TcpServer* tcp_server_;
   std::shared_ptr<StringManager> string_manager_;
@@ -3,7 +3,16 @@
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <thread>
 #include <utility>
+#include <vector>
+
+#include "absl/time/clock.h"
 
 TEST(LinuxTracingSession, Empty) {
   LinuxTracingSession session(nullptr);
@@ -361,3 +370,200 @@ TEST(LinuxTracingSession, Reset) {
   std::vector<CallstackEvent> hashed_callstacks;
   EXPECT_FALSE(session.ReadAllHashedCallstacks(&hashed_callstacks));
 }
+
+TEST(LinuxTracingSession, ConcurrentRecording) {
+  LinuxTracingSession session(nullptr);
+  constexpr uint32_t num_threads = 8;
+  constexpr uint64_t num_timers_per_thread = 10000;
+
+  std::vector<std::thread> threads;
+  for (uint32_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&session, tid] {
+      for (uint64_t i = 0; i < num_timers_per_thread; ++i) {
+        Timer timer;
+        timer.m_TID = tid;
+        timer.m_Start = i;
+        session.RecordTimer(std::move(timer));
+      }
+    });
+  }
+
+  // Read while the threads are recording, and check that the timers of each
+  // thread arrive complete and in order.
+  std::vector<uint64_t> next_starts(num_threads, 0);
+  uint64_t num_read_timers = 0;
+  while (num_read_timers < num_threads * num_timers_per_thread) {
+    std::vector<Timer> timers;
+    if (!session.ReadAllTimers(&timers)) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (const Timer& timer : timers) {
+      EXPECT_EQ(timer.m_Start, next_starts[timer.m_TID]);
+      next_starts[timer.m_TID] = timer.m_Start + 1;
+    }
+    num_read_timers += timers.size();
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  std::vector<Timer> timers;
+  EXPECT_FALSE(session.ReadAllTimers(&timers));
+}
+
+TEST(LinuxTracingSession, WaitForBatch) {
+  LinuxTracingSession session(nullptr);
+  constexpr uint64_t no_limit = std::numeric_limits<uint64_t>::max();
+  EXPECT_FALSE(session.WaitForBatch(absl::Milliseconds(1)));
+
+  session.SetBatchLimits(3, no_limit);
+  session.RecordTimer(Timer());
+  session.RecordTimer(Timer());
+  EXPECT_FALSE(session.WaitForBatch(absl::Milliseconds(1)));
+  // The limit applies to the events of all buffers.
+  session.RecordHashedCallstack(CallstackEvent(11, 12, 13));
+  EXPECT_TRUE(session.WaitForBatch(absl::InfiniteDuration()));
+  EXPECT_FALSE(session.WaitForBatch(absl::Milliseconds(1)));
+
+  std::vector<Timer> timers;
+  EXPECT_TRUE(session.ReadAllTimers(&timers));
+  std::vector<CallstackEvent> hashed_callstacks;
+  EXPECT_TRUE(session.ReadAllHashedCallstacks(&hashed_callstacks));
+
+  session.SetBatchLimits(no_limit, 2 * sizeof(Timer));
+  session.RecordTimer(Timer());
+  EXPECT_FALSE(session.WaitForBatch(absl::Milliseconds(1)));
+  session.RecordTimer(Timer());
+  EXPECT_TRUE(session.WaitForBatch(absl::InfiniteDuration()));
+}
+
+TEST(LinuxTracingSession, WaitForBatchWakesUpWhenBatchIsFull) {
+  LinuxTracingSession session(nullptr);
+  session.SetBatchLimits(2, std::numeric_limits<uint64_t>::max());
+
+  std::thread producer([&session] {
+    session.RecordTimer(Timer());
+    session.RecordTimer(Timer());
+  });
+  // Only returns once the producer has filled the batch.
+  EXPECT_TRUE(session.WaitForBatch(absl::InfiniteDuration()));
+  producer.join();
+
+  std::vector<Timer> timers;
+  EXPECT_TRUE(session.ReadAllTimers(&timers));
+  EXPECT_EQ(timers.size(), 2);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the latency
+// between recording an event and reading it, with the reader waiting for
+// batches as ConnectionManager does.
+TEST(LinuxTracingSession, DISABLED_EventToReadLatency) {
+  LinuxTracingSession session(nullptr);
+  constexpr uint64_t num_timers = 5000;
+  constexpr uint64_t batch_num_events = 100;
+  const absl::Duration max_latency = absl::Milliseconds(20);
+  session.SetBatchLimits(batch_num_events,
+                         std::numeric_limits<uint64_t>::max());
+
+  std::thread producer([&session] {
+    for (uint64_t i = 0; i < num_timers; ++i) {
+      Timer timer;
+      timer.m_Start = absl::GetCurrentTimeNanos();
+      session.RecordTimer(std::move(timer));
+      if (i % 10 == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  });
+
+  std::vector<uint64_t> latencies;
+  while (latencies.size() < num_timers) {
+    session.WaitForBatch(max_latency);
+    std::vector<Timer> timers;
+    if (session.ReadAllTimers(&timers)) {
+      uint64_t now = absl::GetCurrentTimeNanos();
+      for (const Timer& timer : timers) {
+        latencies.push_back(now - timer.m_Start);
+      }
+    }
+  }
+  producer.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  uint64_t p50 = latencies[latencies.size() / 2];
+  uint64_t p99 = latencies[latencies.size() * 99 / 100];
+  std::cout << "Event to read latency: p50 = " << p50 / 1000
+            << " us, p99 = " << p99 / 1000 << " us" << std::endl;
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the throughput
+// of recording timers, context switches and hashed callstacks from 1, 8 and 32
+// producer threads, while a reader drains the session as ConnectionManager
+// does.
+TEST(LinuxTracingSession, DISABLED_RecordContention) {
+  constexpr uint64_t num_events = 3'000'000;
+  for (uint32_t num_producers : {1, 8, 32}) {
+    LinuxTracingSession session(nullptr);
+    const uint64_t num_events_per_producer = num_events / num_producers;
+    std::atomic<uint32_t> num_done_producers = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (uint32_t tid = 0; tid < num_producers; ++tid) {
+      producers.emplace_back([&, tid] {
+        for (uint64_t i = 0; i < num_events_per_producer; ++i) {
+          switch (i % 3) {
+            case 0: {
+              Timer timer;
+              timer.m_TID = tid;
+              timer.m_Start = i;
+              session.RecordTimer(std::move(timer));
+              break;
+            }
+            case 1: {
+              ContextSwitch context_switch;
+              context_switch.m_ThreadId = tid;
+              context_switch.m_Time = i;
+              session.RecordContextSwitch(std::move(context_switch));
+              break;
+            }
+            default: {
+              CallstackEvent callstack;
+              callstack.m_TID = tid;
+              callstack.m_Time = i;
+              session.RecordHashedCallstack(std::move(callstack));
+              break;
+            }
+          }
+        }
+        ++num_done_producers;
+      });
+    }
+
+    uint64_t num_read_events = 0;
+    while (num_read_events < num_events_per_producer * num_producers) {
+      bool producers_done = num_done_producers == num_producers;
+      std::vector<Timer> timers;
+      std::vector<ContextSwitch> context_switches;
+      std::vector<CallstackEvent> callstacks;
+      session.ReadAllTimers(&timers);
+      session.ReadAllContextSwitches(&context_switches);
+      session.ReadAllHashedCallstacks(&callstacks);
+      num_read_events +=
+          timers.size() + context_switches.size() + callstacks.size();
+      if (!producers_done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    for (std::thread& producer : producers) {
+      producer.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << num_producers << " producers: "
+              << num_read_events / seconds / 1e6 << " M events/s"
+              << std::endl;
+  }
+}
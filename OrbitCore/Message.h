@@ -69,6 +69,10 @@ enum MessageType : int16_t {
   Msg_SamplingCallstacks,
   Msg_SamplingHashedCallstacks,
   Msg_KeyAndString,
+  Msg_RequestCompressedEvents,
+  Msg_RemoteTimersCompressed,
+  Msg_RemoteContextSwitchesCompressed,
+  Msg_RemoteSymbols,
 };
 
 //-----------------------------------------------------------------------------
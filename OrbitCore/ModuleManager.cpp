@@ -138,5 +138,6 @@ void ModuleManager::AddPdb(const std::shared_ptr<Pdb>& a_Pdb) {
   auto it = modules.find((DWORD64)a_Pdb->GetHModule());
   if (it != modules.end()) {
     it->second->SetLoaded(true);
+    Capture::GTargetProcess->ClearFunctionCache();
   }
 }
@@ -17,6 +17,7 @@
 #include "Pdb.h"
 #include "SamplingProfiler.h"
 #include "Serialization.h"
+#include "SymbolNamePool.h"
 #include "TcpServer.h"
 #include "Utils.h"
 
@@ -51,7 +52,7 @@ void Function::SetAsMainFrameFunction() {
 
 const std::string& Function::PrettyName() const {
   if (pretty_name_.empty()) {
-    return name_;
+    return demangled_name_.Demangle(&GSymbolNamePool, name_);
   }
 
   return pretty_name_;
@@ -82,7 +83,7 @@ void Function::Select() {
     selected_ = true;
     PRINT("Selected %s at 0x%" PRIx64 " (address_=0x%" PRIx64
           ", load_bias_= 0x%" PRIx64 ", base_address=0x%" PRIx64 ")\n",
-          pretty_name_.c_str(), GetVirtualAddress(), address_, load_bias_,
+          PrettyName().c_str(), GetVirtualAddress(), address_, load_bias_,
           pdb_->GetHModule());
     Capture::GSelectedFunctionsMap[GetVirtualAddress()] = this;
   }
@@ -225,6 +226,8 @@ const char* Function::GetCallingConventionString() {
 }
 
 ORBIT_SERIALIZE(Function, 2) {
+  // Loading may replace the name.
+  demangled_name_.Reset();
   ORBIT_NVP_VAL(0, name_);
   ORBIT_NVP_VAL(0, pretty_name_);
   ORBIT_NVP_VAL(0, address_);
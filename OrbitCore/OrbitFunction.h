@@ -11,6 +11,7 @@
 #include "FunctionStats.h"
 #include "OrbitDbgHelp.h"
 #include "SerializationMacros.h"
+#include "SymbolNamePool.h"
 #include "Utils.h"
 #include "cvconst.h"
 
@@ -95,7 +96,10 @@ class Function {
 
   // TODO: It looks like most setters are used by TestRemoteMessages::Run()
   // only. Move these to a constructor?
-  void SetName(const std::string& name) { name_ = name; }
+  void SetName(const std::string& name) {
+    name_ = name;
+    demangled_name_.Reset();
+  }
   void SetPrettyName(const std::string& pretty_name) {
     pretty_name_ = pretty_name;
   }
@@ -114,10 +118,12 @@ class Function {
   void SetPdb(Pdb* pdb) { pdb_ = pdb; }
 
   const std::string& Name() const { return name_; }
+  // Without a pretty name, the name is demangled on first use through
+  // GSymbolNamePool.
   const std::string& PrettyName() const;
   const std::string& Lower() {
     if (pretty_name_lower_.size() == 0) {
-      pretty_name_lower_ = ToLower(pretty_name_);
+      pretty_name_lower_ = ToLower(PrettyName());
     }
     return pretty_name_lower_;
   }
@@ -131,7 +137,7 @@ class Function {
   const char* GetCallingConventionString();
   void ProcessArgumentInfo();
   bool IsMemberFunction();
-  uint64_t Hash() const { return StringHash(pretty_name_); }
+  uint64_t Hash() const { return StringHash(PrettyName()); }
   void UpdateStats(const Timer& timer);
   bool Hookable();
   void Select();
@@ -167,6 +173,9 @@ class Function {
  private:
   std::string name_;
   std::string pretty_name_;
+  // Where GSymbolNamePool keeps the demangled name_, once PrettyName looked it
+  // up.
+  DemangledNameCache demangled_name_;
   std::string pretty_name_lower_;
   std::string module_;
   std::string file_;
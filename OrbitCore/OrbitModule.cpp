@@ -101,6 +101,11 @@ ORBIT_SERIALIZE(Module, 0) {
 
 //-----------------------------------------------------------------------------
 Function* Pdb::FunctionFromName(const std::string& a_Name) {
+  // Hashing pretty names demangles them all, so only do it when needed.
+  if (m_StringFunctionMap.empty()) {
+    PopulateStringFunctionMap();
+  }
+
   uint64_t hash = StringHash(a_Name);
   auto iter = m_StringFunctionMap.find(hash);
   return (iter == m_StringFunctionMap.end()) ? nullptr : iter->second;
@@ -255,15 +260,20 @@ void Pdb::ProcessData() {
   }
 
   PopulateFunctionMap();
-  PopulateStringFunctionMap();
+  // Functions may have moved, FunctionFromName rebuilds the map on its next
+  // call.
+  m_StringFunctionMap.clear();
 }
 
 //-----------------------------------------------------------------------------
 void Pdb::PopulateFunctionMap() {
   SCOPE_TIMER_LOG("Pdb::PopulateFunctionMap");
+  std::vector<std::pair<uint64_t, Function*>> functions;
+  functions.reserve(m_Functions.size());
   for (Function& function : m_Functions) {
-    m_FunctionMap.insert(std::make_pair(function.Address(), &function));
+    functions.emplace_back(function.Address(), &function);
   }
+  m_FunctionIndex.Build(std::move(functions));
 }
 
 //-----------------------------------------------------------------------------
@@ -284,25 +294,26 @@ void Pdb::PopulateStringFunctionMap() {
 //-----------------------------------------------------------------------------
 Function* Pdb::GetFunctionFromExactAddress(uint64_t a_Address) {
   uint64_t function_address = a_Address - (uint64_t)GetHModule() + load_bias_;
-  auto it = m_FunctionMap.find(function_address);
-  return (it != m_FunctionMap.end()) ? it->second : nullptr;
+  return m_FunctionIndex.FindExact(function_address);
 }
 
 //-----------------------------------------------------------------------------
 Function* Pdb::GetFunctionFromProgramCounter(uint64_t a_Address) {
-  if (m_FunctionMap.empty()) {
-    return nullptr;
-  }
-
   uint64_t relative_address = a_Address - (uint64_t)GetHModule() + load_bias_;
-  auto it = m_FunctionMap.upper_bound(relative_address);
+  return m_FunctionIndex.FindFloor(relative_address);
+}
 
-  if (it == m_FunctionMap.begin()) {
-    return nullptr;
+//-----------------------------------------------------------------------------
+void Pdb::GetFunctionsFromProgramCounters(const uint64_t* a_Addresses,
+                                          size_t a_NumAddresses,
+                                          Function** o_Functions) {
+  std::vector<uint64_t> relative_addresses(a_NumAddresses);
+  for (size_t i = 0; i < a_NumAddresses; ++i) {
+    relative_addresses[i] =
+        a_Addresses[i] - (uint64_t)GetHModule() + load_bias_;
   }
-
-  --it;
-  return it->second;
+  m_FunctionIndex.FindFloors(relative_addresses.data(), a_NumAddresses,
+                             o_Functions);
 }
 
 #endif
@@ -118,6 +118,7 @@ void Process::ListModules() {
     module->LoadDebugInfo();
 #endif
   }
+  ClearFunctionCache();
 }
 
 //-----------------------------------------------------------------------------
@@ -261,6 +262,39 @@ Function* Process::GetFunctionFromAddress(uint64_t address, bool a_IsExact) {
   }
 }
 
+//-----------------------------------------------------------------------------
+void Process::ResolveAddresses(std::vector<uint64_t>* a_Addresses) {
+  ScopeLock lock(m_FunctionCacheMutex);
+  m_FunctionCache.Resolve(m_Modules, a_Addresses);
+}
+
+//-----------------------------------------------------------------------------
+Function* Process::GetCachedFunctionFromAddress(uint64_t a_Address,
+                                                bool a_IsExact) {
+  ScopeLock lock(m_FunctionCacheMutex);
+  Function* function = nullptr;
+  if (!m_FunctionCache.Find(a_Address, &function)) {
+    function = m_FunctionCache.ResolveOne(m_Modules, a_Address);
+  }
+
+  // The cache holds the functions containing the addresses.
+  if (a_IsExact && function != nullptr) {
+    const Pdb* pdb = function->GetPdb();
+    if (pdb != nullptr &&
+        function->Address() !=
+            a_Address - pdb->GetHModule() + pdb->GetLoadBias()) {
+      return nullptr;
+    }
+  }
+  return function;
+}
+
+//-----------------------------------------------------------------------------
+void Process::ClearFunctionCache() {
+  ScopeLock lock(m_FunctionCacheMutex);
+  m_FunctionCache.Clear();
+}
+
 //-----------------------------------------------------------------------------
 std::shared_ptr<Module> Process::GetModuleFromAddress(DWORD64 a_Address) {
   DWORD64 address = (DWORD64)a_Address;
@@ -347,6 +381,17 @@ void Process::AddType(Type& a_Type) {
 //-----------------------------------------------------------------------------
 void Process::AddModule(std::shared_ptr<Module>& a_Module) {
   m_Modules[a_Module->m_AddressStart] = a_Module;
+  ClearFunctionCache();
+}
+
+//-----------------------------------------------------------------------------
+void Process::AddFunctions(const std::shared_ptr<Module>& a_Module,
+                           std::vector<Function>& a_Functions) {
+  for (Function& function : a_Functions) {
+    a_Module->m_Pdb->AddFunction(function);
+  }
+  a_Module->m_Pdb->ProcessData();
+  ClearFunctionCache();
 }
 
 //-----------------------------------------------------------------------------
@@ -390,6 +435,7 @@ void Process::FindPdbs(const std::vector<std::string>& a_SearchLocations) {
       }
     }
   }
+  ClearFunctionCache();
 #else
   UNUSED(a_SearchLocations);
 #endif
@@ -408,6 +454,7 @@ void Process::FillModuleDebugInfo(ModuleDebugInfo& a_ModuleDebugInfo) {
     module->LoadDebugInfo();
     const std::string& moduleName = module->m_FullName;
     module->m_Pdb->LoadPdb(moduleName.c_str());
+    ClearFunctionCache();
     a_ModuleDebugInfo.m_Functions = module->m_Pdb->GetFunctions();
     a_ModuleDebugInfo.load_bias = module->m_Pdb->GetLoadBias();
   } else {
@@ -9,6 +9,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "AddressResolutionCache.h"
 #include "BaseTypes.h"
 #include "DiaManager.h"
 #include "LinuxSymbol.h"
@@ -58,6 +59,10 @@ class Process {
     return m_ThreadNames[a_ThreadId];
   }
   void AddModule(std::shared_ptr<Module>& a_Module);
+  // Adds functions to the Pdb of one of the modules of this process and
+  // processes them.
+  void AddFunctions(const std::shared_ptr<Module>& a_Module,
+                    std::vector<Function>& a_Functions);
   void FindPdbs(const std::vector<std::string>& a_SearchLocations);
   void FillModuleDebugInfo(ModuleDebugInfo& a_ModuleDebugInfo);
 
@@ -87,6 +92,17 @@ class Process {
   void SetCpuUsage(float a_Usage) { m_CpuUsage = a_Usage; }
 
   Function* GetFunctionFromAddress(uint64_t address, bool a_IsExact = true);
+  // Resolves many addresses at once into the cache used by
+  // GetCachedFunctionFromAddress. a_Addresses is sorted and deduplicated in
+  // place.
+  void ResolveAddresses(std::vector<uint64_t>* a_Addresses);
+  // Same as GetFunctionFromAddress, through the cache of resolved addresses.
+  // Addresses that are not cached yet are resolved one by one, which is
+  // slower than resolving them in a batch with ResolveAddresses.
+  Function* GetCachedFunctionFromAddress(uint64_t a_Address,
+                                         bool a_IsExact = true);
+  // Must be called when the functions of a module change.
+  void ClearFunctionCache();
   std::shared_ptr<Module> GetModuleFromAddress(DWORD64 a_Address);
   std::shared_ptr<Module> GetModuleFromName(const std::string& a_Name);
 
@@ -160,6 +176,9 @@ class Process {
 
   absl::flat_hash_map<uint64_t, std::shared_ptr<LinuxSymbol> > m_Symbols;
 
+  AddressResolutionCache m_FunctionCache;
+  Mutex m_FunctionCacheMutex;
+
   // Transients
   std::vector<Function*> m_Functions;
   std::vector<Type*> m_Types;
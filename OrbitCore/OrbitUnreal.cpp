@@ -19,7 +19,9 @@ void OrbitUnreal::OnTypeAdded(Type* a_Type) {
 
 //-----------------------------------------------------------------------------
 void OrbitUnreal::OnFunctionAdded(Function* a_Function) {
-  if (a_Function->PrettyName() == "FName::GetDisplayNameEntry") {
+  // Avoid demangling the names of all other functions.
+  if (a_Function->Name().find("GetDisplayNameEntry") != std::string::npos &&
+      a_Function->PrettyName() == "FName::GetDisplayNameEntry") {
     m_GetDisplayNameEntryFunc = a_Function;
   }
 }
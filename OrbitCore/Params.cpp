@@ -34,9 +34,22 @@ Params::Params()
       m_FontSize(14.f),
       m_Port(44766),
       m_NumBytesAssembly(1024),
+      m_EventBatchMaxNumEvents(10000),
+      m_EventBatchMaxNumBytes(1024 * 1024),
+      m_EventBatchMaxLatencyMs(20),
+      m_LiveSamplingReportPeriodMs(1000),
+      m_SamplingReportWindowSeconds(0),
+      m_UseEventDrivenWakeup(false),
+      m_SamplingWakeupWatermarkBytes(512 * 1024),
+      m_UprobesWakeupWatermarkBytes(4 * 1024 * 1024),
+      m_NumTracingReaderThreads(1),
+      m_SamplingStackDumpBytes(65000),
+      m_UprobesStackDumpBytes(65000),
+      m_TrimUprobesStacks(false),
+      m_UseFramePointerUnwinding(false),
       m_DiffArgs("%1 %2") {}
 
-ORBIT_SERIALIZE(Params, 16) {
+ORBIT_SERIALIZE(Params, 22) {
   ORBIT_NVP_VAL(0, m_LoadTypeInfo);
   ORBIT_NVP_VAL(0, m_SendCallStacks);
   ORBIT_NVP_VAL(0, m_MaxNumTimers);
@@ -61,6 +74,19 @@ ORBIT_SERIALIZE(Params, 16) {
   ORBIT_NVP_VAL(13, m_ProcessFilter);
   ORBIT_NVP_VAL(14, m_BpftraceCallstacks);
   ORBIT_NVP_VAL(15, m_SystemWideScheduling);
+  ORBIT_NVP_VAL(17, m_EventBatchMaxNumEvents);
+  ORBIT_NVP_VAL(17, m_EventBatchMaxNumBytes);
+  ORBIT_NVP_VAL(17, m_EventBatchMaxLatencyMs);
+  ORBIT_NVP_VAL(18, m_LiveSamplingReportPeriodMs);
+  ORBIT_NVP_VAL(18, m_SamplingReportWindowSeconds);
+  ORBIT_NVP_VAL(19, m_UseEventDrivenWakeup);
+  ORBIT_NVP_VAL(19, m_SamplingWakeupWatermarkBytes);
+  ORBIT_NVP_VAL(19, m_UprobesWakeupWatermarkBytes);
+  ORBIT_NVP_VAL(20, m_NumTracingReaderThreads);
+  ORBIT_NVP_VAL(21, m_SamplingStackDumpBytes);
+  ORBIT_NVP_VAL(21, m_UprobesStackDumpBytes);
+  ORBIT_NVP_VAL(21, m_TrimUprobesStacks);
+  ORBIT_NVP_VAL(22, m_UseFramePointerUnwinding);
 }
 
 //-----------------------------------------------------------------------------
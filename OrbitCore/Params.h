@@ -36,6 +36,33 @@ struct Params {
   float m_FontSize;
   int m_Port;
   uint64_t m_NumBytesAssembly;
+  // Events recorded by the service are sent to the client as soon as this
+  // many events or bytes are buffered, and at the latest after this latency.
+  uint64_t m_EventBatchMaxNumEvents;
+  uint64_t m_EventBatchMaxNumBytes;
+  int m_EventBatchMaxLatencyMs;
+  // The sampling report is updated this often while sampling, if not 0.
+  int m_LiveSamplingReportPeriodMs;
+  // If not 0, the sampling report only covers the samples of the last this
+  // many seconds.
+  double m_SamplingReportWindowSeconds;
+  // If set, the Linux tracer blocks on its ring buffers until enough bytes
+  // are available in one of them, instead of polling them. The watermarks are
+  // the number of bytes that wake it up for stack samples and uprobes.
+  bool m_UseEventDrivenWakeup;
+  uint32_t m_SamplingWakeupWatermarkBytes;
+  uint32_t m_UprobesWakeupWatermarkBytes;
+  // Number of threads reading the Linux tracer's ring buffers in parallel.
+  uint32_t m_NumTracingReaderThreads;
+  // Bytes of user stack copied with each stack sample and uprobes event, and
+  // whether the copies kept until instrumented functions return are trimmed.
+  uint16_t m_SamplingStackDumpBytes;
+  uint16_t m_UprobesStackDumpBytes;
+  bool m_TrimUprobesStacks;
+  // If set, callstacks are unwound by following frame pointers, falling back
+  // to DWARF-based unwinding when the chain is broken. Only suitable if the
+  // target is compiled with -fno-omit-frame-pointer.
+  bool m_UseFramePointerUnwinding;
   std::string m_DiffExe;
   std::string m_DiffArgs;
   std::vector<std::string> m_PdbHistory;
@@ -13,6 +13,7 @@
 #include "Capture.h"
 #include "Core.h"
 #include "DiaManager.h"
+#include "ElfFile.h"
 #include "Log.h"
 #include "ObjectCount.h"
 #include "OrbitSession.h"
@@ -140,7 +141,7 @@ void Pdb::Clear() {
   m_Types.clear();
   m_Globals.clear();
   m_TypeMap.clear();
-  m_FunctionMap.clear();
+  m_FunctionIndex.Clear();
   m_FileName = "";
 }
 
@@ -417,38 +418,24 @@ void ShowSymbolInfo(IMAGEHLP_MODULE64& ModuleInfo) {
 }
 
 //-----------------------------------------------------------------------------
+// Unlike the llvm-nm output this used to parse, ElfFile only returns the
+// defined STT_FUNC symbols of .symtab, so variables, sections and undefined
+// symbols are no longer added as functions. The load bias of the file is now
+// also set on the Pdb, so that addresses are translated like for Linux modules.
 bool Pdb::LoadLinuxDebugSymbols(const char* a_PdbName) {
   SCOPE_TIMER_LOG("LoadLinuxDebugSymbols");
-  std::string external = Path::GetExternalPath();
-  std::string tmp =
-      Path::GetTmpPath() + "cmd_" + OrbitUtils::GetTimeStamp() + ".txt";
-  std::string nmCommand = external + std::string("llvm\\llvm-nm.exe ") +
-                          a_PdbName /*+ std::string(" -n")*/;
-
-  const char* tmpname = tmp.data();
-  std::string cmd = nmCommand + " > " + tmpname;
-  std::system(cmd.c_str());
-  std::ifstream file(tmpname, std::ios::in | std::ios::binary);
-  std::string result;
-  std::string line;
-  int numAddedFunctions = 0;
-  while (std::getline(file, line)) {
-    std::vector<std::string> tokens = Tokenize(line);
-    if (tokens.size() == 3) {
-      const std::string& address = tokens[0];
-      const std::string& symbol = tokens[2];
-      Function func;
-      func.SetName(symbol);
-      func.SetAddress(std::stoull(address, nullptr, 16));
-      func.SetPrettyName(symbol);
-      func.SetModule(Path::GetFileName(a_PdbName));
-      func.SetPdb(this);
-      this->AddFunction(func);
-      ++numAddedFunctions;
-    }
+  std::unique_ptr<ElfFile> elf_file = ElfFile::Create(a_PdbName);
+  if (elf_file == nullptr) {
+    PRINT(absl::StrFormat("Unable to load elf-file \"%s\"", a_PdbName));
+    return false;
+  }
+
+  std::optional<uint64_t> load_bias = elf_file->GetLoadBias();
+  if (load_bias) {
+    load_bias_ = load_bias.value();
   }
-  remove(tmpname);
-  return numAddedFunctions > 0;
+
+  return elf_file->GetFunctions(this, &m_Functions);
 }
 
 //-----------------------------------------------------------------------------
@@ -534,9 +521,12 @@ void Pdb::PopulateFunctionMap() {
   SCOPE_TIMER_LOG(
       absl::StrFormat("Pdb::PopulateFunctionMap for %s", m_FileName.c_str()));
 
+  std::vector<std::pair<uint64_t, Function*>> functions;
+  functions.reserve(m_Functions.size());
   for (Function& Function : m_Functions) {
-    m_FunctionMap.insert(std::make_pair(Function.Address(), &Function));
+    functions.emplace_back(Function.Address(), &Function);
   }
+  m_FunctionIndex.Build(std::move(functions));
 
   m_IsPopulatingFunctionMap = false;
 }
@@ -604,26 +594,24 @@ void Pdb::ApplyPresets() {
 //-----------------------------------------------------------------------------
 Function* Pdb::GetFunctionFromExactAddress(uint64_t a_Address) {
   uint64_t address = a_Address - (uint64_t)GetHModule() + load_bias_;
-
-  if (m_FunctionMap.find(address) != m_FunctionMap.end()) {
-    return m_FunctionMap[address];
-  }
-
-  return nullptr;
+  return m_FunctionIndex.FindExact(address);
 }
 
 //-----------------------------------------------------------------------------
 Function* Pdb::GetFunctionFromProgramCounter(uint64_t a_Address) {
   uint64_t address = a_Address - (uint64_t)GetHModule() + load_bias_;
+  return m_FunctionIndex.FindFloor(address);
+}
 
-  auto it = m_FunctionMap.upper_bound(address);
-  if (!m_FunctionMap.empty() && it != m_FunctionMap.begin()) {
-    --it;
-    Function* func = it->second;
-    return func;
+//-----------------------------------------------------------------------------
+void Pdb::GetFunctionsFromProgramCounters(const uint64_t* a_Addresses,
+                                          size_t a_NumAddresses,
+                                          Function** o_Functions) {
+  std::vector<uint64_t> addresses(a_NumAddresses);
+  for (size_t i = 0; i < a_NumAddresses; ++i) {
+    addresses[i] = a_Addresses[i] - (uint64_t)GetHModule() + load_bias_;
   }
-
-  return nullptr;
+  m_FunctionIndex.FindFloors(addresses.data(), a_NumAddresses, o_Functions);
 }
 
 //-----------------------------------------------------------------------------
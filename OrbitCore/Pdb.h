@@ -8,6 +8,7 @@
 #include <thread>
 #include <vector>
 
+#include "FunctionAddressIndex.h"
 #include "OrbitDbgHelp.h"
 #include "OrbitType.h"
 #include "Variable.h"
@@ -74,6 +75,11 @@ class Pdb {
 
   Function* GetFunctionFromExactAddress(uint64_t a_Address);
   Function* GetFunctionFromProgramCounter(uint64_t a_Address);
+  // Same as GetFunctionFromProgramCounter for each of a_NumAddresses
+  // addresses sorted in increasing order, in a single pass over the functions.
+  void GetFunctionsFromProgramCounters(const uint64_t* a_Addresses,
+                                       size_t a_NumAddresses,
+                                       Function** o_Functions);
   std::shared_ptr<OrbitDiaSymbol> SymbolFromAddress(uint64_t a_Address);
   bool LineInfoFromAddress(uint64_t a_Address, struct LineInfo& o_LineInfo);
 
@@ -129,7 +135,7 @@ class Pdb {
   std::vector<Variable> m_Globals;
   IMAGEHLP_MODULE64 m_ModuleInfo;
   std::unordered_map<ULONG, Type> m_TypeMap;
-  std::map<uint64_t, Function*> m_FunctionMap;
+  FunctionAddressIndex m_FunctionIndex;
   std::unordered_map<unsigned long long, Function*> m_StringFunctionMap;
   Timer* m_LoadTimer;
 
@@ -194,6 +200,11 @@ class Pdb {
 
   Function* GetFunctionFromExactAddress(uint64_t a_Address);
   Function* GetFunctionFromProgramCounter(uint64_t a_Address);
+  // Same as GetFunctionFromProgramCounter for each of a_NumAddresses
+  // addresses sorted in increasing order, in a single pass over the functions.
+  void GetFunctionsFromProgramCounters(const uint64_t* a_Addresses,
+                                       size_t a_NumAddresses,
+                                       Function** o_Functions);
   IDiaSymbol* SymbolFromAddress(uint64_t a_Address);
   bool LineInfoFromAddress(uint64_t a_Address, struct LineInfo& o_LineInfo);
   Function* FunctionFromName(const std::string& a_Name);
@@ -238,7 +249,7 @@ class Pdb {
   std::vector<Type> m_Types;
   std::vector<Variable> m_Globals;
   std::unordered_map<ULONG, Type> m_TypeMap;
-  std::map<uint64_t, Function*> m_FunctionMap;
+  FunctionAddressIndex m_FunctionIndex;
   std::unordered_map<unsigned long long, Function*> m_StringFunctionMap;
   Timer* m_LoadTimer = nullptr;
 };
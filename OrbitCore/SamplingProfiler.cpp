@@ -4,6 +4,7 @@
 
 #include "SamplingProfiler.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <set>
@@ -15,7 +16,10 @@
 #include "OrbitModule.h"
 #include "OrbitThread.h"
 #include "Params.h"
+#include "Profiling.h"
 #include "Serialization.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 
 #ifdef _WIN32
 #include <dia2.h>
@@ -39,7 +43,7 @@ SamplingProfiler::SamplingProfiler() {
 }
 
 //-----------------------------------------------------------------------------
-SamplingProfiler::~SamplingProfiler() {}
+SamplingProfiler::~SamplingProfiler() { JoinUpdateReportThread(); }
 
 //-----------------------------------------------------------------------------
 void SamplingProfiler::StartCapture() {
@@ -55,7 +59,10 @@ void SamplingProfiler::StartCapture() {
 }
 
 //-----------------------------------------------------------------------------
-void SamplingProfiler::StopCapture() { m_State = PendingStop; }
+void SamplingProfiler::StopCapture() {
+  m_State = PendingStop;
+  JoinUpdateReportThread();
+}
 
 //-----------------------------------------------------------------------------
 void SamplingProfiler::SampleThreadsAsync() {
@@ -93,6 +100,7 @@ void SamplingProfiler::SampleThreadsAsync() {
 
 //-----------------------------------------------------------------------------
 void SamplingProfiler::GetThreadsUsage() {
+  ScopeLock lock(m_Mutex);
   for (const auto& thread : m_Process->GetThreads()) {
     m_ThreadSampleData[thread->m_TID].m_ThreadUsage.push_back(
         thread->GetUsage());
@@ -101,6 +109,7 @@ void SamplingProfiler::GetThreadsUsage() {
 
 //-----------------------------------------------------------------------------
 void SamplingProfiler::ReserveThreadData() {
+  ScopeLock lock(m_Mutex);
   for (const auto& thread : m_Process->GetThreads()) {
     m_ThreadSampleData[thread->m_TID].m_ThreadUsage.reserve(1024);
     m_ThreadSampleData[thread->m_TID].m_TID = thread->m_TID;
@@ -129,38 +138,56 @@ void SamplingProfiler::FireDoneProcessingCallbacks() {
 //-----------------------------------------------------------------------------
 std::multimap<int, CallstackID> SamplingProfiler::GetCallStacksFromAddress(
     uint64_t a_Addr, ThreadID a_TID, int& o_NumCallstacks) {
-  std::set<CallstackID>& callstacks = m_FunctionToCallstacks[a_Addr];
-  return m_ThreadSampleData[a_TID].SortCallstacks(callstacks, o_NumCallstacks);
+  const std::vector<uint32_t>& callstacks = m_FunctionToCallstacks[a_Addr];
+  return m_ThreadSampleData[a_TID].SortCallstacks(m_UniqueCallstacks,
+                                                  callstacks, o_NumCallstacks);
 }
 
 //-----------------------------------------------------------------------------
-void SamplingProfiler::AddCallStack(CallStack& a_CallStack) {
+void SamplingProfiler::AddCallStack(CallStack& a_CallStack, uint64_t a_Time) {
   CallstackID hash = a_CallStack.Hash();
-  if (!HasCallStack(hash)) {
-    AddUniqueCallStack(a_CallStack);
-  }
-  CallstackEvent hashedCS;
-  hashedCS.m_Id = hash;
-  hashedCS.m_TID = a_CallStack.m_ThreadId;
-  AddHashedCallStack(hashedCS);
+  ScopeLock lock(m_Mutex);
+  CallstackSample sample;
+  sample.m_Time = a_Time;
+  sample.m_CallstackIndex = m_UniqueCallstacks.Intern(
+      hash, a_CallStack.m_Data.data(), a_CallStack.m_Depth);
+  sample.m_TID = a_CallStack.m_ThreadId;
+  m_Callstacks.push_back(sample);
+}
+
+//-----------------------------------------------------------------------------
+void SamplingProfiler::AddCallStack(const CallstackView& a_CallStack,
+                                    ThreadID a_TID, uint64_t a_Time) {
+  ScopeLock lock(m_Mutex);
+  CallstackSample sample;
+  sample.m_Time = a_Time;
+  sample.m_CallstackIndex = m_UniqueCallstacks.Intern(
+      a_CallStack.Hash(), a_CallStack.Data(), a_CallStack.Depth());
+  sample.m_TID = a_TID;
+  m_Callstacks.push_back(sample);
 }
 
 //-----------------------------------------------------------------------------
 void SamplingProfiler::AddHashedCallStack(CallstackEvent& a_CallStack) {
-  if (!HasCallStack(a_CallStack.m_Id)) {
+  ScopeLock lock(m_Mutex);
+  CallstackSample sample;
+  sample.m_CallstackIndex = m_UniqueCallstacks.GetIndex(a_CallStack.m_Id);
+  if (sample.m_CallstackIndex == CallstackInternTable::INVALID_INDEX) {
     PRINT(
         "Error: Callstacks can only be added by hash when they are already "
         "present.\n");
+    return;
   }
-  ScopeLock lock(m_Mutex);
-  m_Callstacks.push_back(a_CallStack);
+  sample.m_Time = static_cast<uint64_t>(a_CallStack.m_Time);
+  sample.m_TID = a_CallStack.m_TID;
+  m_Callstacks.push_back(sample);
 }
 
 //-----------------------------------------------------------------------------
 void SamplingProfiler::AddUniqueCallStack(CallStack& a_CallStack) {
   ScopeLock lock(m_Mutex);
-  m_UniqueCallstacks[a_CallStack.Hash()] =
-      std::make_shared<CallStack>(a_CallStack);
+  m_UniqueCallstacks.Intern(a_CallStack.Hash(), a_CallStack.m_Data.data(),
+                            a_CallStack.m_Depth);
 }
 
 //-----------------------------------------------------------------------------
@@ -190,13 +217,15 @@ void SamplingProfiler::SortByThreadUsage() {
   m_SortedThreadSampleData.reserve(m_ThreadSampleData.size());
 
   // "All"
-  m_ThreadSampleData[0].m_AverageThreadUsage = 100.f;
+  ThreadSampleData& threadSampleDataAll = m_ThreadSampleData[0];
 
   for (auto& pair : m_ThreadSampleData) {
     ThreadSampleData& data = pair.second;
     data.m_TID = pair.first;
+    data.ComputeAverageThreadUsage();
     m_SortedThreadSampleData.push_back(&data);
   }
+  threadSampleDataAll.m_AverageThreadUsage = 100.f;
 
   sort(m_SortedThreadSampleData.begin(), m_SortedThreadSampleData.end(),
        [](const ThreadSampleData* a, const ThreadSampleData* b) {
@@ -235,14 +264,12 @@ bool SamplingProfiler::GetLineInfo(uint64_t a_Address, LineInfo& a_LineInfo) {
 //-----------------------------------------------------------------------------
 void SamplingProfiler::Print() {
   ScopeLock lock(m_Mutex);
-  for (auto& pair : m_UniqueCallstacks) {
-    std::shared_ptr<CallStack> callstack = pair.second;
-    if (callstack) {
-      PRINT_VAR((void*)callstack->m_Hash);
-      PRINT_VAR(callstack->m_Depth);
-      for (uint32_t i = 0; i < callstack->m_Depth; ++i) {
-        PRINT("%s\n", m_AddressToSymbol[callstack->m_Data[i]].c_str());
-      }
+  for (uint32_t index = 0; index < m_UniqueCallstacks.Size(); ++index) {
+    CallstackView callstack = m_UniqueCallstacks.Get(index);
+    PRINT_VAR((void*)callstack.Hash());
+    PRINT_VAR(callstack.Depth());
+    for (uint64_t address : callstack) {
+      PRINT("%s\n", m_AddressToSymbol[address].c_str());
     }
   }
 }
@@ -260,68 +287,285 @@ void SamplingProfiler::ProcessSamples() {
 
   m_State = Processing;
 
-  // Unique call stacks and per thread data
-  for (const CallstackEvent& callstack : m_Callstacks) {
-    if (!HasCallStack(callstack.m_Id)) {
-      PRINT("Error: Processed unknown callstack!\n");
-    }
+  // Samples were already processed by earlier updates, if any, so only those
+  // added since remain.
+  UpdateReport();
+  SortByThreadUsage();
+
+  OutputStats();
 
-    ThreadSampleData& threadSampleData = m_ThreadSampleData[callstack.m_TID];
-    threadSampleData.m_NumSamples++;
-    threadSampleData.m_CallstackCount[callstack.m_Id]++;
+  m_State = DoneProcessing;
+}
+
+//-----------------------------------------------------------------------------
+bool SamplingProfiler::UpdateReport() {
+  ScopeLock lock(m_Mutex);
+  if (m_Callstacks.size() == 0) {
+    return false;
+  }
+
+  ProcessAddresses();
 
+  // Changes to the number of samples per (thread, callstack index). Most new
+  // samples are of callstacks that were already sampled, so there are far
+  // fewer changes than samples.
+  absl::flat_hash_map<uint64_t, int> countDeltas;
+  auto getKey = [](const CallstackSample& a_Sample) {
+    return (static_cast<uint64_t>(a_Sample.m_TID) << 32) |
+           a_Sample.m_CallstackIndex;
+  };
+  for (const CallstackSample& sample : m_Callstacks) {
+    ++countDeltas[getKey(sample)];
+  }
+  int numSamplesDelta = static_cast<int>(m_Callstacks.size());
+
+  if (m_WindowTicks != 0) {
+    for (const CallstackSample& sample : m_Callstacks) {
+      m_LatestSampleTime = std::max(m_LatestSampleTime, sample.m_Time);
+      m_WindowSamples.push_back(sample);
+    }
+    while (!m_WindowSamples.empty() &&
+           m_WindowSamples.front().m_Time + m_WindowTicks <
+               m_LatestSampleTime) {
+      --countDeltas[getKey(m_WindowSamples.front())];
+      --numSamplesDelta;
+      m_WindowSamples.pop_front();
+    }
+  }
+
+  std::unordered_map<ThreadID, std::vector<std::pair<uint32_t, int>>>
+      threadDeltas;
+  absl::flat_hash_map<uint32_t, int> summaryDeltas;
+  for (const auto& [key, delta] : countDeltas) {
+    ThreadID tid = static_cast<ThreadID>(key >> 32);
+    uint32_t callstackIndex = static_cast<uint32_t>(key);
+    if (delta == 0) {
+      continue;
+    }
     if (m_GenerateSummary) {
-      ThreadSampleData& threadSampleDataAll = m_ThreadSampleData[0];
-      threadSampleDataAll.m_NumSamples++;
-      threadSampleDataAll.m_CallstackCount[callstack.m_Id]++;
+      // The summary only counts samples of actual threads.
+      if (tid == 0) {
+        continue;
+      }
+      summaryDeltas[callstackIndex] += delta;
     }
+    threadDeltas[tid].emplace_back(callstackIndex, delta);
+  }
+  if (m_GenerateSummary && !summaryDeltas.empty()) {
+    threadDeltas[0].assign(summaryDeltas.begin(), summaryDeltas.end());
   }
 
-  ProcessAddresses();
+  // Each thread, including "All", only writes to its own ThreadSampleData.
+  std::vector<std::pair<ThreadSampleData*,
+                        const std::vector<std::pair<uint32_t, int>>*>>
+      updates;
+  updates.reserve(threadDeltas.size());
+  for (const auto& [tid, deltas] : threadDeltas) {
+    updates.emplace_back(&m_ThreadSampleData[tid], &deltas);
+  }
+  ParallelFor(updates.size(), [&](size_t a_Index) {
+    UpdateThreadSampleData(updates[a_Index].first, *updates[a_Index].second);
+  });
 
-  for (auto& dataIt : m_ThreadSampleData) {
-    ThreadSampleData& threadSampleData = dataIt.second;
+  SortByThreadUsage();
 
-    threadSampleData.ComputeAverageThreadUsage();
+  m_NumSamples += numSamplesDelta;
+  m_Callstacks.clear();
+  ++m_ReportVersion;
+  return true;
+}
 
-    // Address count per sample per thread
-    for (auto& stackCountIt : threadSampleData.m_CallstackCount) {
-      const CallstackID callstackID = stackCountIt.first;
-      const unsigned int callstackCount = stackCountIt.second;
+//-----------------------------------------------------------------------------
+void SamplingProfiler::UpdateReportAsync() {
+  if (m_UpdatingReport.exchange(true)) {
+    return;
+  }
+  // The previous update is done, only its thread remains to be joined.
+  JoinUpdateReportThread();
+  m_UpdateReportThread = std::thread([this] {
+    UpdateReport();
+    m_UpdatingReport = false;
+  });
+}
 
-      CallstackID resolvedCallstackID = m_RawToResolvedMap[callstackID];
-      std::shared_ptr<CallStack>& callstack =
-          m_UniqueResolvedCallstacks[resolvedCallstackID];
+//-----------------------------------------------------------------------------
+void SamplingProfiler::JoinUpdateReportThread() {
+  if (m_UpdateReportThread.joinable()) {
+    m_UpdateReportThread.join();
+  }
+}
 
-      // exclusive stat
-      threadSampleData.m_ExclusiveCount[callstack->m_Data[0]] += callstackCount;
+//-----------------------------------------------------------------------------
+bool SamplingProfiler::GetSampleReport(ThreadID a_TID,
+                                       std::vector<SampledFunction>* o_Report) {
+  ScopeLock lock(m_Mutex);
+  auto it = m_ThreadSampleData.find(a_TID);
+  if (it == m_ThreadSampleData.end()) {
+    return false;
+  }
+  *o_Report = it->second.m_SampleReport;
+  return true;
+}
 
-      std::set<uint64_t> uniqueAddresses;
-      for (uint32_t i = 0; i < callstack->m_Depth; ++i) {
-        uniqueAddresses.insert(callstack->m_Data[i]);
-      }
+//-----------------------------------------------------------------------------
+void SamplingProfiler::SetSlidingWindow(double a_Seconds) {
+  ScopeLock lock(m_Mutex);
+  m_WindowTicks =
+      a_Seconds > 0 ? TicksFromMicroseconds(a_Seconds * 1000000.0) : 0;
+}
 
-      for (uint64_t address : uniqueAddresses) {
-        threadSampleData.m_AddressCount[address] += callstackCount;
-      }
+//-----------------------------------------------------------------------------
+// Adds a_Delta to the count of a_Address. Addresses whose count drops to zero
+// are removed so that they leave the report.
+static void AddCount(std::unordered_map<uint64_t, unsigned int>* a_Counts,
+                     uint64_t a_Address, int a_Delta) {
+  unsigned int& count = (*a_Counts)[a_Address];
+  count += a_Delta;
+  if (count == 0) {
+    a_Counts->erase(a_Address);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void SamplingProfiler::UpdateThreadSampleData(
+    ThreadSampleData* a_ThreadSampleData,
+    const std::vector<std::pair<uint32_t, int>>& a_CallstackCountDeltas) {
+  ThreadSampleData& threadSampleData = *a_ThreadSampleData;
+  std::vector<unsigned int>& callstackCounts =
+      threadSampleData.m_CallstackCount;
+  if (callstackCounts.size() < m_RawToResolvedIndex.size()) {
+    callstackCounts.resize(m_RawToResolvedIndex.size());
+  }
+
+  // Addresses whose inclusive or exclusive count changed. The exclusive
+  // address of a callstack is also one of its addresses.
+  absl::flat_hash_set<uint64_t> changedAddresses;
+  for (const auto& [callstackIndex, delta] : a_CallstackCountDeltas) {
+    callstackCounts[callstackIndex] += delta;
+    threadSampleData.m_NumSamples += delta;
+
+    uint32_t resolvedIndex = m_RawToResolvedIndex[callstackIndex];
+    CallstackView callstack = m_UniqueResolvedCallstacks.Get(resolvedIndex);
+    if (callstack.Depth() == 0) {
+      continue;
     }
 
-    // sort thread addresses by count
-    for (auto& addressCountIt : threadSampleData.m_AddressCount) {
-      const uint64_t address = addressCountIt.first;
-      const unsigned int count = addressCountIt.second;
-      threadSampleData.m_AddressCountSorted.insert(
-          std::make_pair(count, address));
+    // exclusive stat
+    AddCount(&threadSampleData.m_ExclusiveCount, callstack[0], delta);
+
+    // Recursive functions appear several times in a callstack but only count
+    // once.
+    for (size_t i = m_UniqueAddressOffsets[resolvedIndex];
+         i < m_UniqueAddressOffsets[resolvedIndex + 1]; ++i) {
+      AddCount(&threadSampleData.m_AddressCount, m_UniqueAddresses[i], delta);
+      changedAddresses.insert(m_UniqueAddresses[i]);
     }
   }
 
-  SortByThreadUsage();
+  UpdateSampleReport(&threadSampleData, changedAddresses);
+}
 
-  OutputStats();
+//-----------------------------------------------------------------------------
+// Orders report entries by decreasing count, then by increasing address.
+static bool IsBefore(const std::pair<unsigned int, uint64_t>& a_Lhs,
+                     const std::pair<unsigned int, uint64_t>& a_Rhs) {
+  return a_Lhs.first != a_Rhs.first ? a_Lhs.first > a_Rhs.first
+                                    : a_Lhs.second < a_Rhs.second;
+}
 
-  m_NumSamples = m_Callstacks.size();
-  m_Callstacks.clear();
-  m_State = DoneProcessing;
+//-----------------------------------------------------------------------------
+void SamplingProfiler::UpdateSampleReport(
+    ThreadSampleData* a_ThreadSampleData,
+    const absl::flat_hash_set<uint64_t>& a_ChangedAddresses) {
+  ThreadSampleData& threadSampleData = *a_ThreadSampleData;
+  std::vector<std::pair<unsigned int, uint64_t>>& addressCountSorted =
+      threadSampleData.m_AddressCountSorted;
+  std::vector<SampledFunction>& sampleReport = threadSampleData.m_SampleReport;
+
+  // Only the changed addresses need to be sorted, the others keep their
+  // order.
+  std::vector<std::pair<unsigned int, uint64_t>> changedCountSorted;
+  changedCountSorted.reserve(a_ChangedAddresses.size());
+  for (uint64_t address : a_ChangedAddresses) {
+    auto it = threadSampleData.m_AddressCount.find(address);
+    if (it != threadSampleData.m_AddressCount.end()) {
+      changedCountSorted.emplace_back(it->second, address);
+    }
+  }
+  std::sort(changedCountSorted.begin(), changedCountSorted.end(), IsBefore);
+
+  // Entries of the changed addresses which are already in the report.
+  std::vector<bool> isChanged(addressCountSorted.size());
+  absl::flat_hash_map<uint64_t, SampledFunction*> changedFunctions;
+  changedFunctions.reserve(a_ChangedAddresses.size());
+  for (size_t i = 0; i < addressCountSorted.size(); ++i) {
+    if (a_ChangedAddresses.contains(addressCountSorted[i].second)) {
+      isChanged[i] = true;
+      changedFunctions.emplace(addressCountSorted[i].second, &sampleReport[i]);
+    }
+  }
+
+  // Percentages depend on the number of samples of the thread, which changed.
+  // The exclusive count of an unchanged entry is only looked up if it has
+  // one.
+  float numSamples = (float)threadSampleData.m_NumSamples;
+  auto updatePercentages = [&](unsigned int a_Count, bool a_Changed,
+                               SampledFunction* a_Function) {
+    a_Function->m_Inclusive = 100.f * ((float)a_Count) / numSamples;
+    if (!a_Changed && a_Function->m_Exclusive == 0.f) {
+      return;
+    }
+    a_Function->m_Exclusive = 0.f;
+    auto it = threadSampleData.m_ExclusiveCount.find(a_Function->m_Address);
+    if (it != threadSampleData.m_ExclusiveCount.end()) {
+      a_Function->m_Exclusive = 100.f * (float)it->second / numSamples;
+    }
+  };
+
+  // Merges the unchanged entries with the changed ones. Entries are moved
+  // rather than generated again, only new addresses get a new entry.
+  size_t maxSize = addressCountSorted.size() + changedCountSorted.size();
+  std::vector<std::pair<unsigned int, uint64_t>> mergedCountSorted;
+  mergedCountSorted.reserve(maxSize);
+  std::vector<SampledFunction> mergedReport;
+  mergedReport.reserve(maxSize);
+  size_t unchangedIndex = 0;
+  size_t changedIndex = 0;
+  while (true) {
+    while (unchangedIndex < isChanged.size() && isChanged[unchangedIndex]) {
+      ++unchangedIndex;
+    }
+    bool hasUnchanged = unchangedIndex < addressCountSorted.size();
+    bool hasChanged = changedIndex < changedCountSorted.size();
+    if (!hasUnchanged && !hasChanged) {
+      break;
+    }
+
+    if (!hasChanged ||
+        (hasUnchanged && IsBefore(addressCountSorted[unchangedIndex],
+                                  changedCountSorted[changedIndex]))) {
+      mergedCountSorted.push_back(addressCountSorted[unchangedIndex]);
+      mergedReport.push_back(std::move(sampleReport[unchangedIndex]));
+      updatePercentages(mergedCountSorted.back().first, false,
+                        &mergedReport.back());
+      ++unchangedIndex;
+      continue;
+    }
+
+    uint64_t address = changedCountSorted[changedIndex].second;
+    mergedCountSorted.push_back(changedCountSorted[changedIndex]);
+    auto it = changedFunctions.find(address);
+    if (it != changedFunctions.end()) {
+      mergedReport.push_back(std::move(*it->second));
+    } else {
+      mergedReport.push_back(MakeSampledFunction(address));
+    }
+    updatePercentages(mergedCountSorted.back().first, true,
+                      &mergedReport.back());
+    ++changedIndex;
+  }
+  addressCountSorted.swap(mergedCountSorted);
+  sampleReport.swap(mergedReport);
 }
 
 //-----------------------------------------------------------------------------
@@ -339,14 +583,15 @@ void ThreadSampleData::ComputeAverageThreadUsage() {
 
 //-----------------------------------------------------------------------------
 std::multimap<int, CallstackID> ThreadSampleData::SortCallstacks(
-    const std::set<CallstackID>& a_CallStacks, int& o_TotalCallStacks) {
+    const CallstackInternTable& a_UniqueCallstacks,
+    const std::vector<uint32_t>& a_CallstackIndices, int& o_TotalCallStacks) {
   std::multimap<int, CallstackID> sortedCallstacks;
   int numCallstacks = 0;
-  for (CallstackID id : a_CallStacks) {
-    auto it = m_CallstackCount.find(id);
-    if (it != m_CallstackCount.end()) {
-      int count = it->second;
-      sortedCallstacks.insert(std::make_pair(count, id));
+  for (uint32_t index : a_CallstackIndices) {
+    if (index < m_CallstackCount.size() && m_CallstackCount[index] > 0) {
+      int count = m_CallstackCount[index];
+      sortedCallstacks.insert(
+          std::make_pair(count, a_UniqueCallstacks.Get(index).Hash()));
       numCallstacks += count;
     }
   }
@@ -358,13 +603,31 @@ std::multimap<int, CallstackID> ThreadSampleData::SortCallstacks(
 //-----------------------------------------------------------------------------
 void SamplingProfiler::ProcessAddresses() {
   ScopeLock lock(m_Mutex);
-  for (const auto& it : m_UniqueCallstacks) {
-    CallstackID rawCallstackId = it.first;
-    const std::shared_ptr<CallStack> callstack = it.second;
-    CallStack ResolvedCallstack = *callstack;
+  // Only the callstacks added since the last call need to be resolved.
+  uint32_t rawIndex = static_cast<uint32_t>(m_RawToResolvedIndex.size());
+
+  // Resolve the functions of all new addresses in a single batch, so that
+  // AddAddress finds them in the process' cache.
+  std::vector<uint64_t> newAddresses;
+  for (uint32_t index = rawIndex; index < m_UniqueCallstacks.Size(); ++index) {
+    for (uint64_t address : m_UniqueCallstacks.Get(index)) {
+      if (m_ExactAddresses.find(address) == m_ExactAddresses.end()) {
+        newAddresses.push_back(address);
+      }
+    }
+  }
+  if (!newAddresses.empty()) {
+    m_Process->ResolveAddresses(&newAddresses);
+  }
 
-    for (uint32_t i = 0; i < callstack->m_Depth; ++i) {
-      uint64_t addr = callstack->m_Data[i];
+  m_RawToResolvedIndex.resize(m_UniqueCallstacks.Size());
+  std::vector<uint64_t> resolvedFrames;
+  for (; rawIndex < m_UniqueCallstacks.Size(); ++rawIndex) {
+    CallstackView callstack = m_UniqueCallstacks.Get(rawIndex);
+    resolvedFrames.assign(callstack.begin(), callstack.end());
+
+    for (uint32_t i = 0; i < callstack.Depth(); ++i) {
+      uint64_t addr = callstack[i];
 
       if (m_ExactAddresses.find(addr) == m_ExactAddresses.end()) {
         AddAddress(addr);
@@ -373,19 +636,38 @@ void SamplingProfiler::ProcessAddresses() {
       auto addrIt = m_ExactAddresses.find(addr);
       if (addrIt != m_ExactAddresses.end()) {
         const uint64_t& functionAddr = addrIt->second;
-        ResolvedCallstack.m_Data[i] = functionAddr;
-        m_FunctionToCallstacks[functionAddr].insert(rawCallstackId);
+        resolvedFrames[i] = functionAddr;
+        // Callstacks are visited in increasing index order, so a callstack
+        // already listed for this function is the last one.
+        std::vector<uint32_t>& callstacks =
+            m_FunctionToCallstacks[functionAddr];
+        if (callstacks.empty() || callstacks.back() != rawIndex) {
+          callstacks.push_back(rawIndex);
+        }
       }
     }
 
-    CallstackID resolvedCallstackId = ResolvedCallstack.Hash();
-    if (m_UniqueResolvedCallstacks.find(resolvedCallstackId) ==
-        m_UniqueResolvedCallstacks.end()) {
-      m_UniqueResolvedCallstacks[resolvedCallstackId] =
-          std::make_shared<CallStack>(ResolvedCallstack);
-    }
+    CallstackID resolvedCallstackId =
+        ComputeCallstackHash(resolvedFrames.data(), resolvedFrames.size());
+    m_RawToResolvedIndex[rawIndex] = m_UniqueResolvedCallstacks.Intern(
+        resolvedCallstackId, resolvedFrames.data(), callstack.Depth());
+  }
 
-    m_RawToResolvedMap[rawCallstackId] = resolvedCallstackId;
+  // Distinct addresses of the resolved callstacks added since the last call.
+  if (m_UniqueAddressOffsets.empty()) {
+    m_UniqueAddressOffsets.push_back(0);
+  }
+  for (uint32_t resolvedIndex = m_UniqueAddressOffsets.size() - 1;
+       resolvedIndex < m_UniqueResolvedCallstacks.Size(); ++resolvedIndex) {
+    CallstackView callstack = m_UniqueResolvedCallstacks.Get(resolvedIndex);
+    size_t begin = m_UniqueAddresses.size();
+    m_UniqueAddresses.insert(m_UniqueAddresses.end(), callstack.begin(),
+                             callstack.end());
+    std::sort(m_UniqueAddresses.begin() + begin, m_UniqueAddresses.end());
+    m_UniqueAddresses.erase(
+        std::unique(m_UniqueAddresses.begin() + begin, m_UniqueAddresses.end()),
+        m_UniqueAddresses.end());
+    m_UniqueAddressOffsets.push_back(m_UniqueAddresses.size());
   }
 }
 
@@ -448,7 +730,8 @@ void SamplingProfiler::AddAddress(uint64_t a_Address) {
     std::string symbolName = "???";
 
     if (symbol == nullptr || Contains(symbol->m_Name, "[unknown]")) {
-      Function* function = m_Process->GetFunctionFromAddress(a_Address, false);
+      Function* function =
+          m_Process->GetCachedFunctionFromAddress(a_Address, false);
       if (function) {
         symbolName = function->PrettyName();
         if (symbol) {
@@ -462,44 +745,36 @@ void SamplingProfiler::AddAddress(uint64_t a_Address) {
   }
 }
 
+//-----------------------------------------------------------------------------
+SampledFunction SamplingProfiler::MakeSampledFunction(uint64_t a_Address) {
+  // Threads update their reports concurrently, so the shared maps are only
+  // read here.
+  SampledFunction function;
+  auto symbolIt = m_AddressToSymbol.find(a_Address);
+  if (symbolIt != m_AddressToSymbol.end()) {
+    function.m_Name = symbolIt->second;
+  }
+  function.m_Address = a_Address;
+
+  std::shared_ptr<Module> module = m_Process->GetModuleFromAddress(a_Address);
+  function.m_Module = module ? s2ws(module->m_Name) : L"unknown module";
+
+  auto lineInfoIt = m_AddressToLineInfo.find(a_Address);
+  if (lineInfoIt != m_AddressToLineInfo.end()) {
+    function.m_Line = lineInfoIt->second.m_Line;
+    function.m_File = lineInfoIt->second.m_File;
+  }
+  return function;
+}
+
 //-----------------------------------------------------------------------------
 void SamplingProfiler::OutputStats() {
   for (auto& dataIt : m_ThreadSampleData) {
     ThreadID threadID = dataIt.first;
     ThreadSampleData& threadSampleData = dataIt.second;
-    std::vector<SampledFunction>& sampleReport =
-        threadSampleData.m_SampleReport;
 
     ORBIT_LOGV(threadID);
     ORBIT_LOGV(threadSampleData.m_NumSamples);
-
-    for (std::multimap<unsigned int, uint64_t>::reverse_iterator sortedIt =
-             threadSampleData.m_AddressCountSorted.rbegin();
-         sortedIt != threadSampleData.m_AddressCountSorted.rend(); ++sortedIt) {
-      int numOccurences = sortedIt->first;
-      uint64_t address = sortedIt->second;
-      float prct =
-          100.f * ((float)numOccurences) / (float)threadSampleData.m_NumSamples;
-
-      SampledFunction function;
-      function.m_Name = m_AddressToSymbol[address].c_str();
-      function.m_Inclusive = prct;
-      function.m_Exclusive = 0.f;
-      auto it = threadSampleData.m_ExclusiveCount.find(address);
-      if (it != threadSampleData.m_ExclusiveCount.end()) {
-        function.m_Exclusive =
-            100.f * (float)it->second / (float)threadSampleData.m_NumSamples;
-      }
-      function.m_Address = address;
-
-      std::shared_ptr<Module> module = m_Process->GetModuleFromAddress(address);
-      function.m_Module = module ? s2ws(module->m_Name) : L"unknown module";
-
-      const LineInfo& lineInfo = m_AddressToLineInfo[address];
-      function.m_Line = lineInfo.m_Line;
-      function.m_File = lineInfo.m_File;
-      sampleReport.push_back(function);
-    }
   }
 }
 
@@ -520,7 +795,7 @@ void SamplingProfiler::GetThreadCallstack(Thread* a_Thread) {
   if (depth > 0) {
     frame.m_Callstack.m_Depth = depth;
     frame.m_Callstack.m_ThreadId = a_Thread->m_TID;
-    AddCallStack(frame.m_Callstack);
+    AddCallStack(frame.m_Callstack, OrbitTicks());
   }
 #else
   UNUSED(a_Thread);
@@ -584,14 +859,73 @@ ORBIT_SERIALIZE_WSTRING(SampledFunction, 0) {
 }
 
 //-----------------------------------------------------------------------------
-ORBIT_SERIALIZE_WSTRING(SamplingProfiler, 1) {
+// Callstacks are stored as their ids, depths and concatenated frames.
+template <class Archive>
+static void SerializeCallstacks(Archive& a_Archive,
+                                CallstackInternTable& a_Callstacks) {
+  std::vector<CallstackID> ids;
+  std::vector<uint32_t> depths;
+  std::vector<uint64_t> frames;
+  if constexpr (Archive::is_saving::value) {
+    ids.reserve(a_Callstacks.Size());
+    depths.reserve(a_Callstacks.Size());
+    frames.reserve(a_Callstacks.GetNumFrames());
+    for (uint32_t index = 0; index < a_Callstacks.Size(); ++index) {
+      CallstackView callstack = a_Callstacks.Get(index);
+      ids.push_back(callstack.Hash());
+      depths.push_back(callstack.Depth());
+      frames.insert(frames.end(), callstack.begin(), callstack.end());
+    }
+  }
+
+  a_Archive(ids, depths, frames);
+
+  if constexpr (Archive::is_loading::value) {
+    a_Callstacks.Clear();
+    size_t numFrames = 0;
+    for (size_t i = 0; i < ids.size() && i < depths.size(); ++i) {
+      if (frames.size() - numFrames < depths[i]) {
+        break;
+      }
+      a_Callstacks.Intern(ids[i], frames.data() + numFrames, depths[i]);
+      numFrames += depths[i];
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+ORBIT_SERIALIZE_WSTRING(SamplingProfiler, 2) {
   ORBIT_NVP_VAL(0, m_PeriodMs);
   ORBIT_NVP_VAL(0, m_NumSamples);
   ORBIT_NVP_DEBUG(0, m_ThreadSampleData);
-  ORBIT_NVP_DEBUG(0, m_UniqueCallstacks);
-  ORBIT_NVP_DEBUG(0, m_UniqueResolvedCallstacks);
-  ORBIT_NVP_DEBUG(0, m_RawToResolvedMap);
-  ORBIT_NVP_DEBUG(0, m_FunctionToCallstacks);
+  if (a_Version >= 2) {
+    {
+      ORBIT_SIZE_SCOPE("m_UniqueCallstacks");
+      SerializeCallstacks(a_Archive, m_UniqueCallstacks);
+    }
+    {
+      ORBIT_SIZE_SCOPE("m_UniqueResolvedCallstacks");
+      SerializeCallstacks(a_Archive, m_UniqueResolvedCallstacks);
+    }
+    ORBIT_NVP_DEBUG(2, m_RawToResolvedIndex);
+    ORBIT_NVP_DEBUG(2, m_FunctionToCallstacks);
+  } else {
+    // Captures saved before callstacks were interned only get their unique
+    // callstacks back, as their per thread callstack counts are not loaded.
+    std::unordered_map<CallstackID, std::shared_ptr<CallStack>>
+        uniqueCallstacks;
+    std::unordered_map<CallstackID, std::shared_ptr<CallStack>>
+        uniqueResolvedCallstacks;
+    std::unordered_map<CallstackID, CallstackID> rawToResolvedMap;
+    std::unordered_map<uint64_t, std::set<CallstackID>> functionToCallstacks;
+    a_Archive(uniqueCallstacks, uniqueResolvedCallstacks, rawToResolvedMap,
+              functionToCallstacks);
+    for (auto& pair : uniqueCallstacks) {
+      if (pair.second) {
+        AddUniqueCallStack(*pair.second);
+      }
+    }
+  }
   ORBIT_NVP_DEBUG(0, m_ExactAddresses);
   ORBIT_NVP_DEBUG(0, m_AddressToSymbol);
   ORBIT_NVP_DEBUG(0, m_AddressToLineInfo);
@@ -613,11 +947,24 @@ ORBIT_SERIALIZE_WSTRING(CallstackCount, 0) {
 }
 
 //-----------------------------------------------------------------------------
-ORBIT_SERIALIZE_WSTRING(ThreadSampleData, 0) {
-  ORBIT_NVP_VAL(0, m_CallstackCount);
+ORBIT_SERIALIZE_WSTRING(ThreadSampleData, 2) {
+  if (a_Version >= 1) {
+    ORBIT_NVP_VAL(1, m_CallstackCount);
+  } else {
+    // Counts keyed by callstack id can't be mapped to callstack indices.
+    std::unordered_map<CallstackID, unsigned int> callstackCount;
+    a_Archive(callstackCount);
+  }
   ORBIT_NVP_VAL(0, m_AddressCount);
   ORBIT_NVP_VAL(0, m_ExclusiveCount);
-  ORBIT_NVP_VAL(0, m_AddressCountSorted);
+  if (a_Version >= 2) {
+    ORBIT_NVP_VAL(2, m_AddressCountSorted);
+  } else {
+    std::multimap<unsigned int, uint64_t> addressCountSorted;
+    a_Archive(addressCountSorted);
+    m_AddressCountSorted.assign(addressCountSorted.rbegin(),
+                                addressCountSorted.rend());
+  }
   ORBIT_NVP_VAL(0, m_NumSamples);
   ORBIT_NVP_VAL(0, m_SampleReport);
   ORBIT_NVP_VAL(0, m_ThreadUsage);
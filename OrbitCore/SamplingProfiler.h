@@ -3,12 +3,17 @@
 //-----------------------------------
 #pragma once
 
+#include <deque>
+#include <thread>
+
 #include "BlockChain.h"
 #include "Callstack.h"
+#include "CallstackInternTable.h"
 #include "Core.h"
 #include "EventBuffer.h"
 #include "Pdb.h"
 #include "SerializationMacros.h"
+#include "absl/container/flat_hash_set.h"
 
 class Process;
 class Thread;
@@ -47,11 +52,15 @@ struct ThreadSampleData {
   ThreadSampleData() { m_ThreadUsage.push_back(0); }
   void ComputeAverageThreadUsage();
   std::multimap<int, CallstackID> SortCallstacks(
-      const std::set<CallstackID>& a_CallStacks, int& o_TotalCallStacks);
-  std::unordered_map<CallstackID, unsigned int> m_CallstackCount;
+      const CallstackInternTable& a_UniqueCallstacks,
+      const std::vector<uint32_t>& a_CallstackIndices, int& o_TotalCallStacks);
+  // Number of samples of each unique callstack, indexed like the unique
+  // callstacks of the SamplingProfiler.
+  std::vector<unsigned int> m_CallstackCount;
   std::unordered_map<uint64_t, unsigned int> m_AddressCount;
   std::unordered_map<uint64_t, unsigned int> m_ExclusiveCount;
-  std::multimap<unsigned int, uint64_t> m_AddressCountSorted;
+  // (count, address) pairs by decreasing count, then increasing address.
+  std::vector<std::pair<unsigned int, uint64_t>> m_AddressCountSorted;
   unsigned int m_NumSamples = 0;
   std::vector<SampledFunction> m_SampleReport;
   std::vector<float> m_ThreadUsage;
@@ -93,19 +102,23 @@ class SamplingProfiler {
   bool ShouldStop();
   void FireDoneProcessingCallbacks();
 
-  void AddCallStack(CallStack& a_CallStack);
+  // a_Time is only used by the sliding window, see SetSlidingWindow.
+  void AddCallStack(CallStack& a_CallStack, uint64_t a_Time = 0);
+  void AddCallStack(const CallstackView& a_CallStack, ThreadID a_TID,
+                    uint64_t a_Time = 0);
   void AddHashedCallStack(CallstackEvent& a_CallStack);
   void AddUniqueCallStack(CallStack& a_CallStack);
 
-  const std::shared_ptr<CallStack> GetCallStack(CallstackID a_ID) {
+  // The view stays valid for the lifetime of the profiler. It is empty if the
+  // callstack is unknown.
+  CallstackView GetCallStack(CallstackID a_ID) {
     ScopeLock lock(m_Mutex);
-    return m_UniqueCallstacks[a_ID];
+    return m_UniqueCallstacks.Find(a_ID);
   }
 
   inline bool HasCallStack(CallstackID a_ID) {
     ScopeLock lock(m_Mutex);
-    auto it = m_UniqueCallstacks.find(a_ID);
-    return it != m_UniqueCallstacks.end();
+    return m_UniqueCallstacks.Contains(a_ID);
   }
 
   std::multimap<int, CallstackID> GetCallStacksFromAddress(
@@ -122,9 +135,16 @@ class SamplingProfiler {
   };
   SamplingState GetState() const { return m_State; }
   void SetState(SamplingState a_State) { m_State = a_State; }
+  // Hold GetMutex() while using the thread sample data, reports can be
+  // updated on a worker thread.
   const std::vector<ThreadSampleData*>& GetThreadSampleData() const {
     return m_SortedThreadSampleData;
   }
+  size_t GetNumThreadSampleData() {
+    ScopeLock lock(m_Mutex);
+    return m_SortedThreadSampleData.size();
+  }
+  Mutex& GetMutex() { return m_Mutex; }
   void SetLoadedFromFile(bool a_Value = true) { m_LoadedFromFile = a_Value; }
   void SetIsLinuxPerf(bool a_Value = true) { m_IsLinuxPerf = a_Value; }
 
@@ -143,6 +163,26 @@ class SamplingProfiler {
   void Print();
   void ProcessSamples();
   void ProcessSamplesAsync();
+  // Adds the samples added since the last update to the thread sample data
+  // and updates the reports of the threads they affect, so that reports can
+  // be shown while sampling. Only the functions of the new samples are sorted
+  // and generated, the other entries of a report are moved in order and get
+  // their percentages updated. Returns false if there were no new samples.
+  bool UpdateReport();
+  // Runs UpdateReport on a worker thread, so that the caller, usually the UI
+  // thread, doesn't wait for it. Does nothing if an update is still running,
+  // the next one includes its samples. The worker is joined by StopCapture
+  // and by the destructor.
+  void UpdateReportAsync();
+  // Incremented each time UpdateReport changes the reports.
+  uint32_t GetReportVersion() const { return m_ReportVersion; }
+  // Copies the current report of a thread. Returns false if the thread has no
+  // samples.
+  bool GetSampleReport(ThreadID a_TID, std::vector<SampledFunction>* o_Report);
+  // Only reports the samples that are at most a_Seconds older than the latest
+  // one, which requires samples to be added with their time and roughly in
+  // time order. 0, the default, reports all samples.
+  void SetSlidingWindow(double a_Seconds);
   void AddAddress(uint64_t a_Address);
 
   std::wstring GetSymbolFromAddress(uint64_t a_Address);
@@ -156,13 +196,33 @@ class SamplingProfiler {
   void GetThreadCallstack(Thread* a_Thread);
   void GetThreadsUsage();
   void ProcessAddresses();
+  // Applies changes to the number of samples of some callstacks, given as
+  // (callstack index, delta) pairs, and updates the report.
+  void UpdateThreadSampleData(
+      ThreadSampleData* a_ThreadSampleData,
+      const std::vector<std::pair<uint32_t, int>>& a_CallstackCountDeltas);
+  // Moves the entries of a_ChangedAddresses to their new place in the report,
+  // and generates the entries of new addresses. Entries whose count didn't
+  // change keep their order and are not generated again.
+  void UpdateSampleReport(
+      ThreadSampleData* a_ThreadSampleData,
+      const absl::flat_hash_set<uint64_t>& a_ChangedAddresses);
+  SampledFunction MakeSampledFunction(uint64_t a_Address);
   void OutputStats();
+  void JoinUpdateReportThread();
 
  protected:
   std::shared_ptr<Process> m_Process;
   std::unique_ptr<std::thread> m_SamplingThread;
   std::atomic<SamplingState> m_State;
-  BlockChain<CallstackEvent, 16 * 1024> m_Callstacks;
+  // Sampled callstacks as indices into m_UniqueCallstacks, so that processing
+  // them doesn't need to look up their ids.
+  struct CallstackSample {
+    uint64_t m_Time = 0;
+    uint32_t m_CallstackIndex = 0;
+    ThreadID m_TID = 0;
+  };
+  BlockChain<CallstackSample, 16 * 1024> m_Callstacks;
   Timer m_SamplingTimer;
   Timer m_ThreadUsageTimer;
   int m_PeriodMs = 1;
@@ -172,14 +232,29 @@ class SamplingProfiler {
   int m_NumSamples = 0;
   bool m_LoadedFromFile = false;
   bool m_IsLinuxPerf = false;
+  std::atomic<uint32_t> m_ReportVersion{0};
+  std::atomic<bool> m_UpdatingReport{false};
+  std::thread m_UpdateReportThread;
+
+  // Samples in the sliding window, in the order they were added.
+  std::deque<CallstackSample> m_WindowSamples;
+  uint64_t m_WindowTicks = 0;
+  uint64_t m_LatestSampleTime = 0;
 
   std::unordered_map<ThreadID, ThreadSampleData> m_ThreadSampleData;
-  std::unordered_map<CallstackID, std::shared_ptr<CallStack>>
-      m_UniqueCallstacks;
-  std::unordered_map<CallstackID, std::shared_ptr<CallStack>>
-      m_UniqueResolvedCallstacks;
-  std::unordered_map<CallstackID, CallstackID> m_RawToResolvedMap;
-  std::unordered_map<uint64_t, std::set<CallstackID>> m_FunctionToCallstacks;
+  CallstackInternTable m_UniqueCallstacks;
+  CallstackInternTable m_UniqueResolvedCallstacks;
+  // Index of the resolved callstack of each unique callstack, for the unique
+  // callstacks processed so far.
+  std::vector<uint32_t> m_RawToResolvedIndex;
+  // Distinct addresses of each resolved callstack, in increasing order: those
+  // of resolved callstack i are at indices [m_UniqueAddressOffsets[i],
+  // m_UniqueAddressOffsets[i + 1]) of m_UniqueAddresses.
+  std::vector<uint64_t> m_UniqueAddresses;
+  std::vector<size_t> m_UniqueAddressOffsets;
+  // Indices of the unique callstacks containing each function, in increasing
+  // order.
+  std::unordered_map<uint64_t, std::vector<uint32_t>> m_FunctionToCallstacks;
   std::unordered_map<uint64_t, uint64_t> m_ExactAddresses;
   std::unordered_map<uint64_t, std::wstring> m_AddressToSymbol;
   std::unordered_map<uint64_t, LineInfo> m_AddressToLineInfo;
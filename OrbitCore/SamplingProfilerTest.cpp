@@ -0,0 +1,422 @@
+#include "SamplingProfiler.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "LinuxSymbol.h"
+#include "OrbitProcess.h"
+#include "absl/strings/str_format.h"
+
+namespace {
+CallStack MakeCallStack(ThreadID tid, std::vector<uint64_t> frames) {
+  CallStack callstack;
+  callstack.m_Data = std::move(frames);
+  callstack.m_Depth = callstack.m_Data.size();
+  callstack.m_ThreadId = tid;
+  callstack.Hash();
+  return callstack;
+}
+
+const ThreadSampleData* FindThreadSampleData(const SamplingProfiler& profiler,
+                                             ThreadID tid) {
+  for (const ThreadSampleData* thread_sample_data :
+       profiler.GetThreadSampleData()) {
+    if (thread_sample_data->m_TID == tid) {
+      return thread_sample_data;
+    }
+  }
+  return nullptr;
+}
+
+struct ReportEntry {
+  uint64_t address;
+  float inclusive;
+  float exclusive;
+};
+
+// Report of a thread as computed by ProcessSamples before it was parallelized,
+// for callstacks whose addresses all resolve to themselves. Entries with the
+// same count are in no particular order.
+std::vector<ReportEntry> ComputeReferenceReport(
+    const std::vector<CallStack>& samples, ThreadID tid) {
+  std::unordered_map<CallstackID, const CallStack*> unique_callstacks;
+  std::unordered_map<CallstackID, unsigned int> callstack_count;
+  unsigned int num_samples = 0;
+  for (const CallStack& sample : samples) {
+    if (tid == 0 || sample.m_ThreadId == tid) {
+      unique_callstacks[sample.m_Hash] = &sample;
+      ++callstack_count[sample.m_Hash];
+      ++num_samples;
+    }
+  }
+
+  std::unordered_map<uint64_t, unsigned int> address_count;
+  std::unordered_map<uint64_t, unsigned int> exclusive_count;
+  for (const auto& [id, count] : callstack_count) {
+    const CallStack& callstack = *unique_callstacks[id];
+    exclusive_count[callstack.m_Data[0]] += count;
+    std::set<uint64_t> unique_addresses(callstack.m_Data.begin(),
+                                        callstack.m_Data.end());
+    for (uint64_t address : unique_addresses) {
+      address_count[address] += count;
+    }
+  }
+
+  std::multimap<unsigned int, uint64_t> address_count_sorted;
+  for (const auto& [address, count] : address_count) {
+    address_count_sorted.insert(std::make_pair(count, address));
+  }
+
+  std::vector<ReportEntry> report;
+  for (auto it = address_count_sorted.rbegin();
+       it != address_count_sorted.rend(); ++it) {
+    ReportEntry entry;
+    entry.address = it->second;
+    entry.inclusive = 100.f * (float)it->first / (float)num_samples;
+    entry.exclusive = 0.f;
+    auto exclusive_it = exclusive_count.find(entry.address);
+    if (exclusive_it != exclusive_count.end()) {
+      entry.exclusive =
+          100.f * (float)exclusive_it->second / (float)num_samples;
+    }
+    report.push_back(entry);
+  }
+  return report;
+}
+}  // namespace
+
+TEST(SamplingProfiler, ProcessSamples) {
+  SamplingProfiler profiler;
+  profiler.SetIsLinuxPerf();
+  CallStack callstack_a = MakeCallStack(1, {0x1, 0x2, 0x3});
+  CallStack callstack_b = MakeCallStack(2, {0x4, 0x2});
+  profiler.AddCallStack(callstack_a);
+  profiler.AddCallStack(callstack_a);
+  profiler.AddCallStack(callstack_b);
+  CallstackEvent hashed_callstack(0, callstack_a.m_Hash, 2);
+  profiler.AddHashedCallStack(hashed_callstack);
+  // Unknown callstacks can't be added by id.
+  CallstackEvent unknown_callstack(0, 0x1234, 2);
+  profiler.AddHashedCallStack(unknown_callstack);
+
+  EXPECT_TRUE(profiler.HasCallStack(callstack_b.m_Hash));
+  CallstackView view = profiler.GetCallStack(callstack_b.m_Hash);
+  ASSERT_TRUE(view);
+  EXPECT_EQ(std::vector<uint64_t>(view.begin(), view.end()),
+            callstack_b.m_Data);
+  EXPECT_FALSE(profiler.GetCallStack(0x1234));
+
+  profiler.ProcessSamples();
+  EXPECT_EQ(profiler.GetNumSamples(), 4);
+
+  const ThreadSampleData& summary = profiler.GetSummary();
+  EXPECT_EQ(summary.m_NumSamples, 4);
+  ASSERT_EQ(summary.m_SampleReport.size(), 4);
+  EXPECT_EQ(summary.m_SampleReport[0].m_Address, 0x2);
+  EXPECT_FLOAT_EQ(summary.m_SampleReport[0].m_Inclusive, 100.f);
+  EXPECT_FLOAT_EQ(summary.m_SampleReport[0].m_Exclusive, 0.f);
+  EXPECT_EQ(summary.m_SampleReport[3].m_Address, 0x4);
+  EXPECT_FLOAT_EQ(summary.m_SampleReport[3].m_Inclusive, 25.f);
+  EXPECT_FLOAT_EQ(summary.m_SampleReport[3].m_Exclusive, 25.f);
+
+  const ThreadSampleData* thread_2 = FindThreadSampleData(profiler, 2);
+  ASSERT_NE(thread_2, nullptr);
+  EXPECT_EQ(thread_2->m_NumSamples, 2);
+  EXPECT_EQ(thread_2->m_SampleReport.size(), 4);
+
+  std::shared_ptr<SortedCallstackReport> report =
+      profiler.GetSortedCallstacksFromAddress(0x2, 0);
+  EXPECT_EQ(report->m_NumCallStacksTotal, 4);
+  ASSERT_EQ(report->m_CallStacks.size(), 2);
+  EXPECT_EQ(report->m_CallStacks[0].m_CallstackId, callstack_a.m_Hash);
+  EXPECT_EQ(report->m_CallStacks[0].m_Count, 3);
+  EXPECT_EQ(report->m_CallStacks[1].m_CallstackId, callstack_b.m_Hash);
+  EXPECT_EQ(report->m_CallStacks[1].m_Count, 1);
+
+  report = profiler.GetSortedCallstacksFromAddress(0x4, 1);
+  EXPECT_EQ(report->m_NumCallStacksTotal, 0);
+  EXPECT_TRUE(report->m_CallStacks.empty());
+}
+
+TEST(SamplingProfiler, ReportMatchesReference) {
+  constexpr int num_samples = 20'000;
+  constexpr int num_unique_callstacks = 500;
+  constexpr ThreadID num_threads = 8;
+
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<uint64_t> address_distribution(1, 64);
+  std::uniform_int_distribution<uint32_t> depth_distribution(1, 24);
+  std::vector<CallStack> unique_callstacks;
+  for (int i = 0; i < num_unique_callstacks; ++i) {
+    // Few distinct addresses, so that callstacks contain recursion and
+    // reports contain addresses with the same count.
+    std::vector<uint64_t> frames(depth_distribution(random_engine));
+    for (uint64_t& frame : frames) {
+      frame = address_distribution(random_engine);
+    }
+    unique_callstacks.push_back(MakeCallStack(0, std::move(frames)));
+  }
+
+  std::uniform_int_distribution<int> callstack_distribution(
+      0, num_unique_callstacks - 1);
+  std::uniform_int_distribution<ThreadID> tid_distribution(1, num_threads);
+  std::vector<CallStack> samples;
+  SamplingProfiler profiler;
+  profiler.SetIsLinuxPerf();
+  for (int i = 0; i < num_samples; ++i) {
+    CallStack sample =
+        unique_callstacks[callstack_distribution(random_engine)];
+    sample.m_ThreadId = tid_distribution(random_engine);
+    profiler.AddCallStack(sample);
+    samples.push_back(std::move(sample));
+  }
+  profiler.ProcessSamples();
+  EXPECT_EQ(profiler.GetNumSamples(), num_samples);
+  EXPECT_EQ(profiler.GetSummary().m_NumSamples, num_samples);
+
+  for (ThreadID tid = 0; tid <= num_threads; ++tid) {
+    const ThreadSampleData* thread_sample_data =
+        FindThreadSampleData(profiler, tid);
+    ASSERT_NE(thread_sample_data, nullptr);
+    const std::vector<SampledFunction>& report =
+        thread_sample_data->m_SampleReport;
+
+    // Entries with the same count are now sorted by address.
+    std::vector<ReportEntry> expected_report =
+        ComputeReferenceReport(samples, tid);
+    std::stable_sort(expected_report.begin(), expected_report.end(),
+                     [](const ReportEntry& a, const ReportEntry& b) {
+                       return a.inclusive != b.inclusive
+                                  ? a.inclusive > b.inclusive
+                                  : a.address < b.address;
+                     });
+
+    ASSERT_EQ(report.size(), expected_report.size()) << "thread " << tid;
+    for (size_t i = 0; i < report.size(); ++i) {
+      EXPECT_EQ(report[i].m_Address, expected_report[i].address)
+          << "thread " << tid << ", entry " << i;
+      EXPECT_EQ(report[i].m_Inclusive, expected_report[i].inclusive)
+          << "thread " << tid << ", entry " << i;
+      EXPECT_EQ(report[i].m_Exclusive, expected_report[i].exclusive)
+          << "thread " << tid << ", entry " << i;
+    }
+  }
+}
+
+TEST(SamplingProfiler, UpdateReportMatchesProcessSamples) {
+  constexpr int num_samples = 20'000;
+  constexpr int num_updates = 7;
+  constexpr int num_unique_callstacks = 300;
+  constexpr ThreadID num_threads = 4;
+
+  std::mt19937 random_engine(7);
+  std::uniform_int_distribution<uint64_t> address_distribution(1, 64);
+  std::uniform_int_distribution<uint32_t> depth_distribution(1, 16);
+  std::vector<CallStack> unique_callstacks;
+  for (int i = 0; i < num_unique_callstacks; ++i) {
+    std::vector<uint64_t> frames(depth_distribution(random_engine));
+    for (uint64_t& frame : frames) {
+      frame = address_distribution(random_engine);
+    }
+    unique_callstacks.push_back(MakeCallStack(0, std::move(frames)));
+  }
+
+  std::uniform_int_distribution<int> callstack_distribution(
+      0, num_unique_callstacks - 1);
+  std::uniform_int_distribution<ThreadID> tid_distribution(1, num_threads);
+  SamplingProfiler profiler;
+  profiler.SetIsLinuxPerf();
+  SamplingProfiler incremental_profiler;
+  incremental_profiler.SetIsLinuxPerf();
+  uint32_t report_version = incremental_profiler.GetReportVersion();
+  for (int i = 0; i < num_samples; ++i) {
+    CallStack sample =
+        unique_callstacks[callstack_distribution(random_engine)];
+    sample.m_ThreadId = tid_distribution(random_engine);
+    profiler.AddCallStack(sample);
+    incremental_profiler.AddCallStack(sample);
+    if ((i + 1) % (num_samples / num_updates) == 0) {
+      EXPECT_TRUE(incremental_profiler.UpdateReport());
+      EXPECT_NE(incremental_profiler.GetReportVersion(), report_version);
+      report_version = incremental_profiler.GetReportVersion();
+    }
+  }
+  EXPECT_TRUE(incremental_profiler.UpdateReport());
+  EXPECT_FALSE(incremental_profiler.UpdateReport());
+  EXPECT_EQ(incremental_profiler.GetNumSamples(), num_samples);
+  profiler.ProcessSamples();
+  incremental_profiler.ProcessSamples();
+
+  for (ThreadID tid = 0; tid <= num_threads; ++tid) {
+    const ThreadSampleData* expected = FindThreadSampleData(profiler, tid);
+    ASSERT_NE(expected, nullptr);
+    std::vector<SampledFunction> report;
+    ASSERT_TRUE(incremental_profiler.GetSampleReport(tid, &report));
+    ASSERT_EQ(report.size(), expected->m_SampleReport.size())
+        << "thread " << tid;
+    for (size_t i = 0; i < report.size(); ++i) {
+      const SampledFunction& expected_function = expected->m_SampleReport[i];
+      EXPECT_EQ(report[i].m_Address, expected_function.m_Address)
+          << "thread " << tid << ", entry " << i;
+      EXPECT_EQ(report[i].m_Inclusive, expected_function.m_Inclusive)
+          << "thread " << tid << ", entry " << i;
+      EXPECT_EQ(report[i].m_Exclusive, expected_function.m_Exclusive)
+          << "thread " << tid << ", entry " << i;
+    }
+  }
+}
+
+TEST(SamplingProfiler, UpdateReportAsync) {
+  SamplingProfiler profiler;
+  profiler.SetIsLinuxPerf();
+  CallStack callstack_a = MakeCallStack(1, {0x1, 0x2});
+  CallStack callstack_b = MakeCallStack(2, {0x3, 0x2});
+  profiler.AddCallStack(callstack_a);
+  profiler.AddCallStack(callstack_b);
+
+  uint32_t report_version = profiler.GetReportVersion();
+  profiler.UpdateReportAsync();
+  while (profiler.GetReportVersion() == report_version) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Summary and two threads.
+  EXPECT_EQ(profiler.GetNumThreadSampleData(), 3);
+  std::vector<SampledFunction> report;
+  ASSERT_TRUE(profiler.GetSampleReport(0, &report));
+  ASSERT_EQ(report.size(), 3);
+  EXPECT_EQ(report[0].m_Address, 0x2);
+  EXPECT_FLOAT_EQ(report[0].m_Inclusive, 100.f);
+}
+
+TEST(SamplingProfiler, UpdateReportAsyncIsJoined) {
+  CallStack callstack = MakeCallStack(1, {0x1, 0x2});
+  auto profiler = std::make_unique<SamplingProfiler>();
+  profiler->SetIsLinuxPerf();
+  profiler->AddCallStack(callstack);
+  uint32_t report_version = profiler->GetReportVersion();
+  profiler->UpdateReportAsync();
+  profiler->StopCapture();
+  EXPECT_NE(profiler->GetReportVersion(), report_version);
+
+  // Destroyed while the update may still be running, as when the target
+  // process changes during a capture.
+  profiler->AddCallStack(callstack);
+  profiler->UpdateReportAsync();
+  profiler.reset();
+}
+
+TEST(SamplingProfiler, SlidingWindow) {
+  SamplingProfiler profiler;
+  profiler.SetIsLinuxPerf();
+  profiler.SetSlidingWindow(1.0);
+  CallStack callstack_a = MakeCallStack(1, {0x1, 0x2});
+  CallStack callstack_b = MakeCallStack(2, {0x3, 0x2});
+  auto seconds = [](double s) { return TicksFromMicroseconds(s * 1000000.0); };
+
+  profiler.AddCallStack(callstack_a, seconds(10.0));
+  profiler.AddCallStack(callstack_a, seconds(10.5));
+  EXPECT_TRUE(profiler.UpdateReport());
+  EXPECT_EQ(profiler.GetNumSamples(), 2);
+  EXPECT_EQ(profiler.GetSummary().m_SampleReport.size(), 2);
+
+  // The first sample leaves the window, the second one stays in it.
+  profiler.AddCallStack(callstack_b, seconds(11.25));
+  EXPECT_TRUE(profiler.UpdateReport());
+  EXPECT_EQ(profiler.GetNumSamples(), 2);
+  const ThreadSampleData& summary = profiler.GetSummary();
+  EXPECT_EQ(summary.m_NumSamples, 2);
+  ASSERT_EQ(summary.m_SampleReport.size(), 3);
+  EXPECT_EQ(summary.m_SampleReport[0].m_Address, 0x2);
+  EXPECT_FLOAT_EQ(summary.m_SampleReport[0].m_Inclusive, 100.f);
+  EXPECT_FLOAT_EQ(summary.m_SampleReport[1].m_Exclusive, 50.f);
+
+  profiler.AddCallStack(callstack_b, seconds(12.0));
+  EXPECT_TRUE(profiler.UpdateReport());
+  std::vector<SampledFunction> report;
+  ASSERT_TRUE(profiler.GetSampleReport(1, &report));
+  EXPECT_TRUE(report.empty());
+  ASSERT_TRUE(profiler.GetSampleReport(0, &report));
+  ASSERT_EQ(report.size(), 2);
+  EXPECT_EQ(report[0].m_Address, 0x2);
+  EXPECT_EQ(report[1].m_Address, 0x3);
+  EXPECT_FLOAT_EQ(report[1].m_Exclusive, 100.f);
+  EXPECT_FALSE(profiler.GetSampleReport(3, &report));
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the throughput
+// of AddCallStack and ProcessSamples on a synthetic capture of 10M samples of
+// 10k distinct callstacks, then the time of a live update.
+TEST(SamplingProfiler, DISABLED_Throughput) {
+  constexpr int num_samples = 10'000'000;
+  constexpr int num_unique_callstacks = 10'000;
+  constexpr int num_threads = 16;
+  constexpr int depth = 32;
+  constexpr int num_functions = 4096;
+
+  std::mt19937 random_engine(0);
+  std::uniform_int_distribution<uint64_t> function_distribution(
+      0, num_functions - 1);
+  std::vector<CallStack> callstacks;
+  callstacks.reserve(num_unique_callstacks);
+  for (int i = 0; i < num_unique_callstacks; ++i) {
+    std::vector<uint64_t> frames(depth);
+    for (uint64_t& frame : frames) {
+      frame = 0x400000 + 16 * function_distribution(random_engine);
+    }
+    callstacks.push_back(MakeCallStack(0, std::move(frames)));
+  }
+  std::uniform_int_distribution<int> callstack_distribution(
+      0, num_unique_callstacks - 1);
+
+  // Reports copy the names of the functions.
+  auto process = std::make_shared<Process>();
+  for (int i = 0; i < num_functions; ++i) {
+    auto symbol = std::make_shared<LinuxSymbol>();
+    symbol->m_Name = absl::StrFormat(
+        "engine::render::Renderer::DrawPrimitives%d(int, float)+0x10", i);
+    process->AddSymbol(0x400000 + 16 * i, symbol);
+  }
+
+  SamplingProfiler profiler(process);
+  profiler.SetIsLinuxPerf();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_samples; ++i) {
+    CallStack& callstack = callstacks[callstack_distribution(random_engine)];
+    callstack.m_ThreadId = i % num_threads + 1;
+    profiler.AddCallStack(callstack);
+  }
+  auto added = std::chrono::steady_clock::now();
+  profiler.ProcessSamples();
+  auto processed = std::chrono::steady_clock::now();
+
+  // A live update with few new samples, as while sampling.
+  constexpr int num_new_samples = 1000;
+  for (int i = 0; i < num_new_samples; ++i) {
+    CallStack& callstack = callstacks[callstack_distribution(random_engine)];
+    callstack.m_ThreadId = i % num_threads + 1;
+    profiler.AddCallStack(callstack);
+  }
+  auto update_start = std::chrono::steady_clock::now();
+  profiler.UpdateReport();
+  auto updated = std::chrono::steady_clock::now();
+
+  auto add_seconds = std::chrono::duration<double>(added - start).count();
+  auto process_seconds =
+      std::chrono::duration<double>(processed - added).count();
+  printf("AddCallStack: %.1f M samples/s\n", num_samples / add_seconds / 1e6);
+  printf("ProcessSamples: %.1f M samples/s\n",
+         num_samples / process_seconds / 1e6);
+  printf("UpdateReport of %d new samples: %.1f ms\n", num_new_samples,
+         std::chrono::duration<double, std::milli>(updated - update_start)
+             .count());
+}
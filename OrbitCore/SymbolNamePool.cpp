@@ -0,0 +1,116 @@
+#include "SymbolNamePool.h"
+
+#include "Threading.h"
+#include "Utils.h"
+#include "llvm/Demangle/Demangle.h"
+
+SymbolNamePool GSymbolNamePool;
+
+SymbolNamePool::~SymbolNamePool() { WaitForBackgroundDemangling(); }
+
+// Same test as llvm::demangle: one to four underscores followed by 'Z' for the
+// Itanium scheme, or a '?' for the Microsoft one.
+bool SymbolNamePool::IsMangled(const std::string& name) {
+  size_t num_underscores = name.find_first_not_of('_');
+  if (num_underscores >= 1 && num_underscores <= 4 &&
+      name[num_underscores] == 'Z') {
+    return true;
+  }
+  return !name.empty() && name[0] == '?';
+}
+
+const std::string& SymbolNamePool::Demangle(const std::string& name) {
+  if (!IsMangled(name)) {
+    return name;
+  }
+
+  uint64_t hash = StringHash(name);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = demangled_names_.find(hash);
+    if (it != demangled_names_.end()) {
+      return it->second;
+    }
+  }
+
+  // Demangle without holding the lock. If another thread demangled the same
+  // name in the meantime, its result is kept.
+  std::string demangled_name = llvm::demangle(name);
+  std::lock_guard<std::mutex> lock(mutex_);
+  return demangled_names_.try_emplace(hash, std::move(demangled_name))
+      .first->second;
+}
+
+void SymbolNamePool::DemangleInBackground(std::vector<std::string> names) {
+  std::lock_guard<std::mutex> lock(background_thread_mutex_);
+  queued_names_.push_back(std::move(names));
+  if (background_thread_running_) {
+    return;
+  }
+
+  // The previous thread, if any, found the queue empty and is exiting.
+  if (background_thread_.joinable()) {
+    background_thread_.join();
+  }
+  background_thread_running_ = true;
+  background_thread_ = std::thread(&SymbolNamePool::DemangleQueuedNames, this);
+}
+
+void SymbolNamePool::DemangleQueuedNames() {
+  while (true) {
+    std::vector<std::string> names;
+    {
+      std::lock_guard<std::mutex> lock(background_thread_mutex_);
+      if (queued_names_.empty()) {
+        background_thread_running_ = false;
+        return;
+      }
+      names = std::move(queued_names_.front());
+      queued_names_.pop_front();
+    }
+    ParallelFor(names.size(), [&](size_t i) { Demangle(names[i]); });
+  }
+}
+
+void SymbolNamePool::WaitForBackgroundDemangling() {
+  std::thread background_thread;
+  {
+    std::lock_guard<std::mutex> lock(background_thread_mutex_);
+    background_thread = std::move(background_thread_);
+  }
+  // The thread only exits once the queue is empty.
+  if (background_thread.joinable()) {
+    background_thread.join();
+  }
+}
+
+size_t SymbolNamePool::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return demangled_names_.size();
+}
+
+size_t SymbolNamePool::GetMemoryUsage() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t bytes = 0;
+  for (const auto& [hash, demangled_name] : demangled_names_) {
+    bytes += sizeof(demangled_name) + demangled_name.capacity();
+  }
+  return bytes;
+}
+
+const std::string& DemangledNameCache::Demangle(SymbolNamePool* pool,
+                                                const std::string& name) const {
+  const std::string* demangled_name =
+      demangled_name_.load(std::memory_order_acquire);
+  if (demangled_name != nullptr) {
+    return *demangled_name;
+  }
+
+  const std::string& result = pool->Demangle(name);
+  // Names that are not mangled are returned as they are, there is nothing to
+  // remember.
+  if (&result != &name) {
+    demangled_name_.store(&result, std::memory_order_release);
+  }
+  return result;
+}
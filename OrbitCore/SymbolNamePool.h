@@ -0,0 +1,79 @@
+#ifndef ORBIT_CORE_SYMBOL_NAME_POOL_H_
+#define ORBIT_CORE_SYMBOL_NAME_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/container/node_hash_map.h"
+
+// Demangles symbol names on first use and keeps a single copy of each
+// demangled name, keyed by the hash of its mangled name, however many
+// functions or callstack frames refer to it. Names that are not mangled are
+// never stored. Entries are kept for the lifetime of the pool. Thread-safe.
+class SymbolNamePool {
+ public:
+  SymbolNamePool() = default;
+  ~SymbolNamePool();
+
+  // Returns the demangled form of name. This is name itself if it is not
+  // mangled, otherwise a string owned by the pool.
+  const std::string& Demangle(const std::string& name);
+
+  // Demangles names on several threads in the background, so that later calls
+  // to Demangle find them. Doesn't wait for previous names, they are queued
+  // and demangled in order by the same background thread.
+  void DemangleInBackground(std::vector<std::string> names);
+  // Waits until all names queued so far are demangled.
+  void WaitForBackgroundDemangling();
+
+  size_t Size();
+  // Bytes taken by the demangled names, not counting the map itself.
+  size_t GetMemoryUsage();
+
+  static bool IsMangled(const std::string& name);
+
+ private:
+  void DemangleQueuedNames();
+
+  absl::node_hash_map<uint64_t, std::string> demangled_names_;
+  std::mutex mutex_;
+  std::thread background_thread_;
+  std::deque<std::vector<std::string>> queued_names_;
+  bool background_thread_running_ = false;
+  std::mutex background_thread_mutex_;
+};
+
+// Remembers where a SymbolNamePool keeps the demangled form of one name, so
+// that later lookups neither hash the name nor lock the pool. Copies share the
+// demangled name, which lives as long as the pool.
+class DemangledNameCache {
+ public:
+  DemangledNameCache() = default;
+  DemangledNameCache(const DemangledNameCache& other)
+      : demangled_name_(other.demangled_name_.load(std::memory_order_acquire)) {
+  }
+  DemangledNameCache& operator=(const DemangledNameCache& other) {
+    demangled_name_.store(other.demangled_name_.load(std::memory_order_acquire),
+                          std::memory_order_release);
+    return *this;
+  }
+
+  // Same as pool->Demangle(name). name must be the same on every call, until
+  // Reset.
+  const std::string& Demangle(SymbolNamePool* pool,
+                              const std::string& name) const;
+  void Reset() { demangled_name_.store(nullptr, std::memory_order_release); }
+
+ private:
+  mutable std::atomic<const std::string*> demangled_name_{nullptr};
+};
+
+extern SymbolNamePool GSymbolNamePool;
+
+#endif  // ORBIT_CORE_SYMBOL_NAME_POOL_H_
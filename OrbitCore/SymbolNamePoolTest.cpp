@@ -0,0 +1,121 @@
+#include "SymbolNamePool.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+TEST(SymbolNamePool, IsMangled) {
+  EXPECT_TRUE(SymbolNamePool::IsMangled("_Z3foov"));
+  EXPECT_TRUE(SymbolNamePool::IsMangled("___Z3foov"));
+  EXPECT_TRUE(SymbolNamePool::IsMangled("?foo@@YAXXZ"));
+  EXPECT_FALSE(SymbolNamePool::IsMangled("main"));
+  EXPECT_FALSE(SymbolNamePool::IsMangled("_start"));
+  EXPECT_FALSE(SymbolNamePool::IsMangled("_____Z3foov"));
+  EXPECT_FALSE(SymbolNamePool::IsMangled("__"));
+  EXPECT_FALSE(SymbolNamePool::IsMangled(""));
+}
+
+TEST(SymbolNamePool, Demangle) {
+  SymbolNamePool pool;
+  const std::string c_name = "main";
+  EXPECT_EQ(&pool.Demangle(c_name), &c_name);
+  EXPECT_EQ(pool.Size(), 0);
+
+  const std::string mangled_name = "_ZN3foo3barEi";
+  const std::string& demangled_name = pool.Demangle(mangled_name);
+  EXPECT_EQ(demangled_name, "foo::bar(int)");
+  EXPECT_EQ(pool.Size(), 1);
+
+  // Demangled once, whichever string holds the mangled name.
+  const std::string mangled_name_copy = mangled_name;
+  EXPECT_EQ(&pool.Demangle(mangled_name_copy), &demangled_name);
+  EXPECT_EQ(pool.Size(), 1);
+
+  // Invalid names are returned as they are.
+  const std::string invalid_name = "_Zinvalid";
+  EXPECT_EQ(pool.Demangle(invalid_name), invalid_name);
+}
+
+namespace {
+// C names for one in four names, the others are mangled C++ names.
+std::vector<std::string> MakeNames(size_t first, size_t num_names) {
+  std::vector<std::string> names;
+  for (size_t i = first; i < first + num_names; ++i) {
+    std::string number = std::to_string(i);
+    if (i % 4 == 0) {
+      names.push_back("c_function_" + number);
+    } else {
+      std::string class_name = "Class" + number;
+      names.push_back("_ZN7project" + std::to_string(class_name.size()) +
+                      class_name + "6MethodERKSt6vectorIiSaIiEE");
+    }
+  }
+  return names;
+}
+}  // namespace
+
+TEST(SymbolNamePool, DemangleInBackground) {
+  constexpr size_t num_names = 1'000;
+  SymbolNamePool pool;
+  // The second list is queued behind the first one.
+  pool.DemangleInBackground(MakeNames(0, num_names));
+  pool.DemangleInBackground(MakeNames(num_names, num_names));
+  pool.WaitForBackgroundDemangling();
+  EXPECT_EQ(pool.Size(), 2 * num_names * 3 / 4);
+
+  // A new background thread is started after waiting.
+  pool.DemangleInBackground(MakeNames(2 * num_names, num_names));
+  pool.WaitForBackgroundDemangling();
+  EXPECT_EQ(pool.Size(), 3 * num_names * 3 / 4);
+
+  std::vector<std::string> names = MakeNames(0, 2);
+  EXPECT_EQ(&pool.Demangle(names[0]), &names[0]);
+  EXPECT_EQ(pool.Demangle(names[1]),
+            "project::Class1::Method(std::vector<int, std::allocator<int> > "
+            "const&)");
+  EXPECT_EQ(pool.Size(), 3 * num_names * 3 / 4);
+}
+
+TEST(SymbolNamePool, DemangledNameCache) {
+  SymbolNamePool pool;
+  const std::string c_name = "main";
+  DemangledNameCache c_name_cache;
+  EXPECT_EQ(&c_name_cache.Demangle(&pool, c_name), &c_name);
+
+  const std::string mangled_name = "_ZN3foo3barEi";
+  DemangledNameCache cache;
+  const std::string& demangled_name = cache.Demangle(&pool, mangled_name);
+  EXPECT_EQ(demangled_name, "foo::bar(int)");
+  EXPECT_EQ(&pool.Demangle(mangled_name), &demangled_name);
+
+  // Later lookups, also of copies, don't go through the pool.
+  const std::string other_mangled_name = "_ZN3foo3bazEi";
+  DemangledNameCache copy = cache;
+  EXPECT_EQ(&cache.Demangle(&pool, other_mangled_name), &demangled_name);
+  EXPECT_EQ(&copy.Demangle(&pool, other_mangled_name), &demangled_name);
+  EXPECT_EQ(pool.Size(), 1);
+
+  copy.Reset();
+  EXPECT_EQ(copy.Demangle(&pool, other_mangled_name), "foo::baz(int)");
+  EXPECT_EQ(pool.Size(), 2);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the memory taken
+// by demangling 100k names up front, as functions did, and by the pool, where
+// C names are not stored.
+TEST(SymbolNamePool, DISABLED_MemoryUsage) {
+  constexpr size_t num_names = 100'000;
+  std::vector<std::string> names = MakeNames(0, num_names);
+  SymbolNamePool pool;
+  pool.DemangleInBackground(names);
+  pool.WaitForBackgroundDemangling();
+
+  size_t eager_bytes = 0;
+  for (const std::string& name : names) {
+    const std::string& demangled_name = pool.Demangle(name);
+    eager_bytes += sizeof(std::string) + demangled_name.capacity();
+  }
+  printf("Pretty names: %.1f MB demangled up front, %.1f MB in the pool\n",
+         eager_bytes / 1e6, pool.GetMemoryUsage() / 1e6);
+}
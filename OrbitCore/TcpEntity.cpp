@@ -56,8 +56,12 @@ void TcpEntity::Stop() {
 
 //-----------------------------------------------------------------------------
 void TcpEntity::SendMsg(Message& a_Message, const void* a_Payload) {
-  TcpPacket buffer(a_Message, a_Payload);
-  m_SendQueue.enqueue(buffer);
+  SendPacket(TcpPacket(a_Message, a_Payload));
+}
+
+//-----------------------------------------------------------------------------
+void TcpEntity::SendPacket(TcpPacket&& a_Packet) {
+  m_SendQueue.enqueue(std::move(a_Packet));
   ++m_NumQueuedEntries;
   m_ConditionVariable.signal();
 }
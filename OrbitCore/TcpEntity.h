@@ -39,6 +39,8 @@ class TcpPacket {
   }
 
   std::shared_ptr<std::vector<char>> Data() { return m_Data; };
+  // Allows writing the payload in place when the packet was created without.
+  char* GetPayload() { return m_Data->data() + sizeof(Message); }
 
  private:
   std::shared_ptr<std::vector<char>> m_Data;
@@ -66,6 +68,7 @@ class TcpEntity {
   inline void Send(Orbit::UserData& a_Entry);
   inline void Send(MessageType type, const void* data, size_t size);
   inline void Send(Message& message, const void* data, size_t size);
+  void SendPacket(TcpPacket&& packet);
 
   template <class T>
   void Send(Message& a_Message, const std::vector<T>& a_Vector);
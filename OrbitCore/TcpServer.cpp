@@ -36,6 +36,10 @@ TcpServer::TcpServer() : m_TcpServer(nullptr) {
   m_NumTargetFlushedEntries = 0;
   m_NumTargetFlushedTcpPackets = 0;
   m_NumMessagesFromPreviousSession = 0;
+  m_NumEncodedEvents = 0;
+  m_NumRawEventBytes = 0;
+  m_NumEncodedEventBytes = 0;
+  m_EncodingNanos = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -61,6 +65,10 @@ void TcpServer::Start(unsigned short a_Port) {
 //-----------------------------------------------------------------------------
 void TcpServer::ResetStats() {
   m_NumReceivedMessages = 0;
+  m_NumEncodedEvents = 0;
+  m_NumRawEventBytes = 0;
+  m_NumEncodedEventBytes = 0;
+  m_EncodingNanos = 0;
   if (m_TcpServer != nullptr) {
     m_TcpServer->ResetStats();
   }
@@ -84,9 +92,34 @@ std::vector<std::string> TcpServer::GetStats() {
       " ( " + GetPrettyBitRate(static_cast<ULONG64>(m_BytesPerSecond)) + " )\n";
 
   stats.push_back(bitRate);
+
+  uint64_t numEncodedEvents = m_NumEncodedEvents;
+  if (numEncodedEvents > 0) {
+    uint64_t numRawBytes = m_NumRawEventBytes;
+    stats.push_back(absl::StrFormat(
+        "Bytes per event on the wire = %.1f (raw: %.1f)\n",
+        static_cast<double>(m_NumEncodedEventBytes) / numEncodedEvents,
+        static_cast<double>(numRawBytes) / numEncodedEvents));
+    if (numRawBytes > 0) {
+      double megabytes = static_cast<double>(numRawBytes) / (1024 * 1024);
+      stats.push_back(
+          absl::StrFormat("Encoding cost = %.3f ms/MB\n",
+                          m_EncodingNanos * 0.000001 / megabytes));
+    }
+  }
   return stats;
 }
 
+//-----------------------------------------------------------------------------
+void TcpServer::AddEncodingStats(uint64_t a_NumEvents, uint64_t a_NumRawBytes,
+                                 uint64_t a_NumEncodedBytes,
+                                 double a_EncodingMillis) {
+  m_NumEncodedEvents += a_NumEvents;
+  m_NumRawEventBytes += a_NumRawBytes;
+  m_NumEncodedEventBytes += a_NumEncodedBytes;
+  m_EncodingNanos += static_cast<uint64_t>(a_EncodingMillis * 1000000);
+}
+
 //-----------------------------------------------------------------------------
 TcpSocket* TcpServer::GetSocket() {
   return m_TcpServer != nullptr ? m_TcpServer->GetSocket() : nullptr;
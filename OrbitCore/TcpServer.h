@@ -3,6 +3,7 @@
 //-----------------------------------
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <unordered_map>
 
@@ -45,6 +46,10 @@ class TcpServer : public TcpEntity {
 
   void ResetStats();
   std::vector<std::string> GetStats();
+  // Accounts for a batch of events sent to the client, to report the bytes on
+  // the wire per event and the cost of encoding them in GetStats.
+  void AddEncodingStats(uint64_t num_events, uint64_t num_raw_bytes,
+                        uint64_t num_encoded_bytes, double encoding_millis);
 
  protected:
   class TcpSocket* GetSocket() override final;
@@ -67,6 +72,11 @@ class TcpServer : public TcpEntity {
   uint32_t m_NumTargetFlushedEntries;
   uint32_t m_NumTargetFlushedTcpPackets;
   ULONG64 m_NumMessagesFromPreviousSession;
+
+  std::atomic<uint64_t> m_NumEncodedEvents;
+  std::atomic<uint64_t> m_NumRawEventBytes;
+  std::atomic<uint64_t> m_NumEncodedEventBytes;
+  std::atomic<uint64_t> m_EncodingNanos;
 };
 
 extern TcpServer* GTcpServer;
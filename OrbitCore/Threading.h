@@ -5,9 +5,12 @@
 
 #include <autoresetevent.h>
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 // Moodycamel's concurrent queue
 #ifdef WIN32
@@ -36,6 +39,31 @@ typedef std::condition_variable ConditionVariable;
 template <typename T>
 using LockFreeQueue = moodycamel::ConcurrentQueue<T>;
 
+//-----------------------------------------------------------------------------
+// Calls a_Function(i) for each i in [0, a_Count), spreading the calls over the
+// calling thread and up to hardware_concurrency() - 1 additional threads.
+// Unlike oqpi_tk::parallel_for, this is available on all platforms.
+template <typename Function>
+inline void ParallelFor(size_t a_Count, Function&& a_Function) {
+  size_t numThreads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), a_Count);
+  std::atomic<size_t> nextIndex(0);
+  auto worker = [&]() {
+    for (size_t i = nextIndex++; i < a_Count; i = nextIndex++) {
+      a_Function(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 #ifdef _WIN32
 const DWORD MS_VC_EXCEPTION = 0x406D1388;
 
@@ -53,6 +53,7 @@
 #include "Serialization.h"
 #include "SessionsDataView.h"
 #include "StringManager.h"
+#include "SymbolNamePool.h"
 #include "Systrace.h"
 #include "Tcp.h"
 #include "TcpClient.h"
@@ -185,7 +186,8 @@ void OrbitApp::ProcessTimer(const Timer& a_Timer, const std::string&) {
 void OrbitApp::ProcessSamplingCallStack(LinuxCallstackEvent& a_CallStack) {
   CHECK(!ConnectionManager::Get().IsService());
 
-  Capture::GSamplingProfiler->AddCallStack(a_CallStack.m_CS);
+  Capture::GSamplingProfiler->AddCallStack(a_CallStack.m_CS,
+                                          a_CallStack.m_time);
   GEventTracer.GetEventBuffer().AddCallstackEvent(
       a_CallStack.m_time, a_CallStack.m_CS.m_Hash, a_CallStack.m_CS.m_ThreadId);
 }
@@ -1164,6 +1166,7 @@ void OrbitApp::OnRemoteModuleDebugInfo(const Message& a_Message) {
   std::vector<ModuleDebugInfo> remoteModuleDebugInfo;
   inputAr(remoteModuleDebugInfo);
 
+  std::vector<std::string> mangledNames;
   for (auto& moduleInfo : remoteModuleDebugInfo) {
     // Get module from name
     std::string name = ToLower(moduleInfo.m_Name);
@@ -1174,16 +1177,21 @@ void OrbitApp::OnRemoteModuleDebugInfo(const Message& a_Message) {
       module->LoadDebugInfo();  // To allocate m_Pdb - TODO: clean that up
       module->m_Pdb->SetLoadBias(moduleInfo.load_bias);
 
-      for (auto& function : moduleInfo.m_Functions) {
-        // Add function to pdb
-        module->m_Pdb->AddFunction(function);
+      for (const Function& function : moduleInfo.m_Functions) {
+        if (SymbolNamePool::IsMangled(function.Name())) {
+          mangledNames.push_back(function.Name());
+        }
       }
 
-      module->m_Pdb->ProcessData();
+      Capture::GTargetProcess->AddFunctions(module, moduleInfo.m_Functions);
       module->SetLoaded(true);
     }
   }
 
+  // Functions are sent without pretty names, demangle them before they are
+  // displayed.
+  GSymbolNamePool.DemangleInBackground(std::move(mangledNames));
+
   GOrbitApp->FireRefreshCallbacks();
 }
 
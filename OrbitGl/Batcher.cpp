@@ -3,7 +3,70 @@
 //-----------------------------------
 #include "Batcher.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "Core.h"
+#include "OpenGl.h"
+
+namespace {
+// Adds a_Offset to the id of a picking color, keeping its type.
+Color OffsetPickingColor(const Color& a_PickingColor, uint32_t a_Offset) {
+  uint32_t value;
+  static_assert(sizeof(value) == sizeof(a_PickingColor));
+  memcpy(&value, &a_PickingColor, sizeof(value));
+  PickingID id = PickingID::Get(value);
+  return PickingID::GetColor(static_cast<PickingID::Type>(id.m_Type),
+                             id.m_Id + a_Offset);
+}
+
+// Copies the elements of a_Other after the ones of a_Chain, one block after
+// the other.
+template <class T, uint32_t BlockSize>
+void AppendBlockChain(const BlockChain<T, BlockSize>& a_Other,
+                      BlockChain<T, BlockSize>* a_Chain) {
+  for (Block<T, BlockSize>* block = a_Other.m_Root;
+       block != nullptr && block->m_Size > 0; block = block->m_Next) {
+    a_Chain->push_back(block->m_Data, block->m_Size);
+  }
+}
+
+// Same as above for picking colors, offsetting their ids by a_IdOffset.
+template <uint32_t BlockSize>
+void AppendPickingColors(const BlockChain<Color, BlockSize>& a_Other,
+                         uint32_t a_IdOffset,
+                         BlockChain<Color, BlockSize>* a_Chain) {
+  constexpr uint32_t kChunkSize = 1024;
+  Color chunk[kChunkSize];
+  for (Block<Color, BlockSize>* block = a_Other.m_Root;
+       block != nullptr && block->m_Size > 0; block = block->m_Next) {
+    uint32_t blockSize = block->m_Size;
+    for (uint32_t begin = 0; begin < blockSize; begin += kChunkSize) {
+      uint32_t num = std::min(kChunkSize, blockSize - begin);
+      for (uint32_t i = 0; i < num; ++i) {
+        chunk[i] = OffsetPickingColor(block->m_Data[begin + i], a_IdOffset);
+      }
+      a_Chain->push_back(chunk, num);
+    }
+  }
+}
+
+// Fills a_Buffer with the elements of a_Chain, one block after the other.
+template <class T, uint32_t BlockSize>
+void UploadBlockChain(GLuint a_Buffer,
+                      const BlockChain<T, BlockSize>& a_Chain) {
+  glBindBuffer(GL_ARRAY_BUFFER, a_Buffer);
+  glBufferData(GL_ARRAY_BUFFER, a_Chain.size() * sizeof(T), nullptr,
+               GL_DYNAMIC_DRAW);
+  GLintptr offset = 0;
+  for (Block<T, BlockSize>* block = a_Chain.m_Root;
+       block != nullptr && block->m_Size > 0; block = block->m_Next) {
+    GLsizeiptr size = block->m_Size * sizeof(T);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, block->m_Data);
+    offset += size;
+  }
+}
+}  // namespace
 
 //-----------------------------------------------------------------------------
 TextBox* Batcher::GetTextBox(PickingID a_ID) {
@@ -18,4 +81,86 @@ TextBox* Batcher::GetTextBox(PickingID a_ID) {
   }
 
   return nullptr;
-}
\ No newline at end of file
+}
+
+//-----------------------------------------------------------------------------
+void Batcher::Append(Batcher& a_Other) {
+  // Picking ids are the indices of the primitives in their batcher.
+  LineBuffer& lines = a_Other.m_LineBuffer;
+  uint32_t lineIdOffset = m_LineBuffer.m_Lines.size();
+  AppendBlockChain(lines.m_Lines, &m_LineBuffer.m_Lines);
+  AppendBlockChain(lines.m_Colors, &m_LineBuffer.m_Colors);
+  AppendPickingColors(lines.m_PickingColors, lineIdOffset,
+                      &m_LineBuffer.m_PickingColors);
+  AppendBlockChain(lines.m_UserData, &m_LineBuffer.m_UserData);
+
+  BoxBuffer& boxes = a_Other.m_BoxBuffer;
+  uint32_t boxIdOffset = m_BoxBuffer.m_Boxes.size();
+  AppendBlockChain(boxes.m_Boxes, &m_BoxBuffer.m_Boxes);
+  AppendBlockChain(boxes.m_Colors, &m_BoxBuffer.m_Colors);
+  AppendPickingColors(boxes.m_PickingColors, boxIdOffset,
+                      &m_BoxBuffer.m_PickingColors);
+  AppendBlockChain(boxes.m_UserData, &m_BoxBuffer.m_UserData);
+
+  m_NeedsUpload = true;
+}
+
+//-----------------------------------------------------------------------------
+void Batcher::Draw(bool a_Picking) {
+  static_assert(sizeof(GLuint) == sizeof(uint32_t));
+  if (m_BoxVbos.m_Vertices == 0) {
+    for (VertexBufferObjects* vbos : {&m_LineVbos, &m_BoxVbos}) {
+      glGenBuffers(1, &vbos->m_Vertices);
+      glGenBuffers(1, &vbos->m_Colors);
+      glGenBuffers(1, &vbos->m_PickingColors);
+    }
+  }
+
+  if (m_NeedsUpload) {
+    Upload();
+    m_NeedsUpload = false;
+  }
+
+  DrawVertexBufferObjects(m_BoxVbos, GL_QUADS, 4 * m_BoxBuffer.m_Boxes.size(),
+                          a_Picking);
+  DrawVertexBufferObjects(m_LineVbos, GL_LINES,
+                          2 * m_LineBuffer.m_Lines.size(), a_Picking);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//-----------------------------------------------------------------------------
+void Batcher::ReleaseVertexBufferObjects() {
+  for (VertexBufferObjects* vbos : {&m_LineVbos, &m_BoxVbos}) {
+    if (vbos->m_Vertices != 0) {
+      GLuint buffers[] = {vbos->m_Vertices, vbos->m_Colors,
+                          vbos->m_PickingColors};
+      glDeleteBuffers(3, buffers);
+      *vbos = VertexBufferObjects();
+    }
+  }
+  m_NeedsUpload = true;
+}
+
+//-----------------------------------------------------------------------------
+void Batcher::Upload() {
+  UploadBlockChain(m_LineVbos.m_Vertices, m_LineBuffer.m_Lines);
+  UploadBlockChain(m_LineVbos.m_Colors, m_LineBuffer.m_Colors);
+  UploadBlockChain(m_LineVbos.m_PickingColors, m_LineBuffer.m_PickingColors);
+  UploadBlockChain(m_BoxVbos.m_Vertices, m_BoxBuffer.m_Boxes);
+  UploadBlockChain(m_BoxVbos.m_Colors, m_BoxBuffer.m_Colors);
+  UploadBlockChain(m_BoxVbos.m_PickingColors, m_BoxBuffer.m_PickingColors);
+}
+
+//-----------------------------------------------------------------------------
+void Batcher::DrawVertexBufferObjects(const VertexBufferObjects& a_Vbos,
+                                      uint32_t a_Mode, uint32_t a_NumVertices,
+                                      bool a_Picking) {
+  if (a_NumVertices == 0) return;
+
+  glBindBuffer(GL_ARRAY_BUFFER, a_Vbos.m_Vertices);
+  glVertexPointer(3, GL_FLOAT, sizeof(Vec3), nullptr);
+  glBindBuffer(GL_ARRAY_BUFFER,
+               !a_Picking ? a_Vbos.m_Colors : a_Vbos.m_PickingColors);
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color), nullptr);
+  glDrawArrays(a_Mode, 0, a_NumVertices);
+}
@@ -2,6 +2,7 @@
 // Copyright Pierric Gimmig 2013-2017
 //-----------------------------------
 #pragma once
+#include <cstdint>
 #include <vector>
 
 #include "BlockChain.h"
@@ -44,6 +45,10 @@ struct BoxBuffer {
 //-----------------------------------------------------------------------------
 class Batcher {
  public:
+  Batcher() = default;
+  Batcher(const Batcher&) = delete;
+  Batcher& operator=(const Batcher&) = delete;
+
   inline void AddLine(const Line& a_Line, Color* a_Colors,
                       PickingID::Type a_Type, void* a_UserData = nullptr) {
     Color pickCol = PickingID::GetColor(a_Type, m_LineBuffer.m_Lines.size());
@@ -51,6 +56,7 @@ class Batcher {
     m_LineBuffer.m_Colors.push_back(a_Colors, 2);
     m_LineBuffer.m_PickingColors.push_back_n(pickCol, 2);
     m_LineBuffer.m_UserData.push_back(a_UserData);
+    m_NeedsUpload = true;
   }
 
   inline void AddBox(const Box& a_Box, Color* a_Colors, PickingID::Type a_Type,
@@ -60,19 +66,52 @@ class Batcher {
     m_BoxBuffer.m_Colors.push_back(a_Colors, 4);
     m_BoxBuffer.m_PickingColors.push_back_n(pickCol, 4);
     m_BoxBuffer.m_UserData.push_back(a_UserData);
+    m_NeedsUpload = true;
   }
 
   inline void Reset() {
     m_LineBuffer.Reset();
     m_BoxBuffer.Reset();
+    m_NeedsUpload = true;
   }
 
+  // Adds the lines and boxes of a_Other after the ones of this batcher. Their
+  // picking ids follow the ones already in this batcher.
+  void Append(Batcher& a_Other);
+
+  // Draws the boxes, then the lines, from vertex buffer objects. They are
+  // only filled again when primitives were added or reset since the last
+  // call, so that redrawing unchanged primitives doesn't send them to the
+  // GPU again. Requires a current GL context.
+  void Draw(bool a_Picking);
+  // Deletes the vertex buffer objects filled by Draw, which are created again
+  // by the next call. They are not deleted by the destructor, which can run
+  // without a current GL context: the owner of a drawn batcher calls this
+  // while the context is current. Requires a current GL context.
+  void ReleaseVertexBufferObjects();
+
   TextBox* GetTextBox(PickingID a_ID);
 
   BoxBuffer& GetBoxBuffer() { return m_BoxBuffer; }
   LineBuffer& GetLineBuffer() { return m_LineBuffer; }
 
  protected:
+  // Names of the GL buffer objects holding the vertices, colors and picking
+  // colors of a LineBuffer or BoxBuffer. 0 until first drawn.
+  struct VertexBufferObjects {
+    uint32_t m_Vertices = 0;
+    uint32_t m_Colors = 0;
+    uint32_t m_PickingColors = 0;
+  };
+
+  void Upload();
+  static void DrawVertexBufferObjects(const VertexBufferObjects& a_Vbos,
+                                      uint32_t a_Mode, uint32_t a_NumVertices,
+                                      bool a_Picking);
+
   LineBuffer m_LineBuffer;
   BoxBuffer m_BoxBuffer;
+  VertexBufferObjects m_LineVbos;
+  VertexBufferObjects m_BoxVbos;
+  bool m_NeedsUpload = true;
 };
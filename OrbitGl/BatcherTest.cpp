@@ -0,0 +1,206 @@
+#include "Batcher.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "TimerChain.h"
+
+namespace {
+PickingID GetPickingId(const Color& color) {
+  uint32_t value;
+  memcpy(&value, &color, sizeof(value));
+  return PickingID::Get(value);
+}
+
+Line MakeLine(float x) {
+  Line line;
+  line.m_Beg = Vec3(x, 0, 0);
+  line.m_End = Vec3(x, 1, 0);
+  return line;
+}
+
+Box MakeBox(float x) {
+  Box box;
+  for (Vec3& vertex : box.m_Vertices) vertex = Vec3(x, 0, 0);
+  return box;
+}
+
+// Adds a box for each timer of tracks, roughly as
+// TimeGraph::UpdateTrackPrimitives does.
+void AddBoxes(const std::vector<std::unique_ptr<TimerChain>>& tracks,
+              size_t begin, size_t end, Batcher* batcher) {
+  for (size_t i = begin; i < end; ++i) {
+    for (TimerBlock& block : *tracks[i]) {
+      for (uint32_t k = 0; k < block.size(); ++k) {
+        TextBox& text_box = block[k];
+        const Timer& timer = text_box.GetTimer();
+        float x = static_cast<float>(timer.m_Start) * 1e-3f;
+        float width = static_cast<float>(timer.m_End - timer.m_Start) * 1e-3f;
+        text_box.SetPos(Vec2(x, static_cast<float>(i)));
+        text_box.SetSize(Vec2(width, 1.f));
+        Box box;
+        box.m_Vertices[0] = Vec3(x, static_cast<float>(i), 0);
+        box.m_Vertices[1] = Vec3(x, static_cast<float>(i) + 1, 0);
+        box.m_Vertices[2] = Vec3(x + width, static_cast<float>(i) + 1, 0);
+        box.m_Vertices[3] = Vec3(x + width, static_cast<float>(i), 0);
+        Color color(static_cast<unsigned char>(i), 0, 0, 255);
+        Color colors[4];
+        Fill(colors, color);
+        batcher->AddBox(box, colors, PickingID::BOX, &text_box);
+      }
+    }
+  }
+}
+
+std::vector<std::unique_ptr<TimerChain>> MakeTracks(
+    size_t num_tracks, uint32_t num_timers_per_track) {
+  std::vector<std::unique_ptr<TimerChain>> tracks;
+  for (size_t i = 0; i < num_tracks; ++i) {
+    tracks.push_back(std::make_unique<TimerChain>());
+    for (uint32_t j = 0; j < num_timers_per_track; ++j) {
+      Timer timer;
+      timer.m_Start = 1000 * j;
+      timer.m_End = 1000 * j + 500 + i;
+      TextBox text_box;
+      text_box.SetTimer(timer);
+      tracks.back()->push_back(text_box);
+    }
+  }
+  return tracks;
+}
+
+// Adds the boxes of tracks with one batcher per worker, each worker taking a
+// contiguous range of tracks, then appends the batchers in order as
+// TimeGraph::UpdatePrimitives does. Returns the first batcher.
+std::unique_ptr<Batcher> AddBoxesInParallel(
+    const std::vector<std::unique_ptr<TimerChain>>& tracks,
+    size_t num_workers) {
+  std::vector<std::unique_ptr<Batcher>> batchers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    batchers.push_back(std::make_unique<Batcher>());
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_workers; ++i) {
+    threads.emplace_back([&, i] {
+      AddBoxes(tracks, tracks.size() * i / num_workers,
+               tracks.size() * (i + 1) / num_workers, batchers[i].get());
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 1; i < num_workers; ++i) {
+    batchers[0]->Append(*batchers[i]);
+  }
+  return std::move(batchers[0]);
+}
+}  // namespace
+
+TEST(Batcher, Append) {
+  int user_data[5];
+  Color red(255, 0, 0, 255);
+  Color red_colors[4];
+  Fill(red_colors, red);
+  Color green(0, 255, 0, 255);
+  Color green_colors[4];
+  Fill(green_colors, green);
+
+  Batcher batcher;
+  batcher.AddLine(MakeLine(0), red_colors, PickingID::LINE, &user_data[0]);
+  batcher.AddBox(MakeBox(1), red_colors, PickingID::BOX, &user_data[1]);
+
+  Batcher other;
+  other.AddLine(MakeLine(2), green_colors, PickingID::EVENT, &user_data[2]);
+  other.AddLine(MakeLine(3), green_colors, PickingID::LINE, &user_data[3]);
+  other.AddBox(MakeBox(4), green_colors, PickingID::BOX, &user_data[4]);
+
+  batcher.Append(other);
+
+  LineBuffer& lines = batcher.GetLineBuffer();
+  ASSERT_EQ(lines.m_Lines.size(), 3);
+  ASSERT_EQ(lines.m_Colors.size(), 6);
+  ASSERT_EQ(lines.m_PickingColors.size(), 6);
+  EXPECT_EQ(lines.m_Lines.SlowAt(2)->m_Beg[0], 3);
+  EXPECT_EQ(*lines.m_Colors.SlowAt(5), green);
+  EXPECT_EQ(*lines.m_UserData.SlowAt(1), &user_data[2]);
+  PickingID id = GetPickingId(*lines.m_PickingColors.SlowAt(2));
+  EXPECT_EQ(id.m_Type, PickingID::EVENT);
+  EXPECT_EQ(id.m_Id, 1);
+  id = GetPickingId(*lines.m_PickingColors.SlowAt(5));
+  EXPECT_EQ(id.m_Type, PickingID::LINE);
+  EXPECT_EQ(id.m_Id, 2);
+
+  BoxBuffer& boxes = batcher.GetBoxBuffer();
+  ASSERT_EQ(boxes.m_Boxes.size(), 2);
+  ASSERT_EQ(boxes.m_PickingColors.size(), 8);
+  EXPECT_EQ(boxes.m_Boxes.SlowAt(1)->m_Vertices[0][0], 4);
+  EXPECT_EQ(*boxes.m_Colors.SlowAt(4), green);
+  EXPECT_EQ(batcher.GetTextBox(PickingID::Get(PickingID::BOX, 1)),
+            reinterpret_cast<TextBox*>(&user_data[4]));
+  id = GetPickingId(*boxes.m_PickingColors.SlowAt(7));
+  EXPECT_EQ(id.m_Type, PickingID::BOX);
+  EXPECT_EQ(id.m_Id, 1);
+
+  // Other is left untouched.
+  EXPECT_EQ(other.GetLineBuffer().m_Lines.size(), 2);
+}
+
+// The boxes and their picking ids must not depend on the number of workers.
+TEST(Batcher, ParallelTracks) {
+  constexpr size_t num_tracks = 16;
+  constexpr uint32_t num_timers_per_track = 5'000;
+  std::vector<std::unique_ptr<TimerChain>> tracks =
+      MakeTracks(num_tracks, num_timers_per_track);
+
+  std::vector<void*> expected_user_data;
+  for (size_t num_workers : {1, 3, 16}) {
+    std::unique_ptr<Batcher> batcher = AddBoxesInParallel(tracks, num_workers);
+    BoxBuffer& boxes = batcher->GetBoxBuffer();
+    ASSERT_EQ(boxes.m_Boxes.size(), num_tracks * num_timers_per_track);
+    ASSERT_EQ(boxes.m_PickingColors.size(), 4 * boxes.m_Boxes.size());
+
+    std::vector<void*> user_data;
+    for (void* text_box : boxes.m_UserData) {
+      user_data.push_back(text_box);
+    }
+    if (expected_user_data.empty()) {
+      expected_user_data = user_data;
+    } else {
+      EXPECT_EQ(user_data, expected_user_data);
+    }
+
+    uint32_t index = 0;
+    for (const Color& color : boxes.m_PickingColors) {
+      PickingID id = GetPickingId(color);
+      ASSERT_EQ(id.m_Type, PickingID::BOX);
+      ASSERT_EQ(id.m_Id, index / 4);
+      ++index;
+    }
+  }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the time to add
+// the boxes of 256 tracks on several numbers of workers.
+TEST(Batcher, DISABLED_ParallelTracksThroughput) {
+  constexpr size_t num_tracks = 256;
+  constexpr uint32_t num_timers_per_track = 10'000;
+  std::vector<std::unique_ptr<TimerChain>> tracks =
+      MakeTracks(num_tracks, num_timers_per_track);
+
+  for (size_t num_workers : {1, 4, 16}) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<Batcher> batcher = AddBoxesInParallel(tracks, num_workers);
+    auto end = std::chrono::steady_clock::now();
+
+    BoxBuffer& boxes = batcher->GetBoxBuffer();
+    EXPECT_EQ(boxes.m_Boxes.size(), num_tracks * num_timers_per_track);
+    printf("%u boxes of %zu tracks on %zu workers: %.1f ms\n",
+           boxes.m_Boxes.size(), num_tracks, num_workers,
+           std::chrono::duration<double, std::milli>(end - start).count());
+  }
+}
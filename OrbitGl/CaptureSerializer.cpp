@@ -104,11 +104,14 @@ void CaptureSerializer::Save(T& a_Archive) {
   std::vector<std::shared_ptr<TimerChain> > chains =
       m_TimeGraph->GetAllTimerChains();
   for (const std::shared_ptr<TimerChain>& chain : chains) {
-    for (const TextBox& box : *chain) {
-      a_Archive(cereal::binary_data((char*)&box.GetTimer(), sizeof(Timer)));
-
-      if (++numWrites > m_NumTimers) {
-        return;
+    for (const TimerBlock& block : *chain) {
+      for (uint32_t i = 0; i < block.size(); ++i) {
+        a_Archive(
+            cereal::binary_data((char*)&block[i].GetTimer(), sizeof(Timer)));
+
+        if (++numWrites > m_NumTimers) {
+          return;
+        }
       }
     }
   }
@@ -129,10 +132,10 @@ void CaptureSerializer::Load(const std::wstring a_FileName) {
 
     // functions
     std::shared_ptr<Module> module = std::make_shared<Module>();
-    Capture::GTargetProcess->AddModule(module);
     module->m_Pdb = std::make_shared<Pdb>(ws2s(a_FileName).c_str());
     archive(module->m_Pdb->GetFunctions());
     module->m_Pdb->ProcessData();
+    Capture::GTargetProcess->AddModule(module);
     GPdbDbg = module->m_Pdb;
     Capture::GSelectedFunctionsMap.clear();
     for (Function& func : module->m_Pdb->GetFunctions()) {
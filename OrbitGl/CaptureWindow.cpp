@@ -129,10 +129,11 @@ void CaptureWindow::MouseMoved(int a_X, int a_Y, bool a_Left, bool /*a_Right*/,
               m_WorldHeight - m_TimeGraph.GetThreadTotalHeight(), m_WorldMaxY);
     UpdateSceneBox();
 
+    // PanTime decides whether the time graph primitives need an update.
     m_TimeGraph.PanTime(m_ScreenClickX, a_X, getWidth(),
                         (double)m_RefTimeClick);
     UpdateVerticalSlider();
-    NeedsUpdate();
+    NeedsRedraw();
   }
 
   if (m_IsSelecting) {
@@ -271,9 +272,9 @@ void CaptureWindow::Hover(int a_X, int a_Y) {
     if (!textBox->GetTimer().IsType(Timer::CORE_ACTIVITY)) {
       Function* func =
           Capture::GSelectedFunctionsMap[textBox->GetTimer().m_FunctionAddress];
-      m_ToolTip =
-          s2ws(absl::StrFormat("%s %s", func ? func->PrettyName().c_str() : "",
-                               textBox->GetText().c_str()));
+      m_ToolTip = s2ws(
+          absl::StrFormat("%s %s", func ? func->PrettyName().c_str() : "",
+                          m_TimeGraph.GetTimerLabel(*textBox).m_Text.c_str()));
       GOrbitApp->SendToUiAsync(L"tooltip:" + m_ToolTip);
       NeedsRedraw();
     }
@@ -320,6 +321,11 @@ void CaptureWindow::PreRender() {
   m_NeedsRedraw = m_NeedsRedraw || m_TimeGraph.IsRedrawNeeded();
 }
 
+//-----------------------------------------------------------------------------
+void CaptureWindow::ReleaseGlResources() {
+  m_TimeGraph.ReleaseVertexBufferObjects();
+}
+
 //-----------------------------------------------------------------------------
 void CaptureWindow::PostRender() {
   if (m_IsHovering) {
@@ -433,7 +439,7 @@ void CaptureWindow::Pan(float a_Ratio) {
                       m_MousePosX + static_cast<int>(a_Ratio * getWidth()),
                       getWidth(), refTime);
   UpdateSceneBox();
-  NeedsUpdate();
+  NeedsRedraw();
 }
 
 //-----------------------------------------------------------------------------
@@ -642,10 +648,14 @@ void CaptureWindow::Draw() {
     Vec2 pos(from, m_WorldTopLeftY - m_WorldHeight);
     Vec2 size(sizex, m_WorldHeight);
 
-    std::string time = GetPrettyTime(micros * 0.001);
-    TextBox box(pos, size, time, Color(0, 128, 0, 128));
-    box.SetTextY(m_SelectStop[1]);
-    box.Draw(m_TextRenderer, -FLT_MAX, true, true);
+    TextBox box(pos, size, Color(0, 128, 0, 128));
+    box.Draw();
+
+    if (!m_Picking) {
+      std::string time = GetPrettyTime(micros * 0.001);
+      m_TextRenderer.AddText(time.c_str(), to, m_SelectStop[1], Z_VALUE_TEXT,
+                             Color(255, 255, 255, 255), -1.f, true);
+    }
   }
 
   if (!m_Picking && !m_IsHovering) {
@@ -822,6 +832,11 @@ void CaptureWindow::RenderUI() {
     m_StatsWindow.AddLine(VAR_TO_ANSI(m_TimeGraph.GetNumDrawnTextBoxes()));
     m_StatsWindow.AddLine(VAR_TO_ANSI(m_TimeGraph.GetNumTimers()));
     m_StatsWindow.AddLine(VAR_TO_ANSI(m_TimeGraph.GetThreadTotalHeight()));
+    m_StatsWindow.AddLine(VAR_TO_ANSI(GetLastRenderTimeMs()));
+    m_StatsWindow.AddLine(VAR_TO_ANSI(GetAverageRenderTimeMs()));
+    m_StatsWindow.AddLine(VAR_TO_ANSI(GetMaxRenderTimeMs()));
+    m_StatsWindow.AddLine(
+        VAR_TO_ANSI(m_TimeGraph.GetUpdatePrimitivesTimeMs()));
 
 #ifdef WIN32
     for (std::string& line : GTcpServer->GetStats()) {
@@ -43,6 +43,7 @@ class CaptureWindow : public GlCanvas {
   void RenderText() override;
   void PreRender() override;
   void PostRender() override;
+  void ReleaseGlResources() override;
   void Resize(int a_Width, int a_Height) override;
   void RenderHelpUi();
   void RenderThreadFilterUi();
@@ -4,6 +4,7 @@
 
 #include "GlCanvas.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -505,6 +506,7 @@ void GlCanvas::Render(int a_Width, int a_Height) {
   glFlush();
 
   timer.Stop();
+  m_RenderTimesMs.Add(static_cast<float>(timer.ElapsedMillis()));
 
   m_ImguiActive = ImGui::IsAnyItemActive();
 
@@ -514,6 +516,31 @@ void GlCanvas::Render(int a_Width, int a_Height) {
   m_DoubleClicking = false;
 }
 
+//-----------------------------------------------------------------------------
+float GlCanvas::GetLastRenderTimeMs() {
+  return m_RenderTimesMs.Size() > 0 ? m_RenderTimesMs.Latest() : 0.f;
+}
+
+//-----------------------------------------------------------------------------
+float GlCanvas::GetAverageRenderTimeMs() {
+  if (m_RenderTimesMs.Size() == 0) return 0.f;
+
+  float sum = 0.f;
+  for (size_t i = 0; i < m_RenderTimesMs.Size(); ++i) {
+    sum += m_RenderTimesMs[i];
+  }
+  return sum / static_cast<float>(m_RenderTimesMs.Size());
+}
+
+//-----------------------------------------------------------------------------
+float GlCanvas::GetMaxRenderTimeMs() {
+  float max = 0.f;
+  for (size_t i = 0; i < m_RenderTimesMs.Size(); ++i) {
+    max = std::max(max, m_RenderTimesMs[i]);
+  }
+  return max;
+}
+
 //-----------------------------------------------------------------------------
 void GlCanvas::Resize(int a_Width, int a_Height) {
   m_Width = a_Width;
@@ -8,6 +8,7 @@
 #include "ImGuiOrbit.h"
 #include "PickingManager.h"
 #include "ProcessUtils.h"
+#include "RingBuffer.h"
 #include "TextRenderer.h"
 #include "TimeGraph.h"
 
@@ -92,6 +93,12 @@ class GlCanvas : public GlPanel {
 
   float GetDeltaTimeSeconds() const { return m_DeltaTime; }
 
+  // Time spent in Render for the last frames, in milliseconds. This is CPU
+  // time: Render doesn't wait for the GPU to be done.
+  float GetLastRenderTimeMs();
+  float GetAverageRenderTimeMs();
+  float GetMaxRenderTimeMs();
+
   virtual void Draw() {}
   virtual void DrawScreenSpace() {}
   virtual void RenderUI();
@@ -153,6 +160,7 @@ class GlCanvas : public GlPanel {
   TextRenderer m_TextRenderer;
   TextBox m_SceneBox;
   Timer m_UpdateTimer;
+  RingBuffer<float, 128> m_RenderTimesMs;
   PickingManager m_PickingManager;
   bool m_Picking;
   bool m_DoubleClicking;
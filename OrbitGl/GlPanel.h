@@ -18,6 +18,9 @@ class GlPanel {
   virtual void Resize(int a_Width, int a_Height);
   virtual void Render(int a_Width, int a_Height);
   virtual void PreRender(){};
+  // Frees the GL objects of the panel. Called while its GL context is current,
+  // before the context is destroyed.
+  virtual void ReleaseGlResources() {}
   virtual void SetWindowOffset(int a_X, int a_Y) {
     m_WindowOffset[0] = a_X;
     m_WindowOffset[1] = a_Y;
@@ -23,6 +23,7 @@ SamplingReport::~SamplingReport() { m_ThreadReports.clear(); }
 
 //-----------------------------------------------------------------------------
 void SamplingReport::FillReport() {
+  ScopeLock lock(m_Profiler->GetMutex());
   const auto& sampleData = m_Profiler->GetThreadSampleData();
 
   for (ThreadSampleData* threadSampleData : sampleData) {
@@ -105,8 +106,9 @@ void SamplingReport::OnCallstackIndexChanged(int a_Index) {
       a_Index < (int)m_SelectedSortedCallstackReport->m_CallStacks.size()) {
     CallstackCount& cs = m_SelectedSortedCallstackReport->m_CallStacks[a_Index];
     m_SelectedAddressCallstackIndex = a_Index;
+    CallstackView callstack = m_Profiler->GetCallStack(cs.m_CallstackId);
     m_CallstackDataView->SetCallStack(
-        m_Profiler->GetCallStack(cs.m_CallstackId));
+        callstack ? std::make_shared<CallStack>(callstack) : nullptr);
   } else {
     m_SelectedAddressCallstackIndex = 0;
   }
@@ -12,12 +12,14 @@
 #include "Core.h"
 #include "OrbitModule.h"
 #include "OrbitType.h"
+#include "Params.h"
 #include "SamplingReport.h"
 
 //-----------------------------------------------------------------------------
 SamplingReportDataView::SamplingReportDataView()
     : m_CallstackDataView(nullptr) {
   m_SortingToggles.resize(SamplingColumn::NumColumns, false);
+  m_UpdatePeriodMs = GParams.m_LiveSamplingReportPeriodMs;
 }
 
 //-----------------------------------------------------------------------------
@@ -235,6 +237,20 @@ void SamplingReportDataView::OnSelect(int a_Index) {
   m_SamplingReport->OnSelectAddress(func.m_Address, m_TID);
 }
 
+//-----------------------------------------------------------------------------
+void SamplingReportDataView::OnTimer() {
+  // Reports are updated while sampling, see SamplingProfiler::UpdateReport.
+  if (m_SamplingProfiler == nullptr ||
+      m_SamplingProfiler->GetReportVersion() == m_ReportVersion) {
+    return;
+  }
+
+  m_ReportVersion = m_SamplingProfiler->GetReportVersion();
+  if (m_SamplingProfiler->GetSampleReport(m_TID, &m_Functions)) {
+    OnFilter(m_Filter);
+  }
+}
+
 //-----------------------------------------------------------------------------
 void SamplingReportDataView::LinkDataView(DataView* a_DataView) {
   if (a_DataView->GetType() == CALLSTACK) {
@@ -23,10 +23,12 @@ class SamplingReportDataView : public DataView {
   void OnContextMenu(const std::wstring& a_Action, int a_MenuIndex,
                      std::vector<int>& a_ItemIndices) override;
   void OnSelect(int a_Index) override;
+  void OnTimer() override;
 
   virtual void LinkDataView(DataView* a_DataView) override;
   void SetSamplingProfiler(std::shared_ptr<SamplingProfiler>& a_Profiler) {
     m_SamplingProfiler = a_Profiler;
+    m_ReportVersion = a_Profiler->GetReportVersion();
   }
   void SetSamplingReport(class SamplingReport* a_SamplingReport) {
     m_SamplingReport = a_SamplingReport;
@@ -55,6 +57,8 @@ class SamplingReportDataView : public DataView {
  protected:
   std::vector<SampledFunction> m_Functions;
   ThreadID m_TID;
+  // Version of the profiler's reports that m_Functions was copied from.
+  uint32_t m_ReportVersion = 0;
   std::wstring m_Name;
   std::shared_ptr<SamplingProfiler> m_SamplingProfiler;
   class CallStackDataView* m_CallstackDataView;
@@ -0,0 +1,34 @@
+#include "SubPixelTimerFilter.h"
+
+#include <cmath>
+
+SubPixelTimerFilter::SubPixelTimerFilter(TickType min_tick, TickType max_tick,
+                                         uint32_t num_pixels)
+    : min_tick_(min_tick),
+      pixels_per_tick_(max_tick > min_tick
+                           ? static_cast<double>(num_pixels) /
+                                 static_cast<double>(max_tick - min_tick)
+                           : 0.0) {}
+
+int64_t SubPixelTimerFilter::GetColumn(TickType tick) const {
+  // Ticks before min_tick_ give negative columns.
+  auto ticks_from_min = static_cast<int64_t>(tick - min_tick_);
+  return static_cast<int64_t>(
+      std::floor(static_cast<double>(ticks_from_min) * pixels_per_tick_));
+}
+
+bool SubPixelTimerFilter::Accept(TickType start) {
+  int64_t column = GetColumn(start);
+  if (column == last_column_) {
+    return false;
+  }
+  last_column_ = column;
+  return true;
+}
+
+bool SubPixelTimerFilter::CanSkip(const TimerBlock& block) const {
+  // All the timers of the block start and end in the column of the last line,
+  // so they are all narrower than a pixel.
+  return block.size() > 0 && GetColumn(block.GetMinStart()) == last_column_ &&
+         GetColumn(block.GetMaxEnd()) == last_column_;
+}
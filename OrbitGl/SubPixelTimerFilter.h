@@ -0,0 +1,40 @@
+#ifndef ORBIT_GL_SUB_PIXEL_TIMER_FILTER_H_
+#define ORBIT_GL_SUB_PIXEL_TIMER_FILTER_H_
+
+#include <cstdint>
+
+#include "Profiling.h"
+#include "TimerChain.h"
+
+// Level of detail of the timers narrower than a pixel, drawn as lines. When
+// zoomed out, many of them start in the same pixel column of a depth and
+// would be drawn on top of each other: only the first one is kept.
+//
+// Timers of a chain are visited in the order they were added, which is their
+// order in time within a depth. Whole blocks falling in the column of the last
+// line are skipped without visiting their timers.
+class SubPixelTimerFilter {
+ public:
+  // [min_tick, max_tick] is drawn over num_pixels pixel columns.
+  SubPixelTimerFilter(TickType min_tick, TickType max_tick,
+                      uint32_t num_pixels);
+
+  // Call before visiting the timers of each chain.
+  void StartChain() { last_column_ = NO_COLUMN; }
+
+  // Returns whether a timer narrower than a pixel, starting at start, needs
+  // to be drawn.
+  bool Accept(TickType start);
+  // Returns whether Accept would reject all the timers of block.
+  bool CanSkip(const TimerBlock& block) const;
+
+ private:
+  static constexpr int64_t NO_COLUMN = INT64_MIN;
+  int64_t GetColumn(TickType tick) const;
+
+  TickType min_tick_;
+  double pixels_per_tick_;
+  int64_t last_column_ = NO_COLUMN;
+};
+
+#endif  // ORBIT_GL_SUB_PIXEL_TIMER_FILTER_H_
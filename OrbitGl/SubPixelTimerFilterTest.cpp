@@ -0,0 +1,167 @@
+#include "SubPixelTimerFilter.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Batcher.h"
+
+namespace {
+TextBox MakeTextBox(TickType start, TickType end) {
+  Timer timer;
+  timer.m_Start = start;
+  timer.m_End = end;
+  TextBox text_box;
+  text_box.SetTimer(timer);
+  return text_box;
+}
+
+// Adds a line to batcher for each timer of chains narrower than a pixel, as
+// TimeGraph::UpdatePrimitives does, going through filter if there is one.
+void AddLines(const std::vector<std::unique_ptr<TimerChain>>& chains,
+              TickType min_tick, TickType max_tick, uint32_t num_pixels,
+              SubPixelTimerFilter* filter, Batcher* batcher) {
+  double pixels_per_tick = static_cast<double>(num_pixels) /
+                           static_cast<double>(max_tick - min_tick);
+  Color colors[2];
+  for (const auto& chain : chains) {
+    if (filter != nullptr) filter->StartChain();
+    for (TimerBlock& block : *chain) {
+      if (filter != nullptr && filter->CanSkip(block)) continue;
+      for (uint32_t i = 0; i < block.size(); ++i) {
+        const Timer& timer = block[i].GetTimer();
+        double width = (timer.m_End - timer.m_Start) * pixels_per_tick;
+        if (width > 1) continue;
+        if (filter != nullptr && !filter->Accept(timer.m_Start)) continue;
+        Line line;
+        line.m_Beg = Vec3(
+            static_cast<float>((timer.m_Start - min_tick) * pixels_per_tick),
+            0, 0);
+        line.m_End = line.m_Beg + Vec3(0, 1, 0);
+        batcher->AddLine(line, colors, PickingID::LINE, &block[i]);
+      }
+    }
+  }
+}
+
+constexpr TickType kCaptureStart = 1'000'000'000;
+constexpr TickType kCaptureDuration = 600'000'000'000;
+constexpr TickType kCaptureEnd = kCaptureStart + kCaptureDuration;
+
+// 10 minute capture with num_timers timers of 500 us over num_chains chains.
+std::vector<std::unique_ptr<TimerChain>> MakeCapture(uint32_t num_chains,
+                                                     uint32_t num_timers) {
+  constexpr TickType duration = 500'000;
+  std::vector<std::unique_ptr<TimerChain>> chains;
+  uint32_t num_timers_per_chain = num_timers / num_chains;
+  TickType period = kCaptureDuration / num_timers_per_chain;
+  for (uint32_t i = 0; i < num_chains; ++i) {
+    chains.push_back(std::make_unique<TimerChain>());
+    for (uint32_t j = 0; j < num_timers_per_chain; ++j) {
+      TickType start = kCaptureStart + j * period + i * 1000;
+      chains.back()->push_back(MakeTextBox(start, start + duration));
+    }
+  }
+  return chains;
+}
+}  // namespace
+
+TEST(SubPixelTimerFilter, Accept) {
+  // 10 ticks per pixel.
+  SubPixelTimerFilter filter(1000, 2000, 100);
+  filter.StartChain();
+  EXPECT_TRUE(filter.Accept(1000));
+  EXPECT_FALSE(filter.Accept(1005));
+  EXPECT_FALSE(filter.Accept(1009));
+  EXPECT_TRUE(filter.Accept(1010));
+  EXPECT_TRUE(filter.Accept(1500));
+  EXPECT_FALSE(filter.Accept(1500));
+
+  // Columns before the start of the view.
+  EXPECT_TRUE(filter.Accept(995));
+  EXPECT_FALSE(filter.Accept(990));
+  EXPECT_TRUE(filter.Accept(989));
+
+  filter.StartChain();
+  EXPECT_TRUE(filter.Accept(989));
+}
+
+TEST(SubPixelTimerFilter, CanSkip) {
+  SubPixelTimerFilter filter(1000, 2000, 100);
+  TimerChain chain;
+  for (uint32_t i = 0; i < TimerBlock::MAX_SIZE; ++i) {
+    chain.push_back(MakeTextBox(1020, 1025));
+  }
+  chain.push_back(MakeTextBox(1025, 1030));
+  TimerBlock& first_block = *chain.begin();
+  TimerBlock& second_block = *++chain.begin();
+
+  filter.StartChain();
+  EXPECT_FALSE(filter.CanSkip(first_block));
+  EXPECT_TRUE(filter.Accept(1020));
+  EXPECT_TRUE(filter.CanSkip(first_block));
+  // Ends in the next column.
+  EXPECT_FALSE(filter.CanSkip(second_block));
+
+  filter.StartChain();
+  EXPECT_FALSE(filter.CanSkip(first_block));
+}
+
+// Lines added to the batcher for a whole capture, with and without the filter.
+TEST(SubPixelTimerFilter, FullCaptureBatcherSize) {
+  constexpr uint32_t num_chains = 4;
+  constexpr uint32_t num_timers = 20'000;
+  constexpr uint32_t num_pixels = 100;
+  std::vector<std::unique_ptr<TimerChain>> chains =
+      MakeCapture(num_chains, num_timers);
+
+  auto batcher = std::make_unique<Batcher>();
+  AddLines(chains, kCaptureStart, kCaptureEnd, num_pixels, nullptr,
+           batcher.get());
+  EXPECT_EQ(batcher->GetLineBuffer().m_Lines.size(), num_timers);
+
+  batcher->Reset();
+  SubPixelTimerFilter filter(kCaptureStart, kCaptureEnd, num_pixels);
+  AddLines(chains, kCaptureStart, kCaptureEnd, num_pixels, &filter,
+           batcher.get());
+  size_t num_filtered_lines = batcher->GetLineBuffer().m_Lines.size();
+  EXPECT_GE(num_filtered_lines, num_chains * num_pixels);
+  EXPECT_LE(num_filtered_lines, num_chains * (num_pixels + 1));
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the line
+// vertices added for a capture with 10M timers over 16 chains, viewed on 2560
+// pixels, and the time to add them.
+TEST(SubPixelTimerFilter, DISABLED_FullCaptureBatcherSize) {
+  constexpr uint32_t num_chains = 16;
+  constexpr uint32_t num_timers = 10'000'000;
+  constexpr uint32_t num_pixels = 2560;
+  std::vector<std::unique_ptr<TimerChain>> chains =
+      MakeCapture(num_chains, num_timers);
+
+  auto batcher = std::make_unique<Batcher>();
+  auto start = std::chrono::steady_clock::now();
+  AddLines(chains, kCaptureStart, kCaptureEnd, num_pixels, nullptr,
+           batcher.get());
+  auto middle = std::chrono::steady_clock::now();
+  size_t num_vertices = 2 * batcher->GetLineBuffer().m_Lines.size();
+
+  batcher->Reset();
+  SubPixelTimerFilter filter(kCaptureStart, kCaptureEnd, num_pixels);
+  auto middle_filtered = std::chrono::steady_clock::now();
+  AddLines(chains, kCaptureStart, kCaptureEnd, num_pixels, &filter,
+           batcher.get());
+  auto end = std::chrono::steady_clock::now();
+  size_t num_filtered_vertices = 2 * batcher->GetLineBuffer().m_Lines.size();
+
+  EXPECT_LE(num_filtered_vertices, 2 * num_chains * (num_pixels + 1));
+  printf("Full capture of %u timers: %zu line vertices in %.1f ms, %zu in "
+         "%.1f ms with the filter\n",
+         num_timers, num_vertices,
+         std::chrono::duration<double, std::milli>(middle - start).count(),
+         num_filtered_vertices,
+         std::chrono::duration<double, std::milli>(end - middle_filtered)
+             .count());
+}
@@ -7,64 +7,18 @@
 #include "Capture.h"
 #include "GlCanvas.h"
 #include "OpenGl.h"
-#include "Params.h"
 #include "TextRenderer.h"
-#include "absl/strings/str_format.h"
 
 //-----------------------------------------------------------------------------
-TextBox::TextBox()
-    : m_Pos(Vec2::Zero()),
-      m_Size(Vec2(100.f, 10.f)),
-      m_MainFrameCounter(-1),
-      m_Selected(false),
-      m_TextY(FLT_MAX),
-      m_ElapsedTimeTextLength(0) {
-  Update();
-}
-
-//-----------------------------------------------------------------------------
-TextBox::TextBox(const Vec2& a_Pos, const Vec2& a_Size,
-                 const std::string& a_Text, const Color& a_Color)
-    : m_Pos(a_Pos),
-      m_Size(a_Size),
-      m_Text(a_Text),
-      m_Color(a_Color),
-      m_MainFrameCounter(-1),
-      m_Selected(false),
-      m_ElapsedTimeTextLength(0) {
-  Update();
-}
+TextBox::TextBox() : m_Pos(Vec2::Zero()), m_Size(Vec2(100.f, 10.f)) {}
 
 //-----------------------------------------------------------------------------
 TextBox::TextBox(const Vec2& a_Pos, const Vec2& a_Size, const Color& a_Color)
-    : m_Pos(a_Pos),
-      m_Size(a_Size),
-      m_Color(a_Color),
-      m_MainFrameCounter(-1),
-      m_Selected(false),
-      m_ElapsedTimeTextLength(0) {
-  Update();
-}
-
-//-----------------------------------------------------------------------------
-TextBox::TextBox(const Vec2& a_Pos, const Vec2& a_Size)
-    : m_Pos(a_Pos),
-      m_Size(a_Size),
-      m_MainFrameCounter(-1),
-      m_Selected(false),
-      m_ElapsedTimeTextLength(0) {
-  Update();
-}
+    : m_Pos(a_Pos), m_Size(a_Size), m_Color(a_Color) {}
 
 //-----------------------------------------------------------------------------
 TextBox::~TextBox() {}
 
-//-----------------------------------------------------------------------------
-void TextBox::Update() {
-  m_Min = m_Pos;
-  m_Max = m_Pos + Vec2(fabs(m_Size[0]), fabs(m_Size[1]));
-}
-
 //-----------------------------------------------------------------------------
 float TextBox::GetScreenSize(const TextRenderer& a_TextRenderer) {
   float worldWidth = a_TextRenderer.GetSceneBox().m_Size[0];
@@ -74,8 +28,7 @@ float TextBox::GetScreenSize(const TextRenderer& a_TextRenderer) {
 }
 
 //-----------------------------------------------------------------------------
-void TextBox::Draw(TextRenderer& a_TextRenderer, float a_MinX, bool a_Visible,
-                   bool a_RightJustify, bool isInactive, unsigned int a_ID,
+void TextBox::Draw(bool a_Visible, bool isInactive, unsigned int a_ID,
                    bool a_IsPicking, bool a_IsHighlighted) {
   bool isCoreActivity = m_Timer.IsType(Timer::CORE_ACTIVITY);
   bool isSameThreadIdAsSelected =
@@ -116,25 +69,6 @@ void TextBox::Draw(TextRenderer& a_TextRenderer, float a_MinX, bool a_Visible,
     glVertex3f(m_Pos[0] + m_Size[0], m_Pos[1], z);
     glEnd();
 
-    static Color s_Color(255, 255, 255, 255);
-
-    float posX = std::max(m_Pos[0], a_MinX);
-    if (a_RightJustify) {
-      posX += m_Size[0];
-    }
-
-    float maxSize = m_Pos[0] + m_Size[0] - posX;
-
-    Function* func = Capture::GSelectedFunctionsMap[m_Timer.m_FunctionAddress];
-    std::string text = absl::StrFormat(
-        "%s %s", func ? func->PrettyName().c_str() : "", m_Text.c_str());
-
-    if (!a_IsPicking && !isCoreActivity) {
-      a_TextRenderer.AddText(
-          text.c_str(), posX, m_TextY == FLT_MAX ? m_Pos[1] + 1.f : m_TextY,
-          GlCanvas::Z_VALUE_TEXT, s_Color, maxSize, a_RightJustify);
-    }
-
     glColor4ubv(&grey[0]);
   }
 
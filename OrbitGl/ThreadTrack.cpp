@@ -46,7 +46,7 @@ void ThreadTrack::OnDrag(int a_X, int a_Y) { Track::OnDrag(a_X, a_Y); }
 //-----------------------------------------------------------------------------
 void ThreadTrack::OnTimer(const Timer& a_Timer) {
   UpdateDepth(a_Timer.m_Depth + 1);
-  TextBox textBox(Vec2(0, 0), Vec2(0, 0), "", Color(255, 0, 0, 255));
+  TextBox textBox(Vec2(0, 0), Vec2(0, 0), Color(255, 0, 0, 255));
   textBox.SetTimer(a_Timer);
 
   std::shared_ptr<TimerChain> timerChain = m_Timers[a_Timer.m_Depth];
@@ -101,10 +101,15 @@ const TextBox* ThreadTrack::GetFirstAfterTime(TickType a_Tick,
   std::shared_ptr<TimerChain> textBoxes = GetTimers(a_Depth);
   if (textBoxes == nullptr) return nullptr;
 
-  // TODO: do better than linear search...
-  for (TextBox& textBox : *textBoxes) {
-    if (textBox.GetTimer().m_Start > a_Tick) {
-      return &textBox;
+  // Blocks ending before a_Tick only hold timers starting before it.
+  for (TimerBlock& block : *textBoxes) {
+    if (block.GetMaxEnd() <= a_Tick) {
+      continue;
+    }
+    for (uint32_t i = 0; i < block.size(); ++i) {
+      if (block[i].GetTimer().m_Start > a_Tick) {
+        return &block[i];
+      }
     }
   }
 
@@ -119,13 +124,20 @@ const TextBox* ThreadTrack::GetFirstBeforeTime(TickType a_Tick,
 
   TextBox* textBox = nullptr;
 
-  // TODO: do better than linear search...
-  for (TextBox& box : *textBoxes) {
-    if (box.GetTimer().m_Start > a_Tick) {
-      return textBox;
+  for (TimerBlock& block : *textBoxes) {
+    uint32_t size = block.size();
+    // All the timers of a block ending before a_Tick start before it.
+    if (size > 0 && block.GetMaxEnd() <= a_Tick) {
+      textBox = &block[size - 1];
+      continue;
     }
+    for (uint32_t i = 0; i < size; ++i) {
+      if (block[i].GetTimer().m_Start > a_Tick) {
+        return textBox;
+      }
 
-    textBox = &box;
+      textBox = &block[i];
+    }
   }
 
   return nullptr;
@@ -6,17 +6,15 @@
 #include <map>
 #include <memory>
 
-#include "BlockChain.h"
 #include "CallstackTypes.h"
 #include "TextBox.h"
 #include "Threading.h"
+#include "TimerChain.h"
 #include "Track.h"
 
 class TextRenderer;
 class EventTrack;
 
-typedef BlockChain<TextBox, 4 * 1024> TimerChain;
-
 //-----------------------------------------------------------------------------
 class ThreadTrack : public Track {
  public:
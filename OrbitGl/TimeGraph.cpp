@@ -5,6 +5,8 @@
 #include "TimeGraph.h"
 
 #include <algorithm>
+#include <cmath>
+#include <thread>
 #include <OrbitBase/Logging.h>
 
 #include "App.h"
@@ -23,6 +25,7 @@
 #include "PickingManager.h"
 #include "SamplingProfiler.h"
 #include "StringManager.h"
+#include "SubPixelTimerFilter.h"
 #include "Systrace.h"
 #include "TextBox.h"
 #include "TextRenderer.h"
@@ -57,6 +60,8 @@ void TimeGraph::SetFontSize(int a_FontSize) {
 //-----------------------------------------------------------------------------
 void TimeGraph::Clear() {
   m_Batcher.Reset();
+  m_VisibleTextBoxes.clear();
+  m_TimerLabels.clear();
   m_SessionMinCounter = 0xFFFFFFFFFFFFFFFF;
   m_SessionMaxCounter = 0;
   m_ThreadCountMap.clear();
@@ -185,7 +190,46 @@ void TimeGraph::PanTime(int a_InitialX, int a_CurrentX, int a_Width,
                       GetSessionTimeSpanUs() - m_TimeWindowUs);
   m_MaxTimeUs = m_MinTimeUs + m_TimeWindowUs;
 
-  NeedsUpdate();
+  if (CanTranslatePrimitives()) {
+    m_NeedsUpdateText = true;
+    NeedsRedraw();
+  } else {
+    NeedsUpdate();
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool TimeGraph::CanTranslatePrimitives() const {
+  double primitivesTimeWindowUs = m_PrimitivesMaxTimeUs - m_PrimitivesMinTimeUs;
+  if (primitivesTimeWindowUs <= 0 ||
+      std::abs(m_TimeWindowUs - primitivesTimeWindowUs) >
+          1e-9 * primitivesTimeWindowUs) {
+    return false;
+  }
+
+  double marginUs = PRIMITIVES_MARGIN_RATIO * primitivesTimeWindowUs;
+  return m_MinTimeUs >= m_PrimitivesMinTimeUs - marginUs &&
+         m_MaxTimeUs <= m_PrimitivesMaxTimeUs + marginUs;
+}
+
+//-----------------------------------------------------------------------------
+void TimeGraph::GetPrimitivesTransform(float* o_Scale, float* o_Offset) const {
+  if (m_PrimitivesMaxTimeUs <= m_PrimitivesMinTimeUs ||
+      m_PrimitivesWorldWidth == 0 || m_TimeWindowUs <= 0) {
+    *o_Scale = 1.f;
+    *o_Offset = 0.f;
+    return;
+  }
+
+  double worldPerUs = m_WorldWidth / m_TimeWindowUs;
+  double primitivesWorldPerUs = m_PrimitivesWorldWidth /
+                                (m_PrimitivesMaxTimeUs - m_PrimitivesMinTimeUs);
+  double scale = worldPerUs / primitivesWorldPerUs;
+  double offset = m_WorldStartX +
+                  (m_PrimitivesMinTimeUs - m_MinTimeUs) * worldPerUs -
+                  m_PrimitivesWorldStartX * scale;
+  *o_Scale = static_cast<float>(scale);
+  *o_Offset = static_cast<float>(offset);
 }
 
 //-----------------------------------------------------------------------------
@@ -230,7 +274,7 @@ void TimeGraph::ProcessTimer(const Timer& a_Timer) {
   }
 
   if (a_Timer.m_FunctionAddress > 0) {
-    Function* func = Capture::GTargetProcess->GetFunctionFromAddress(
+    Function* func = Capture::GTargetProcess->GetCachedFunctionFromAddress(
         a_Timer.m_FunctionAddress);
     if (func != nullptr) {
       ++Capture::GFunctionCountMap[a_Timer.m_FunctionAddress];
@@ -462,228 +506,354 @@ inline std::string GetExtraInfo(const Timer& a_Timer) {
   return info;
 }
 
+//-----------------------------------------------------------------------------
+// Unlike operator[], doesn't insert into a_Functions: tracks are updated in
+// parallel.
+inline Function* FindFunction(const std::map<uint64_t, Function*>& a_Functions,
+                              uint64_t a_Address) {
+  auto it = a_Functions.find(a_Address);
+  return it != a_Functions.end() ? it->second : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// Brightness of a GPU timer given the key of its stage string. The keys are
+// computed once rather than looking up the string of each timer in the
+// StringManager, which takes a lock while tracks are updated in parallel.
+// LinuxTracingHandler keys the stage strings with StringHash.
+inline float GetGpuStageColorCoeff(uint64_t a_StageKey) {
+  static const uint64_t s_SwQueueKey = StringHash("sw queue");
+  static const uint64_t s_HwQueueKey = StringHash("hw queue");
+  if (a_StageKey == s_SwQueueKey) return 0.5f;
+  if (a_StageKey == s_HwQueueKey) return 0.75f;
+  return 1.0f;
+}
+
 //-----------------------------------------------------------------------------
 void TimeGraph::UpdatePrimitives(bool a_Picking) {
   CHECK(string_manager_);
 
+  Timer timer;
+  timer.Start();
+
   m_Batcher.Reset();
   m_VisibleTextBoxes.clear();
-  m_TextRendererStatic.Clear();
   m_TextRendererStatic.Init();  // TODO: needed?
 
   UpdateMaxTimeStamp(GEventTracer.GetEventBuffer().GetMaxTime());
 
-  m_SceneBox = m_Canvas->GetSceneBox();
-  float minX = m_SceneBox.GetPosX();
+  UpdateView();
   m_NumDrawnTextBoxes = 0;
 
+  UpdateThreadIds();
+
+  // Primitives are generated with a margin on each side of the view, so that
+  // panning within it only translates them, see PanTime.
+  m_PrimitivesMinTimeUs = m_MinTimeUs;
+  m_PrimitivesMaxTimeUs = m_MaxTimeUs;
+  m_PrimitivesWorldStartX = m_WorldStartX;
+  m_PrimitivesWorldWidth = m_WorldWidth;
+  double marginUs = PRIMITIVES_MARGIN_RATIO * m_TimeWindowUs;
+  TickType rawStart = GetTickFromUs(std::max(m_MinTimeUs - marginUs, 0.0));
+  TickType rawStop = GetTickFromUs(m_MaxTimeUs + marginUs);
+
+  ThreadTrackMap threadTracks = GetThreadTracksCopy();
+  std::vector<ThreadTrack*> tracks;
+  uint64_t numTimers = 0;
+  for (auto& pair : threadTracks) {
+    if (!m_Layout.IsThreadVisible(pair.second->GetID())) continue;
+    tracks.push_back(pair.second.get());
+    numTimers += pair.second->GetNumTimers();
+  }
+
+  // Each worker updates a contiguous range of tracks, with about the same
+  // number of timers in each range. The first worker adds its primitives to
+  // m_Batcher and the others are appended in order, so that picking ids don't
+  // depend on the number of workers.
+  size_t numWorkers = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), tracks.size());
+  std::vector<size_t> rangeBegins(numWorkers + 1, tracks.size());
+  uint64_t numTimersBefore = 0;
+  for (size_t i = 0, worker = 0; i < tracks.size(); ++i) {
+    while (worker < numWorkers &&
+           numTimersBefore >= numTimers * worker / numWorkers) {
+      rangeBegins[worker++] = i;
+    }
+    numTimersBefore += tracks[i]->GetNumTimers();
+  }
+  while (m_WorkerBatchers.size() + 1 < numWorkers) {
+    m_WorkerBatchers.push_back(std::make_unique<Batcher>());
+  }
+
+  std::vector<TrackPrimitives> workerPrimitives(numWorkers);
+  ParallelFor(numWorkers, [&](size_t a_Worker) {
+    TrackPrimitives& primitives = workerPrimitives[a_Worker];
+    primitives.m_Batcher =
+        a_Worker == 0 ? &m_Batcher : m_WorkerBatchers[a_Worker - 1].get();
+    primitives.m_Batcher->Reset();
+    for (size_t i = rangeBegins[a_Worker]; i < rangeBegins[a_Worker + 1];
+         ++i) {
+      UpdateTrackPrimitives(tracks[i], rawStart, rawStop, &primitives);
+    }
+  });
+
+  for (size_t i = 0; i < numWorkers; ++i) {
+    TrackPrimitives& primitives = workerPrimitives[i];
+    if (i > 0) {
+      m_Batcher.Append(*primitives.m_Batcher);
+    }
+
+    m_VisibleTextBoxes.insert(m_VisibleTextBoxes.end(),
+                              primitives.m_TextBoxes.begin(),
+                              primitives.m_TextBoxes.end());
+
+    for (const auto& [threadId, depth] : primitives.m_ThreadDepths) {
+      UpdateThreadDepth(threadId, depth);
+    }
+  }
+
+  UpdateText();
+
+  if (!a_Picking) {
+    UpdateEvents(rawStart, rawStop);
+  }
+
+  m_NeedsUpdatePrimitives = false;
+  m_NeedsRedraw = true;
+
+  timer.Stop();
+  m_UpdatePrimitivesTimeMs = timer.ElapsedMillis();
+}
+
+//-----------------------------------------------------------------------------
+void TimeGraph::UpdateView() {
+  m_SceneBox = m_Canvas->GetSceneBox();
   m_TimeWindowUs = m_MaxTimeUs - m_MinTimeUs;
   m_WorldStartX = m_Canvas->GetWorldTopLeftX();
   m_WorldWidth = m_Canvas->GetWorldWidth();
-  double invTimeWindow = 1.0 / m_TimeWindowUs;
+}
 
-  UpdateThreadIds();
+//-----------------------------------------------------------------------------
+void TimeGraph::UpdateText() {
+  m_TextRendererStatic.Clear();
 
-  double span = m_MaxTimeUs - m_MinTimeUs;
-  TickType rawStart = GetTickFromUs(m_MinTimeUs + m_MarginRatio * span);
-  TickType rawStop = GetTickFromUs(m_MaxTimeUs);
+  float scale;
+  float offset;
+  GetPrimitivesTransform(&scale, &offset);
+  float minX = m_SceneBox.GetPosX();
+  float maxX = minX + m_SceneBox.GetSize()[0];
 
-  unsigned int TextBoxID = 0;
+  // Only keeps the labels of about the timers being drawn.
+  if (m_TimerLabels.size() > 2 * m_VisibleTextBoxes.size() + 1024) {
+    m_TimerLabels.clear();
+  }
 
-  for (auto& pair : GetThreadTracksCopy()) {
-    std::shared_ptr<ThreadTrack>& threadTrack = pair.second;
+  for (const TextBox* textBox : m_VisibleTextBoxes) {
+    static Color s_Color(255, 255, 255, 255);
 
-    if (!m_Layout.IsThreadVisible(threadTrack->GetID())) continue;
+    float boxMinX = offset + scale * textBox->GetPos()[0];
+    float boxMaxX = boxMinX + scale * textBox->GetSize()[0];
+    if (boxMaxX < minX || boxMinX > maxX) continue;
 
-    std::vector<std::shared_ptr<TimerChain>> depthChain =
-        threadTrack->GetTimers();
-    for (auto& textBoxes : depthChain) {
-      if (textBoxes == nullptr) break;
+    const TimerLabel& label = GetTimerLabel(*textBox);
+    float posX = std::max(boxMinX, minX);
+    float maxSize = boxMaxX - posX;
+    m_TextRendererStatic.AddTextTrailingCharsPrioritized(
+        label.m_Text.c_str(), posX, textBox->GetPosY() + 1.f,
+        GlCanvas::Z_VALUE_TEXT, s_Color, label.m_ElapsedTimeTextLength,
+        maxSize);
+  }
 
-      for (TextBox& textBox : *textBoxes) {
-        const Timer& timer = textBox.GetTimer();
+  m_NeedsUpdateText = false;
+}
 
-        if (!(rawStart > timer.m_End || rawStop < timer.m_Start)) {
-          double start =
-              MicroSecondsFromTicks(m_SessionMinCounter, timer.m_Start) -
-              m_MinTimeUs;
-          double end = MicroSecondsFromTicks(m_SessionMinCounter, timer.m_End) -
-                       m_MinTimeUs;
-          double elapsed = end - start;
+//-----------------------------------------------------------------------------
+void TimeGraph::UpdateTrackPrimitives(ThreadTrack* a_Track, TickType a_MinTick,
+                                      TickType a_MaxTick,
+                                      TrackPrimitives* a_Primitives) {
+  Batcher* batcher = a_Primitives->m_Batcher;
+  double invTimeWindow = 1.0 / m_TimeWindowUs;
+  SubPixelTimerFilter subPixelFilter(GetTickFromUs(m_MinTimeUs),
+                                     GetTickFromUs(m_MaxTimeUs),
+                                     m_Canvas->getWidth());
 
-          double NormalizedStart = start * invTimeWindow;
-          double NormalizedLength = elapsed * invTimeWindow;
+  std::vector<std::shared_ptr<TimerChain>> depthChain = a_Track->GetTimers();
+  for (auto& textBoxes : depthChain) {
+    if (textBoxes == nullptr) break;
 
-          bool isCore = timer.IsType(Timer::CORE_ACTIVITY);
+    subPixelFilter.StartChain();
+    for (TimerBlock& block : *textBoxes) {
+      if (!block.Intersects(a_MinTick, a_MaxTick)) continue;
+      if (subPixelFilter.CanSkip(block)) continue;
 
-          float threadOffset =
-              !isCore ? m_Layout.GetThreadOffset(timer.m_TID, timer.m_Depth)
-                      : m_Layout.GetCoreOffset(timer.m_Processor);
+      for (uint32_t k = 0; k < block.size(); ++k) {
+        TextBox& textBox = block[k];
+        const Timer& timer = textBox.GetTimer();
+        if (a_MinTick > timer.m_End || a_MaxTick < timer.m_Start) continue;
+
+        double start =
+            MicroSecondsFromTicks(m_SessionMinCounter, timer.m_Start) -
+            m_MinTimeUs;
+        double end = MicroSecondsFromTicks(m_SessionMinCounter, timer.m_End) -
+                     m_MinTimeUs;
+        double elapsed = end - start;
+
+        double NormalizedStart = start * invTimeWindow;
+        double NormalizedLength = elapsed * invTimeWindow;
+
+        // Only one of the lines starting in a pixel column is drawn.
+        bool isVisibleWidth = NormalizedLength * m_Canvas->getWidth() > 1;
+        if (!isVisibleWidth && !subPixelFilter.Accept(timer.m_Start)) {
+          continue;
+        }
 
-          float boxHeight = !isCore ? m_Layout.GetTextBoxHeight()
-                                    : m_Layout.GetTextCoresHeight();
+        bool isCore = timer.IsType(Timer::CORE_ACTIVITY);
 
-          float WorldTimerStartX =
-              float(m_WorldStartX + NormalizedStart * m_WorldWidth);
-          float WorldTimerWidth = float(NormalizedLength * m_WorldWidth);
+        float threadOffset =
+            !isCore ? m_Layout.GetThreadOffset(timer.m_TID, timer.m_Depth)
+                    : m_Layout.GetCoreOffset(timer.m_Processor);
 
-          Vec2 pos(WorldTimerStartX, threadOffset);
-          Vec2 size(WorldTimerWidth, boxHeight);
+        float boxHeight = !isCore ? m_Layout.GetTextBoxHeight()
+                                  : m_Layout.GetTextCoresHeight();
 
-          textBox.SetPos(pos);
-          textBox.SetSize(size);
+        float WorldTimerStartX =
+            float(m_WorldStartX + NormalizedStart * m_WorldWidth);
+        float WorldTimerWidth = float(NormalizedLength * m_WorldWidth);
 
-          if (!isCore) {
-            UpdateThreadDepth(timer.m_TID, timer.m_Depth + 1);
-          }
+        Vec2 pos(WorldTimerStartX, threadOffset);
+        Vec2 size(WorldTimerWidth, boxHeight);
 
-          bool isContextSwitch = timer.IsType(Timer::THREAD_ACTIVITY);
-          bool isVisibleWidth = NormalizedLength * m_Canvas->getWidth() > 1;
-          bool isSameThreadIdAsSelected =
-              isCore && (timer.m_TID == Capture::GSelectedThreadId);
-          bool isInactive =
-              (!isContextSwitch && timer.m_FunctionAddress &&
-               (Capture::GVisibleFunctionsMap.size() &&
-                Capture::GVisibleFunctionsMap[timer.m_FunctionAddress] ==
-                    nullptr)) ||
-              (Capture::GSelectedThreadId != 0 && isCore &&
-               !isSameThreadIdAsSelected);
-          bool isSelected = &textBox == Capture::GSelectedTextBox;
-
-          const unsigned char g = 100;
-          Color grey(g, g, g, 255);
-          static Color selectionColor(0, 128, 255, 255);
-          Color col = GetThreadColor(timer.m_TID);
-
-          // We disambiguate the different types of GPU activity based on the
-          // string that is displayed on their timeslice.
-          if (timer.m_Type == Timer::GPU_ACTIVITY) {
-            constexpr const char* kSwQueueString = "sw queue";
-            constexpr const char* kHwQueueString = "hw queue";
-            constexpr const char* kHwExecutionString = "hw execution";
-            float coeff = 1.0f;
-            std::string gpu_stage =
-                string_manager_->Get(timer.m_UserData[0]).value_or("");
-            if (gpu_stage == kSwQueueString) {
-              coeff = 0.5f;
-            } else if (gpu_stage == kHwQueueString) {
-              coeff = 0.75f;
-            } else if (gpu_stage == kHwExecutionString) {
-              coeff = 1.0f;
-            }
-
-            col[0] = coeff * col[0];
-            col[1] = coeff * col[1];
-            col[2] = coeff * col[2];
-          }
+        textBox.SetPos(pos);
+        textBox.SetSize(size);
 
-          col = isSelected
-                    ? selectionColor
-                    : isSameThreadIdAsSelected ? col : isInactive ? grey : col;
-          textBox.SetColor(col[0], col[1], col[2]);
-          static int oddAlpha = 210;
-          if (!(timer.m_Depth & 0x1)) {
-            col[3] = oddAlpha;
-          }
+        if (!isCore) {
+          int& depth = a_Primitives->m_ThreadDepths[timer.m_TID];
+          depth = std::max(depth, timer.m_Depth + 1);
+        }
 
-          float z = isInactive ? GlCanvas::Z_VALUE_BOX_INACTIVE
-                               : GlCanvas::Z_VALUE_BOX_ACTIVE;
-
-          if (isVisibleWidth) {
-            Box box;
-            box.m_Vertices[0] = Vec3(pos[0], pos[1], z);
-            box.m_Vertices[1] = Vec3(pos[0], pos[1] + size[1], z);
-            box.m_Vertices[2] = Vec3(pos[0] + size[0], pos[1] + size[1], z);
-            box.m_Vertices[3] = Vec3(pos[0] + size[0], pos[1], z);
-            Color colors[4];
-            Fill(colors, col);
-
-            static float coeff = 0.94f;
-            Vec3 dark = Vec3(col[0], col[1], col[2]) * coeff;
-            colors[1] = Color((unsigned char)dark[0], (unsigned char)dark[1],
-                              (unsigned char)dark[2], (unsigned char)col[3]);
-            colors[0] = colors[1];
-            m_Batcher.AddBox(box, colors, PickingID::BOX, &textBox);
-
-            if (!isContextSwitch && textBox.GetText().size() == 0) {
-              double elapsedMillis = ((double)elapsed) * 0.001;
-              std::string time = GetPrettyTime(elapsedMillis);
-              Function* func =
-                  Capture::GSelectedFunctionsMap[timer.m_FunctionAddress];
-
-              textBox.SetElapsedTimeTextLength(time.length());
-
-              const char* name = nullptr;
-              if (func) {
-                std::string extraInfo = GetExtraInfo(timer);
-                name = func->PrettyName().c_str();
-                std::string text = absl::StrFormat(
-                    "%s %s %s", name, extraInfo.c_str(), time.c_str());
-
-                textBox.SetText(text);
-              } else if (timer.m_Type == Timer::INTROSPECTION) {
-                textBox.SetText(
-                    string_manager_->Get(timer.m_UserData[0]).value_or(""));
-              } else if (timer.m_Type == Timer::GPU_ACTIVITY) {
-                textBox.SetText(
-                    string_manager_->Get(timer.m_UserData[0]).value_or(""));
-              } else if (!SystraceManager::Get().IsEmpty()) {
-                textBox.SetText(SystraceManager::Get().GetFunctionName(
-                    timer.m_FunctionAddress));
-              } else if (!Capture::IsCapturing()) {
-                // GZoneNames is populated when capturing, prevent race
-                // by accessing it only when not capturing.
-                auto it = Capture::GZoneNames.find(timer.m_FunctionAddress);
-                if (it != Capture::GZoneNames.end()) {
-                  name = it->second.c_str();
-                  std::string text =
-                      absl::StrFormat("%s %s", name, time.c_str());
-                  textBox.SetText(text);
-                }
-              }
-            }
-
-            if (!isCore) {
-              // m_VisibleTextBoxes.push_back(&textBox);
-              static Color s_Color(255, 255, 255, 255);
-
-              const Vec2& boxPos = textBox.GetPos();
-              const Vec2& boxSize = textBox.GetSize();
-              float posX = std::max(boxPos[0], minX);
-              float maxSize = boxPos[0] + boxSize[0] - posX;
-              m_TextRendererStatic.AddTextTrailingCharsPrioritized(
-                  textBox.GetText().c_str(), posX, textBox.GetPosY() + 1.f,
-                  GlCanvas::Z_VALUE_TEXT, s_Color,
-                  textBox.GetElapsedTimeTextLength(), maxSize);
-            }
-          } else {
-            Line line;
-            line.m_Beg = Vec3(pos[0], pos[1], z);
-            line.m_End = Vec3(pos[0], pos[1] + size[1], z);
-            Color colors[2];
-            Fill(colors, col);
-            m_Batcher.AddLine(line, colors, PickingID::LINE, &textBox);
-          }
+        bool isContextSwitch = timer.IsType(Timer::THREAD_ACTIVITY);
+        bool isSameThreadIdAsSelected =
+            isCore && (timer.m_TID == Capture::GSelectedThreadId);
+        bool isInactive =
+            (!isContextSwitch && timer.m_FunctionAddress &&
+             (Capture::GVisibleFunctionsMap.size() &&
+              FindFunction(Capture::GVisibleFunctionsMap,
+                           timer.m_FunctionAddress) == nullptr)) ||
+            (Capture::GSelectedThreadId != 0 && isCore &&
+             !isSameThreadIdAsSelected);
+        bool isSelected = &textBox == Capture::GSelectedTextBox;
+
+        const unsigned char g = 100;
+        Color grey(g, g, g, 255);
+        static Color selectionColor(0, 128, 255, 255);
+        Color col = GetThreadColor(timer.m_TID);
+
+        // We disambiguate the different types of GPU activity based on the
+        // string that is displayed on their timeslice.
+        if (timer.m_Type == Timer::GPU_ACTIVITY) {
+          float coeff = GetGpuStageColorCoeff(timer.m_UserData[0]);
+
+          col[0] = coeff * col[0];
+          col[1] = coeff * col[1];
+          col[2] = coeff * col[2];
+        }
+
+        col = isSelected
+                  ? selectionColor
+                  : isSameThreadIdAsSelected ? col : isInactive ? grey : col;
+        textBox.SetColor(col[0], col[1], col[2]);
+        static int oddAlpha = 210;
+        if (!(timer.m_Depth & 0x1)) {
+          col[3] = oddAlpha;
         }
 
-        ++TextBoxID;
+        float z = isInactive ? GlCanvas::Z_VALUE_BOX_INACTIVE
+                             : GlCanvas::Z_VALUE_BOX_ACTIVE;
+
+        if (isVisibleWidth) {
+          Box box;
+          box.m_Vertices[0] = Vec3(pos[0], pos[1], z);
+          box.m_Vertices[1] = Vec3(pos[0], pos[1] + size[1], z);
+          box.m_Vertices[2] = Vec3(pos[0] + size[0], pos[1] + size[1], z);
+          box.m_Vertices[3] = Vec3(pos[0] + size[0], pos[1], z);
+          Color colors[4];
+          Fill(colors, col);
+
+          static float coeff = 0.94f;
+          Vec3 dark = Vec3(col[0], col[1], col[2]) * coeff;
+          colors[1] = Color((unsigned char)dark[0], (unsigned char)dark[1],
+                            (unsigned char)dark[2], (unsigned char)col[3]);
+          colors[0] = colors[1];
+          batcher->AddBox(box, colors, PickingID::BOX, &textBox);
+
+          if (!isCore) {
+            a_Primitives->m_TextBoxes.push_back(&textBox);
+          }
+        } else {
+          Line line;
+          line.m_Beg = Vec3(pos[0], pos[1], z);
+          line.m_End = Vec3(pos[0], pos[1] + size[1], z);
+          Color colors[2];
+          Fill(colors, col);
+          batcher->AddLine(line, colors, PickingID::LINE, &textBox);
+        }
       }
     }
   }
+}
 
-  if (!a_Picking) {
-    UpdateEvents();
+//-----------------------------------------------------------------------------
+const TimeGraph::TimerLabel& TimeGraph::GetTimerLabel(
+    const TextBox& a_TextBox) {
+  static const TimerLabel s_EmptyLabel;
+  auto it = m_TimerLabels.find(&a_TextBox);
+  if (it != m_TimerLabels.end()) {
+    return it->second;
   }
 
-  m_NeedsUpdatePrimitives = false;
-  m_NeedsRedraw = true;
+  const Timer& timer = a_TextBox.GetTimer();
+  if (timer.IsType(Timer::THREAD_ACTIVITY)) {
+    return s_EmptyLabel;
+  }
+
+  double elapsedMillis =
+      MicroSecondsFromTicks(timer.m_Start, timer.m_End) * 0.001;
+  std::string time = GetPrettyTime(elapsedMillis);
+  TimerLabel label;
+  label.m_ElapsedTimeTextLength = time.length();
+
+  Function* func =
+      FindFunction(Capture::GSelectedFunctionsMap, timer.m_FunctionAddress);
+  if (func) {
+    std::string extraInfo = GetExtraInfo(timer);
+    label.m_Text = absl::StrFormat("%s %s %s", func->PrettyName().c_str(),
+                                   extraInfo.c_str(), time.c_str());
+  } else if (timer.m_Type == Timer::INTROSPECTION) {
+    label.m_Text = string_manager_->Get(timer.m_UserData[0]).value_or("");
+  } else if (timer.m_Type == Timer::GPU_ACTIVITY) {
+    label.m_Text = string_manager_->Get(timer.m_UserData[0]).value_or("");
+  } else if (!SystraceManager::Get().IsEmpty()) {
+    label.m_Text =
+        SystraceManager::Get().GetFunctionName(timer.m_FunctionAddress);
+  } else if (!Capture::IsCapturing()) {
+    // GZoneNames is populated when capturing, prevent race
+    // by accessing it only when not capturing.
+    auto zoneIt = Capture::GZoneNames.find(timer.m_FunctionAddress);
+    if (zoneIt != Capture::GZoneNames.end()) {
+      label.m_Text =
+          absl::StrFormat("%s %s", zoneIt->second.c_str(), time.c_str());
+    }
+  }
+
+  // Empty labels aren't cached: names may only be known later, for example
+  // once the function is selected.
+  if (label.m_Text.empty()) {
+    return s_EmptyLabel;
+  }
+  return m_TimerLabels[&a_TextBox] = std::move(label);
 }
 
 //-----------------------------------------------------------------------------
-void TimeGraph::UpdateEvents() {
-  TickType rawMin = GetTickFromUs(m_MinTimeUs);
-  TickType rawMax = GetTickFromUs(m_MaxTimeUs);
-
+void TimeGraph::UpdateEvents(TickType a_MinTick, TickType a_MaxTick) {
   ScopeLock lock(GEventTracer.GetEventBuffer().GetMutex());
 
   Color lineColor[2];
@@ -700,7 +870,7 @@ void TimeGraph::UpdateEvents() {
       for (auto& callstackPair : callstacks) {
         unsigned long long time = callstackPair.first;
 
-        if (time > rawMin && time < rawMax) {
+        if (time > a_MinTick && time < a_MaxTick) {
           float x = GetWorldFromTick(time);
           Line line;
           line.m_Beg = Vec3(x, ThreadOffset, GlCanvas::Z_VALUE_EVENT);
@@ -752,11 +922,10 @@ void TimeGraph::SelectEvents(float a_WorldStart, float a_WorldEnd,
   samplingProfiler->SetGenerateSummary(a_TID == 0);
 
   for (CallstackEvent& event : m_SelectedCallstackEvents) {
-    const std::shared_ptr<CallStack> callstack =
+    CallstackView callstack =
         Capture::GSamplingProfiler->GetCallStack(event.m_Id);
     if (callstack) {
-      callstack->m_ThreadId = event.m_TID;
-      samplingProfiler->AddCallStack(*callstack);
+      samplingProfiler->AddCallStack(callstack, event.m_TID, event.m_Time);
     }
   }
   samplingProfiler->ProcessSamples();
@@ -778,6 +947,9 @@ void TimeGraph::Draw(bool a_Picking) {
           !a_Picking && m_NeedsUpdatePrimitives) ||
       a_Picking) {
     UpdatePrimitives(a_Picking);
+  } else if (m_NeedsUpdateText) {
+    UpdateView();
+    UpdateText();
   }
 
   DrawThreadTracks(a_Picking);
@@ -952,6 +1124,12 @@ void TimeGraph::DrawText() {
   }
 }
 
+//----------------------------------------------------------------------------
+void TimeGraph::ReleaseVertexBufferObjects() {
+  // Worker batchers are only appended to m_Batcher, never drawn.
+  m_Batcher.ReleaseVertexBufferObjects();
+}
+
 //----------------------------------------------------------------------------
 void TimeGraph::DrawBuffered(bool a_Picking) {
   glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
@@ -961,58 +1139,21 @@ void TimeGraph::DrawBuffered(bool a_Picking) {
   glEnableClientState(GL_COLOR_ARRAY);
   glEnable(GL_TEXTURE_2D);
 
-  DrawBoxBuffer(a_Picking);
-  DrawLineBuffer(a_Picking);
+  // Primitives may have been generated for another view, see PanTime.
+  float scale;
+  float offset;
+  GetPrimitivesTransform(&scale, &offset);
+  glPushMatrix();
+  glTranslatef(offset, 0, 0);
+  glScalef(scale, 1, 1);
+  m_Batcher.Draw(a_Picking);
+  glPopMatrix();
 
   glDisableClientState(GL_COLOR_ARRAY);
   glDisableClientState(GL_VERTEX_ARRAY);
   glPopAttrib();
 }
 
-//----------------------------------------------------------------------------
-void TimeGraph::DrawBoxBuffer(bool a_Picking) {
-  Block<Box, BoxBuffer::NUM_BOXES_PER_BLOCK>* boxBlock =
-      m_Batcher.GetBoxBuffer().m_Boxes.m_Root;
-  Block<Color, BoxBuffer::NUM_BOXES_PER_BLOCK * 4>* colorBlock;
-
-  colorBlock = !a_Picking ? m_Batcher.GetBoxBuffer().m_Colors.m_Root
-                          : m_Batcher.GetBoxBuffer().m_PickingColors.m_Root;
-
-  while (boxBlock) {
-    if (int numElems = boxBlock->m_Size) {
-      glVertexPointer(3, GL_FLOAT, sizeof(Vec3), boxBlock->m_Data);
-      glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color),
-                     (void*)(colorBlock->m_Data));
-      glDrawArrays(GL_QUADS, 0, numElems * 4);
-    }
-
-    boxBlock = boxBlock->m_Next;
-    colorBlock = colorBlock->m_Next;
-  }
-}
-
-//----------------------------------------------------------------------------
-void TimeGraph::DrawLineBuffer(bool a_Picking) {
-  Block<Line, LineBuffer::NUM_LINES_PER_BLOCK>* lineBlock =
-      m_Batcher.GetLineBuffer().m_Lines.m_Root;
-  Block<Color, LineBuffer::NUM_LINES_PER_BLOCK * 2>* colorBlock;
-
-  colorBlock = !a_Picking ? m_Batcher.GetLineBuffer().m_Colors.m_Root
-                          : m_Batcher.GetLineBuffer().m_PickingColors.m_Root;
-
-  while (lineBlock) {
-    if (int numElems = lineBlock->m_Size) {
-      glVertexPointer(3, GL_FLOAT, sizeof(Vec3), lineBlock->m_Data);
-      glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Color),
-                     (void*)(colorBlock->m_Data));
-      glDrawArrays(GL_LINES, 0, numElems * 2);
-    }
-
-    lineBlock = lineBlock->m_Next;
-    colorBlock = colorBlock->m_Next;
-  }
-}
-
 //-----------------------------------------------------------------------------
 void TimeGraph::DrawEvents(bool a_Picking) {
   // Draw track background
@@ -1036,28 +1177,6 @@ void TimeGraph::DrawEvents(bool a_Picking) {
   }
 }
 
-//-----------------------------------------------------------------------------
-void TimeGraph::DrawMainFrame(TextBox& a_Box) {
-  if (a_Box.GetMainFrameCounter() == -1) {
-    a_Box.SetMainFrameCounter(++m_MainFrameCounter);
-  }
-
-  static unsigned char grey = 180;
-  static Color frameColor(grey, grey, grey, 10);
-
-  if (a_Box.GetMainFrameCounter() % 2 == 0) {
-    float minX = m_SceneBox.GetPosX();
-    TextBox frameBox;
-
-    frameBox.SetPosX(a_Box.GetPosX());
-    frameBox.SetPosY(m_SceneBox.GetPosY());
-    frameBox.SetSizeX(a_Box.GetSize()[0]);
-    frameBox.SetSizeY(m_SceneBox.GetSize()[0]);
-    frameBox.SetColor(frameColor);
-    frameBox.Draw(*m_TextRenderer, minX, true, false, false);
-  }
-}
-
 //-----------------------------------------------------------------------------
 bool TimeGraph::IsVisible(const Timer& a_Timer) {
   double start = MicroSecondsFromTicks(m_SessionMinCounter, a_Timer.m_Start);
@@ -3,7 +3,9 @@
 //-----------------------------------
 #pragma once
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "Batcher.h"
 #include "BlockChain.h"
@@ -27,19 +29,20 @@ class TimeGraph {
 
   void Draw(bool a_Picking = false);
   void DrawThreadTracks(bool a_Picking = false);
-  void DrawMainFrame(TextBox& a_Box);
   void DrawEvents(bool a_Picking = false);
   void DrawTime();
-  void DrawLineBuffer(bool a_Picking);
-  void DrawBoxBuffer(bool a_Picking);
   void DrawBuffered(bool a_Picking);
   void DrawText();
+  // Deletes the GL buffers of the primitives. Requires the GL context they
+  // were drawn with to be current.
+  void ReleaseVertexBufferObjects();
 
   void NeedsUpdate();
   void UpdatePrimitives(bool a_Picking);
+  double GetUpdatePrimitivesTimeMs() const { return m_UpdatePrimitivesTimeMs; }
 
   void UpdateThreadIds();
-  void UpdateEvents();
+  void UpdateEvents(TickType a_MinTick, TickType a_MaxTick);
   void SelectEvents(float a_WorldStart, float a_WorldEnd, ThreadID a_TID);
 
   void ProcessTimer(const Timer& a_Timer);
@@ -107,6 +110,14 @@ class TimeGraph {
   TimeGraphLayout& GetLayout() { return m_Layout; }
   Color GetThreadColor(ThreadID a_TID) const;
 
+  // Label of a timer, built when it is first drawn wide enough to show text.
+  // Only the labels of about the timers being drawn are kept.
+  struct TimerLabel {
+    std::string m_Text;
+    size_t m_ElapsedTimeTextLength = 0;
+  };
+  const TimerLabel& GetTimerLabel(const TextBox& a_TextBox);
+
   void OnLeft();
   void OnRight();
   void OnUp();
@@ -116,6 +127,22 @@ class TimeGraph {
   std::shared_ptr<ThreadTrack> GetThreadTrack(ThreadID a_TID);
   ThreadTrackMap GetThreadTracksCopy() const;
 
+  // Output of the tracks updated by one worker of UpdatePrimitives, merged
+  // on the calling thread once all workers are done.
+  struct TrackPrimitives {
+    Batcher* m_Batcher = nullptr;
+    std::vector<TextBox*> m_TextBoxes;
+    std::map<ThreadID, int> m_ThreadDepths;
+  };
+  void UpdateTrackPrimitives(ThreadTrack* a_Track, TickType a_MinTick,
+                             TickType a_MaxTick, TrackPrimitives* a_Primitives);
+  void UpdateView();
+  void UpdateText();
+  bool CanTranslatePrimitives() const;
+  // World x of the current view is o_Scale * x + o_Offset for a primitive of
+  // m_Batcher at x.
+  void GetPrimitivesTransform(float* o_Scale, float* o_Offset) const;
+
  private:
   TextRenderer m_TextRendererStatic;
   TextRenderer* m_TextRenderer = nullptr;
@@ -137,7 +164,6 @@ class TimeGraph {
 
   double m_ZoomValue = 0;
   double m_MouseRatio = 0;
-  unsigned int m_MainFrameCounter = 0;
   unsigned char m_TrackAlpha = 255;
 
   TimeGraphLayout m_Layout;
@@ -155,8 +181,21 @@ class TimeGraph {
   bool m_NeedsUpdatePrimitives = false;
   bool m_DrawText = true;
   bool m_NeedsRedraw = false;
+  bool m_NeedsUpdateText = false;
   std::vector<TextBox*> m_VisibleTextBoxes;
+  std::unordered_map<const TextBox*, TimerLabel> m_TimerLabels;
+  // View for which the primitives of m_Batcher were generated. They cover
+  // PRIMITIVES_MARGIN_RATIO of its time window on each side.
+  static constexpr double PRIMITIVES_MARGIN_RATIO = 0.5;
+  double m_PrimitivesMinTimeUs = 0;
+  double m_PrimitivesMaxTimeUs = 0;
+  float m_PrimitivesWorldStartX = 0;
+  float m_PrimitivesWorldWidth = 0;
+  double m_UpdatePrimitivesTimeMs = 0;
   Batcher m_Batcher;
+  // Batchers of the workers of UpdatePrimitives but the first one, which uses
+  // m_Batcher.
+  std::vector<std::unique_ptr<Batcher>> m_WorkerBatchers;
   PickingManager* m_PickingManager = nullptr;
   Timer m_LastThreadReorder;
   MemoryTracker m_MemTracker;
@@ -114,8 +114,11 @@ float TimeGraphLayout::GetCoreOffset(int a_CoreId) {
 
 //-----------------------------------------------------------------------------
 float TimeGraphLayout::GetThreadOffset(ThreadID a_TID, int a_Depth) {
-  return m_ThreadBlockOffsets[a_TID] - GetTracksHeight() -
-         (a_Depth + 1) * m_TextBoxHeight;
+  // Doesn't insert into m_ThreadBlockOffsets, as tracks are updated in
+  // parallel. Threads without a block are drawn from 0, as before.
+  auto iter = m_ThreadBlockOffsets.find(a_TID);
+  float blockOffset = iter != m_ThreadBlockOffsets.end() ? iter->second : 0.f;
+  return blockOffset - GetTracksHeight() - (a_Depth + 1) * m_TextBoxHeight;
 }
 
 //-----------------------------------------------------------------------------
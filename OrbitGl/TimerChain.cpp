@@ -0,0 +1,71 @@
+#include "TimerChain.h"
+
+#include <algorithm>
+
+void TimerBlock::Add(const TextBox& text_box) {
+  const Timer& timer = text_box.GetTimer();
+  data_[size_] = text_box;
+  min_start_.store(std::min(GetMinStart(), timer.m_Start),
+                   std::memory_order_relaxed);
+  max_end_.store(std::max(GetMaxEnd(), timer.m_End), std::memory_order_relaxed);
+  ++size_;
+}
+
+TimerChain::~TimerChain() {
+  TimerBlock* block = root_;
+  while (block != nullptr) {
+    TimerBlock* next = block->next_;
+    delete block;
+    block = next;
+  }
+}
+
+void TimerChain::push_back(const TextBox& text_box) {
+  if (current_->size_ == TimerBlock::MAX_SIZE) {
+    current_->next_ = new TimerBlock(current_);
+    current_ = current_->next_;
+    ++num_blocks_;
+  }
+  current_->Add(text_box);
+  ++num_items_;
+}
+
+TimerBlock* TimerChain::GetBlockContaining(const TextBox* text_box) const {
+  for (TimerBlock* block = root_; block != nullptr; block = block->next_) {
+    const TextBox* begin = &block->data_[0];
+    if (text_box >= begin && text_box < begin + block->size_) {
+      return block;
+    }
+  }
+  return nullptr;
+}
+
+TextBox* TimerChain::GetElementAfter(const TextBox* text_box) const {
+  TimerBlock* block = GetBlockContaining(text_box);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  uint32_t index = text_box - &block->data_[0];
+  if (index + 1 < block->size_) {
+    return &block->data_[index + 1];
+  }
+  if (block->next_ != nullptr && block->next_->size_ > 0) {
+    return &block->next_->data_[0];
+  }
+  return nullptr;
+}
+
+TextBox* TimerChain::GetElementBefore(const TextBox* text_box) const {
+  TimerBlock* block = GetBlockContaining(text_box);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  uint32_t index = text_box - &block->data_[0];
+  if (index > 0) {
+    return &block->data_[index - 1];
+  }
+  if (block->prev_ != nullptr) {
+    return &block->prev_->data_[block->prev_->size_ - 1];
+  }
+  return nullptr;
+}
@@ -0,0 +1,105 @@
+#ifndef ORBIT_GL_TIMER_CHAIN_H_
+#define ORBIT_GL_TIMER_CHAIN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "Profiling.h"
+#include "TextBox.h"
+
+class TimerChain;
+
+// Fixed-size block of the timers of a TimerChain. The block keeps the smallest
+// start and the largest end of its timers, so that a time range can skip the
+// whole block without looking at its timers.
+class TimerBlock {
+ public:
+  static constexpr uint32_t MAX_SIZE = 1024;
+
+  uint32_t size() const { return size_; }
+  TextBox& operator[](uint32_t index) { return data_[index]; }
+  const TextBox& operator[](uint32_t index) const { return data_[index]; }
+
+  TickType GetMinStart() const {
+    return min_start_.load(std::memory_order_relaxed);
+  }
+  TickType GetMaxEnd() const {
+    return max_end_.load(std::memory_order_relaxed);
+  }
+  // Returns whether any timer of the block overlaps [min_tick, max_tick].
+  bool Intersects(TickType min_tick, TickType max_tick) const {
+    return size_ > 0 && min_tick <= GetMaxEnd() && max_tick >= GetMinStart();
+  }
+
+ private:
+  friend class TimerChain;
+  friend class TimerChainIterator;
+
+  explicit TimerBlock(TimerBlock* prev) : prev_(prev) {}
+  void Add(const TextBox& text_box);
+
+  TimerBlock* prev_;
+  TimerBlock* next_ = nullptr;
+  // Only written by the thread adding timers, atomic as the UI thread reads
+  // them at the same time. A reader may see a range wider than the timers it
+  // sees, which only costs visiting the block.
+  std::atomic<TickType> min_start_ = std::numeric_limits<TickType>::max();
+  std::atomic<TickType> max_end_ = std::numeric_limits<TickType>::min();
+  // Written after the timer and the time range, as timers are added while
+  // others read them.
+  std::atomic<uint32_t> size_ = 0;
+  TextBox data_[MAX_SIZE];
+};
+
+// Iterates over the blocks of a TimerChain.
+class TimerChainIterator {
+ public:
+  explicit TimerChainIterator(TimerBlock* block) : block_(block) {}
+
+  TimerBlock& operator*() const { return *block_; }
+  bool operator!=(const TimerChainIterator& other) const {
+    return block_ != other.block_;
+  }
+  TimerChainIterator& operator++() {
+    block_ = block_->next_;
+    return *this;
+  }
+
+ private:
+  TimerBlock* block_;
+};
+
+// Timers of one depth of a thread, in the order they were added. Timers are
+// appended by the capture thread while the UI thread reads them, so blocks are
+// never moved or freed before the chain is destroyed.
+//
+// Iterating over a chain visits its blocks: callers drawing a time range skip
+// the blocks that don't intersect it.
+class TimerChain {
+ public:
+  TimerChain() : root_(new TimerBlock(nullptr)), current_(root_) {}
+  ~TimerChain();
+  TimerChain(const TimerChain&) = delete;
+  TimerChain& operator=(const TimerChain&) = delete;
+
+  void push_back(const TextBox& text_box);
+  uint32_t size() const { return num_items_; }
+  uint32_t GetNumBlocks() const { return num_blocks_; }
+
+  TextBox* GetElementAfter(const TextBox* text_box) const;
+  TextBox* GetElementBefore(const TextBox* text_box) const;
+
+  TimerChainIterator begin() const { return TimerChainIterator(root_); }
+  TimerChainIterator end() const { return TimerChainIterator(nullptr); }
+
+ private:
+  TimerBlock* GetBlockContaining(const TextBox* text_box) const;
+
+  TimerBlock* root_;
+  TimerBlock* current_;
+  std::atomic<uint32_t> num_blocks_ = 1;
+  std::atomic<uint32_t> num_items_ = 0;
+};
+
+#endif  // ORBIT_GL_TIMER_CHAIN_H_
@@ -0,0 +1,182 @@
+#include "TimerChain.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace {
+TextBox MakeTextBox(TickType start, TickType end) {
+  Timer timer;
+  timer.m_Start = start;
+  timer.m_End = end;
+  TextBox text_box;
+  text_box.SetTimer(timer);
+  return text_box;
+}
+
+// Number of timers of chain overlapping [min_tick, max_tick], visiting every
+// timer as TimeGraph::UpdatePrimitives did.
+size_t CountVisibleTimersInAllBlocks(const TimerChain& chain, TickType min_tick,
+                                     TickType max_tick) {
+  size_t count = 0;
+  for (const TimerBlock& block : chain) {
+    for (uint32_t i = 0; i < block.size(); ++i) {
+      const Timer& timer = block[i].GetTimer();
+      count += !(min_tick > timer.m_End || max_tick < timer.m_Start);
+    }
+  }
+  return count;
+}
+
+// Same as above, skipping the blocks which don't intersect the range.
+size_t CountVisibleTimers(const TimerChain& chain, TickType min_tick,
+                          TickType max_tick) {
+  size_t count = 0;
+  for (const TimerBlock& block : chain) {
+    if (!block.Intersects(min_tick, max_tick)) continue;
+    for (uint32_t i = 0; i < block.size(); ++i) {
+      const Timer& timer = block[i].GetTimer();
+      count += !(min_tick > timer.m_End || max_tick < timer.m_Start);
+    }
+  }
+  return count;
+}
+
+// Spreads num_timers over 4 chains, as for 4 depths of a thread. Timers don't
+// overlap within a chain. Returns the end of the last timer.
+TickType MakeChains(uint32_t num_timers,
+                    std::vector<std::unique_ptr<TimerChain>>* chains) {
+  constexpr uint32_t num_depths = 4;
+  uint32_t num_timers_per_depth = num_timers / num_depths;
+  for (uint32_t depth = 0; depth < num_depths; ++depth) {
+    uint32_t duration = 100 << depth;
+    chains->push_back(std::make_unique<TimerChain>());
+    for (uint32_t i = 0; i < num_timers_per_depth; ++i) {
+      TickType start = TickType{duration} * i;
+      chains->back()->push_back(MakeTextBox(start, start + duration - 1));
+    }
+  }
+  return TickType{100} * num_timers_per_depth;
+}
+}  // namespace
+
+TEST(TimerChain, PushBack) {
+  TimerChain chain;
+  EXPECT_EQ(chain.size(), 0);
+  EXPECT_EQ(chain.GetNumBlocks(), 1);
+  EXPECT_FALSE((*chain.begin()).Intersects(0, UINT64_MAX));
+
+  constexpr uint32_t num_timers = 2 * TimerBlock::MAX_SIZE + 10;
+  for (uint32_t i = 0; i < num_timers; ++i) {
+    chain.push_back(MakeTextBox(10 * i, 10 * i + 5));
+  }
+  EXPECT_EQ(chain.size(), num_timers);
+  EXPECT_EQ(chain.GetNumBlocks(), 3);
+
+  uint32_t index = 0;
+  for (const TimerBlock& block : chain) {
+    EXPECT_EQ(block.GetMinStart(), 10 * index);
+    for (uint32_t i = 0; i < block.size(); ++i) {
+      EXPECT_EQ(block[i].GetTimer().m_Start, 10 * index);
+      ++index;
+    }
+    EXPECT_EQ(block.GetMaxEnd(), 10 * (index - 1) + 5);
+  }
+  EXPECT_EQ(index, num_timers);
+
+  const TimerBlock& first_block = *chain.begin();
+  EXPECT_TRUE(first_block.Intersects(0, 0));
+  EXPECT_TRUE(first_block.Intersects(10 * TimerBlock::MAX_SIZE - 5,
+                                     10 * TimerBlock::MAX_SIZE));
+  EXPECT_FALSE(first_block.Intersects(10 * TimerBlock::MAX_SIZE - 4,
+                                      10 * TimerBlock::MAX_SIZE));
+}
+
+TEST(TimerChain, GetElementAfterAndBefore) {
+  TimerChain chain;
+  constexpr uint32_t num_timers = TimerBlock::MAX_SIZE + 1;
+  for (uint32_t i = 0; i < num_timers; ++i) {
+    chain.push_back(MakeTextBox(i, i));
+  }
+
+  TimerBlock& first_block = *chain.begin();
+  TimerBlock& last_block = *++chain.begin();
+  TextBox* first = &first_block[0];
+  TextBox* last_of_first_block = &first_block[TimerBlock::MAX_SIZE - 1];
+  TextBox* last = &last_block[0];
+
+  EXPECT_EQ(chain.GetElementBefore(first), nullptr);
+  EXPECT_EQ(chain.GetElementAfter(first), &first_block[1]);
+  EXPECT_EQ(chain.GetElementAfter(last_of_first_block), last);
+  EXPECT_EQ(chain.GetElementBefore(last), last_of_first_block);
+  EXPECT_EQ(chain.GetElementAfter(last), nullptr);
+
+  TextBox other;
+  EXPECT_EQ(chain.GetElementAfter(&other), nullptr);
+  EXPECT_EQ(chain.GetElementBefore(&other), nullptr);
+}
+
+// Memory used by a timer stored in a TimerChain, not counting its label which
+// is only built while the timer is drawn.
+TEST(TimerChain, BytesPerTimer) {
+  static_assert(sizeof(TextBox) <= 80);
+  EXPECT_LE(sizeof(TimerBlock), (sizeof(TextBox) + 1) * TimerBlock::MAX_SIZE);
+}
+
+TEST(TimerChain, VisibleTimers) {
+  std::vector<std::unique_ptr<TimerChain>> chains;
+  const TickType capture_end = MakeChains(20'000, &chains);
+  EXPECT_GT(chains[0]->GetNumBlocks(), 1);
+
+  for (TickType window : {capture_end, capture_end / 10, capture_end / 1000}) {
+    TickType min_tick = capture_end / 2 - window / 2;
+    TickType max_tick = min_tick + window;
+    size_t expected_count = 0;
+    size_t count = 0;
+    for (const auto& chain : chains) {
+      expected_count +=
+          CountVisibleTimersInAllBlocks(*chain, min_tick, max_tick);
+      count += CountVisibleTimers(*chain, min_tick, max_tick);
+    }
+    EXPECT_GT(count, 0);
+    EXPECT_EQ(count, expected_count);
+  }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests. Prints the time to find
+// the timers visible at several zoom levels when visiting every timer or
+// skipping the blocks outside of the view.
+TEST(TimerChain, DISABLED_VisibleTimersThroughput) {
+  for (uint32_t num_timers : {1'000'000, 10'000'000}) {
+    std::vector<std::unique_ptr<TimerChain>> chains;
+    const TickType capture_end = MakeChains(num_timers, &chains);
+
+    for (TickType window : {capture_end, capture_end / 10, capture_end / 1000,
+                            capture_end / 100'000}) {
+      TickType min_tick = capture_end / 2 - window / 2;
+      TickType max_tick = min_tick + window;
+
+      auto start = std::chrono::steady_clock::now();
+      size_t expected_count = 0;
+      for (const auto& chain : chains) {
+        expected_count +=
+            CountVisibleTimersInAllBlocks(*chain, min_tick, max_tick);
+      }
+      auto middle = std::chrono::steady_clock::now();
+      size_t count = 0;
+      for (const auto& chain : chains) {
+        count += CountVisibleTimers(*chain, min_tick, max_tick);
+      }
+      auto end = std::chrono::steady_clock::now();
+
+      EXPECT_EQ(count, expected_count);
+      printf("%u timers, %zu visible: %.3f ms visiting all timers, %.3f ms "
+             "skipping blocks\n",
+             num_timers, count,
+             std::chrono::duration<double, std::milli>(middle - start).count(),
+             std::chrono::duration<double, std::milli>(end - middle).count());
+    }
+  }
+}
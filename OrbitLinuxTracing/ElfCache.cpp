@@ -0,0 +1,113 @@
+#include "ElfCache.h"
+
+#include <sys/mman.h>
+
+#include <tuple>
+
+#include "absl/container/flat_hash_set.h"
+
+namespace LinuxTracing {
+
+namespace {
+using MappingKey =
+    std::tuple<uint64_t, uint64_t, uint64_t, uint64_t, std::string>;
+
+MappingKey GetMappingKey(const unwindstack::MapInfo& map_info) {
+  return MappingKey{map_info.start, map_info.end, map_info.offset,
+                    map_info.flags, map_info.name};
+}
+
+bool IsExecutableFileMapping(const unwindstack::MapInfo& map_info) {
+  return (map_info.flags & PROT_EXEC) != 0 && !map_info.name.empty() &&
+         map_info.name[0] != '[';
+}
+}  // namespace
+
+void ElfCache::UpdateMaps(unwindstack::Maps* old_maps,
+                          unwindstack::Maps* new_maps) {
+  absl::flat_hash_map<MappingKey, unwindstack::MapInfo*> old_mappings;
+  for (const std::unique_ptr<unwindstack::MapInfo>& map_info : *old_maps) {
+    if (map_info->elf != nullptr) {
+      old_mappings.emplace(GetMappingKey(*map_info), map_info.get());
+    }
+  }
+
+  // Reuse the Elf objects of the mappings that did not change.
+  absl::flat_hash_set<unwindstack::MapInfo*> reused_mappings;
+  std::vector<unwindstack::MapInfo*> changed_mappings;
+  for (const std::unique_ptr<unwindstack::MapInfo>& map_info : *new_maps) {
+    if ((map_info->flags & PROT_EXEC) == 0) {
+      continue;
+    }
+    auto old_mapping_it = old_mappings.find(GetMappingKey(*map_info));
+    if (old_mapping_it != old_mappings.end()) {
+      CopyElf(GetCachedElf(*old_mapping_it->second), map_info.get());
+      reused_mappings.insert(old_mapping_it->second);
+      ++hit_count_;
+    } else {
+      changed_mappings.push_back(map_info.get());
+    }
+  }
+
+  // Remember the Elf objects of the mappings that went away or changed. Only
+  // these need to be added, as the others have moved to the new maps.
+  for (const auto& [mapping_key, old_mapping] : old_mappings) {
+    if (reused_mappings.contains(old_mapping) ||
+        !IsExecutableFileMapping(*old_mapping) || !old_mapping->elf->valid()) {
+      continue;
+    }
+    CachedElf cached_elf = GetCachedElf(*old_mapping);
+    cached_elf.build_id = GetBuildId(old_mapping);
+    if (cached_elf.build_id.empty()) {
+      continue;
+    }
+    std::pair<std::string, uint64_t> file_mapping{old_mapping->name,
+                                                  old_mapping->offset};
+    if (elfs_by_file_mapping_.size() >= MAX_CACHED_FILE_MAPPINGS &&
+        !elfs_by_file_mapping_.contains(file_mapping)) {
+      elfs_by_file_mapping_.clear();
+    }
+    elfs_by_file_mapping_.insert_or_assign(std::move(file_mapping),
+                                           std::move(cached_elf));
+  }
+
+  for (unwindstack::MapInfo* changed_mapping : changed_mappings) {
+    if (IsExecutableFileMapping(*changed_mapping)) {
+      auto cached_elf_it = elfs_by_file_mapping_.find(
+          std::make_pair(changed_mapping->name, changed_mapping->offset));
+      // The file could have been replaced, e.g., by a new build of the library.
+      if (cached_elf_it != elfs_by_file_mapping_.end() &&
+          cached_elf_it->second.build_id == GetBuildId(changed_mapping)) {
+        CopyElf(cached_elf_it->second, changed_mapping);
+        ++hit_count_;
+        continue;
+      }
+    }
+    ++miss_count_;
+  }
+}
+
+void ElfCache::CopyElf(const CachedElf& cached_elf,
+                       unwindstack::MapInfo* map_info) {
+  map_info->elf = cached_elf.elf;
+  map_info->elf_offset = cached_elf.elf_offset;
+  map_info->elf_start_offset = cached_elf.elf_start_offset;
+}
+
+ElfCache::CachedElf ElfCache::GetCachedElf(
+    const unwindstack::MapInfo& map_info) {
+  return CachedElf{"", map_info.elf, map_info.elf_offset,
+                   map_info.elf_start_offset};
+}
+
+std::string ElfCache::GetBuildId(unwindstack::MapInfo* map_info) {
+  std::string build_id = map_info->GetBuildID();
+  if (build_id.empty() && map_info->offset != 0 &&
+      map_info->prev_map != nullptr &&
+      map_info->prev_map->name == map_info->name) {
+    build_id = map_info->prev_map->GetBuildID();
+  }
+  return build_id;
+}
+
+}  // namespace LinuxTracing
@@ -0,0 +1,64 @@
+#ifndef ORBIT_LINUX_TRACING_ELF_CACHE_H_
+#define ORBIT_LINUX_TRACING_ELF_CACHE_H_
+
+#include <unwindstack/Unwinder.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace LinuxTracing {
+
+// libunwindstack creates the unwindstack::Elf of a mapping, which reads and
+// parses the ELF file and its unwinding information, the first time a frame
+// falls into the mapping, and stores it in the unwindstack::MapInfo. As every
+// change of the memory maps of the target causes the maps to be parsed again
+// into new MapInfos, ElfCache transfers the Elf objects already created from
+// the previous maps to the new ones, so that they are not created again:
+// - from identical mappings (same address range, offset, flags and file), i.e.,
+//   from all mappings that did not change;
+// - for executable file mappings that did change (e.g., a library that was
+//   unloaded and loaded again at another address), from the latest previous
+//   mapping of the same file at the same offset, if the build id of the file
+//   didn't change in the meantime.
+class ElfCache {
+ public:
+  void UpdateMaps(unwindstack::Maps* old_maps, unwindstack::Maps* new_maps);
+
+  // Executable mappings that received an existing Elf object.
+  uint64_t GetHitCount() const { return hit_count_; }
+  // Executable mappings whose Elf object will need to be created.
+  uint64_t GetMissCount() const { return miss_count_; }
+
+ private:
+  // The cache is cleared when it would grow past this many file mappings, so
+  // that a target that keeps mapping new files can't grow it without bounds.
+  static constexpr size_t MAX_CACHED_FILE_MAPPINGS = 1024;
+
+  struct CachedElf {
+    std::string build_id;
+    std::shared_ptr<unwindstack::Elf> elf;
+    uint64_t elf_offset;
+    uint64_t elf_start_offset;
+  };
+
+  static void CopyElf(const CachedElf& cached_elf,
+                      unwindstack::MapInfo* map_info);
+  static CachedElf GetCachedElf(const unwindstack::MapInfo& map_info);
+  // The build id of the file a mapping belongs to. For a mapping that doesn't
+  // start with the ELF header, e.g., the executable segment of a library, this
+  // is read from the previous mapping of the same file.
+  static std::string GetBuildId(unwindstack::MapInfo* map_info);
+
+  // Keyed by file name and offset of the mapping in the file.
+  absl::flat_hash_map<std::pair<std::string, uint64_t>, CachedElf>
+      elfs_by_file_mapping_{};
+  uint64_t hit_count_ = 0;
+  uint64_t miss_count_ = 0;
+};
+
+}  // namespace LinuxTracing
+
+#endif  // ORBIT_LINUX_TRACING_ELF_CACHE_H_
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <linux/limits.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "ElfCache.h"
+#include "LibunwindstackUnwinder.h"
+#include "absl/strings/str_format.h"
+
+namespace LinuxTracing {
+
+namespace {
+std::string GetTestDataPath(const std::string& file_name) {
+  char executable_path[PATH_MAX];
+  ssize_t length =
+      readlink("/proc/self/exe", executable_path, sizeof(executable_path));
+  if (length <= 0 || length == sizeof(executable_path)) {
+    return "";
+  }
+  std::string executable_dir{executable_path, static_cast<size_t>(length)};
+  executable_dir.erase(executable_dir.find_last_of('/') + 1);
+  return executable_dir + "testdata/" + file_name;
+}
+
+// Replaces the file at destination with a copy of source. The new file is
+// renamed over destination, like an install would do, so that the old file
+// stays valid for the Elf objects that already mapped it.
+void ReplaceFile(const std::string& source, const std::string& destination) {
+  std::string temporary = destination + ".new";
+  {
+    std::ifstream input{source, std::ios::binary};
+    std::ofstream output{temporary, std::ios::binary | std::ios::trunc};
+    output << input.rdbuf();
+  }
+  ASSERT_EQ(rename(temporary.c_str(), destination.c_str()), 0);
+}
+
+std::unique_ptr<unwindstack::BufferMaps> ParseMapsWithFileAt(
+    const std::string& file, uint64_t start) {
+  return LibunwindstackUnwinder::ParseMaps(
+      absl::StrFormat("%08x-%08x r-xp 00000000 00:00 0 %s\n", start,
+                      start + 0x1000, file));
+}
+
+// Maps library at 0x1000 with a valid Elf object, calls replace_library, then
+// maps library at 0x5000 instead and returns the new maps after updating
+// elf_cache.
+template <typename ReplaceLibraryT>
+std::unique_ptr<unwindstack::BufferMaps> MoveLibrary(
+    const std::string& library, ElfCache* elf_cache,
+    ReplaceLibraryT replace_library,
+    std::shared_ptr<unwindstack::Elf>* old_elf) {
+  std::unique_ptr<unwindstack::BufferMaps> old_maps =
+      ParseMapsWithFileAt(library, 0x1000);
+  std::unique_ptr<unwindstack::BufferMaps> new_maps =
+      ParseMapsWithFileAt(library, 0x5000);
+  if (old_maps == nullptr || new_maps == nullptr) {
+    return nullptr;
+  }
+  unwindstack::MapInfo* old_lib = old_maps->Find(0x1000);
+  std::shared_ptr<unwindstack::Memory> process_memory =
+      unwindstack::Memory::CreateOfflineMemory(nullptr, 0, 0);
+  old_lib->GetElf(process_memory, unwindstack::ARCH_X86_64);
+  EXPECT_TRUE(old_lib->elf->valid());
+  EXPECT_FALSE(old_lib->GetBuildID().empty());
+  *old_elf = old_lib->elf;
+
+  replace_library();
+  elf_cache->UpdateMaps(old_maps.get(), new_maps.get());
+  return new_maps;
+}
+}  // namespace
+
+TEST(ElfCache, ReusesElfOfUnchangedMappings) {
+  std::unique_ptr<unwindstack::BufferMaps> old_maps =
+      LibunwindstackUnwinder::ParseMaps(
+          "00001000-00002000 r-xp 00000000 00:00 0 /not/a/lib.so\n"
+          "00002000-00003000 rw-p 00001000 00:00 0 /not/a/lib.so\n"
+          "00010000-00011000 r-xp 00000000 00:00 0 /not/another/lib.so\n");
+  ASSERT_NE(old_maps, nullptr);
+  std::unique_ptr<unwindstack::BufferMaps> new_maps =
+      LibunwindstackUnwinder::ParseMaps(
+          "00001000-00002000 r-xp 00000000 00:00 0 /not/a/lib.so\n"
+          "00002000-00003000 rw-p 00001000 00:00 0 /not/a/lib.so\n"
+          "00010000-00012000 r-xp 00000000 00:00 0 /not/another/lib.so\n"
+          "00020000-00021000 r-xp 00000000 00:00 0\n");
+  ASSERT_NE(new_maps, nullptr);
+
+  unwindstack::MapInfo* old_lib = old_maps->Find(0x1000);
+  ASSERT_NE(old_lib, nullptr);
+  old_lib->elf = std::make_shared<unwindstack::Elf>(nullptr);
+  old_lib->elf_offset = 0x10;
+  unwindstack::MapInfo* old_other_lib = old_maps->Find(0x10000);
+  ASSERT_NE(old_other_lib, nullptr);
+  old_other_lib->elf = std::make_shared<unwindstack::Elf>(nullptr);
+
+  ElfCache elf_cache;
+  elf_cache.UpdateMaps(old_maps.get(), new_maps.get());
+
+  unwindstack::MapInfo* new_lib = new_maps->Find(0x1000);
+  ASSERT_NE(new_lib, nullptr);
+  EXPECT_EQ(new_lib->elf, old_lib->elf);
+  EXPECT_EQ(new_lib->elf_offset, 0x10);
+
+  // The address range of the other library changed.
+  unwindstack::MapInfo* new_other_lib = new_maps->Find(0x10000);
+  ASSERT_NE(new_other_lib, nullptr);
+  EXPECT_EQ(new_other_lib->elf, nullptr);
+
+  EXPECT_EQ(elf_cache.GetHitCount(), 1);
+  // The other library and the anonymous executable mapping.
+  EXPECT_EQ(elf_cache.GetMissCount(), 2);
+}
+
+TEST(ElfCache, ReusesElfOfMovedFile) {
+  std::string library = ::testing::TempDir() + "ElfCacheTest_moved.so";
+  ReplaceFile(GetTestDataPath("hello_world_elf"), library);
+
+  ElfCache elf_cache;
+  std::shared_ptr<unwindstack::Elf> old_elf;
+  std::unique_ptr<unwindstack::BufferMaps> new_maps =
+      MoveLibrary(library, &elf_cache, [] {}, &old_elf);
+  ASSERT_NE(new_maps, nullptr);
+
+  unwindstack::MapInfo* new_lib = new_maps->Find(0x5000);
+  ASSERT_NE(new_lib, nullptr);
+  EXPECT_EQ(new_lib->elf, old_elf);
+  EXPECT_EQ(elf_cache.GetHitCount(), 1);
+  EXPECT_EQ(elf_cache.GetMissCount(), 0);
+  remove(library.c_str());
+}
+
+TEST(ElfCache, DoesNotReuseElfOfFileWithNewBuildId) {
+  std::string library = ::testing::TempDir() + "ElfCacheTest_rebuilt.so";
+  ReplaceFile(GetTestDataPath("hello_world_elf"), library);
+
+  ElfCache elf_cache;
+  std::shared_ptr<unwindstack::Elf> old_elf;
+  std::unique_ptr<unwindstack::BufferMaps> new_maps = MoveLibrary(
+      library, &elf_cache,
+      [&library] {
+        // A new build of the library, with another build id, is loaded.
+        ReplaceFile(GetTestDataPath("no_symbols_elf"), library);
+      },
+      &old_elf);
+  ASSERT_NE(new_maps, nullptr);
+
+  unwindstack::MapInfo* new_lib = new_maps->Find(0x5000);
+  ASSERT_NE(new_lib, nullptr);
+  EXPECT_EQ(new_lib->elf, nullptr);
+  EXPECT_EQ(elf_cache.GetHitCount(), 0);
+  EXPECT_EQ(elf_cache.GetMissCount(), 1);
+  remove(library.c_str());
+}
+
+}  // namespace LinuxTracing
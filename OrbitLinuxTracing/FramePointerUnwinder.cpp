@@ -0,0 +1,164 @@
+#include "FramePointerUnwinder.h"
+
+#include <sys/mman.h>
+
+#include <cstring>
+
+namespace LinuxTracing {
+
+namespace {
+bool ReadStackValue(const char* stack_dump, uint64_t stack_dump_size,
+                    uint64_t stack_begin, uint64_t address, uint64_t* value) {
+  if (address < stack_begin || address - stack_begin > stack_dump_size ||
+      stack_dump_size - (address - stack_begin) < sizeof(uint64_t)) {
+    return false;
+  }
+  memcpy(value, stack_dump + (address - stack_begin), sizeof(uint64_t));
+  return true;
+}
+}  // namespace
+
+std::vector<unwindstack::FrameData> FramePointerUnwinder::Unwind(
+    unwindstack::Maps* maps,
+    const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+    const char* stack_dump, uint64_t stack_dump_size) {
+  return UnwindOrFallBack(maps, perf_regs, stack_dump, stack_dump_size, false);
+}
+
+std::vector<unwindstack::FrameData>
+FramePointerUnwinder::UnwindFromFunctionEntry(
+    unwindstack::Maps* maps,
+    const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+    const char* stack_dump, uint64_t stack_dump_size) {
+  return UnwindOrFallBack(maps, perf_regs, stack_dump, stack_dump_size, true);
+}
+
+std::vector<unwindstack::FrameData> FramePointerUnwinder::UnwindOrFallBack(
+    unwindstack::Maps* maps,
+    const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+    const char* stack_dump, uint64_t stack_dump_size, bool at_function_entry) {
+  if (maps != nullptr) {
+    std::optional<std::vector<unwindstack::FrameData>> callstack =
+        UnwindWithFramePointers(maps, perf_regs, stack_dump, stack_dump_size,
+                                at_function_entry);
+    if (callstack.has_value()) {
+      ++frame_pointer_unwind_count_;
+      return std::move(callstack.value());
+    }
+  }
+  ++fallback_unwind_count_;
+  return fallback_unwinder_.Unwind(maps, perf_regs, stack_dump,
+                                   stack_dump_size);
+}
+
+std::optional<std::vector<unwindstack::FrameData>>
+FramePointerUnwinder::UnwindWithFramePointers(
+    unwindstack::Maps* maps,
+    const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+    const char* stack_dump, uint64_t stack_dump_size, bool at_function_entry) {
+  const uint64_t stack_begin = perf_regs[PERF_REG_X86_SP];
+  std::vector<unwindstack::FrameData> callstack;
+
+  // Appends the frame for address and returns whether unwinding can continue,
+  // or std::nullopt if address is not in a known executable mapping.
+  // As libunwindstack does, the pc of a frame reached through a return address
+  // is the address of the call instruction rather than the return address.
+  auto add_frame = [&](uint64_t address, uint64_t sp,
+                       bool is_return_address) -> std::optional<bool> {
+    unwindstack::MapInfo* map_info = maps->Find(address);
+    if (map_info == nullptr) {
+      return std::nullopt;
+    }
+    if (map_info->name == "[uprobes]") {
+      // The return address was hijacked by uretprobes: this is as far as the
+      // stack can be unwound, also for LibunwindstackUnwinder.
+      unwindstack::FrameData& frame = callstack.emplace_back();
+      frame.num = callstack.size() - 1;
+      frame.pc = address;
+      frame.sp = sp;
+      frame.map_name = map_info->name;
+      frame.map_start = map_info->start;
+      frame.map_end = map_info->end;
+      frame.map_flags = map_info->flags;
+      return false;
+    }
+    if ((map_info->flags & PROT_EXEC) == 0) {
+      return std::nullopt;
+    }
+
+    uint64_t pc = is_return_address ? address - 1 : address;
+    unwindstack::FrameData& frame = callstack.emplace_back();
+    frame.num = callstack.size() - 1;
+    frame.pc = pc;
+    frame.sp = sp;
+    frame.map_name = map_info->name;
+    frame.map_offset = map_info->offset;
+    frame.map_start = map_info->start;
+    frame.map_end = map_info->end;
+    frame.map_flags = map_info->flags;
+    unwindstack::Elf* elf =
+        map_info->GetElf(process_memory_, unwindstack::ARCH_X86_64);
+    if (elf != nullptr && elf->valid()) {
+      frame.rel_pc = elf->GetRelPc(pc, map_info);
+      elf->GetFunctionName(frame.rel_pc, &frame.function_name,
+                           &frame.function_offset);
+    } else {
+      frame.rel_pc = pc - map_info->start;
+    }
+    return true;
+  };
+
+  std::optional<bool> can_continue =
+      add_frame(perf_regs[PERF_REG_X86_IP], stack_begin, false);
+  if (!can_continue.has_value()) {
+    return std::nullopt;
+  }
+
+  uint64_t frame_pointer = perf_regs[PERF_REG_X86_BP];
+  uint64_t caller_sp = stack_begin;
+  if (can_continue.value() && at_function_entry) {
+    // The return address is on top of the stack, and rbp still holds the
+    // frame pointer of the caller.
+    uint64_t return_address;
+    if (!ReadStackValue(stack_dump, stack_dump_size, stack_begin, stack_begin,
+                        &return_address)) {
+      return std::nullopt;
+    }
+    caller_sp = stack_begin + sizeof(uint64_t);
+    can_continue = add_frame(return_address, caller_sp, true);
+    if (!can_continue.has_value()) {
+      return std::nullopt;
+    }
+  }
+
+  while (can_continue.value() && frame_pointer != 0) {
+    if (callstack.size() >= MAX_FRAMES) {
+      return std::nullopt;
+    }
+    // The frame of the caller must be above the current frame.
+    if (frame_pointer < caller_sp || frame_pointer % sizeof(uint64_t) != 0) {
+      return std::nullopt;
+    }
+    uint64_t next_frame_pointer;
+    uint64_t return_address;
+    if (!ReadStackValue(stack_dump, stack_dump_size, stack_begin,
+                        frame_pointer, &next_frame_pointer) ||
+        !ReadStackValue(stack_dump, stack_dump_size, stack_begin,
+                        frame_pointer + sizeof(uint64_t), &return_address)) {
+      return std::nullopt;
+    }
+    if (return_address == 0) {
+      break;
+    }
+    caller_sp = frame_pointer + 2 * sizeof(uint64_t);
+    can_continue = add_frame(return_address, caller_sp, true);
+    if (!can_continue.has_value()) {
+      return std::nullopt;
+    }
+    frame_pointer = next_frame_pointer;
+  }
+
+  return callstack;
+}
+
+}  // namespace LinuxTracing
@@ -0,0 +1,80 @@
+#ifndef ORBIT_LINUX_TRACING_FRAME_POINTER_UNWINDER_H_
+#define ORBIT_LINUX_TRACING_FRAME_POINTER_UNWINDER_H_
+
+#include <asm/perf_regs.h>
+#include <unwindstack/Unwinder.h>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "LibunwindstackUnwinder.h"
+
+namespace LinuxTracing {
+
+// FramePointerUnwinder unwinds by following the chain of frame pointers (rbp)
+// through the copied stack, which is much cheaper than constructing an
+// unwindstack::Unwinder and evaluating DWARF CFI for every sample, but only
+// works for code compiled with -fno-omit-frame-pointer.
+// When a return address falls outside of the known executable mappings, or
+// when the chain looks broken (a frame pointer outside of the copied stack, or
+// not strictly increasing), it falls back to LibunwindstackUnwinder.
+// Unwinding stops successfully at a null frame pointer, which marks the
+// outermost frame (_start and the entry point of threads clear rbp), or at a
+// return address hijacked by uretprobes, in which case, as with
+// LibunwindstackUnwinder, the last frame is the [uprobes] frame.
+class FramePointerUnwinder {
+ public:
+  static std::unique_ptr<unwindstack::BufferMaps> ParseMaps(
+      const std::string& maps_buffer) {
+    return LibunwindstackUnwinder::ParseMaps(maps_buffer);
+  }
+
+  // Unwinds from an arbitrary instruction. If the instruction is in the
+  // prologue or epilogue of a function, the caller of that function is
+  // missing from the callstack, like with any frame-pointer-based unwinder.
+  std::vector<unwindstack::FrameData> Unwind(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size);
+
+  // Unwinds from the first instruction of a function, e.g., from a uprobe:
+  // the function has not pushed its frame pointer yet, and the return address
+  // is at the top of the stack. This produces the complete callstack.
+  std::vector<unwindstack::FrameData> UnwindFromFunctionEntry(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size);
+
+  uint64_t GetFramePointerUnwindCount() const {
+    return frame_pointer_unwind_count_;
+  }
+  uint64_t GetFallbackUnwindCount() const { return fallback_unwind_count_; }
+
+ private:
+  static constexpr size_t MAX_FRAMES = 1024;  // As LibunwindstackUnwinder.
+
+  std::vector<unwindstack::FrameData> UnwindOrFallBack(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size, bool at_function_entry);
+
+  // Returns std::nullopt if the frame pointer chain cannot be followed.
+  std::optional<std::vector<unwindstack::FrameData>> UnwindWithFramePointers(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size, bool at_function_entry);
+
+  LibunwindstackUnwinder fallback_unwinder_{};
+  // Only used to create the unwindstack::Elf of a map the first time a frame
+  // falls into it, which happens from the file backing the map.
+  std::shared_ptr<unwindstack::Memory> process_memory_ =
+      unwindstack::Memory::CreateOfflineMemory(nullptr, 0, 0);
+  uint64_t frame_pointer_unwind_count_ = 0;
+  uint64_t fallback_unwind_count_ = 0;
+};
+
+}  // namespace LinuxTracing
+
+#endif  // ORBIT_LINUX_TRACING_FRAME_POINTER_UNWINDER_H_
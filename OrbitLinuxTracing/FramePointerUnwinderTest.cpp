@@ -0,0 +1,164 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "FramePointerUnwinder.h"
+
+namespace LinuxTracing {
+
+namespace {
+constexpr uint64_t STACK_BEGIN = 0x7000;
+constexpr uint64_t STACK_SIZE = 0x100;
+
+const char* const TEST_MAPS =
+    "00100000-00200000 r-xp 00000000 00:00 0 /not/a/file\n"
+    "00200000-00300000 r--p 00000000 00:00 0 /not/a/file\n"
+    "00300000-00301000 r-xp 00000000 00:00 0 [uprobes]\n";
+
+class TestStack {
+ public:
+  TestStack() { memset(data_.data(), 0, data_.size()); }
+
+  void Write(uint64_t address, uint64_t value) {
+    memcpy(data_.data() + (address - STACK_BEGIN), &value, sizeof(value));
+  }
+
+  const char* GetData() const { return data_.data(); }
+
+ private:
+  std::array<char, STACK_SIZE> data_;
+};
+
+std::array<uint64_t, PERF_REG_X86_64_MAX> MakeRegisters(uint64_t ip,
+                                                        uint64_t bp) {
+  std::array<uint64_t, PERF_REG_X86_64_MAX> registers{};
+  registers[PERF_REG_X86_IP] = ip;
+  registers[PERF_REG_X86_BP] = bp;
+  registers[PERF_REG_X86_SP] = STACK_BEGIN;
+  return registers;
+}
+
+using PcSp = std::pair<uint64_t, uint64_t>;
+
+std::vector<PcSp> CallstackToPcSpPairs(
+    const std::vector<unwindstack::FrameData>& callstack) {
+  std::vector<PcSp> pc_sp_pairs;
+  for (const unwindstack::FrameData& frame : callstack) {
+    pc_sp_pairs.emplace_back(frame.pc, frame.sp);
+  }
+  return pc_sp_pairs;
+}
+
+// Two frames above the innermost one, the outermost with a null frame pointer.
+TestStack MakeTestStackWithFramePointerChain() {
+  TestStack stack;
+  stack.Write(0x7010, 0x7030);
+  stack.Write(0x7018, 0x100200);
+  stack.Write(0x7030, 0);
+  stack.Write(0x7038, 0x100300);
+  return stack;
+}
+}  // namespace
+
+TEST(FramePointerUnwinder, FollowsFramePointers) {
+  std::unique_ptr<unwindstack::BufferMaps> maps =
+      FramePointerUnwinder::ParseMaps(TEST_MAPS);
+  ASSERT_NE(maps, nullptr);
+  TestStack stack = MakeTestStackWithFramePointerChain();
+  FramePointerUnwinder unwinder;
+
+  std::vector<unwindstack::FrameData> callstack =
+      unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x7010),
+                      stack.GetData(), STACK_SIZE);
+
+  EXPECT_THAT(CallstackToPcSpPairs(callstack),
+              ::testing::ElementsAre(PcSp(0x100100, 0x7000),
+                                     PcSp(0x1001ff, 0x7020),
+                                     PcSp(0x1002ff, 0x7040)));
+  EXPECT_EQ(callstack.back().map_name, "/not/a/file");
+  EXPECT_EQ(unwinder.GetFramePointerUnwindCount(), 1);
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 0);
+}
+
+TEST(FramePointerUnwinder, UnwindsFromFunctionEntry) {
+  std::unique_ptr<unwindstack::BufferMaps> maps =
+      FramePointerUnwinder::ParseMaps(TEST_MAPS);
+  ASSERT_NE(maps, nullptr);
+  TestStack stack = MakeTestStackWithFramePointerChain();
+  stack.Write(STACK_BEGIN, 0x100400);
+  FramePointerUnwinder unwinder;
+
+  std::vector<unwindstack::FrameData> callstack =
+      unwinder.UnwindFromFunctionEntry(maps.get(),
+                                       MakeRegisters(0x100100, 0x7010),
+                                       stack.GetData(), STACK_SIZE);
+
+  EXPECT_THAT(CallstackToPcSpPairs(callstack),
+              ::testing::ElementsAre(PcSp(0x100100, 0x7000),
+                                     PcSp(0x1003ff, 0x7008),
+                                     PcSp(0x1001ff, 0x7020),
+                                     PcSp(0x1002ff, 0x7040)));
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 0);
+}
+
+TEST(FramePointerUnwinder, StopsAtUprobesFrame) {
+  std::unique_ptr<unwindstack::BufferMaps> maps =
+      FramePointerUnwinder::ParseMaps(TEST_MAPS);
+  ASSERT_NE(maps, nullptr);
+  TestStack stack = MakeTestStackWithFramePointerChain();
+  stack.Write(0x7018, 0x300000);
+  FramePointerUnwinder unwinder;
+
+  std::vector<unwindstack::FrameData> callstack =
+      unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x7010),
+                      stack.GetData(), STACK_SIZE);
+
+  EXPECT_THAT(CallstackToPcSpPairs(callstack),
+              ::testing::ElementsAre(PcSp(0x100100, 0x7000),
+                                     PcSp(0x300000, 0x7020)));
+  EXPECT_EQ(callstack.back().map_name, "[uprobes]");
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 0);
+}
+
+TEST(FramePointerUnwinder, FallsBackOnBrokenChain) {
+  std::unique_ptr<unwindstack::BufferMaps> maps =
+      FramePointerUnwinder::ParseMaps(TEST_MAPS);
+  ASSERT_NE(maps, nullptr);
+  FramePointerUnwinder unwinder;
+
+  // Frame pointer below the stack pointer.
+  TestStack stack = MakeTestStackWithFramePointerChain();
+  unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x6ff0), stack.GetData(),
+                  STACK_SIZE);
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 1);
+
+  // Frame pointer outside of the copied stack.
+  stack.Write(0x7030, 0x8000);
+  unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x7010), stack.GetData(),
+                  STACK_SIZE);
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 2);
+
+  // Frame pointers not increasing.
+  stack.Write(0x7030, 0x7010);
+  unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x7010), stack.GetData(),
+                  STACK_SIZE);
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 3);
+
+  // Return address in a non-executable mapping.
+  stack = MakeTestStackWithFramePointerChain();
+  stack.Write(0x7038, 0x200000);
+  unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x7010), stack.GetData(),
+                  STACK_SIZE);
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 4);
+
+  // Return address outside of any mapping.
+  stack.Write(0x7038, 0x400000);
+  unwinder.Unwind(maps.get(), MakeRegisters(0x100100, 0x7010), stack.GetData(),
+                  STACK_SIZE);
+  EXPECT_EQ(unwinder.GetFallbackUnwindCount(), 5);
+
+  EXPECT_EQ(unwinder.GetFramePointerUnwindCount(), 0);
+}
+
+}  // namespace LinuxTracing
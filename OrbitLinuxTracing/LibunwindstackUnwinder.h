@@ -21,6 +21,16 @@ class LibunwindstackUnwinder {
       const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
       const char* stack_dump, uint64_t stack_dump_size);
 
+  // DWARF-based unwinding doesn't need to know that the first instruction of a
+  // function is being executed. This is part of the interface shared with
+  // FramePointerUnwinder for UprobesCallstackManager.
+  std::vector<unwindstack::FrameData> UnwindFromFunctionEntry(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size) {
+    return Unwind(maps, perf_regs, stack_dump, stack_dump_size);
+  }
+
   std::vector<unwindstack::FrameData> Unwind(
       const std::string& maps_buffer,
       const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
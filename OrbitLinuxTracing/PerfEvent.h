@@ -4,9 +4,10 @@
 #include <OrbitLinuxTracing/Function.h>
 
 #include <array>
+#include <cstring>
 #include <memory>
 
-#include "MakeUniqueForOverwrite.h"
+#include "PerfEventAllocator.h"
 #include "PerfEventRecords.h"
 
 namespace LinuxTracing {
@@ -18,10 +19,20 @@ class PerfEventVisitor;
 // perf_event_open records will be copied from the ring buffer directly into the
 // concrete subclass (depending on the event type), in general into a
 // "ring_buffer_record" field.
+// As PerfEvents are created and destroyed at a very high rate, their memory is
+// recycled through PerfEventAllocator. The virtual destructor guarantees that
+// the sized operator delete receives the size of the most derived class.
 
 class PerfEvent {
  public:
   virtual ~PerfEvent() = default;
+  static void* operator new(size_t size) {
+    return PerfEventAllocator::Allocate(size);
+  }
+  static void operator delete(void* event, size_t size) {
+    PerfEventAllocator::Deallocate(event, size);
+  }
+
   virtual uint64_t GetTimestamp() const = 0;
   virtual void Accept(PerfEventVisitor* visitor) = 0;
   void SetOriginFileDescriptor(int fd) { origin_file_descriptor_ = fd; }
@@ -170,11 +181,10 @@ struct __attribute__((__packed__)) dynamically_sized_perf_event_stack_sample {
   struct __attribute__((__packed__))
   dynamically_sized_perf_event_sample_stack_user {
     uint64_t dyn_size;
-    std::unique_ptr<char[]> data;
+    PooledBuffer data;
 
     explicit dynamically_sized_perf_event_sample_stack_user(uint64_t dyn_size)
-        : dyn_size{dyn_size},
-          data{make_unique_for_overwrite<char[]>(dyn_size)} {}
+        : dyn_size{dyn_size}, data{MakePooledBuffer(dyn_size)} {}
   };
 
   perf_event_header header;
@@ -184,6 +194,13 @@ struct __attribute__((__packed__)) dynamically_sized_perf_event_stack_sample {
 
   explicit dynamically_sized_perf_event_stack_sample(uint64_t dyn_size)
       : stack{dyn_size} {}
+
+  static void* operator new(size_t size) {
+    return PerfEventAllocator::Allocate(size);
+  }
+  static void operator delete(void* record, size_t size) {
+    PerfEventAllocator::Deallocate(record, size);
+  }
 };
 
 class SamplePerfEvent : public PerfEvent {
@@ -213,11 +230,26 @@ class SamplePerfEvent : public PerfEvent {
         ring_buffer_record->regs);
   }
 
+  uint64_t GetStackPointer() const { return ring_buffer_record->regs.sp; }
+
   const char* GetStackData() const {
     return ring_buffer_record->stack.data.get();
   }
   uint64_t GetStackSize() const { return ring_buffer_record->stack.dyn_size; }
 
+  // Keeps only the first new_stack_size bytes of the stack copy, i.e., the
+  // region starting at the stack pointer, and releases the rest.
+  void TrimStack(uint64_t new_stack_size) {
+    if (new_stack_size >= ring_buffer_record->stack.dyn_size) {
+      return;
+    }
+    PooledBuffer trimmed_data = MakePooledBuffer(new_stack_size);
+    memcpy(trimmed_data.get(), ring_buffer_record->stack.data.get(),
+           new_stack_size);
+    ring_buffer_record->stack.data = std::move(trimmed_data);
+    ring_buffer_record->stack.dyn_size = new_stack_size;
+  }
+
  private:
   static std::array<uint64_t, PERF_REG_X86_64_MAX>
   perf_event_sample_regs_user_all_to_register_array(
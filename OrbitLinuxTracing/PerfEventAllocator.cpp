@@ -0,0 +1,119 @@
+#include "PerfEventAllocator.h"
+
+#include <array>
+#include <atomic>
+#include <new>
+
+#include "concurrentqueue.h"
+
+namespace LinuxTracing {
+
+namespace {
+
+constexpr size_t SMALL_CLASS_COUNT =
+    PerfEventAllocator::MAX_SMALL_CLASS_SIZE /
+    PerfEventAllocator::SMALL_CLASS_GRANULARITY;
+constexpr size_t LARGE_CLASS_COUNT =
+    PerfEventAllocator::MAX_LARGE_CLASS_SIZE_LOG2 -
+    PerfEventAllocator::MIN_LARGE_CLASS_SIZE_LOG2 + 1;
+constexpr size_t CLASS_COUNT = SMALL_CLASS_COUNT + LARGE_CLASS_COUNT;
+// Returned by GetSizeClass for sizes that are not pooled.
+constexpr size_t NO_CLASS = CLASS_COUNT;
+
+size_t GetSizeClass(size_t size) {
+  if (size <= PerfEventAllocator::MAX_SMALL_CLASS_SIZE) {
+    if (size == 0) {
+      return 0;
+    }
+    return (size - 1) / PerfEventAllocator::SMALL_CLASS_GRANULARITY;
+  }
+  size_t size_log2 = PerfEventAllocator::MIN_LARGE_CLASS_SIZE_LOG2;
+  while ((size_t{1} << size_log2) < size) {
+    ++size_log2;
+    if (size_log2 > PerfEventAllocator::MAX_LARGE_CLASS_SIZE_LOG2) {
+      return NO_CLASS;
+    }
+  }
+  return SMALL_CLASS_COUNT + size_log2 -
+         PerfEventAllocator::MIN_LARGE_CLASS_SIZE_LOG2;
+}
+
+size_t GetClassSize(size_t size_class) {
+  if (size_class < SMALL_CLASS_COUNT) {
+    return (size_class + 1) * PerfEventAllocator::SMALL_CLASS_GRANULARITY;
+  }
+  return size_t{1} << (size_class - SMALL_CLASS_COUNT +
+                       PerfEventAllocator::MIN_LARGE_CLASS_SIZE_LOG2);
+}
+
+using FreeLists = std::array<moodycamel::ConcurrentQueue<void*>, CLASS_COUNT>;
+
+FreeLists& GetFreeLists() {
+  // Intentionally leaked, so that events destroyed during static destruction
+  // can still be deallocated.
+  static auto* free_lists = new FreeLists{};
+  return *free_lists;
+}
+
+std::atomic<uint64_t> reused_count{0};
+std::atomic<uint64_t> system_allocation_count{0};
+
+}  // namespace
+
+void* PerfEventAllocator::Allocate(size_t size) {
+  size_t size_class = GetSizeClass(size);
+  if (size_class == NO_CLASS) {
+    system_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+  }
+
+  void* block;
+  if (GetFreeLists()[size_class].try_dequeue(block)) {
+    reused_count.fetch_add(1, std::memory_order_relaxed);
+    return block;
+  }
+  system_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return ::operator new(GetClassSize(size_class));
+}
+
+void PerfEventAllocator::Deallocate(void* block, size_t size) {
+  if (block == nullptr) {
+    return;
+  }
+  size_t size_class = GetSizeClass(size);
+  if (size_class == NO_CLASS) {
+    ::operator delete(block);
+    return;
+  }
+
+  moodycamel::ConcurrentQueue<void*>& free_list = GetFreeLists()[size_class];
+  size_t max_cached_blocks =
+      MAX_CACHED_BYTES_PER_CLASS / GetClassSize(size_class);
+  if (free_list.size_approx() >= max_cached_blocks ||
+      !free_list.enqueue(block)) {
+    ::operator delete(block);
+  }
+}
+
+void PerfEventAllocator::ReleaseCachedMemory() {
+  for (moodycamel::ConcurrentQueue<void*>& free_list : GetFreeLists()) {
+    std::array<void*, 64> blocks;
+    size_t count;
+    while ((count = free_list.try_dequeue_bulk(blocks.begin(),
+                                               blocks.size())) > 0) {
+      for (size_t i = 0; i < count; ++i) {
+        ::operator delete(blocks[i]);
+      }
+    }
+  }
+}
+
+PerfEventAllocator::Stats PerfEventAllocator::GetAndResetStats() {
+  Stats stats;
+  stats.reused_count = reused_count.exchange(0, std::memory_order_relaxed);
+  stats.system_allocation_count =
+      system_allocation_count.exchange(0, std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace LinuxTracing
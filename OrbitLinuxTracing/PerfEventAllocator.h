@@ -0,0 +1,69 @@
+#ifndef ORBIT_LINUX_TRACING_PERF_EVENT_ALLOCATOR_H_
+#define ORBIT_LINUX_TRACING_PERF_EVENT_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace LinuxTracing {
+
+// PerfEventAllocator recycles the memory of PerfEvents and of the copies of
+// the user stacks of sampled events, which would otherwise cause hundreds of
+// thousands of malloc/free pairs per second on the tracer hot path.
+// Small blocks (fixed-size events) are grouped in size classes of
+// SMALL_CLASS_GRANULARITY bytes, larger blocks (stack copies) in power-of-two
+// size classes. Each size class keeps a lock-free free list, as an event is
+// usually allocated by a reader thread but released by whichever thread visits
+// it. Sizes above the largest class are forwarded to the system allocator.
+class PerfEventAllocator {
+ public:
+  struct Stats {
+    uint64_t reused_count = 0;
+    uint64_t system_allocation_count = 0;
+  };
+
+  static void* Allocate(size_t size);
+  // size must be the same that was passed to Allocate.
+  static void Deallocate(void* block, size_t size);
+
+  // Returns the memory cached by all size classes to the system allocator.
+  // Call when tracing stops, so that the pool doesn't outlive the capture.
+  static void ReleaseCachedMemory();
+
+  static Stats GetAndResetStats();
+
+  static constexpr size_t SMALL_CLASS_GRANULARITY = 64;
+  static constexpr size_t MAX_SMALL_CLASS_SIZE = 512;
+  static constexpr size_t MIN_LARGE_CLASS_SIZE_LOG2 = 10;
+  static constexpr size_t MAX_LARGE_CLASS_SIZE_LOG2 = 16;
+  // Blocks freed while a size class already caches this many bytes are
+  // returned to the system allocator.
+  static constexpr size_t MAX_CACHED_BYTES_PER_CLASS = 16 * 1024 * 1024;
+};
+
+// Deleter for the buffers allocated with PerfEventAllocator, e.g., through
+// MakePooledBuffer.
+class PooledBufferDeleter {
+ public:
+  PooledBufferDeleter() = default;
+  explicit PooledBufferDeleter(size_t size) : size_{size} {}
+
+  void operator()(char* buffer) const {
+    PerfEventAllocator::Deallocate(buffer, size_);
+  }
+
+ private:
+  size_t size_ = 0;
+};
+
+using PooledBuffer = std::unique_ptr<char[], PooledBufferDeleter>;
+
+// Like make_unique_for_overwrite<char[]>, the buffer is not initialized.
+inline PooledBuffer MakePooledBuffer(size_t size) {
+  return PooledBuffer{static_cast<char*>(PerfEventAllocator::Allocate(size)),
+                      PooledBufferDeleter{size}};
+}
+
+}  // namespace LinuxTracing
+
+#endif  // ORBIT_LINUX_TRACING_PERF_EVENT_ALLOCATOR_H_
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "PerfEvent.h"
+#include "PerfEventAllocator.h"
+
+namespace LinuxTracing {
+
+TEST(PerfEventAllocator, BlocksAreDistinctAndWritable) {
+  std::vector<std::pair<void*, size_t>> blocks;
+  for (size_t size : {0, 1, 63, 64, 65, 300, 512, 513, 1024, 4000, 65000,
+                      65536, 65537, 1 << 20}) {
+    void* block = PerfEventAllocator::Allocate(size);
+    ASSERT_NE(block, nullptr);
+    memset(block, 0xAB, size);
+    for (const auto& [other_block, other_size] : blocks) {
+      EXPECT_NE(block, other_block);
+    }
+    blocks.emplace_back(block, size);
+  }
+  for (const auto& [block, size] : blocks) {
+    PerfEventAllocator::Deallocate(block, size);
+  }
+}
+
+TEST(PerfEventAllocator, SampleEventsAreRecycled) {
+  constexpr size_t event_count = 100;
+  // Each StackSamplePerfEvent allocates the event, the record and the stack.
+  constexpr size_t allocations_per_event = 3;
+
+  std::vector<std::unique_ptr<PerfEvent>> events;
+  for (size_t i = 0; i < event_count; ++i) {
+    events.push_back(std::make_unique<StackSamplePerfEvent>(65000));
+  }
+  events.clear();
+
+  PerfEventAllocator::GetAndResetStats();
+  for (size_t i = 0; i < event_count; ++i) {
+    events.push_back(std::make_unique<StackSamplePerfEvent>(65000));
+  }
+  PerfEventAllocator::Stats stats = PerfEventAllocator::GetAndResetStats();
+  EXPECT_EQ(stats.system_allocation_count, 0);
+  EXPECT_EQ(stats.reused_count, event_count * allocations_per_event);
+}
+
+TEST(PerfEventAllocator, EventsFreedOnAnotherThreadAreRecycled) {
+  constexpr size_t event_count = 100;
+
+  std::vector<std::unique_ptr<PerfEvent>> events;
+  for (size_t i = 0; i < event_count; ++i) {
+    events.push_back(std::make_unique<UretprobesPerfEvent>());
+  }
+  std::thread releasing_thread{[&events] { events.clear(); }};
+  releasing_thread.join();
+
+  PerfEventAllocator::GetAndResetStats();
+  for (size_t i = 0; i < event_count; ++i) {
+    events.push_back(std::make_unique<UretprobesPerfEvent>());
+  }
+  PerfEventAllocator::Stats stats = PerfEventAllocator::GetAndResetStats();
+  EXPECT_EQ(stats.system_allocation_count, 0);
+  EXPECT_EQ(stats.reused_count, event_count);
+}
+
+TEST(PerfEventAllocator, ReleaseCachedMemory) {
+  constexpr size_t size = 4000;
+  PerfEventAllocator::Deallocate(PerfEventAllocator::Allocate(size), size);
+  PerfEventAllocator::ReleaseCachedMemory();
+
+  PerfEventAllocator::GetAndResetStats();
+  PerfEventAllocator::Deallocate(PerfEventAllocator::Allocate(size), size);
+  PerfEventAllocator::Stats stats = PerfEventAllocator::GetAndResetStats();
+  EXPECT_EQ(stats.system_allocation_count, 1);
+  EXPECT_EQ(stats.reused_count, 0);
+}
+
+TEST(PerfEventAllocator, OversizedBlocksAreNotPooled) {
+  constexpr size_t size = 1 << 20;
+  PerfEventAllocator::Deallocate(PerfEventAllocator::Allocate(size), size);
+
+  PerfEventAllocator::GetAndResetStats();
+  PerfEventAllocator::Deallocate(PerfEventAllocator::Allocate(size), size);
+  PerfEventAllocator::Stats stats = PerfEventAllocator::GetAndResetStats();
+  EXPECT_EQ(stats.system_allocation_count, 1);
+  EXPECT_EQ(stats.reused_count, 0);
+}
+
+}  // namespace LinuxTracing
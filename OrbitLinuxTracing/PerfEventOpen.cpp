@@ -31,6 +31,17 @@ perf_event_attr generic_event_attr() {
   return pe;
 }
 
+void set_wakeup_watermark(perf_event_attr* pe,
+                          uint32_t wakeup_watermark_bytes) {
+  if (wakeup_watermark_bytes == 0) {
+    return;
+  }
+  pe->watermark = 1;
+  // pe->wakeup_watermark is in a union with pe->wakeup_events, which is only
+  // used if pe->watermark is not set.
+  pe->wakeup_watermark = wakeup_watermark_bytes;
+}
+
 int generic_event_open(perf_event_attr* attr, pid_t pid, int32_t cpu) {
   int fd = perf_event_open(attr, pid, cpu, -1, 0);
   if (fd == -1) {
@@ -53,40 +64,51 @@ perf_event_attr uprobe_event_attr(const char* module,
 }
 }  // namespace
 
-int context_switch_event_open(pid_t pid, int32_t cpu) {
+int context_switch_event_open(pid_t pid, int32_t cpu,
+                              uint32_t wakeup_watermark_bytes) {
   perf_event_attr pe = generic_event_attr();
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_DUMMY;
   pe.context_switch = 1;
+  set_wakeup_watermark(&pe, wakeup_watermark_bytes);
 
   return generic_event_open(&pe, pid, cpu);
 }
 
-int mmap_task_event_open(pid_t pid, int32_t cpu) {
+int mmap_task_event_open(pid_t pid, int32_t cpu,
+                         uint32_t wakeup_watermark_bytes) {
   perf_event_attr pe = generic_event_attr();
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_DUMMY;
   pe.mmap = 1;
   pe.task = 1;
+  set_wakeup_watermark(&pe, wakeup_watermark_bytes);
 
   return generic_event_open(&pe, pid, cpu);
 }
 
-int sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu) {
+int sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
+                      uint16_t stack_dump_size,
+                      uint32_t wakeup_watermark_bytes) {
   perf_event_attr pe = generic_event_attr();
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_CPU_CLOCK;
   pe.sample_period = period_ns;
   pe.sample_type |= PERF_SAMPLE_STACK_USER | PERF_SAMPLE_REGS_USER;
+  pe.sample_stack_user = stack_dump_size;
+  set_wakeup_watermark(&pe, wakeup_watermark_bytes);
 
   return generic_event_open(&pe, pid, cpu);
 }
 
 int uprobes_stack_event_open(const char* module, uint64_t function_offset,
-                             pid_t pid, int32_t cpu) {
+                             pid_t pid, int32_t cpu, uint16_t stack_dump_size,
+                             uint32_t wakeup_watermark_bytes) {
   perf_event_attr pe = uprobe_event_attr(module, function_offset);
   pe.config = 0;
   pe.sample_type |= PERF_SAMPLE_STACK_USER | PERF_SAMPLE_REGS_USER;
+  pe.sample_stack_user = stack_dump_size;
+  set_wakeup_watermark(&pe, wakeup_watermark_bytes);
 
   return generic_event_open(&pe, pid, cpu);
 }
@@ -120,12 +142,14 @@ void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length) {
 }
 
 int tracepoint_event_open(const char* tracepoint_category,
-                          const char* tracepoint_name, pid_t pid, int32_t cpu) {
+                          const char* tracepoint_name, pid_t pid, int32_t cpu,
+                          uint32_t wakeup_watermark_bytes) {
   int tp_id = GetTracepointId(tracepoint_category, tracepoint_name);
   perf_event_attr pe = generic_event_attr();
   pe.type = PERF_TYPE_TRACEPOINT;
   pe.config = tp_id;
   pe.sample_type |= PERF_SAMPLE_RAW;
+  set_wakeup_watermark(&pe, wakeup_watermark_bytes);
 
   return generic_event_open(&pe, pid, cpu);
 }
@@ -95,23 +95,35 @@ static constexpr uint64_t SAMPLE_REGS_USER_ALL =
 // If we want the size we pass to coincide with the size we get, we need to pass
 // a lower value. For the current layout of perf_event_stack_sample, the maximum
 // size is 65312, but let's leave some extra room.
-// TODO: As this amount of memory has to be copied from the ring buffer for each
-//  sample, this constant should be a parameters and should be made available in
-//  some setting.
+// As this amount of memory has to be copied from the ring buffer for each
+// sample, sample_event_open and uprobes_stack_event_open take the size of the
+// stack dump as a parameter, and this constant is only the maximum.
 static constexpr uint16_t SAMPLE_STACK_USER_SIZE = 65000;
 
+// The functions below that open a file descriptor which can own a ring buffer
+// take a wakeup_watermark_bytes parameter: if not zero, a poll/epoll_wait on
+// the file descriptor only returns once at least that many bytes are available
+// in the ring buffer (perf_event_attr::watermark/wakeup_watermark). If zero,
+// the kernel's default applies (half of the ring buffer).
+
 // perf_event_open for context switches.
-int context_switch_event_open(pid_t pid, int32_t cpu);
+int context_switch_event_open(pid_t pid, int32_t cpu,
+                              uint32_t wakeup_watermark_bytes);
 
 // perf_event_open for task (fork and exit) and mmap records in the same buffer.
-int mmap_task_event_open(pid_t pid, int32_t cpu);
+int mmap_task_event_open(pid_t pid, int32_t cpu,
+                         uint32_t wakeup_watermark_bytes);
 
-// perf_event_open for stack sampling.
-int sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu);
+// perf_event_open for stack sampling. stack_dump_size must be a multiple of 8
+// and not larger than SAMPLE_STACK_USER_SIZE.
+int sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
+                      uint16_t stack_dump_size,
+                      uint32_t wakeup_watermark_bytes);
 
-// perf_event_open for uprobes and uretprobes.
+// perf_event_open for uprobes and uretprobes. stack_dump_size as above.
 int uprobes_stack_event_open(const char* module, uint64_t function_offset,
-                             pid_t pid, int32_t cpu);
+                             pid_t pid, int32_t cpu, uint16_t stack_dump_size,
+                             uint32_t wakeup_watermark_bytes);
 
 int uretprobes_event_open(const char* module, uint64_t function_offset,
                           pid_t pid, int32_t cpu);
@@ -124,7 +136,8 @@ void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length);
 // (for example, "sched_waking"). Returns the file descriptor for the
 // perf event or -1 in case of any errors.
 int tracepoint_event_open(const char* tracepoint_category,
-                          const char* tracepoint_name, pid_t pid, int32_t cpu);
+                          const char* tracepoint_name, pid_t pid, int32_t cpu,
+                          uint32_t wakeup_watermark_bytes);
 
 }  // namespace LinuxTracing
 
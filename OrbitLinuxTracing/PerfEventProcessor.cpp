@@ -2,25 +2,35 @@
 
 #include <OrbitBase/Logging.h>
 
+#include <algorithm>
+#include <limits>
 #include <queue>
 
 #include "Utils.h"
 
 namespace LinuxTracing {
 
-void PerfEventProcessor::AddEvent(int /*origin_fd*/,
+void PerfEventProcessor::AddEvent(int origin_fd,
                                   std::unique_ptr<PerfEvent> event) {
 #ifndef NDEBUG
-  if (last_processed_timestamp_ > 0 &&
-      event->GetTimestamp() <
-          last_processed_timestamp_ - PROCESSING_DELAY_MS * 1'000'000) {
+  if (event->GetTimestamp() < last_processed_timestamp_) {
     ERROR("Processed an event out of order");
   }
 #endif
+  auto watermark_it = watermarks_.find(origin_fd);
+  if (watermark_it != watermarks_.end()) {
+    watermark_it->second =
+        std::max(watermark_it->second, event->GetTimestamp());
+  }
 
   event_queue_.push(std::move(event));
 }
 
+void PerfEventProcessor::UpdateWatermark(int origin_fd, uint64_t timestamp_ns) {
+  uint64_t& watermark = watermarks_[origin_fd];
+  watermark = std::max(watermark, timestamp_ns);
+}
+
 void PerfEventProcessor::ProcessAllEvents() {
   while (!event_queue_.empty()) {
     PerfEvent* event = event_queue_.top().get();
@@ -36,13 +46,21 @@ void PerfEventProcessor::ProcessAllEvents() {
 
 void PerfEventProcessor::ProcessOldEvents() {
   uint64_t max_timestamp = MonotonicTimestampNs();
+  uint64_t min_watermark = 0;
+  if (!watermarks_.empty()) {
+    min_watermark = std::numeric_limits<uint64_t>::max();
+    for (const auto& fd_watermark : watermarks_) {
+      min_watermark = std::min(min_watermark, fd_watermark.second);
+    }
+  }
 
   while (!event_queue_.empty()) {
     PerfEvent* event = event_queue_.top().get();
 
     // Do not read the most recent events are out-of-order events could arrive.
-    if (event->GetTimestamp() + PROCESSING_DELAY_MS * 1'000'000 >=
-        max_timestamp) {
+    if (event->GetTimestamp() > min_watermark &&
+        event->GetTimestamp() + PROCESSING_DELAY_MS * 1'000'000 >=
+            max_timestamp) {
       break;
     }
     event->Accept(visitor_.get());
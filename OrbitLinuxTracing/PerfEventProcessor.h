@@ -7,6 +7,7 @@
 
 #include "PerfEvent.h"
 #include "PerfEventVisitor.h"
+#include "absl/container/flat_hash_map.h"
 
 namespace LinuxTracing {
 
@@ -24,16 +25,15 @@ class TimestampReverseCompare {
 // perf_event_open records coming from multiple ring buffers, and allows reading
 // them in order (oldest first). In other words, it synchronizes events from all
 // ring buffers according to their timestamps.
-// Its implementation builds on the assumption that we never expect events with
-// a timestamp older than PROCESSING_DELAY_MS to be added. By not processing
-// events that are not older than this delay, we will never process events out
-// of order.
+// As in PerfEventProcessor2, events are processed as soon as they are older
+// than the minimum watermark across all sources registered with
+// UpdateWatermark, and in any case once they are older than
+// PROCESSING_DELAY_MS, as we never expect events with a timestamp older than
+// this delay to be added.
 class PerfEventProcessor {
  public:
-  // Do not process events that are more recent than 0.1 seconds. There could be
-  // events coming out of order as they are read from different perf_event_open
-  // ring buffers and this ensure that all events are processed in the correct
-  // order.
+  // Process events that are older than 0.1 seconds even if they have not been
+  // passed by all watermarks.
   static constexpr uint64_t PROCESSING_DELAY_MS = 100;
 
   explicit PerfEventProcessor(std::unique_ptr<PerfEventVisitor> visitor)
@@ -41,6 +41,10 @@ class PerfEventProcessor {
 
   void AddEvent(int origin_fd, std::unique_ptr<PerfEvent> event);
 
+  // Registers origin_fd as a source of events, if needed, and notifies that no
+  // event older than timestamp_ns will be added from origin_fd anymore.
+  void UpdateWatermark(int origin_fd, uint64_t timestamp_ns);
+
   void ProcessAllEvents();
 
   void ProcessOldEvents();
@@ -58,6 +62,7 @@ class PerfEventProcessor {
       event_queue_;
 
   std::unique_ptr<PerfEventVisitor> visitor_;
+  absl::flat_hash_map<int, uint64_t> watermarks_{};
 
 #ifndef NDEBUG
   uint64_t last_processed_timestamp_ = 0;
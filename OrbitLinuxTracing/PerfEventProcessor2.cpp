@@ -2,72 +2,173 @@
 
 #include <OrbitBase/Logging.h>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
-#include <queue>
+#include <utility>
 
 #include "PerfEvent.h"
 #include "Utils.h"
 
 namespace LinuxTracing {
 
+void PerfEventRingQueue::Push(std::unique_ptr<PerfEvent> event) {
+  if (size_ == events_.size()) {
+    Grow();
+  }
+  // The capacity is always a power of two.
+  events_[(front_index_ + size_) & (events_.size() - 1)] = std::move(event);
+  ++size_;
+}
+
+const std::unique_ptr<PerfEvent>& PerfEventRingQueue::Front() const {
+  CHECK(size_ > 0);
+  return events_[front_index_];
+}
+
+std::unique_ptr<PerfEvent> PerfEventRingQueue::Pop() {
+  CHECK(size_ > 0);
+  std::unique_ptr<PerfEvent> event = std::move(events_[front_index_]);
+  front_index_ = (front_index_ + 1) & (events_.size() - 1);
+  --size_;
+  return event;
+}
+
+void PerfEventRingQueue::Grow() {
+  size_t new_capacity =
+      events_.empty() ? INITIAL_CAPACITY : 2 * events_.size();
+  std::vector<std::unique_ptr<PerfEvent>> new_events(new_capacity);
+  for (size_t i = 0; i < size_; ++i) {
+    new_events[i] =
+        std::move(events_[(front_index_ + i) & (events_.size() - 1)]);
+  }
+  events_ = std::move(new_events);
+  front_index_ = 0;
+}
+
 void PerfEventQueue::PushEvent(int origin_fd,
                                std::unique_ptr<PerfEvent> event) {
-  if (fd_event_queues_.count(origin_fd) > 0) {
-    std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>> event_queue =
-        fd_event_queues_.at(origin_fd);
-    CHECK(!event_queue->empty());
-    // Fundamental assumption: events from the same file descriptor come already
-    // in order.
-    CHECK(event->GetTimestamp() >= event_queue->front()->GetTimestamp());
-    event_queue->push(std::move(event));
+  size_t slot;
+  auto slot_it = fd_slots_.find(origin_fd);
+  if (slot_it != fd_slots_.end()) {
+    slot = slot_it->second;
   } else {
-    auto event_queue =
-        std::make_shared<std::queue<std::unique_ptr<PerfEvent>>>();
-    fd_event_queues_.insert(std::make_pair(origin_fd, event_queue));
-    event_queue->push(std::move(event));
-    event_queues_queue_.push(std::make_pair(origin_fd, event_queue));
+    slot = queues_.size();
+    queues_.emplace_back();
+    heap_positions_.push_back(NOT_IN_HEAP);
+    fd_slots_.emplace(origin_fd, slot);
   }
+
+  PerfEventRingQueue& event_queue = queues_[slot];
+  if (!event_queue.Empty()) {
+    // Fundamental assumption: events from the same file descriptor come already
+    // in order. The front of the queue doesn't change, and neither does the
+    // position of the queue in the heap.
+    CHECK(event->GetTimestamp() >= event_queue.Front()->GetTimestamp());
+    event_queue.Push(std::move(event));
+    return;
+  }
+
+  event_queue.Push(std::move(event));
+  heap_positions_[slot] = heap_.size();
+  heap_.push_back(slot);
+  SiftUp(heap_.size() - 1);
 }
 
-bool PerfEventQueue::HasEvent() { return !event_queues_queue_.empty(); }
+bool PerfEventQueue::HasEvent() const { return !heap_.empty(); }
 
 PerfEvent* PerfEventQueue::TopEvent() {
-  return event_queues_queue_.top().second->front().get();
+  return queues_[heap_.front()].Front().get();
 }
 
 std::unique_ptr<PerfEvent> PerfEventQueue::PopEvent() {
-  std::pair<int, std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>>
-      top_fd_queue = event_queues_queue_.top();
-  event_queues_queue_.pop();
-  const int& top_fd = top_fd_queue.first;
-  std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>& top_queue =
-      top_fd_queue.second;
-
-  std::unique_ptr<PerfEvent> top_event = std::move(top_queue->front());
-  top_queue->pop();
-  if (top_queue->empty()) {
-    fd_event_queues_.erase(top_fd);
+  size_t top_slot = heap_.front();
+  PerfEventRingQueue& top_queue = queues_[top_slot];
+  std::unique_ptr<PerfEvent> top_event = top_queue.Pop();
+
+  if (top_queue.Empty()) {
+    // Remove the queue from the heap by replacing it with the last one.
+    HeapSwap(0, heap_.size() - 1);
+    heap_.pop_back();
+    heap_positions_[top_slot] = NOT_IN_HEAP;
+    if (!heap_.empty()) {
+      SiftDown(0);
+    }
   } else {
-    // Remove and re-insert so that the queue is in the right position in the
-    // heap after the front of the queue has been removed.
-    event_queues_queue_.push(top_fd_queue);
+    // The front of the queue can only have become more recent, so move the
+    // queue down the heap in place.
+    SiftDown(0);
   }
 
   return top_event;
 }
 
+void PerfEventQueue::HeapSwap(size_t heap_index_a, size_t heap_index_b) {
+  std::swap(heap_[heap_index_a], heap_[heap_index_b]);
+  heap_positions_[heap_[heap_index_a]] = heap_index_a;
+  heap_positions_[heap_[heap_index_b]] = heap_index_b;
+}
+
+void PerfEventQueue::SiftUp(size_t heap_index) {
+  while (heap_index > 0) {
+    size_t parent_index = (heap_index - 1) / 2;
+    if (HeapKey(parent_index) <= HeapKey(heap_index)) {
+      break;
+    }
+    HeapSwap(parent_index, heap_index);
+    heap_index = parent_index;
+  }
+}
+
+void PerfEventQueue::SiftDown(size_t heap_index) {
+  while (true) {
+    size_t left_index = 2 * heap_index + 1;
+    if (left_index >= heap_.size()) {
+      break;
+    }
+    size_t min_child_index = left_index;
+    size_t right_index = left_index + 1;
+    if (right_index < heap_.size() &&
+        HeapKey(right_index) < HeapKey(left_index)) {
+      min_child_index = right_index;
+    }
+    if (HeapKey(heap_index) <= HeapKey(min_child_index)) {
+      break;
+    }
+    HeapSwap(heap_index, min_child_index);
+    heap_index = min_child_index;
+  }
+}
+
 void PerfEventProcessor2::AddEvent(int origin_fd,
                                    std::unique_ptr<PerfEvent> event) {
 #ifndef NDEBUG
-  if (last_processed_timestamp_ > 0 &&
-      event->GetTimestamp() <
-          last_processed_timestamp_ - PROCESSING_DELAY_MS * 1'000'000) {
+  if (event->GetTimestamp() < last_processed_timestamp_) {
     ERROR("Processed an event out of order");
   }
 #endif
+  auto watermark_it = watermarks_.find(origin_fd);
+  if (watermark_it != watermarks_.end()) {
+    watermark_it->second =
+        std::max(watermark_it->second, event->GetTimestamp());
+  }
   event_queue_.PushEvent(origin_fd, std::move(event));
 }
 
+void PerfEventProcessor2::UpdateWatermark(int origin_fd,
+                                          uint64_t timestamp_ns) {
+  uint64_t& watermark = watermarks_[origin_fd];
+  watermark = std::max(watermark, timestamp_ns);
+}
+
+uint64_t PerfEventProcessor2::ComputeMinWatermark() const {
+  uint64_t min_watermark = std::numeric_limits<uint64_t>::max();
+  for (const auto& fd_watermark : watermarks_) {
+    min_watermark = std::min(min_watermark, fd_watermark.second);
+  }
+  return min_watermark;
+}
+
 void PerfEventProcessor2::ProcessAllEvents() {
   while (event_queue_.HasEvent()) {
     std::unique_ptr<PerfEvent> event = event_queue_.PopEvent();
@@ -79,22 +180,31 @@ void PerfEventProcessor2::ProcessAllEvents() {
 }
 
 void PerfEventProcessor2::ProcessOldEvents() {
-  uint64_t max_timestamp = MonotonicTimestampNs();
+  uint64_t current_timestamp = MonotonicTimestampNs();
+  uint64_t min_watermark = watermarks_.empty() ? 0 : ComputeMinWatermark();
 
   while (event_queue_.HasEvent()) {
     PerfEvent* event = event_queue_.TopEvent();
+    uint64_t timestamp = event->GetTimestamp();
 
     // Do not read the most recent events as out-of-order events could arrive.
-    if (event->GetTimestamp() + PROCESSING_DELAY_MS * 1'000'000 >=
-        max_timestamp) {
+    if (timestamp > min_watermark &&
+        timestamp + PROCESSING_DELAY_MS * 1'000'000 >= current_timestamp) {
       break;
     }
 
     event->Accept(visitor_.get());
 #ifndef NDEBUG
-    last_processed_timestamp_ = event->GetTimestamp();
+    last_processed_timestamp_ = timestamp;
 #endif
     event_queue_.PopEvent();
+
+    uint64_t processing_delay_ns =
+        current_timestamp > timestamp ? current_timestamp - timestamp : 0;
+    ++processed_event_count_;
+    sum_processing_delay_ns_ += processing_delay_ns;
+    max_processing_delay_ns_ =
+        std::max(max_processing_delay_ns_, processing_delay_ns);
   }
 }
 
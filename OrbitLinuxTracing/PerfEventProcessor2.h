@@ -2,8 +2,9 @@
 #define ORBIT_LINUX_TRACING_PERF_EVENT_PROCESSOR_2_H_
 
 #include <ctime>
+#include <limits>
 #include <memory>
-#include <queue>
+#include <vector>
 
 #include "PerfEvent.h"
 #include "PerfEventVisitor.h"
@@ -11,69 +12,86 @@
 
 namespace LinuxTracing {
 
+// Queue of events coming from the same ring buffer. Events are stored in a
+// circular buffer backed by a contiguous vector, which only grows when it is
+// full. Hence, after the initial growth, neither push nor pop allocate.
+class PerfEventRingQueue {
+ public:
+  bool Empty() const { return size_ == 0; }
+  size_t Size() const { return size_; }
+
+  void Push(std::unique_ptr<PerfEvent> event);
+  const std::unique_ptr<PerfEvent>& Front() const;
+  std::unique_ptr<PerfEvent> Pop();
+
+ private:
+  static constexpr size_t INITIAL_CAPACITY = 64;
+
+  void Grow();
+
+  std::vector<std::unique_ptr<PerfEvent>> events_{};
+  size_t front_index_ = 0;
+  size_t size_ = 0;
+};
+
 // This class implements a data structure that holds a large number of different
 // perf_event_open records coming from multiple ring buffers, and allows reading
 // them in order (oldest first).
 // Instead of keeping a single priority queue with all the events to process,
 // on which push/pop operations would be logarithmic in the number of events,
 // we leverage the fact that events coming from the same perf_event_open ring
-// buffer are already sorted. We then keep a priority queue of queues, where
-// the events in each queue come from the same ring buffer. Whenever an event
-// is removed from a queue, we need to move such queue down the priority
-// queue. As std::priority_queue does not support decreasing the priority of
-// an element, we achieve this by removing and re-inserting.
-// In order to be able to add an event to a queue, we also need to maintain
-// the association between a queue and its ring buffer. We use the file
-// descriptor used to read from the ring buffer as identifier for a ring
-// buffer. Keeping this association is what the pairs and the map are for.
-// TODO: Implement a custom priority queue that supports decreasing the
-//  priority.
+// buffer are already sorted. We then keep one PerfEventRingQueue per ring
+// buffer and an indexed binary min-heap of the non-empty queues, ordered by the
+// timestamp of their front event. As the heap keeps track of the position of
+// each queue in it, the queue at the top can be moved down the heap in place
+// after its front event has been removed, with no removal and re-insertion.
+// We use the file descriptor used to read from the ring buffer as identifier
+// for a ring buffer. Queues of file descriptors that become empty are kept, so
+// that their storage can be reused.
 class PerfEventQueue {
  public:
   void PushEvent(int origin_fd, std::unique_ptr<PerfEvent> event);
-  bool HasEvent();
+  bool HasEvent() const;
   PerfEvent* TopEvent();
   std::unique_ptr<PerfEvent> PopEvent();
 
  private:
-  // Comparator for the priority queue: pop will return the queue associated
-  // with the file descriptor from which the oldest event still to process
-  // originated.
-  struct QueueFrontTimestampReverseCompare {
-    bool operator()(
-        const std::pair<
-            int, std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>>& lhs,
-        const std::pair<
-            int, std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>>&
-            rhs) {
-      return lhs.second->front()->GetTimestamp() >
-             rhs.second->front()->GetTimestamp();
-    }
-  };
-
-  std::priority_queue<
-      std::pair<int, std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>>,
-      std::vector<std::pair<
-          int, std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>>>,
-      QueueFrontTimestampReverseCompare>
-      event_queues_queue_{};
-  absl::flat_hash_map<int,
-                      std::shared_ptr<std::queue<std::unique_ptr<PerfEvent>>>>
-      fd_event_queues_{};
+  static constexpr size_t NOT_IN_HEAP = std::numeric_limits<size_t>::max();
+
+  uint64_t HeapKey(size_t heap_index) const {
+    return queues_[heap_[heap_index]].Front()->GetTimestamp();
+  }
+  void HeapSwap(size_t heap_index_a, size_t heap_index_b);
+  void SiftUp(size_t heap_index);
+  void SiftDown(size_t heap_index);
+
+  // Indexed by the "slot" assigned to each file descriptor.
+  std::vector<PerfEventRingQueue> queues_{};
+  std::vector<size_t> heap_positions_{};
+  absl::flat_hash_map<int, size_t> fd_slots_{};
+  // Slots of the non-empty queues.
+  std::vector<size_t> heap_{};
 };
 
 // This class receives perf_event_open events coming from several ring buffers
 // and processes them in order according to their timestamps.
-// Its implementation builds on the assumption that we never expect events with
-// a timestamp older than PROCESSING_DELAY_MS to be added. By not processing
-// events that are not older than this delay, we will never process events out
-// of order.
+// Each source of events (identified by the file descriptor of its ring buffer)
+// can be registered with UpdateWatermark. For every registered source, the
+// processor keeps a low watermark: a timestamp such that no event older than
+// it will still be added from that source. As events from the same ring buffer
+// are sorted, adding an event advances the watermark of its source to the
+// timestamp of the event. The reader of the ring buffer can also advance it
+// when it observes the ring buffer empty. Events are processed as soon as they
+// are older than the minimum watermark across all registered sources.
+// In any case, we never expect events with a timestamp older than
+// PROCESSING_DELAY_MS to be added, so events older than this delay are
+// processed even if some watermark is lagging behind (or if no source has been
+// registered).
 class PerfEventProcessor2 {
  public:
-  // Do not process events that are more recent than 0.1 seconds. There could be
-  // events coming out of order as they are read from different perf_event_open
-  // ring buffers and this ensure that all events are processed in the correct
-  // order.
+  // Process events that are older than 0.1 seconds even if they have not been
+  // passed by all watermarks. This bounds the latency introduced by a source
+  // whose watermark is not updated.
   static constexpr uint64_t PROCESSING_DELAY_MS = 100;
 
   explicit PerfEventProcessor2(std::unique_ptr<PerfEventVisitor> visitor)
@@ -81,13 +99,41 @@ class PerfEventProcessor2 {
 
   void AddEvent(int origin_fd, std::unique_ptr<PerfEvent> event);
 
+  // Registers origin_fd as a source of events, if needed, and notifies that no
+  // event older than timestamp_ns will be added from origin_fd anymore.
+  void UpdateWatermark(int origin_fd, uint64_t timestamp_ns);
+
   void ProcessAllEvents();
 
   void ProcessOldEvents();
 
+  // Time between the timestamp of the events and their processing, since the
+  // last call to ResetProcessingDelayStats. Events processed by
+  // ProcessAllEvents are not considered.
+  uint64_t GetProcessedEventCount() const { return processed_event_count_; }
+  uint64_t GetMaxProcessingDelayNs() const { return max_processing_delay_ns_; }
+  double GetAverageProcessingDelayNs() const {
+    return processed_event_count_ == 0
+               ? 0.0
+               : static_cast<double>(sum_processing_delay_ns_) /
+                     processed_event_count_;
+  }
+  void ResetProcessingDelayStats() {
+    processed_event_count_ = 0;
+    sum_processing_delay_ns_ = 0;
+    max_processing_delay_ns_ = 0;
+  }
+
  private:
+  uint64_t ComputeMinWatermark() const;
+
   PerfEventQueue event_queue_;
   std::unique_ptr<PerfEventVisitor> visitor_;
+  absl::flat_hash_map<int, uint64_t> watermarks_{};
+
+  uint64_t processed_event_count_ = 0;
+  uint64_t sum_processing_delay_ns_ = 0;
+  uint64_t max_processing_delay_ns_ = 0;
 
 #ifndef NDEBUG
   uint64_t last_processed_timestamp_ = 0;
@@ -1,25 +1,41 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+
 #include "PerfEventProcessor2.h"
+#include "Utils.h"
 
 namespace LinuxTracing {
 
 namespace {
 class TestEvent : public PerfEvent {
  public:
-  explicit TestEvent(uint64_t timestamp) : timestamp_(timestamp) {}
+  explicit TestEvent(uint64_t timestamp,
+                     std::vector<uint64_t>* processed_timestamps = nullptr)
+      : timestamp_(timestamp), processed_timestamps_(processed_timestamps) {}
 
   uint64_t GetTimestamp() const override { return timestamp_; }
 
-  void Accept(PerfEventVisitor* visitor) override {}
+  void Accept(PerfEventVisitor* visitor) override {
+    if (processed_timestamps_ != nullptr) {
+      processed_timestamps_->push_back(timestamp_);
+    }
+  }
 
  private:
   uint64_t timestamp_;
+  std::vector<uint64_t>* processed_timestamps_;
 };
 
 std::unique_ptr<PerfEvent> MakeTestEvent(uint64_t timestamp) {
   return std::make_unique<TestEvent>(timestamp);
 }
+
+std::unique_ptr<PerfEvent> MakeRecordingTestEvent(
+    uint64_t timestamp, std::vector<uint64_t>* processed_timestamps) {
+  return std::make_unique<TestEvent>(timestamp, processed_timestamps);
+}
 }  // namespace
 
 TEST(PerfEventQueue, SingleFd) {
@@ -106,4 +122,121 @@ TEST(PerfEventQueue, MultipleFd) {
   EXPECT_FALSE(event_queue.HasEvent());
 }
 
+TEST(PerfEventRingQueue, PushAndPopAcrossGrowth) {
+  PerfEventRingQueue ring_queue;
+  EXPECT_TRUE(ring_queue.Empty());
+
+  // Interleave pushes and pops so that the content wraps around the circular
+  // buffer before it needs to grow.
+  uint64_t next_pushed = 0;
+  uint64_t next_popped = 0;
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < 50; ++i) {
+      ring_queue.Push(MakeTestEvent(next_pushed++));
+    }
+    for (int i = 0; i < 30; ++i) {
+      EXPECT_EQ(ring_queue.Front()->GetTimestamp(), next_popped);
+      EXPECT_EQ(ring_queue.Pop()->GetTimestamp(), next_popped);
+      ++next_popped;
+    }
+    EXPECT_EQ(ring_queue.Size(), next_pushed - next_popped);
+  }
+
+  while (!ring_queue.Empty()) {
+    EXPECT_EQ(ring_queue.Pop()->GetTimestamp(), next_popped);
+    ++next_popped;
+  }
+  EXPECT_EQ(next_popped, next_pushed);
+}
+
+TEST(PerfEventQueue, ManyFds) {
+  for (int fd_count : {8, 64, 256}) {
+    PerfEventQueue event_queue;
+    std::mt19937 rng{static_cast<uint32_t>(fd_count)};
+    std::uniform_int_distribution<uint64_t> increment_distribution{0, 1000};
+    std::uniform_int_distribution<int> fd_distribution{0, fd_count - 1};
+
+    std::vector<uint64_t> last_timestamp_per_fd(fd_count, 0);
+    std::vector<uint64_t> pushed_timestamps;
+    uint64_t last_popped_timestamp = 0;
+    size_t popped_count = 0;
+
+    for (int i = 0; i < 100 * fd_count; ++i) {
+      int fd = fd_distribution(rng);
+      // Only push to a fd events that are not older than the last popped event,
+      // as it happens in PerfEventProcessor2 thanks to the processing delay.
+      uint64_t timestamp =
+          std::max(last_timestamp_per_fd[fd], last_popped_timestamp) +
+          increment_distribution(rng);
+      last_timestamp_per_fd[fd] = timestamp;
+      event_queue.PushEvent(fd, MakeTestEvent(timestamp));
+      pushed_timestamps.push_back(timestamp);
+
+      if (i % 3 == 0) {
+        ASSERT_TRUE(event_queue.HasEvent());
+        uint64_t timestamp = event_queue.PopEvent()->GetTimestamp();
+        EXPECT_GE(timestamp, last_popped_timestamp);
+        last_popped_timestamp = timestamp;
+        ++popped_count;
+      }
+    }
+
+    while (event_queue.HasEvent()) {
+      uint64_t timestamp = event_queue.TopEvent()->GetTimestamp();
+      EXPECT_EQ(event_queue.PopEvent()->GetTimestamp(), timestamp);
+      EXPECT_GE(timestamp, last_popped_timestamp);
+      last_popped_timestamp = timestamp;
+      ++popped_count;
+    }
+    EXPECT_EQ(popped_count, pushed_timestamps.size());
+  }
+}
+
+TEST(PerfEventProcessor2, ProcessesEventsPassedByAllWatermarks) {
+  PerfEventProcessor2 processor{std::make_unique<PerfEventVisitor>()};
+  std::vector<uint64_t> processed;
+
+  // Far enough in the future that PROCESSING_DELAY_MS never applies.
+  const uint64_t base = MonotonicTimestampNs() + 3'600'000'000'000;
+  processor.UpdateWatermark(11, 0);
+  processor.UpdateWatermark(22, 0);
+
+  processor.AddEvent(11, MakeRecordingTestEvent(base + 1, &processed));
+  processor.AddEvent(11, MakeRecordingTestEvent(base + 3, &processed));
+  processor.ProcessOldEvents();
+  EXPECT_TRUE(processed.empty());
+
+  processor.AddEvent(22, MakeRecordingTestEvent(base + 2, &processed));
+  processor.ProcessOldEvents();
+  EXPECT_EQ(processed, (std::vector<uint64_t>{base + 1, base + 2}));
+
+  processor.UpdateWatermark(22, base + 5);
+  processor.ProcessOldEvents();
+  EXPECT_EQ(processed, (std::vector<uint64_t>{base + 1, base + 2, base + 3}));
+
+  processor.AddEvent(22, MakeRecordingTestEvent(base + 6, &processed));
+  processor.ProcessOldEvents();
+  EXPECT_EQ(processed.size(), 3);
+
+  processor.ProcessAllEvents();
+  EXPECT_EQ(processed,
+            (std::vector<uint64_t>{base + 1, base + 2, base + 3, base + 6}));
+}
+
+TEST(PerfEventProcessor2, FallsBackToProcessingDelay) {
+  PerfEventProcessor2 processor{std::make_unique<PerfEventVisitor>()};
+  std::vector<uint64_t> processed;
+
+  const uint64_t now = MonotonicTimestampNs();
+  const uint64_t old_timestamp =
+      now - 2 * PerfEventProcessor2::PROCESSING_DELAY_MS * 1'000'000;
+  const uint64_t recent_timestamp = now + 3'600'000'000'000;
+  processor.UpdateWatermark(11, 0);
+
+  processor.AddEvent(22, MakeRecordingTestEvent(old_timestamp, &processed));
+  processor.AddEvent(22, MakeRecordingTestEvent(recent_timestamp, &processed));
+  processor.ProcessOldEvents();
+  EXPECT_EQ(processed, std::vector<uint64_t>{old_timestamp});
+}
+
 }  // namespace LinuxTracing
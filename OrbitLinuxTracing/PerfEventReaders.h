@@ -21,10 +21,16 @@ template <typename SamplePerfEventT>
 inline std::unique_ptr<SamplePerfEventT> ConsumeSamplePerfEvent(
     PerfEventRingBuffer* ring_buffer, const perf_event_header& header) {
   // Data in the ring buffer has the layout of perf_event_stack_sample, but we
-  // copy it into dynamically_sized_perf_event_stack_sample.
-  uint64_t dyn_size;
-  ring_buffer->ReadValueAtOffset(
-      &dyn_size, offsetof(perf_event_stack_sample, stack.dyn_size));
+  // copy it into dynamically_sized_perf_event_stack_sample. As the stack dump
+  // size is configurable, the offset of stack.dyn_size depends on stack.size.
+  uint64_t stack_size;
+  ring_buffer->ReadValueAtOffset(&stack_size,
+                                 offsetof(perf_event_stack_sample, stack.size));
+  uint64_t dyn_size = 0;
+  if (stack_size != 0) {
+    ring_buffer->ReadValueAtOffset(
+        &dyn_size, offsetof(perf_event_stack_sample, stack.data) + stack_size);
+  }
   auto event = std::make_unique<SamplePerfEventT>(dyn_size);
   event->ring_buffer_record->header = header;
   ring_buffer->ReadValueAtOffset(&event->ring_buffer_record->sample_id,
@@ -61,6 +61,9 @@ struct __attribute__((__packed__)) perf_event_sample_regs_user_all {
   uint64_t r15;
 };
 
+// The actual length of data is the stack dump size passed to perf_event_open
+// in perf_event_attr::sample_stack_user (at most SAMPLE_STACK_USER_SIZE), and
+// it can be read from size: dyn_size follows data immediately.
 struct __attribute__((__packed__)) perf_event_sample_stack_user {
   uint64_t size;                     /* if PERF_SAMPLE_STACK_USER */
   char data[SAMPLE_STACK_USER_SIZE]; /* if PERF_SAMPLE_STACK_USER */
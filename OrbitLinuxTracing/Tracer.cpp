@@ -24,12 +24,22 @@ void Tracer::Run(pid_t pid, uint64_t sampling_period_ns,
                  const std::vector<Function>& instrumented_functions,
                  TracerListener* listener, bool trace_context_switches,
                  bool trace_callstacks, bool trace_instrumented_functions,
+                 bool use_event_driven_wakeup,
+                 const WakeupWatermarks& wakeup_watermarks,
+                 uint32_t num_reader_threads,
+                 const StackDumpOptions& stack_dump_options,
+                 bool use_frame_pointer_unwinding,
                  const std::shared_ptr<std::atomic<bool>>& exit_requested) {
   TracerThread session{pid, sampling_period_ns, instrumented_functions};
   session.SetListener(listener);
   session.SetTraceContextSwitches(trace_context_switches);
   session.SetTraceCallstacks(trace_callstacks);
   session.SetTraceInstrumentedFunctions(trace_instrumented_functions);
+  session.SetUseEventDrivenWakeup(use_event_driven_wakeup);
+  session.SetWakeupWatermarks(wakeup_watermarks);
+  session.SetNumReaderThreads(num_reader_threads);
+  session.SetStackDumpOptions(stack_dump_options);
+  session.SetUseFramePointerUnwinding(use_frame_pointer_unwinding);
   session.Run(exit_requested);
 }
 
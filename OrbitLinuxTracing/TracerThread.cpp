@@ -1,10 +1,17 @@
 #include "TracerThread.h"
 
 #include <OrbitBase/Logging.h>
+#include <OrbitBase/SafeStrerror.h>
 #include <OrbitBase/Tracing.h>
 
+#include <algorithm>
+#include <iterator>
 #include <thread>
 
+#include "FramePointerUnwinder.h"
+#include "LibunwindstackUnwinder.h"
+#include "MakeUniqueForOverwrite.h"
+#include "PerfEventAllocator.h"
 #include "UprobesUnwindingVisitor.h"
 #include "absl/strings/str_format.h"
 
@@ -18,13 +25,28 @@ void CloseFileDescriptors(const std::vector<int>& fds) {
   }
 }
 
+template <typename UnwinderT>
+std::unique_ptr<PerfEventVisitor> CreateUprobesUnwindingVisitor(
+    const std::string& initial_maps, TracerListener* listener,
+    bool trim_uprobes_stacks, const ElfCache** elf_cache) {
+  auto uprobes_unwinding_visitor =
+      std::make_unique<UprobesUnwindingVisitor<UnwinderT>>(initial_maps);
+  uprobes_unwinding_visitor->SetListener(listener);
+  uprobes_unwinding_visitor->SetTrimUprobesStacks(trim_uprobes_stacks);
+  *elf_cache = &uprobes_unwinding_visitor->GetElfCache();
+  return uprobes_unwinding_visitor;
+}
+
 }  // namespace
 
 bool TracerThread::OpenRingBufferForGpuTracepoint(
     const char* tracepoint_category, const char* tracepoint_name, int32_t cpu,
     std::vector<int>* gpu_tracing_fds,
     std::vector<PerfEventRingBuffer>* ring_buffers) {
-  int fd = tracepoint_event_open(tracepoint_category, tracepoint_name, -1, cpu);
+  int fd = tracepoint_event_open(
+      tracepoint_category, tracepoint_name, -1, cpu,
+      ComputeWakeupWatermark(wakeup_watermarks_.gpu_tracing_bytes,
+                             GPU_TRACING_RING_BUFFER_SIZE_KB));
   if (fd == -1) {
     return false;
   }
@@ -38,6 +60,7 @@ bool TracerThread::OpenRingBufferForGpuTracepoint(
     return false;
   }
   ring_buffers->push_back(std::move(ring_buffer));
+  ring_buffer_fds_to_cpu_[fd] = cpu;
 
   return true;
 }
@@ -138,22 +161,35 @@ void TracerThread::Run(
 
   if (trace_context_switches_) {
     for (int32_t cpu : all_cpus) {
-      int context_switch_fd = context_switch_event_open(-1, cpu);
+      int context_switch_fd = context_switch_event_open(
+          -1, cpu,
+          ComputeWakeupWatermark(wakeup_watermarks_.context_switch_bytes,
+                                 CONTEXT_SWITCHES_RING_BUFFER_SIZE_KB));
       std::string buffer_name = absl::StrFormat("context_switch_%u", cpu);
       PerfEventRingBuffer context_switch_ring_buffer{
           context_switch_fd, CONTEXT_SWITCHES_RING_BUFFER_SIZE_KB, buffer_name};
       if (context_switch_ring_buffer.IsOpen()) {
         tracing_fds_.push_back(context_switch_fd);
         ring_buffers_.push_back(std::move(context_switch_ring_buffer));
+        ring_buffer_fds_to_cpu_[context_switch_fd] = cpu;
       } else {
         perf_event_open_errors = true;
       }
     }
   }
 
-  auto uprobes_unwinding_visitor =
-      std::make_unique<UprobesUnwindingVisitor>(ReadMaps(pid_));
-  uprobes_unwinding_visitor->SetListener(listener_);
+  std::unique_ptr<PerfEventVisitor> uprobes_unwinding_visitor;
+  if (use_frame_pointer_unwinding_) {
+    uprobes_unwinding_visitor =
+        CreateUprobesUnwindingVisitor<FramePointerUnwinder>(
+            ReadMaps(pid_), listener_, stack_dump_options_.trim_uprobes_stacks,
+            &elf_cache_);
+  } else {
+    uprobes_unwinding_visitor =
+        CreateUprobesUnwindingVisitor<LibunwindstackUnwinder>(
+            ReadMaps(pid_), listener_, stack_dump_options_.trim_uprobes_stacks,
+            &elf_cache_);
+  }
   // Switch between PerfEventProcessor and PerfEventProcessor2 here.
   // PerfEventProcessor2 is supposedly faster but assumes that events from the
   // same perf_event_open ring buffer are already sorted.
@@ -173,8 +209,13 @@ void TracerThread::Run(
       bool function_uprobes_open_error = false;
 
       for (int32_t cpu : cpuset_cpus) {
+        // Only the watermark of the file descriptor owning the ring buffer is
+        // relevant, but we don't know yet which one that will be.
         int uprobes_fd = uprobes_stack_event_open(
-            function.BinaryPath().c_str(), function.FileOffset(), -1, cpu);
+            function.BinaryPath().c_str(), function.FileOffset(), -1, cpu,
+            ComputeStackDumpSize(stack_dump_options_.uprobes_bytes),
+            ComputeWakeupWatermark(wakeup_watermarks_.uprobes_bytes,
+                                   UPROBES_RING_BUFFER_SIZE_KB));
         if (uprobes_fd < 0) {
           function_uprobes_open_error = true;
           break;
@@ -247,7 +288,9 @@ void TracerThread::Run(
           ring_buffers_.emplace_back(ring_buffer_fd,
                                      UPROBES_RING_BUFFER_SIZE_KB, buffer_name);
           uprobes_ring_buffer_fds_per_cpu[cpu] = ring_buffer_fd;
+          ring_buffer_fds_to_cpu_[ring_buffer_fd] = cpu;
           uprobes_fds_.emplace(ring_buffer_fd);
+          deferred_events_fds_.emplace(ring_buffer_fd);
           // Must be called after the ring buffer has been opened.
           perf_event_redirect(uretprobes_fd, ring_buffer_fd);
         }
@@ -256,13 +299,18 @@ void TracerThread::Run(
   }
 
   for (int32_t cpu : cpuset_cpus) {
-    int mmap_task_fd = mmap_task_event_open(-1, cpu);
+    int mmap_task_fd = mmap_task_event_open(
+        -1, cpu,
+        ComputeWakeupWatermark(wakeup_watermarks_.mmap_task_bytes,
+                               MMAP_TASK_RING_BUFFER_SIZE_KB));
     std::string buffer_name = absl::StrFormat("mmap_task_%u", cpu);
     PerfEventRingBuffer mmap_task_ring_buffer{
         mmap_task_fd, MMAP_TASK_RING_BUFFER_SIZE_KB, buffer_name};
     if (mmap_task_ring_buffer.IsOpen()) {
       tracing_fds_.push_back(mmap_task_fd);
       ring_buffers_.push_back(std::move(mmap_task_ring_buffer));
+      ring_buffer_fds_to_cpu_[mmap_task_fd] = cpu;
+      deferred_events_fds_.emplace(mmap_task_fd);
     } else {
       perf_event_open_errors = true;
     }
@@ -270,13 +318,19 @@ void TracerThread::Run(
 
   if (trace_callstacks_) {
     for (int32_t cpu : cpuset_cpus) {
-      int sampling_fd = sample_event_open(sampling_period_ns_, -1, cpu);
+      int sampling_fd = sample_event_open(
+          sampling_period_ns_, -1, cpu,
+          ComputeStackDumpSize(stack_dump_options_.sampling_bytes),
+          ComputeWakeupWatermark(wakeup_watermarks_.sampling_bytes,
+                                 SAMPLING_RING_BUFFER_SIZE_KB));
       std::string buffer_name = absl::StrFormat("sampling_%u", cpu);
       PerfEventRingBuffer sampling_ring_buffer{
           sampling_fd, SAMPLING_RING_BUFFER_SIZE_KB, buffer_name};
       if (sampling_ring_buffer.IsOpen()) {
         tracing_fds_.push_back(sampling_fd);
         ring_buffers_.push_back(std::move(sampling_ring_buffer));
+        ring_buffer_fds_to_cpu_[sampling_fd] = cpu;
+        deferred_events_fds_.emplace(sampling_fd);
       } else {
         perf_event_open_errors = true;
       }
@@ -301,6 +355,16 @@ void TracerThread::Run(
         "or to set /proc/sys/kernel/perf_event_paranoid to -1?");
   }
 
+  CreateReaderShards();
+  if (use_event_driven_wakeup_) {
+    for (auto& shard : reader_shards_) {
+      if (!RegisterRingBuffersWithEpoll(shard.get())) {
+        ERROR("Could not set up epoll, falling back to polling the ring "
+              "buffers");
+      }
+    }
+  }
+
   // Start recording events.
   for (int fd : tracing_fds_) {
     perf_event_enable(fd);
@@ -311,23 +375,79 @@ void TracerThread::Run(
     listener_->OnTid(tid);
   }
 
-  stats_.Reset();
+  // Events from these ring buffers can only be processed once their watermark
+  // has passed them, or after PerfEventProcessor2::PROCESSING_DELAY_MS.
+  for (int fd : deferred_events_fds_) {
+    uprobes_event_processor_->UpdateWatermark(fd, 0);
+  }
 
-  bool last_iteration_saw_events = false;
   std::thread deferred_events_thread(&TracerThread::ProcessDeferredEvents,
                                      this);
 
+  // The first shard is read by this thread, the other ones by additional
+  // reader threads.
+  std::vector<std::thread> reader_threads;
+  for (size_t i = 1; i < reader_shards_.size(); ++i) {
+    reader_threads.emplace_back(&TracerThread::ReadRingBuffers, this,
+                                reader_shards_[i].get(),
+                                std::cref(exit_requested));
+  }
+  ReadRingBuffers(reader_shards_[0].get(), exit_requested);
+  for (std::thread& reader_thread : reader_threads) {
+    reader_thread.join();
+  }
+
+  // Finish processing all deferred events.
+  stop_deferred_thread_ = true;
+  deferred_events_thread.join();
+  uprobes_event_processor_->ProcessAllEvents();
+
+  // Stop recording.
+  for (int fd : tracing_fds_) {
+    perf_event_disable(fd);
+  }
+
+  for (auto& shard : reader_shards_) {
+    if (shard->epoll_fd != -1) {
+      close(shard->epoll_fd);
+      shard->epoll_fd = -1;
+    }
+  }
+
+  // Close the ring buffers.
+  ring_buffers_.clear();
+
+  // Close the file descriptors.
+  for (int fd : tracing_fds_) {
+    close(fd);
+  }
+
+  PerfEventAllocator::ReleaseCachedMemory();
+}
+
+void TracerThread::ReadRingBuffers(
+    ReaderShard* shard,
+    const std::shared_ptr<std::atomic<bool>>& exit_requested) {
+  shard->stats.Reset();
+  bool last_iteration_saw_events = false;
+
   while (!(*exit_requested)) {
     ORBIT_SCOPE("Tracer Iteration");
 
     if (!last_iteration_saw_events) {
       // Periodically print event statistics.
-      PrintStatsIfTimerElapsed();
+      PrintStatsIfTimerElapsed(shard);
 
-      // Sleep if there was no new event in the last iteration so that we are
-      // not constantly polling. Don't sleep so long that ring buffers overflow.
-      // TODO: Refine this sleeping pattern, possibly using exponential backoff.
-      {
+      if (shard->epoll_fd != -1) {
+        // Block until at least one ring buffer has reached its watermark.
+        ORBIT_SCOPE("Wait");
+        WaitForNewData(shard);
+      } else {
+        // Sleep if there was no new event in the last iteration so that we are
+        // not constantly polling. Don't sleep so long that ring buffers
+        // overflow.
+        // TODO: Refine this sleeping pattern, possibly using exponential
+        //  backoff.
         ORBIT_SCOPE("Sleep");
         usleep(IDLE_TIME_ON_EMPTY_RING_BUFFERS_US);
       }
@@ -338,10 +458,12 @@ void TracerThread::Run(
     // Read and process events from all ring buffers. In order to ensure that no
     // buffer is read constantly while others overflow, we schedule the reading
     // using round-robin like scheduling.
-    for (PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    for (size_t ring_buffer_index = 0;
+         ring_buffer_index < shard->ring_buffers.size(); ++ring_buffer_index) {
       if (*exit_requested) {
         break;
       }
+      PerfEventRingBuffer* ring_buffer = shard->ring_buffers[ring_buffer_index];
 
       // Read up to ROUND_ROBIN_POLLING_BATCH_SIZE (5) new events.
       // TODO: Some event types (e.g., stack samples) have a much longer
@@ -353,13 +475,20 @@ void TracerThread::Run(
         if (*exit_requested) {
           break;
         }
-        if (!ring_buffer.HasNewData()) {
+        if (!ring_buffer->HasNewData()) {
+          if (shard->ring_buffers_defer_events[ring_buffer_index]) {
+            // Release: the events deferred from this ring buffer so far must
+            // be visible to whoever observes this timestamp.
+            shard->ring_buffers_empty_timestamps_ns[ring_buffer_index].store(
+                MonotonicTimestampNs() - EMPTY_RING_BUFFER_WATERMARK_MARGIN_NS,
+                std::memory_order_release);
+          }
           break;
         }
 
         last_iteration_saw_events = true;
         perf_event_header header;
-        ring_buffer.ReadHeader(&header);
+        ring_buffer->ReadHeader(&header);
 
         // perf_event_header::type contains the type of record, e.g.,
         // PERF_RECORD_SAMPLE, PERF_RECORD_MMAP, etc., defined in enum
@@ -371,90 +500,183 @@ void TracerThread::Run(
             ERROR(
                 "Unexpected PERF_RECORD_SWITCH (only "
                 "PERF_RECORD_SWITCH_CPU_WIDE are expected)");
-            ProcessContextSwitchEvent(header, &ring_buffer);
+            ProcessContextSwitchEvent(header, ring_buffer, shard);
             break;
           case PERF_RECORD_SWITCH_CPU_WIDE:
-            ProcessContextSwitchCpuWideEvent(header, &ring_buffer);
+            ProcessContextSwitchCpuWideEvent(header, ring_buffer, shard);
             break;
           case PERF_RECORD_FORK:
-            ProcessForkEvent(header, &ring_buffer);
+            ProcessForkEvent(header, ring_buffer, shard);
             break;
           case PERF_RECORD_EXIT:
-            ProcessExitEvent(header, &ring_buffer);
+            ProcessExitEvent(header, ring_buffer, shard);
             break;
           case PERF_RECORD_MMAP:
-            ProcessMmapEvent(header, &ring_buffer);
+            ProcessMmapEvent(header, ring_buffer, shard);
             break;
           case PERF_RECORD_SAMPLE:
-            ProcessSampleEvent(header, &ring_buffer);
+            ProcessSampleEvent(header, ring_buffer, shard);
             break;
           case PERF_RECORD_LOST:
-            ProcessLostEvent(header, &ring_buffer);
+            ProcessLostEvent(header, ring_buffer, shard);
             break;
           default:
             ERROR("Unexpected perf_event_header::type: %u", header.type);
-            ring_buffer.SkipRecord(header);
+            ring_buffer->SkipRecord(header);
             break;
         }
       }
     }
   }
+}
 
-  // Finish processing all deferred events.
-  stop_deferred_thread_ = true;
-  deferred_events_thread.join();
-  uprobes_event_processor_->ProcessAllEvents();
+uint32_t TracerThread::ComputeWakeupWatermark(
+    uint32_t watermark_bytes, uint64_t ring_buffer_size_kb) const {
+  if (!use_event_driven_wakeup_) {
+    return 0;
+  }
+  // Make sure we are woken up well before the ring buffer is full.
+  uint64_t max_watermark_bytes = ring_buffer_size_kb * 1024 / 2;
+  return static_cast<uint32_t>(
+      std::max<uint64_t>(1, std::min<uint64_t>(watermark_bytes,
+                                                max_watermark_bytes)));
+}
 
-  // Stop recording.
-  for (int fd : tracing_fds_) {
-    perf_event_disable(fd);
+uint16_t TracerThread::ComputeStackDumpSize(uint16_t stack_dump_bytes) {
+  return std::min(stack_dump_bytes, SAMPLE_STACK_USER_SIZE) &
+         ~static_cast<uint16_t>(7);
+}
+
+void TracerThread::CreateReaderShards() {
+  int32_t num_cores = GetNumCores();
+  uint32_t num_shards = std::min<uint32_t>(
+      num_reader_threads_, static_cast<uint32_t>(std::max(1, num_cores)));
+  for (uint32_t i = 0; i < num_shards; ++i) {
+    auto shard = std::make_unique<ReaderShard>();
+    shard->index = i;
+    reader_shards_.push_back(std::move(shard));
+  }
+
+  // Assign contiguous ranges of cpus to the same shard, as neighboring cpus are
+  // more likely to share caches and to be on the same NUMA node.
+  for (PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    int32_t cpu = 0;
+    auto cpu_it = ring_buffer_fds_to_cpu_.find(ring_buffer.GetFileDescriptor());
+    if (cpu_it != ring_buffer_fds_to_cpu_.end()) {
+      cpu = cpu_it->second;
+    }
+    uint32_t shard_index =
+        static_cast<uint32_t>(std::clamp(cpu, 0, num_cores - 1)) * num_shards /
+        static_cast<uint32_t>(num_cores);
+    reader_shards_[shard_index]->ring_buffers.push_back(&ring_buffer);
+  }
+
+  for (auto& shard : reader_shards_) {
+    size_t ring_buffer_count = shard->ring_buffers.size();
+    shard->ring_buffers_empty_timestamps_ns =
+        std::make_unique<std::atomic<uint64_t>[]>(ring_buffer_count);
+    for (size_t i = 0; i < ring_buffer_count; ++i) {
+      shard->ring_buffers_defer_events.push_back(deferred_events_fds_.contains(
+          shard->ring_buffers[i]->GetFileDescriptor()));
+      shard->ring_buffers_empty_timestamps_ns[i] = 0;
+    }
   }
+}
 
-  // Close the ring buffers.
-  ring_buffers_.clear();
+std::unique_lock<std::mutex> TracerThread::LockReaderListener() {
+  if (reader_shards_.size() <= 1) {
+    return std::unique_lock<std::mutex>(reader_listener_mutex_,
+                                        std::defer_lock);
+  }
+  return std::unique_lock<std::mutex>(reader_listener_mutex_);
+}
 
-  // Close the file descriptors.
-  for (int fd : tracing_fds_) {
-    close(fd);
+bool TracerThread::RegisterRingBuffersWithEpoll(ReaderShard* shard) {
+  shard->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (shard->epoll_fd == -1) {
+    ERROR("epoll_create1: %s", SafeStrerror(errno));
+    return false;
+  }
+
+  for (size_t i = 0; i < shard->ring_buffers.size(); ++i) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = i;
+    if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD,
+                  shard->ring_buffers[i]->GetFileDescriptor(), &event) != 0) {
+      ERROR("epoll_ctl: %s", SafeStrerror(errno));
+      close(shard->epoll_fd);
+      shard->epoll_fd = -1;
+      return false;
+    }
+  }
+
+  shard->epoll_events.resize(std::max<size_t>(1, shard->ring_buffers.size()));
+  return true;
+}
+
+void TracerThread::WaitForNewData(ReaderShard* shard) {
+  // We don't need to know which ring buffers are ready, as the caller checks
+  // all of them for new data in round-robin. Note that reading from a
+  // perf_event_open file descriptor with poll/epoll also resets its wakeup
+  // state, so the next call blocks until a new watermark is reached.
+  int ready_count = epoll_wait(shard->epoll_fd, shard->epoll_events.data(),
+                               static_cast<int>(shard->epoll_events.size()),
+                               EPOLL_WAIT_TIMEOUT_MS);
+  if (ready_count == -1 && errno != EINTR) {
+    ERROR("epoll_wait: %s", SafeStrerror(errno));
+    // Don't spin on a persistent error.
+    usleep(IDLE_TIME_ON_EMPTY_RING_BUFFERS_US);
+  } else if (ready_count > 0) {
+    ++shard->stats.wakeup_count;
   }
 }
 
 void TracerThread::ProcessContextSwitchEvent(const perf_event_header& header,
-                                             PerfEventRingBuffer* ring_buffer) {
+                                             PerfEventRingBuffer* ring_buffer,
+                                             ReaderShard* shard) {
   ContextSwitchPerfEvent event;
   ring_buffer->ConsumeRecord(header, &event.ring_buffer_record);
   pid_t tid = event.GetTid();
   uint16_t cpu = static_cast<uint16_t>(event.GetCpu());
   uint64_t time = event.GetTimestamp();
 
-  if (event.IsSwitchOut()) {
-    listener_->OnContextSwitchOut(ContextSwitchOut(tid, cpu, time));
-  } else {
-    listener_->OnContextSwitchIn(ContextSwitchIn(tid, cpu, time));
+  {
+    std::unique_lock<std::mutex> lock = LockReaderListener();
+    if (event.IsSwitchOut()) {
+      listener_->OnContextSwitchOut(ContextSwitchOut(tid, cpu, time));
+    } else {
+      listener_->OnContextSwitchIn(ContextSwitchIn(tid, cpu, time));
+    }
   }
 
-  ++stats_.sched_switch_count;
+  ++shard->stats.sched_switch_count;
 }
 
 void TracerThread::ProcessContextSwitchCpuWideEvent(
-    const perf_event_header& header, PerfEventRingBuffer* ring_buffer) {
+    const perf_event_header& header, PerfEventRingBuffer* ring_buffer,
+    ReaderShard* shard) {
   SystemWideContextSwitchPerfEvent event;
   ring_buffer->ConsumeRecord(header, &event.ring_buffer_record);
   pid_t tid = event.GetTid();
   uint16_t cpu = static_cast<uint16_t>(event.GetCpu());
   uint64_t time = event.GetTimestamp();
-  
-  if (event.IsSwitchOut()) {
-    listener_->OnContextSwitchOut(ContextSwitchOut(tid, cpu, time));
-  } else {
-    listener_->OnContextSwitchIn(ContextSwitchIn(tid, cpu, time));
+
+  {
+    std::unique_lock<std::mutex> lock = LockReaderListener();
+    if (event.IsSwitchOut()) {
+      listener_->OnContextSwitchOut(ContextSwitchOut(tid, cpu, time));
+    } else {
+      listener_->OnContextSwitchIn(ContextSwitchIn(tid, cpu, time));
+    }
   }
 
-  ++stats_.sched_switch_count;
+  ++shard->stats.sched_switch_count;
 }
 
 void TracerThread::ProcessForkEvent(const perf_event_header& header,
-                                    PerfEventRingBuffer* ring_buffer) {
+                                    PerfEventRingBuffer* ring_buffer,
+                                    ReaderShard* /*shard*/) {
   ForkPerfEvent event;
   ring_buffer->ConsumeRecord(header, &event.ring_buffer_record);
 
@@ -463,11 +685,13 @@ void TracerThread::ProcessForkEvent(const perf_event_header& header,
   }
 
   // A new thread of the sampled process was spawned.
+  std::unique_lock<std::mutex> lock = LockReaderListener();
   listener_->OnTid(event.GetTid());
 }
 
 void TracerThread::ProcessExitEvent(const perf_event_header& header,
-                                    PerfEventRingBuffer* ring_buffer) {
+                                    PerfEventRingBuffer* ring_buffer,
+                                    ReaderShard* /*shard*/) {
   ExitPerfEvent event;
   ring_buffer->ConsumeRecord(header, &event.ring_buffer_record);
 
@@ -479,7 +703,8 @@ void TracerThread::ProcessExitEvent(const perf_event_header& header,
 }
 
 void TracerThread::ProcessMmapEvent(const perf_event_header& header,
-                                    PerfEventRingBuffer* ring_buffer) {
+                                    PerfEventRingBuffer* ring_buffer,
+                                    ReaderShard* shard) {
   pid_t pid = ReadMmapRecordPid(ring_buffer);
   ring_buffer->SkipRecord(header);
 
@@ -492,11 +717,12 @@ void TracerThread::ProcessMmapEvent(const perf_event_header& header,
   auto event =
       std::make_unique<MapsPerfEvent>(MonotonicTimestampNs(), ReadMaps(pid_));
   event->SetOriginFileDescriptor(ring_buffer->GetFileDescriptor());
-  DeferEvent(std::move(event));
+  DeferEvent(std::move(event), shard);
 }
 
 void TracerThread::ProcessSampleEvent(const perf_event_header& header,
-                                      PerfEventRingBuffer* ring_buffer) {
+                                      PerfEventRingBuffer* ring_buffer,
+                                      ReaderShard* shard) {
   int fd = ring_buffer->GetFileDescriptor();
   bool is_probe = uprobes_fds_.contains(fd);
   bool is_gpu_event = gpu_tracing_fds_.contains(fd);
@@ -528,69 +754,120 @@ void TracerThread::ProcessSampleEvent(const perf_event_header& header,
         ConsumeSamplePerfEvent<UprobesWithStackPerfEvent>(ring_buffer, header);
     event->SetFunction(uprobes_ids_to_function_.at(event->GetStreamId()));
     event->SetOriginFileDescriptor(fd);
-    DeferEvent(std::move(event));
-    ++stats_.uprobes_count;
+    DeferEvent(std::move(event), shard);
+    ++shard->stats.uprobes_count;
 
   } else if (is_uretprobe) {
     auto event = make_unique_for_overwrite<UretprobesPerfEvent>();
     ring_buffer->ConsumeRecord(header, &event->ring_buffer_record);
     event->SetFunction(uprobes_ids_to_function_.at(event->GetStreamId()));
     event->SetOriginFileDescriptor(fd);
-    DeferEvent(std::move(event));
-    ++stats_.uprobes_count;
+    DeferEvent(std::move(event), shard);
+    ++shard->stats.uprobes_count;
 
   } else if (is_gpu_event) {
     // TODO: Consider deferring events.
     auto event = ConsumeSampleRaw(ring_buffer, header);
-    gpu_event_processor_->PushEvent(event);
-    ++stats_.gpu_events_count;
+    {
+      std::unique_lock<std::mutex> lock = LockReaderListener();
+      gpu_event_processor_->PushEvent(event);
+    }
+    ++shard->stats.gpu_events_count;
   } else {
     auto event =
         ConsumeSamplePerfEvent<StackSamplePerfEvent>(ring_buffer, header);
     event->SetOriginFileDescriptor(fd);
-    DeferEvent(std::move(event));
-    ++stats_.sample_count;
+    DeferEvent(std::move(event), shard);
+    ++shard->stats.sample_count;
   }
 }
 
 void TracerThread::ProcessLostEvent(const perf_event_header& header,
-                                    PerfEventRingBuffer* ring_buffer) {
+                                    PerfEventRingBuffer* ring_buffer,
+                                    ReaderShard* shard) {
   LostPerfEvent event;
   ring_buffer->ConsumeRecord(header, &event.ring_buffer_record);
-  stats_.lost_count += event.GetNumLost();
-  stats_.lost_count_per_buffer[ring_buffer] += event.GetNumLost();
+  shard->stats.lost_count += event.GetNumLost();
+  shard->stats.lost_count_per_buffer[ring_buffer] += event.GetNumLost();
 }
 
-void TracerThread::DeferEvent(std::unique_ptr<PerfEvent> event) {
-  std::lock_guard<std::mutex> lock(deferred_events_mutex_);
-  deferred_events_.emplace_back(std::move(event));
+void TracerThread::DeferEvent(std::unique_ptr<PerfEvent> event,
+                              ReaderShard* shard) {
+  shard->deferred_events.enqueue(std::move(event));
 }
 
 std::vector<std::unique_ptr<PerfEvent>> TracerThread::ConsumeDeferredEvents() {
-  std::lock_guard<std::mutex> lock(deferred_events_mutex_);
-  std::vector<std::unique_ptr<PerfEvent>> events(std::move(deferred_events_));
-  deferred_events_.clear();
+  std::vector<std::unique_ptr<PerfEvent>> events;
+  for (auto& shard : reader_shards_) {
+    shard->deferred_events.try_dequeue_bulk(
+        std::back_inserter(events), shard->deferred_events.size_approx());
+  }
   return events;
 }
 
+void TracerThread::UpdateDeferredEventsWatermarks() {
+  for (auto& shard : reader_shards_) {
+    for (size_t i = 0; i < shard->ring_buffers.size(); ++i) {
+      if (!shard->ring_buffers_defer_events[i]) {
+        continue;
+      }
+      uint64_t empty_timestamp_ns =
+          shard->ring_buffers_empty_timestamps_ns[i].load(
+              std::memory_order_acquire);
+      uprobes_event_processor_->UpdateWatermark(
+          shard->ring_buffers[i]->GetFileDescriptor(), empty_timestamp_ns);
+    }
+  }
+}
+
 void TracerThread::ProcessDeferredEvents() {
+  uint64_t stats_begin_ns = MonotonicTimestampNs();
   bool should_exit = false;
   while (!should_exit) {
     // When "should_exit" becomes true, we know that we have stopped generating
     // deferred events. The last iteration will consume all remaining events.
     should_exit = stop_deferred_thread_;
+    // Read the watermarks before consuming the deferred events: all events read
+    // from a ring buffer before it was observed empty are then consumed below.
+    UpdateDeferredEventsWatermarks();
     std::vector<std::unique_ptr<PerfEvent>> events = ConsumeDeferredEvents();
+    for (auto& event : events) {
+      int fd = event->GetOriginFileDescriptor();
+      uprobes_event_processor_->AddEvent(fd, std::move(event));
+    }
+
+    // Even without new events, advancing watermarks can allow processing more.
+    uprobes_event_processor_->ProcessOldEvents();
+    PrintDeferredEventsStatsIfTimerElapsed(&stats_begin_ns);
+
     if (events.empty()) {
       // TODO: use a wait/notify mechanism instead of check/sleep.
       usleep(IDLE_TIME_ON_EMPTY_DEFERRED_EVENTS_US);
-    } else {
-      for (auto& event : events) {
-        int fd = event->GetOriginFileDescriptor();
-        uprobes_event_processor_->AddEvent(fd, std::move(event));
-      }
+    }
+  }
+}
 
-      uprobes_event_processor_->ProcessOldEvents();
+void TracerThread::PrintDeferredEventsStatsIfTimerElapsed(
+    uint64_t* stats_begin_ns) {
+  if (*stats_begin_ns + EVENT_COUNT_WINDOW_S * 1'000'000'000 <
+      MonotonicTimestampNs()) {
+    double actual_window_s = (MonotonicTimestampNs() - *stats_begin_ns) / 1e9;
+    LOG("Deferred events processed (last %.1f s): %lu, delay avg: %.1f ms, "
+        "max: %.1f ms",
+        actual_window_s, uprobes_event_processor_->GetProcessedEventCount(),
+        uprobes_event_processor_->GetAverageProcessingDelayNs() / 1e6,
+        uprobes_event_processor_->GetMaxProcessingDelayNs() / 1e6);
+    uprobes_event_processor_->ResetProcessingDelayStats();
+    PerfEventAllocator::Stats allocator_stats =
+        PerfEventAllocator::GetAndResetStats();
+    LOG("Event allocations per second: %.0f pooled, %.0f from the system",
+        allocator_stats.reused_count / actual_window_s,
+        allocator_stats.system_allocation_count / actual_window_s);
+    if (elf_cache_ != nullptr) {
+      LOG("Elf objects reused across maps refreshes: %lu, created again: %lu",
+          elf_cache_->GetHitCount(), elf_cache_->GetMissCount());
     }
+    *stats_begin_ns = MonotonicTimestampNs();
   }
 }
 
@@ -600,28 +877,41 @@ void TracerThread::Reset() {
   uprobes_fds_.clear();
   uprobes_ids_to_function_.clear();
   gpu_tracing_fds_.clear();
-  deferred_events_.clear();
+  ring_buffer_fds_to_cpu_.clear();
+  deferred_events_fds_.clear();
+  reader_shards_.clear();
   stop_deferred_thread_ = false;
 }
 
-void TracerThread::PrintStatsIfTimerElapsed() {
-  constexpr uint64_t EVENT_COUNT_WINDOW_S = 5;
-
-  if (stats_.event_count_begin_ns + EVENT_COUNT_WINDOW_S * 1'000'000'000 <
+void TracerThread::PrintStatsIfTimerElapsed(ReaderShard* shard) {
+  if (shard->stats.event_count_begin_ns + EVENT_COUNT_WINDOW_S * 1'000'000'000 <
       MonotonicTimestampNs()) {
     double actual_window_s =
-        (MonotonicTimestampNs() - stats_.event_count_begin_ns) / 1e9;
+        (MonotonicTimestampNs() - shard->stats.event_count_begin_ns) / 1e9;
+    double thread_cpu_time_s =
+        (ThreadCpuTimeNs() - shard->stats.thread_cpu_time_begin_ns) / 1e9;
+    if (reader_shards_.size() > 1) {
+      LOG("Reader thread %u of %lu (%lu ring buffers):", shard->index + 1,
+          reader_shards_.size(), shard->ring_buffers.size());
+    }
+    LOG("Tracer thread CPU usage (last %.1f s): %.1f%%", actual_window_s,
+        100.0 * thread_cpu_time_s / actual_window_s);
+    if (shard->epoll_fd != -1) {
+      LOG("Tracer wakeups per second: %.0f",
+          shard->stats.wakeup_count / actual_window_s);
+    }
     LOG("Events per second (last %.1f s):", actual_window_s);
-    LOG("  sched switches: %.0f", stats_.sched_switch_count / actual_window_s);
-    LOG("  samples: %.0f", stats_.sample_count / actual_window_s);
-    LOG("  u(ret)probes: %.0f", stats_.uprobes_count / actual_window_s);
-    LOG("  gpu events: %.0f", stats_.gpu_events_count / actual_window_s);
-    LOG("  lost: %.0f, of which:", stats_.lost_count / actual_window_s);
-    for (const auto& lost_from_buffer : stats_.lost_count_per_buffer) {
+    LOG("  sched switches: %.0f",
+        shard->stats.sched_switch_count / actual_window_s);
+    LOG("  samples: %.0f", shard->stats.sample_count / actual_window_s);
+    LOG("  u(ret)probes: %.0f", shard->stats.uprobes_count / actual_window_s);
+    LOG("  gpu events: %.0f", shard->stats.gpu_events_count / actual_window_s);
+    LOG("  lost: %.0f, of which:", shard->stats.lost_count / actual_window_s);
+    for (const auto& lost_from_buffer : shard->stats.lost_count_per_buffer) {
       LOG("    from %s: %.0f", lost_from_buffer.first->GetName().c_str(),
           lost_from_buffer.second / actual_window_s);
     }
-    stats_.Reset();
+    shard->stats.Reset();
   }
 }
 
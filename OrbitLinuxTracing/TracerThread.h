@@ -3,9 +3,13 @@
 
 #include <OrbitLinuxTracing/Events.h>
 #include <OrbitLinuxTracing/Function.h>
+#include <OrbitLinuxTracing/StackDumpOptions.h>
 #include <OrbitLinuxTracing/TracerListener.h>
+#include <OrbitLinuxTracing/WakeupWatermarks.h>
 #include <linux/perf_event.h>
+#include <sys/epoll.h>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <mutex>
@@ -13,6 +17,7 @@
 #include <regex>
 #include <vector>
 
+#include "ElfCache.h"
 #include "GpuTracepointEventProcessor.h"
 #include "PerfEvent.h"
 #include "PerfEventProcessor.h"
@@ -22,6 +27,7 @@
 #include "Utils.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "concurrentqueue.h"
 
 namespace LinuxTracing {
 
@@ -52,9 +58,83 @@ class TracerThread {
     trace_instrumented_functions_ = trace_instrumented_functions;
   }
 
+  void SetUseEventDrivenWakeup(bool use_event_driven_wakeup) {
+    use_event_driven_wakeup_ = use_event_driven_wakeup;
+  }
+
+  void SetWakeupWatermarks(const WakeupWatermarks& wakeup_watermarks) {
+    wakeup_watermarks_ = wakeup_watermarks;
+  }
+
+  // Ring buffers are sharded by cpu across this many threads, which read from
+  // them in parallel.
+  void SetNumReaderThreads(uint32_t num_reader_threads) {
+    num_reader_threads_ = std::max<uint32_t>(1, num_reader_threads);
+  }
+
+  void SetStackDumpOptions(const StackDumpOptions& stack_dump_options) {
+    stack_dump_options_ = stack_dump_options;
+  }
+
+  void SetUseFramePointerUnwinding(bool use_frame_pointer_unwinding) {
+    use_frame_pointer_unwinding_ = use_frame_pointer_unwinding;
+  }
+
   void Run(const std::shared_ptr<std::atomic<bool>>& exit_requested);
 
  private:
+  // Returns the stack dump size to pass to perf_event_open: a multiple of 8
+  // bytes, as required by the kernel, not larger than SAMPLE_STACK_USER_SIZE.
+  static uint16_t ComputeStackDumpSize(uint16_t stack_dump_bytes);
+
+  // Returns the wakeup watermark to pass to perf_event_open for a ring buffer
+  // of size ring_buffer_size_kb, or 0 if not in event-driven wakeup mode.
+  uint32_t ComputeWakeupWatermark(uint32_t watermark_bytes,
+                                  uint64_t ring_buffer_size_kb) const;
+
+  struct EventStats {
+    void Reset() { *this = EventStats(); }
+    uint64_t event_count_begin_ns = MonotonicTimestampNs();
+    uint64_t thread_cpu_time_begin_ns = ThreadCpuTimeNs();
+    uint64_t wakeup_count = 0;
+    uint64_t sched_switch_count = 0;
+    uint64_t sample_count = 0;
+    uint64_t uprobes_count = 0;
+    uint64_t gpu_events_count = 0;
+    uint64_t lost_count = 0;
+    absl::flat_hash_map<PerfEventRingBuffer*, uint64_t> lost_count_per_buffer{};
+  };
+
+  // A group of ring buffers read by the same thread. Each shard passes the
+  // events it defers to the deferred-event thread through its own lock-free
+  // queue. As every ring buffer belongs to exactly one shard, events from the
+  // same ring buffer are still received in order by the deferred-event thread.
+  struct ReaderShard {
+    uint32_t index = 0;
+    std::vector<PerfEventRingBuffer*> ring_buffers;
+    // For each ring buffer in ring_buffers, whether its events are deferred
+    // and, if so, the latest time it was observed empty (minus a safety
+    // margin). This allows the deferred-event thread to advance the watermark
+    // of the ring buffer even when it has no new events.
+    std::vector<bool> ring_buffers_defer_events;
+    std::unique_ptr<std::atomic<uint64_t>[]> ring_buffers_empty_timestamps_ns;
+    int epoll_fd = -1;
+    std::vector<epoll_event> epoll_events;
+    moodycamel::ConcurrentQueue<std::unique_ptr<PerfEvent>> deferred_events;
+    EventStats stats;
+  };
+
+  void CreateReaderShards();
+  // Returns a lock on reader_listener_mutex_, which is not locked if there is
+  // a single reader thread.
+  std::unique_lock<std::mutex> LockReaderListener();
+  void ReadRingBuffers(
+      ReaderShard* shard,
+      const std::shared_ptr<std::atomic<bool>>& exit_requested);
+
+  bool RegisterRingBuffersWithEpoll(ReaderShard* shard);
+  void WaitForNewData(ReaderShard* shard);
+
   bool OpenRingBufferForGpuTracepoint(
       const char* tracepoint_category, const char* tracepoint_name, int32_t cpu,
       std::vector<int>* gpu_tracing_fds,
@@ -64,26 +144,30 @@ class TracerThread {
   bool InitGpuTracepointEventProcessor();
 
   void ProcessContextSwitchEvent(const perf_event_header& header,
-                                 PerfEventRingBuffer* ring_buffer);
+                                 PerfEventRingBuffer* ring_buffer,
+                                 ReaderShard* shard);
   void ProcessContextSwitchCpuWideEvent(const perf_event_header& header,
-                                        PerfEventRingBuffer* ring_buffer);
+                                        PerfEventRingBuffer* ring_buffer,
+                                        ReaderShard* shard);
   void ProcessForkEvent(const perf_event_header& header,
-                        PerfEventRingBuffer* ring_buffer);
+                        PerfEventRingBuffer* ring_buffer, ReaderShard* shard);
   void ProcessExitEvent(const perf_event_header& header,
-                        PerfEventRingBuffer* ring_buffer);
+                        PerfEventRingBuffer* ring_buffer, ReaderShard* shard);
   void ProcessMmapEvent(const perf_event_header& header,
-                        PerfEventRingBuffer* ring_buffer);
+                        PerfEventRingBuffer* ring_buffer, ReaderShard* shard);
   void ProcessSampleEvent(const perf_event_header& header,
-                          PerfEventRingBuffer* ring_buffer);
+                          PerfEventRingBuffer* ring_buffer, ReaderShard* shard);
   void ProcessLostEvent(const perf_event_header& header,
-                        PerfEventRingBuffer* ring_buffer);
+                        PerfEventRingBuffer* ring_buffer, ReaderShard* shard);
 
   void Reset();
-  void PrintStatsIfTimerElapsed();
+  void PrintStatsIfTimerElapsed(ReaderShard* shard);
 
-  void DeferEvent(std::unique_ptr<PerfEvent> event);
+  void DeferEvent(std::unique_ptr<PerfEvent> event, ReaderShard* shard);
   std::vector<std::unique_ptr<PerfEvent>> ConsumeDeferredEvents();
+  void UpdateDeferredEventsWatermarks();
   void ProcessDeferredEvents();
+  void PrintDeferredEventsStatsIfTimerElapsed(uint64_t* stats_begin_ns);
 
   // Number of records to read consecutively from a perf_event_open ring buffer
   // before switching to another one.
@@ -98,6 +182,18 @@ class TracerThread {
   static constexpr uint32_t IDLE_TIME_ON_EMPTY_RING_BUFFERS_US = 100;
   static constexpr uint32_t IDLE_TIME_ON_EMPTY_DEFERRED_EVENTS_US = 1000;
 
+  // In event-driven wakeup mode, ring buffers that never reach their watermark
+  // are still read at least this often. This also bounds the time it takes to
+  // notice that the exit was requested.
+  static constexpr int EPOLL_WAIT_TIMEOUT_MS = 10;
+
+  // An event can become visible in a ring buffer slightly after the time at
+  // which it was timestamped. When a ring buffer is observed empty, we assume
+  // that no event older than this margin will still appear in it.
+  static constexpr uint64_t EMPTY_RING_BUFFER_WATERMARK_MARGIN_NS = 5'000'000;
+
+  static constexpr uint64_t EVENT_COUNT_WINDOW_S = 5;
+
   pid_t pid_;
   uint64_t sampling_period_ns_;
   std::vector<Function> instrumented_functions_;
@@ -108,31 +204,32 @@ class TracerThread {
   bool trace_callstacks_ = true;
   bool trace_instrumented_functions_ = true;
   bool trace_gpu_driver_events_ = false;
+  bool use_event_driven_wakeup_ = false;
+  WakeupWatermarks wakeup_watermarks_{};
+  uint32_t num_reader_threads_ = 1;
+  StackDumpOptions stack_dump_options_{};
+  bool use_frame_pointer_unwinding_ = false;
 
   std::vector<int> tracing_fds_;
   std::vector<PerfEventRingBuffer> ring_buffers_;
   absl::flat_hash_set<int> uprobes_fds_;
   absl::flat_hash_map<uint64_t, const Function*> uprobes_ids_to_function_;
   absl::flat_hash_set<int> gpu_tracing_fds_;
+  absl::flat_hash_map<int, int32_t> ring_buffer_fds_to_cpu_;
+  // Ring buffers with events that go through uprobes_event_processor_.
+  absl::flat_hash_set<int> deferred_events_fds_;
+  std::vector<std::unique_ptr<ReaderShard>> reader_shards_;
+
+  // With more than one reader thread, serializes the calls to listener_ and to
+  // gpu_event_processor_ made directly from the reader threads.
+  std::mutex reader_listener_mutex_;
 
   std::atomic<bool> stop_deferred_thread_ = false;
-  std::vector<std::unique_ptr<PerfEvent>> deferred_events_;
-  std::mutex deferred_events_mutex_;
   std::shared_ptr<PerfEventProcessor2> uprobes_event_processor_;
+  // Owned by the visitor of uprobes_event_processor_, only read from the
+  // deferred events thread, which is also the one updating it.
+  const ElfCache* elf_cache_ = nullptr;
   std::shared_ptr<GpuTracepointEventProcessor> gpu_event_processor_;
-
-  struct EventStats {
-    void Reset() { *this = EventStats(); }
-    uint64_t event_count_begin_ns = MonotonicTimestampNs();
-    uint64_t sched_switch_count = 0;
-    uint64_t sample_count = 0;
-    uint64_t uprobes_count = 0;
-    uint64_t gpu_events_count = 0;
-    uint64_t lost_count = 0;
-    absl::flat_hash_map<PerfEventRingBuffer*, uint64_t> lost_count_per_buffer{};
-  };
-
-  EventStats stats_;
 };
 
 }  // namespace LinuxTracing
@@ -1,6 +1,9 @@
 #ifndef ORBIT_LINUX_TRACING_UPROBES_CALLSTACK_MANAGER_H_
 #define ORBIT_LINUX_TRACING_UPROBES_CALLSTACK_MANAGER_H_
 
+#include <sys/mman.h>
+
+#include "ElfCache.h"
 #include "LibunwindstackUnwinder.h"
 #include "PerfEvent.h"
 #include "absl/container/flat_hash_map.h"
@@ -16,10 +19,14 @@ class LateUnwindCallstack {
                                std::shared_ptr<unwindstack::BufferMaps> maps)
       : uprobes_event_{std::make_unique<UprobesWithStackPerfEvent>(
             std::move(uprobes_event))},
-        maps_{std::move(maps)} {}
+        maps_{std::move(maps)},
+        stack_pointer_{uprobes_event_->GetStackPointer()} {}
 
   bool IsUnwound() const { return uprobes_event_ == nullptr; }
 
+  // The stack pointer of the uprobes event, still available after unwinding.
+  uint64_t GetStackPointer() const { return stack_pointer_; }
+
   UprobesWithStackPerfEvent* GetUprobesEvent() const {
     return uprobes_event_.get();
   }
@@ -41,11 +48,15 @@ class LateUnwindCallstack {
  private:
   std::unique_ptr<UprobesWithStackPerfEvent> uprobes_event_;
   std::shared_ptr<unwindstack::BufferMaps> maps_;
+  uint64_t stack_pointer_;
   std::vector<unwindstack::FrameData> callstack_{};
 };
 
-// UprobesCallstackManager is a class template to simplify testing, so that we
-// can pass a mock unwinder.
+// UprobesCallstackManager is a class template so that we can pass a mock
+// unwinder for testing, and so that the unwinding method can be chosen between
+// LibunwindstackUnwinder and FramePointerUnwinder. Callstacks of uprobes are
+// unwound with UnwindFromFunctionEntry, as uprobes are hit at the first
+// instruction of the instrumented functions.
 template <typename UnwinderT>
 class UprobesCallstackManager {
  public:
@@ -60,14 +71,31 @@ class UprobesCallstackManager {
   UprobesCallstackManager(UprobesCallstackManager&&) = default;
   UprobesCallstackManager& operator=(UprobesCallstackManager&&) = default;
 
+  // If set, the stack copies of uprobes events, which are kept until the
+  // instrumented function returns, are trimmed to the region that unwinding
+  // them can actually access. See TrimUprobesStack.
+  void SetTrimUprobesStacks(bool trim_uprobes_stacks) {
+    trim_uprobes_stacks_ = trim_uprobes_stacks;
+  }
+
   void ProcessMaps(const std::string& maps_buffer) {
-    current_maps_ = LibunwindstackUnwinder::ParseMaps(maps_buffer);
+    std::shared_ptr<unwindstack::BufferMaps> new_maps =
+        LibunwindstackUnwinder::ParseMaps(maps_buffer);
+    if (current_maps_ != nullptr && new_maps != nullptr) {
+      elf_cache_.UpdateMaps(current_maps_.get(), new_maps.get());
+    }
+    current_maps_ = std::move(new_maps);
   }
 
+  const ElfCache& GetElfCache() const { return elf_cache_; }
+
   void ProcessUprobesCallstack(pid_t tid,
                                UprobesWithStackPerfEvent&& uprobes_event) {
     std::vector<LateUnwindCallstack>& previous_callstacks =
         tid_uprobes_callstacks_stacks_[tid];
+    if (trim_uprobes_stacks_) {
+      TrimUprobesStack(previous_callstacks, &uprobes_event);
+    }
     previous_callstacks.emplace_back(std::move(uprobes_event), current_maps_);
   }
 
@@ -97,12 +125,61 @@ class UprobesCallstackManager {
   }
 
  private:
+  // Extra bytes kept above the stack pointer of the enclosing uprobes in
+  // TrimUprobesStack, as the last step of the unwinder can read slightly past
+  // the hijacked return address.
+  static constexpr uint64_t TRIMMED_STACK_MARGIN = 1024;
+
   UnwinderT* unwinder_;
   std::shared_ptr<unwindstack::BufferMaps> current_maps_ = nullptr;
+  // Keeps the parsed ELF files across changes of the maps.
+  ElfCache elf_cache_{};
   // This map keeps, for every thread, the stack of callstacks collected when
   // entering a uprobes-instrumented function.
   absl::flat_hash_map<pid_t, std::vector<LateUnwindCallstack>>
       tid_uprobes_callstacks_stacks_{};
+  bool trim_uprobes_stacks_ = false;
+
+  // Unwinding the callstack of a uprobes event stops at the return address
+  // hijacked by the uretprobe of the enclosing instrumented function, which is
+  // stored at the stack pointer of the previous uprobes event of the thread.
+  // For the outermost instrumented function, the stack is instead bounded by
+  // the end of the mapping that contains the stack pointer, as the thread's
+  // stack cannot extend past it. This doesn't depend on previous unwinds,
+  // which could have stopped before the actual outermost frame. The stack copy
+  // is trimmed accordingly, which makes the memory held by deep recursions of
+  // instrumented functions proportional to the size of their frames.
+  void TrimUprobesStack(
+      const std::vector<LateUnwindCallstack>& previous_callstacks,
+      UprobesWithStackPerfEvent* uprobes_event) {
+    uint64_t stack_pointer = uprobes_event->GetStackPointer();
+    uint64_t stack_end;
+    if (!previous_callstacks.empty()) {
+      stack_end = previous_callstacks.back().GetStackPointer() +
+                  sizeof(uint64_t) + TRIMMED_STACK_MARGIN;
+    } else {
+      if (current_maps_ == nullptr) {
+        return;
+      }
+      unwindstack::MapInfo* stack_map_info = current_maps_->Find(stack_pointer);
+      // The stack of a thread created after the latest snapshot of the maps is
+      // not known, or could fall in a stale mapping: only trust a readable and
+      // writable, non-executable mapping.
+      if (stack_map_info == nullptr ||
+          (stack_map_info->flags & (PROT_READ | PROT_WRITE | PROT_EXEC)) !=
+              (PROT_READ | PROT_WRITE)) {
+        return;
+      }
+      stack_end = stack_map_info->end;
+    }
+
+    if (stack_end <= stack_pointer) {
+      // Inconsistent with the stack growing towards lower addresses, e.g.,
+      // because of a lost uretprobe or of a tid being reused: don't trim.
+      return;
+    }
+    uprobes_event->TrimStack(stack_end - stack_pointer);
+  }
 
   void UnwindPreviousUprobesCallstacks(pid_t tid) {
     std::vector<LateUnwindCallstack>& previous_callstacks =
@@ -110,7 +187,7 @@ class UprobesCallstackManager {
     for (LateUnwindCallstack& late_unwind_callstack : previous_callstacks) {
       if (!late_unwind_callstack.IsUnwound()) {
         const std::vector<unwindstack::FrameData>& callstack =
-            unwinder_->Unwind(
+            unwinder_->UnwindFromFunctionEntry(
                 late_unwind_callstack.GetMaps(),
                 late_unwind_callstack.GetUprobesEvent()->GetRegisters(),
                 late_unwind_callstack.GetUprobesEvent()->GetStackData(),
@@ -80,6 +80,13 @@ class TestUnwinder {
     return stack_dump_sizes_to_callstack.at(stack_dump_size);
   }
 
+  std::vector<unwindstack::FrameData> UnwindFromFunctionEntry(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size) {
+    return Unwind(maps, perf_regs, stack_dump, stack_dump_size);
+  }
+
   uint64_t GetNextStackDumpSize() {
     ++next_stack_dump_size_;
     return next_stack_dump_size_;
@@ -490,4 +497,120 @@ TEST(UprobesCallstackManager, UnwindingErrorOnStackThenValid) {
   callstack_manager.ProcessUretprobes(tid);
 }
 
+namespace {
+// Returns the callstack set with SetNextCallstack and records the size of all
+// the stack dumps it is asked to unwind.
+class StackDumpSizeRecordingUnwinder {
+ public:
+  static std::unique_ptr<unwindstack::BufferMaps> ParseMaps(
+      const std::string& /*maps_buffer*/) {
+    auto maps = std::make_unique<unwindstack::BufferMaps>("");
+    maps->Parse();
+    return maps;
+  }
+
+  std::vector<unwindstack::FrameData> Unwind(
+      unwindstack::Maps* /*maps*/,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& /*perf_regs*/,
+      const char* /*stack_dump*/, uint64_t stack_dump_size) {
+    stack_dump_sizes_.push_back(stack_dump_size);
+    return next_callstack_;
+  }
+
+  std::vector<unwindstack::FrameData> UnwindFromFunctionEntry(
+      unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      const char* stack_dump, uint64_t stack_dump_size) {
+    return Unwind(maps, perf_regs, stack_dump, stack_dump_size);
+  }
+
+  void SetNextCallstack(std::vector<unwindstack::FrameData> callstack) {
+    next_callstack_ = std::move(callstack);
+  }
+
+  const std::vector<uint64_t>& GetStackDumpSizes() const {
+    return stack_dump_sizes_;
+  }
+
+ private:
+  std::vector<unwindstack::FrameData> next_callstack_{};
+  std::vector<uint64_t> stack_dump_sizes_{};
+};
+
+constexpr uint64_t TEST_STACK_DUMP_SIZE = 65000;
+
+template <typename SamplePerfEventT>
+SamplePerfEventT MakeTestEventWithStackPointer(uint64_t stack_pointer) {
+  SamplePerfEventT event{TEST_STACK_DUMP_SIZE};
+  event.ring_buffer_record->regs.sp = stack_pointer;
+  return event;
+}
+
+// The stack of the test thread is [0x10000, 0x12000).
+constexpr const char* TEST_MAPS_WITH_STACK =
+    "10000-12000 rw-p 00000000 00:00 0 [stack]\n";
+
+void RunUprobesInRecursion(
+    UprobesCallstackManager<StackDumpSizeRecordingUnwinder>* callstack_manager,
+    StackDumpSizeRecordingUnwinder* unwinder) {
+  constexpr pid_t tid = 42;
+
+  // FUNCTION is entered twice recursively.
+  callstack_manager->ProcessUprobesCallstack(
+      tid, MakeTestEventWithStackPointer<UprobesWithStackPerfEvent>(0x11000));
+  callstack_manager->ProcessUprobesCallstack(
+      tid, MakeTestEventWithStackPointer<UprobesWithStackPerfEvent>(0x10800));
+
+  // Sample inside the innermost FUNCTION, which triggers the unwinding of the
+  // callstacks of both uprobes.
+  unwinder->SetNextCallstack(MakeTestUprobesCallstack({"FUNCTION"}));
+  callstack_manager->ProcessSampledCallstack(
+      tid, MakeTestEventWithStackPointer<StackSamplePerfEvent>(0x10000));
+
+  callstack_manager->ProcessUretprobes(tid);
+  callstack_manager->ProcessUretprobes(tid);
+}
+}  // namespace
+
+TEST(UprobesCallstackManager, TrimsUprobesStacks) {
+  StackDumpSizeRecordingUnwinder unwinder{};
+  UprobesCallstackManager<StackDumpSizeRecordingUnwinder> callstack_manager{
+      &unwinder, TEST_MAPS_WITH_STACK};
+  callstack_manager.SetTrimUprobesStacks(true);
+
+  RunUprobesInRecursion(&callstack_manager, &unwinder);
+
+  // The outermost uprobes stack is bounded by the end of the stack mapping,
+  // the inner one by the stack pointer of the outermost uprobes plus
+  // UprobesCallstackManager::TRIMMED_STACK_MARGIN.
+  EXPECT_THAT(unwinder.GetStackDumpSizes(),
+              ::testing::ElementsAre(TEST_STACK_DUMP_SIZE, 0x12000 - 0x11000,
+                                     0x11000 + 8 + 1024 - 0x10800));
+}
+
+TEST(UprobesCallstackManager, DoesNotTrimOutermostUprobesStackWithoutMapping) {
+  StackDumpSizeRecordingUnwinder unwinder{};
+  UprobesCallstackManager<StackDumpSizeRecordingUnwinder> callstack_manager{
+      &unwinder, ""};
+  callstack_manager.SetTrimUprobesStacks(true);
+
+  RunUprobesInRecursion(&callstack_manager, &unwinder);
+
+  EXPECT_THAT(unwinder.GetStackDumpSizes(),
+              ::testing::ElementsAre(TEST_STACK_DUMP_SIZE, TEST_STACK_DUMP_SIZE,
+                                     0x11000 + 8 + 1024 - 0x10800));
+}
+
+TEST(UprobesCallstackManager, DoesNotTrimUprobesStacksByDefault) {
+  StackDumpSizeRecordingUnwinder unwinder{};
+  UprobesCallstackManager<StackDumpSizeRecordingUnwinder> callstack_manager{
+      &unwinder, TEST_MAPS_WITH_STACK};
+
+  RunUprobesInRecursion(&callstack_manager, &unwinder);
+
+  EXPECT_THAT(unwinder.GetStackDumpSizes(),
+              ::testing::ElementsAre(TEST_STACK_DUMP_SIZE, TEST_STACK_DUMP_SIZE,
+                                     TEST_STACK_DUMP_SIZE));
+}
+
 }  // namespace LinuxTracing
@@ -1,8 +1,12 @@
 #include "UprobesUnwindingVisitor.h"
 
+#include "FramePointerUnwinder.h"
+#include "LibunwindstackUnwinder.h"
+
 namespace LinuxTracing {
 
-void UprobesUnwindingVisitor::visit(StackSamplePerfEvent* event) {
+template <typename UnwinderT>
+void UprobesUnwindingVisitor<UnwinderT>::visit(StackSamplePerfEvent* event) {
   CHECK(listener_ != nullptr);
   const std::vector<unwindstack::FrameData>& full_callstack =
       callstack_manager_.ProcessSampledCallstack(event->GetTid(), *event);
@@ -15,7 +19,9 @@ void UprobesUnwindingVisitor::visit(StackSamplePerfEvent* event) {
   }
 }
 
-void UprobesUnwindingVisitor::visit(UprobesWithStackPerfEvent* event) {
+template <typename UnwinderT>
+void UprobesUnwindingVisitor<UnwinderT>::visit(
+    UprobesWithStackPerfEvent* event) {
   CHECK(listener_ != nullptr);
 
   // We are seeing that, on thread migration, uprobe events can sometimes be
@@ -59,7 +65,8 @@ void UprobesUnwindingVisitor::visit(UprobesWithStackPerfEvent* event) {
                                              std::move(*event));
 }
 
-void UprobesUnwindingVisitor::visit(UretprobesPerfEvent* event) {
+template <typename UnwinderT>
+void UprobesUnwindingVisitor<UnwinderT>::visit(UretprobesPerfEvent* event) {
   CHECK(listener_ != nullptr);
 
   // Duplicate uprobe detection.
@@ -79,12 +86,14 @@ void UprobesUnwindingVisitor::visit(UretprobesPerfEvent* event) {
   callstack_manager_.ProcessUretprobes(event->GetTid());
 }
 
-void UprobesUnwindingVisitor::visit(MapsPerfEvent* event) {
+template <typename UnwinderT>
+void UprobesUnwindingVisitor<UnwinderT>::visit(MapsPerfEvent* event) {
   callstack_manager_.ProcessMaps(event->GetMaps());
 }
 
+template <typename UnwinderT>
 std::vector<CallstackFrame>
-UprobesUnwindingVisitor::CallstackFramesFromLibunwindstackFrames(
+UprobesUnwindingVisitor<UnwinderT>::CallstackFramesFromLibunwindstackFrames(
     const std::vector<unwindstack::FrameData>& libunwindstack_frames) {
   std::vector<CallstackFrame> callstack_frames;
   callstack_frames.reserve(libunwindstack_frames.size());
@@ -97,4 +106,7 @@ UprobesUnwindingVisitor::CallstackFramesFromLibunwindstackFrames(
   return callstack_frames;
 }
 
+template class UprobesUnwindingVisitor<LibunwindstackUnwinder>;
+template class UprobesUnwindingVisitor<FramePointerUnwinder>;
+
 }  // namespace LinuxTracing
@@ -32,7 +32,10 @@ namespace LinuxTracing {
 //  uretprobes events should be rare if they don't come with a stack sample).
 //  Start by passing the function_address to ProcessUretprobes as well for a
 //  comparison against the address of the uprobe on the stack.
+// UnwinderT is either LibunwindstackUnwinder or FramePointerUnwinder, the
+// class template is explicitly instantiated for both in the .cpp file.
 
+template <typename UnwinderT>
 class UprobesUnwindingVisitor : public PerfEventVisitor {
  public:
   explicit UprobesUnwindingVisitor(const std::string& initial_maps)
@@ -46,6 +49,14 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
 
   void SetListener(TracerListener* listener) { listener_ = listener; }
 
+  void SetTrimUprobesStacks(bool trim_uprobes_stacks) {
+    callstack_manager_.SetTrimUprobesStacks(trim_uprobes_stacks);
+  }
+
+  const ElfCache& GetElfCache() const {
+    return callstack_manager_.GetElfCache();
+  }
+
   void visit(StackSamplePerfEvent* event) override;
   void visit(UprobesWithStackPerfEvent* event) override;
   void visit(UretprobesPerfEvent* event) override;
@@ -53,8 +64,8 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
 
  private:
   UprobesFunctionCallManager function_call_manager_{};
-  LibunwindstackUnwinder unwinder_{};
-  UprobesCallstackManager<LibunwindstackUnwinder> callstack_manager_;
+  UnwinderT unwinder_{};
+  UprobesCallstackManager<UnwinderT> callstack_manager_;
 
   TracerListener* listener_ = nullptr;
 
@@ -14,6 +14,13 @@ inline uint64_t MonotonicTimestampNs() {
   return 1'000'000'000llu * ts.tv_sec + ts.tv_nsec;
 }
 
+// CPU time consumed by the calling thread.
+inline uint64_t ThreadCpuTimeNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return 1'000'000'000llu * ts.tv_sec + ts.tv_nsec;
+}
+
 std::optional<std::string> ExecuteCommand(const std::string& cmd);
 
 std::optional<std::string> ReadFile(std::string_view filename);
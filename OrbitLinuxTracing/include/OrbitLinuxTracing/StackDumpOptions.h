@@ -0,0 +1,26 @@
+#ifndef ORBIT_LINUX_TRACING_STACK_DUMP_OPTIONS_H_
+#define ORBIT_LINUX_TRACING_STACK_DUMP_OPTIONS_H_
+
+#include <cstdint>
+
+namespace LinuxTracing {
+
+// Number of bytes of the user stack that the kernel copies into each stack
+// sample and each uprobes record, starting from the stack pointer. Larger
+// sizes allow unwinding deeper callstacks, but the whole stack dump is copied
+// out of the ring buffer for every event. Values are rounded down to a
+// multiple of 8 bytes, and capped to 65000 bytes, the largest stack dump that
+// still fits in a single perf_event_open record.
+struct StackDumpOptions {
+  uint16_t sampling_bytes = 65000;
+  uint16_t uprobes_bytes = 65000;
+  // The stack dump of a uprobes event is kept in memory until the instrumented
+  // function returns. If set, it is first trimmed to the part that unwinding
+  // it requires, bounded by the stack pointer of the enclosing instrumented
+  // function or by the end of the mapping of the thread's stack.
+  bool trim_uprobes_stacks = false;
+};
+
+}  // namespace LinuxTracing
+
+#endif  // ORBIT_LINUX_TRACING_STACK_DUMP_OPTIONS_H_
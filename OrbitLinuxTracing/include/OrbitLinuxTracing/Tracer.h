@@ -3,7 +3,9 @@
 
 #include <OrbitLinuxTracing/Events.h>
 #include <OrbitLinuxTracing/Function.h>
+#include <OrbitLinuxTracing/StackDumpOptions.h>
 #include <OrbitLinuxTracing/TracerListener.h>
+#include <OrbitLinuxTracing/WakeupWatermarks.h>
 #include <unistd.h>
 
 #include <atomic>
@@ -43,12 +45,41 @@ class Tracer {
     trace_instrumented_functions_ = trace_instrumented_functions;
   }
 
+  // In event-driven wakeup mode, the tracer blocks on all ring buffers with
+  // epoll instead of polling them and sleeping when they are all empty.
+  void SetUseEventDrivenWakeup(bool use_event_driven_wakeup) {
+    use_event_driven_wakeup_ = use_event_driven_wakeup;
+  }
+
+  void SetWakeupWatermarks(const WakeupWatermarks& wakeup_watermarks) {
+    wakeup_watermarks_ = wakeup_watermarks;
+  }
+
+  // Number of threads reading from the perf_event_open ring buffers in
+  // parallel. Ring buffers are assigned to threads by cpu.
+  void SetNumReaderThreads(uint32_t num_reader_threads) {
+    num_reader_threads_ = num_reader_threads;
+  }
+
+  void SetStackDumpOptions(const StackDumpOptions& stack_dump_options) {
+    stack_dump_options_ = stack_dump_options;
+  }
+
+  // Unwind callstacks by following frame pointers, falling back to DWARF-based
+  // unwinding only when the chain of frame pointers is broken. Only suitable
+  // if the target is compiled with -fno-omit-frame-pointer.
+  void SetUseFramePointerUnwinding(bool use_frame_pointer_unwinding) {
+    use_frame_pointer_unwinding_ = use_frame_pointer_unwinding;
+  }
+
   void Start() {
     *exit_requested_ = false;
     thread_ = std::make_shared<std::thread>(
         &Tracer::Run, pid_, sampling_period_ns_, instrumented_functions_,
         listener_, trace_context_switches_, trace_callstacks_,
-        trace_instrumented_functions_, exit_requested_);
+        trace_instrumented_functions_, use_event_driven_wakeup_,
+        wakeup_watermarks_, num_reader_threads_, stack_dump_options_,
+        use_frame_pointer_unwinding_, exit_requested_);
     thread_->detach();
   }
 
@@ -64,6 +95,11 @@ class Tracer {
   bool trace_context_switches_ = true;
   bool trace_callstacks_ = true;
   bool trace_instrumented_functions_ = true;
+  bool use_event_driven_wakeup_ = false;
+  WakeupWatermarks wakeup_watermarks_{};
+  uint32_t num_reader_threads_ = 1;
+  StackDumpOptions stack_dump_options_{};
+  bool use_frame_pointer_unwinding_ = false;
 
   // exit_requested_ must outlive this object because it is used by thread_.
   // The control block of shared_ptr is thread safe (i.e., reference counting
@@ -76,6 +112,11 @@ class Tracer {
                   const std::vector<Function>& instrumented_functions,
                   TracerListener* listener, bool trace_context_switches,
                   bool trace_callstacks, bool trace_instrumented_functions,
+                  bool use_event_driven_wakeup,
+                  const WakeupWatermarks& wakeup_watermarks,
+                  uint32_t num_reader_threads,
+                  const StackDumpOptions& stack_dump_options,
+                  bool use_frame_pointer_unwinding,
                   const std::shared_ptr<std::atomic<bool>>& exit_requested);
 
   static std::optional<uint64_t> ComputeSamplingPeriodNs(
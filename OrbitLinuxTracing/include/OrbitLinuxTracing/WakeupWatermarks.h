@@ -0,0 +1,23 @@
+#ifndef ORBIT_LINUX_TRACING_WAKEUP_WATERMARKS_H_
+#define ORBIT_LINUX_TRACING_WAKEUP_WATERMARKS_H_
+
+#include <cstdint>
+
+namespace LinuxTracing {
+
+// Number of bytes that need to be available in a perf_event_open ring buffer
+// before the kernel wakes up the tracer, for each class of ring buffers. Only
+// used when the tracer is in event-driven wakeup mode. Values larger than half
+// of the corresponding ring buffer are reduced to half of the ring buffer, so
+// that a wakeup always happens before the ring buffer can overflow.
+struct WakeupWatermarks {
+  uint32_t context_switch_bytes = 64 * 1024;
+  uint32_t mmap_task_bytes = 4 * 1024;
+  uint32_t sampling_bytes = 512 * 1024;
+  uint32_t uprobes_bytes = 4 * 1024 * 1024;
+  uint32_t gpu_tracing_bytes = 64 * 1024;
+};
+
+}  // namespace LinuxTracing
+
+#endif  // ORBIT_LINUX_TRACING_WAKEUP_WATERMARKS_H_
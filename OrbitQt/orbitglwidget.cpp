@@ -69,6 +69,10 @@ void OrbitGLWidget::initializeGL() {
 
   initializeOpenGLFunctions();
 
+  // The panel frees its GL objects while the context still exists.
+  connect(context(), SIGNAL(aboutToBeDestroyed()), this,
+          SLOT(OnContextAboutToBeDestroyed()));
+
   if (m_OrbitPanel) {
     m_OrbitPanel->Initialize();
   }
@@ -76,6 +80,15 @@ void OrbitGLWidget::initializeGL() {
   PrintContextInformation();
 }
 
+//-----------------------------------------------------------------------------
+void OrbitGLWidget::OnContextAboutToBeDestroyed() {
+  if (m_OrbitPanel) {
+    makeCurrent();
+    m_OrbitPanel->ReleaseGlResources();
+    doneCurrent();
+  }
+}
+
 //-----------------------------------------------------------------------------
 void OrbitGLWidget::PrintContextInformation() {
   QString glType;
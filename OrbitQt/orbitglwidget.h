@@ -38,6 +38,7 @@ class OrbitGLWidget : public QOpenGLWidget, protected QOpenGLFunctions {
   void messageLogged(const QOpenGLDebugMessage& msg);
   void showContextMenu();
   void OnMenuClicked(int a_Index);
+  void OnContextAboutToBeDestroyed();
 
  private:
   GlPanel* m_OrbitPanel;
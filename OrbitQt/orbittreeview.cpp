@@ -85,6 +85,12 @@ void OrbitTreeView::SetDataModel(std::shared_ptr<DataView> a_Model) {
   m_Model = new OrbitTableModel();
   m_Model->SetDataView(a_Model);
   setModel(m_Model);
+
+  if (m_Model->GetUpdatePeriodMs() > 0 && m_Timer == nullptr) {
+    m_Timer = new QTimer(this);
+    connect(m_Timer, SIGNAL(timeout()), this, SLOT(OnTimer()));
+    m_Timer->start(m_Model->GetUpdatePeriodMs());
+  }
 }
 
 //-----------------------------------------------------------------------------